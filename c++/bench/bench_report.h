@@ -0,0 +1,130 @@
+// file: bench/bench_report.h
+#pragma once
+
+// 基准结果的 JSON 输出：文本结果照常打印到 stdout，命令行带 "--json <文件>" 时另外把每条结果写进该文件，
+// 供 bench 目标（run_benches.cmake）汇总成 bench_results.json，按提交跟踪回归
+// 文件格式：
+//   {"bench": "scheduler_bench", "build": "release", "timestamp": "2026-01-01T00:00:00Z",
+//    "host": {"cpus": 8, "cpu_model": "..."}, "commit": "<环境变量 SUNSHINE_BENCH_COMMIT>",
+//    "results": [{"name": "threads=4", "tasks_per_sec": 2100000}, ...]}
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <initializer_list>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class BenchReport {
+public:
+    typedef std::initializer_list<std::pair<const char *, double>> Metrics;
+
+    // 从 argv 中取出 "--json <文件>"，其余参数前移、argc 相应减少，位置参数的解析不受影响
+    BenchReport(const char *bench, int &argc, char **argv) :
+        m_bench(bench) {
+        int out = 1;
+        for (int i = 1; i < argc; ++i) {
+            if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+                m_path = argv[++i];
+            } else {
+                argv[out++] = argv[i];
+            }
+        }
+        argc = out;
+        argv[argc] = nullptr;
+    }
+
+    ~BenchReport() {
+        if (!m_path.empty()) write();
+    }
+
+    BenchReport(const BenchReport &) = delete;
+    BenchReport &operator=(const BenchReport &) = delete;
+
+    // 一条结果：name 在同一基准内唯一（例如 "threads=4"），metrics 为指标名（带单位）-> 数值
+    void add(const std::string &name, Metrics metrics) {
+        std::string item = "{\"name\": " + Quote(name);
+        for (const auto &m : metrics) {
+            item += ", " + Quote(m.first) + ": " + Number(m.second);
+        }
+        item += "}";
+        m_results.push_back(std::move(item));
+    }
+
+private:
+    static std::string Quote(const std::string &s) {
+        std::string out = "\"";
+        for (char c : s) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            } else {
+                out += c;
+            }
+        }
+        return out + "\"";
+    }
+
+    static std::string Number(double v) {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.10g", v);
+        // JSON 没有 inf / nan
+        if (std::strpbrk(buf, "in")) return "null";
+        return buf;
+    }
+
+    static std::string CpuModel() {
+        std::ifstream in("/proc/cpuinfo");
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.compare(0, 10, "model name") == 0) {
+                size_t colon = line.find(':');
+                if (colon != std::string::npos) return line.substr(line.find_first_not_of(' ', colon + 1));
+            }
+        }
+        return "";
+    }
+
+    void write() const {
+        char ts[32];
+        std::time_t now = std::time(nullptr);
+        std::tm tm;
+        gmtime_r(&now, &tm);
+        std::strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%SZ", &tm);
+        const char *commit = std::getenv("SUNSHINE_BENCH_COMMIT");
+#ifdef NDEBUG
+        const char *build = "release";
+#else
+        const char *build = "debug";
+#endif
+
+        std::FILE *fp = std::fopen(m_path.c_str(), "w");
+        if (!fp) {
+            std::perror(m_path.c_str());
+            return;
+        }
+        std::fprintf(fp, "{\"bench\": %s, \"build\": \"%s\", \"timestamp\": \"%s\",\n", Quote(m_bench).c_str(), build,
+                     ts);
+        std::fprintf(fp, " \"host\": {\"cpus\": %u, \"cpu_model\": %s}, \"commit\": %s,\n",
+                     std::thread::hardware_concurrency(), Quote(CpuModel()).c_str(),
+                     commit ? Quote(commit).c_str() : "null");
+        std::fprintf(fp, " \"results\": [");
+        for (size_t i = 0; i < m_results.size(); ++i) {
+            std::fprintf(fp, "%s\n  %s", i ? "," : "", m_results[i].c_str());
+        }
+        std::fprintf(fp, "\n]}\n");
+        std::fclose(fp);
+    }
+
+private:
+    std::string m_bench;
+    std::string m_path;
+    std::vector<std::string> m_results;
+};
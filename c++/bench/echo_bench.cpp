@@ -0,0 +1,186 @@
+// file: bench/echo_bench.cpp
+// IOManager echo 服务的吞吐与延迟：N 条长连接同时乒乓（写一条消息 -> 读回同样长度），统计 req/s 与 p50 / p99
+// 服务端是 IOManager 上的 hook 协程（阻塞式 read / write），客户端是另一个 IOManager 上的协程，
+// 每条连接一个协程，所以 N 可以取到上千而不需要同样多的线程
+//
+// 用法：echo_bench [每项秒数，默认 2] [服务端线程数，默认 1] [消息字节数，默认 64]
+//                  [连接数列表，默认 1,16,64,256] [--json 结果文件]
+#include "bench_report.h"
+#include "libs/iomanager.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace sunshine;
+
+static void echo(int fd) {
+    char buf[4096];
+    for (;;) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0) break;
+        ssize_t off = 0;
+        while (off < n) {
+            ssize_t w = write(fd, buf + off, n - off);
+            if (w <= 0) break;
+            off += w;
+        }
+    }
+    close(fd);
+}
+
+struct Stats {
+    std::atomic<bool> start{false}; // 所有连接建立之后才开始记录
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> connected{0};
+    std::atomic<size_t> done{0};
+    std::atomic<uint64_t> errors{0};
+    std::mutex mutex;
+    std::vector<uint32_t> latency; // 微秒
+};
+
+static void client(Stats &st, uint16_t port, size_t msg_size) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    std::vector<uint32_t> lat;
+    if (connect(fd, (sockaddr *)&addr, sizeof(addr)) != 0) {
+        st.errors.fetch_add(1);
+    } else {
+        st.connected.fetch_add(1);
+        std::string msg(msg_size, 'x');
+        std::string buf(msg_size, '\0');
+        lat.reserve(1 << 14);
+        while (!st.stop.load(std::memory_order_relaxed)) {
+            auto begin = std::chrono::steady_clock::now();
+            if (write(fd, msg.data(), msg.size()) != (ssize_t)msg.size()) {
+                st.errors.fetch_add(1);
+                break;
+            }
+            size_t got = 0;
+            while (got < msg_size) {
+                ssize_t n = read(fd, &buf[got], msg_size - got);
+                if (n <= 0) break;
+                got += n;
+            }
+            if (got < msg_size) {
+                st.errors.fetch_add(1);
+                break;
+            }
+            if (!st.start.load(std::memory_order_relaxed)) continue;
+            lat.push_back(static_cast<uint32_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin)
+                    .count()));
+        }
+    }
+    close(fd);
+    {
+        std::lock_guard<std::mutex> lock(st.mutex);
+        st.latency.insert(st.latency.end(), lat.begin(), lat.end());
+    }
+    st.done.fetch_add(1);
+}
+
+static void runCase(BenchReport &report, IOManager &server, IOManager &clients, size_t conns, double seconds,
+                    size_t msg_size) {
+    std::atomic<int> port{0};
+    std::atomic<int> listen_fd{-1};
+    std::atomic<bool> listen_done{false};
+    server.scheduler([&server, &port, &listen_fd, &listen_done]() {
+        int lfd = socket(AF_INET, SOCK_STREAM, 0);
+        int on = 1;
+        setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(lfd, (sockaddr *)&addr, sizeof(addr));
+        listen(lfd, 4096);
+        socklen_t len = sizeof(addr);
+        getsockname(lfd, (sockaddr *)&addr, &len);
+        listen_fd.store(lfd);
+        port.store(ntohs(addr.sin_port));
+        for (;;) {
+            int fd = accept(lfd, nullptr, nullptr);
+            if (fd < 0) break;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            server.scheduler([fd]() { echo(fd); });
+        }
+        close(lfd);
+        listen_done.store(true);
+    });
+    while (port.load() == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    Stats st;
+    uint16_t p = static_cast<uint16_t>(port.load());
+    for (size_t i = 0; i < conns; ++i) clients.scheduler([&st, p, msg_size]() { client(st, p, msg_size); });
+    // 计时从所有连接建立之后开始：之前的请求不计入
+    while (st.connected.load() + st.errors.load() < conns) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    auto begin = std::chrono::steady_clock::now();
+    st.start.store(true);
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    st.stop.store(true);
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    while (st.done.load() < conns) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    // 监听协程停在 accept 上：shutdown 让它返回，由它自己关闭 fd
+    shutdown(listen_fd.load(), SHUT_RDWR);
+    while (!listen_done.load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    std::sort(st.latency.begin(), st.latency.end());
+    auto pct = [&](double q) -> uint32_t {
+        if (st.latency.empty()) return 0;
+        return st.latency[std::min(st.latency.size() - 1, static_cast<size_t>(q * st.latency.size()))];
+    };
+    double rate = st.latency.size() / sec;
+    std::printf("conns %-6zu %10.0f req/s  p50 %6u us  p99 %6u us  errors %llu\n", conns, rate, pct(0.50),
+                pct(0.99), (unsigned long long)st.errors.load());
+    report.add("conns=" + std::to_string(conns), {{"requests_per_sec", rate},
+                                                  {"p50_us", static_cast<double>(pct(0.50))},
+                                                  {"p99_us", static_cast<double>(pct(0.99))},
+                                                  {"errors", static_cast<double>(st.errors.load())}});
+}
+
+int main(int argc, char **argv) {
+    BenchReport report("echo_bench", argc, argv);
+    double seconds = argc > 1 ? std::atof(argv[1]) : 2;
+    size_t threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1;
+    size_t msg_size = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 64;
+    std::string list = argc > 4 ? argv[4] : "1,16,64,256";
+    if (!threads) threads = 1;
+    if (!msg_size) msg_size = 1;
+    signal(SIGPIPE, SIG_IGN);
+
+    IOManager server(threads, false, "echo");
+    IOManager clients(1, false, "client");
+    server.start();
+    clients.start();
+
+    std::printf("echo_bench: %zu server thread(s), %zu-byte messages, %.1fs each\n", threads, msg_size, seconds);
+    size_t pos = 0;
+    while (pos < list.size()) {
+        size_t comma = list.find(',', pos);
+        if (comma == std::string::npos) comma = list.size();
+        size_t conns = std::strtoul(list.substr(pos, comma - pos).c_str(), nullptr, 10);
+        if (conns) runCase(report, server, clients, conns, seconds, msg_size);
+        pos = comma + 1;
+    }
+
+    clients.stop();
+    server.stop();
+    return 0;
+}
@@ -0,0 +1,195 @@
+// file: bench/echo_syscall_bench.cpp
+// echo 服务的系统调用计数：对比一次性注册（默认）、持久注册（iomanager.persistent_et）和
+// io_uring 后端（iomanager.io_uring，单次 recv / multishot recv 两种）
+// 服务端是单线程 IOManager 上的 hook 协程（阻塞式 read / write），客户端是普通线程做乒乓请求，
+// 统计服务端线程上每个请求平均发生多少次 epoll_ctl / epoll_wait / read+write（含 eventfd tickle）/ io_uring_enter
+// - epoll_ctl / epoll_wait：在本程序里定义同名函数拦截，计数后转发给 libc
+// - read / write：替换 hook 的 read_f / write_f，只统计开启 hook 的线程
+// - io_uring_enter：IoUring 通过 syscall(2) 调用，拦截 syscall 按调用号计数
+//
+// 用法：echo_syscall_bench [连接数，默认 4] [每个连接的请求数，默认 20000]
+#include "libs/Config.h"
+#include "libs/hook.h"
+#include "libs/iomanager.h"
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <dlfcn.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <stdarg.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <vector>
+
+using namespace sunshine;
+
+static std::atomic<uint64_t> s_epoll_ctl{0};
+static std::atomic<uint64_t> s_epoll_wait{0};
+static std::atomic<uint64_t> s_io{0};
+static std::atomic<uint64_t> s_enter{0};
+
+extern "C" int epoll_ctl(int epfd, int op, int fd, struct epoll_event *event) {
+    using fun = int (*)(int, int, int, struct epoll_event *);
+    static fun real = (fun)dlsym(RTLD_NEXT, "epoll_ctl");
+    s_epoll_ctl.fetch_add(1, std::memory_order_relaxed);
+    return real(epfd, op, fd, event);
+}
+
+extern "C" int epoll_wait(int epfd, struct epoll_event *events, int maxevents, int timeout) {
+    using fun = int (*)(int, struct epoll_event *, int, int);
+    static fun real = (fun)dlsym(RTLD_NEXT, "epoll_wait");
+    s_epoll_wait.fetch_add(1, std::memory_order_relaxed);
+    return real(epfd, events, maxevents, timeout);
+}
+
+// 系统调用参数都按 long 传递，取出 6 个转发即可
+extern "C" long syscall(long number, ...) {
+    using fun = long (*)(long, ...);
+    static fun real = (fun)dlsym(RTLD_NEXT, "syscall");
+    va_list ap;
+    va_start(ap, number);
+    long a[6];
+    for (long &x : a) x = va_arg(ap, long);
+    va_end(ap);
+    if (number == __NR_io_uring_enter) s_enter.fetch_add(1, std::memory_order_relaxed);
+    return real(number, a[0], a[1], a[2], a[3], a[4], a[5]);
+}
+
+static read_fun s_real_read = nullptr;
+static write_fun s_real_write = nullptr;
+
+static ssize_t countingRead(int fd, void *buf, size_t count) {
+    if (is_hook_enable()) s_io.fetch_add(1, std::memory_order_relaxed);
+    return s_real_read(fd, buf, count);
+}
+
+static ssize_t countingWrite(int fd, const void *buf, size_t count) {
+    if (is_hook_enable()) s_io.fetch_add(1, std::memory_order_relaxed);
+    return s_real_write(fd, buf, count);
+}
+
+static const size_t MSG_SIZE = 64;
+
+static void echo(int fd) {
+    char buf[4096];
+    for (;;) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0) break;
+        ssize_t off = 0;
+        while (off < n) {
+            ssize_t w = write(fd, buf + off, n - off);
+            if (w <= 0) break;
+            off += w;
+        }
+    }
+    close(fd);
+}
+
+enum Mode { ONESHOT, PERSISTENT, URING, URING_MULTISHOT };
+static const char *s_mode_names[] = {"oneshot", "persistent", "io_uring", "uring-ms"};
+
+static void runOnce(Mode mode, size_t conns, size_t requests) {
+    Config::Lookup<bool>("iomanager.persistent_et")->setValue(mode == PERSISTENT);
+    Config::Lookup<bool>("iomanager.io_uring")->setValue(mode == URING || mode == URING_MULTISHOT);
+    Config::Lookup<bool>("iomanager.io_uring_multishot_recv")->setValue(mode == URING_MULTISHOT);
+
+    IOManager iom(1, false, "echo");
+    iom.start();
+
+    std::atomic<int> port{0};
+    iom.scheduler([&iom, &port, conns]() {
+        int lfd = socket(AF_INET, SOCK_STREAM, 0);
+        int on = 1;
+        setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        bind(lfd, (sockaddr *)&addr, sizeof(addr));
+        listen(lfd, 128);
+        socklen_t len = sizeof(addr);
+        getsockname(lfd, (sockaddr *)&addr, &len);
+        port.store(ntohs(addr.sin_port));
+        for (size_t i = 0; i < conns; ++i) {
+            int fd = accept(lfd, nullptr, nullptr);
+            if (fd < 0) break;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            iom.scheduler([fd]() { echo(fd); });
+        }
+        close(lfd);
+    });
+    while (port.load() == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    // 客户端先全部建立连接，计数从第一个请求开始
+    std::vector<int> fds;
+    for (size_t i = 0; i < conns; ++i) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(port.load());
+        if (connect(fd, (sockaddr *)&addr, sizeof(addr)) != 0) {
+            std::perror("connect");
+            std::exit(1);
+        }
+        fds.push_back(fd);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    uint64_t ctl0 = s_epoll_ctl.load(), wait0 = s_epoll_wait.load(), io0 = s_io.load(), enter0 = s_enter.load();
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> clients;
+    for (int fd : fds) {
+        clients.emplace_back([fd, requests]() {
+            char msg[MSG_SIZE] = {'x'};
+            char buf[MSG_SIZE];
+            for (size_t i = 0; i < requests; ++i) {
+                if (write(fd, msg, sizeof(msg)) != (ssize_t)sizeof(msg)) std::exit(1);
+                size_t got = 0;
+                while (got < sizeof(buf)) {
+                    ssize_t n = read(fd, buf + got, sizeof(buf) - got);
+                    if (n <= 0) std::exit(1);
+                    got += n;
+                }
+            }
+        });
+    }
+    for (auto &t : clients) t.join();
+    auto end = std::chrono::steady_clock::now();
+    uint64_t ctl = s_epoll_ctl.load() - ctl0, wait = s_epoll_wait.load() - wait0, io = s_io.load() - io0;
+    uint64_t enter = s_enter.load() - enter0;
+
+    for (int fd : fds) close(fd);
+    iom.stop();
+
+    double total = double(conns * requests);
+    double sec = std::chrono::duration<double>(end - begin).count();
+    std::printf("%-10s epoll_ctl/req %5.2f  epoll_wait/req %5.2f  read+write/req %5.2f  io_uring_enter/req %5.2f  "
+                "total/req %5.2f  req/sec %.0f\n",
+                s_mode_names[mode], ctl / total, wait / total, io / total, enter / total,
+                (ctl + wait + io + enter) / total, total / sec);
+}
+
+int main(int argc, char **argv) {
+    size_t conns = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4;
+    size_t requests = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 20000;
+
+    s_real_read = read_f;
+    s_real_write = write_f;
+    read_f = &countingRead;
+    write_f = &countingWrite;
+
+    runOnce(ONESHOT, conns, requests);
+    runOnce(PERSISTENT, conns, requests);
+    runOnce(URING, conns, requests);
+    runOnce(URING_MULTISHOT, conns, requests);
+    return 0;
+}
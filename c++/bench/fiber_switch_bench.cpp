@@ -0,0 +1,135 @@
+// file: bench/fiber_switch_bench.cpp
+// 上下文切换基准：同一线程上两个上下文来回切换，输出每秒切换次数
+// - ucontext：swapcontext（每次切换都有一次 rt_sigprocmask 系统调用）
+// - asm：sunshine_ctx_swap（只保存 callee-saved 寄存器）
+// - Fiber：Fiber::swapIn / YieldToHold，使用构建时选定的后端（SUNSHINE_FIBER_CONTEXT）
+// 另外统计协程的创建开销（ns/fiber）：
+// - create：新建协程（栈取自 StackPool 的线程缓存）-> 运行到结束 -> 析构
+// - reset：已结束的协程换一个回调复用（调度器执行回调任务走的路径）
+//
+// 用法：fiber_switch_bench [往返次数，默认 5000000] [--json 结果文件]
+#include "bench_report.h"
+#include "libs/context.h"
+#include "libs/fiber.h"
+#include "libs/stack_pool.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ucontext.h>
+
+using namespace sunshine;
+
+static const size_t STACK_SIZE = 64 * 1024;
+static size_t s_rounds = 0;
+static BenchReport *s_report = nullptr;
+
+static void report(const char *name, std::chrono::steady_clock::time_point begin, size_t rounds) {
+    auto end = std::chrono::steady_clock::now();
+    double sec = std::chrono::duration<double>(end - begin).count();
+    // 一次往返 = 两次切换
+    double switches = rounds * 2.0;
+    std::printf("%-10s %12.0f switches/sec %8.1f ns/switch\n", name, switches / sec, sec * 1e9 / switches);
+    s_report->add(std::string("switch/") + name,
+                  {{"switches_per_sec", switches / sec}, {"ns_per_switch", sec * 1e9 / switches}});
+}
+
+// ---------- ucontext ----------
+static ucontext_t s_uc_main, s_uc_co;
+
+static void ucontextEntry() {
+    for (;;) swapcontext(&s_uc_co, &s_uc_main);
+}
+
+static void benchUcontext(size_t rounds) {
+    void *stack = StackPool::Map(STACK_SIZE);
+    getcontext(&s_uc_co);
+    s_uc_co.uc_stack.ss_sp = stack;
+    s_uc_co.uc_stack.ss_size = STACK_SIZE;
+    s_uc_co.uc_link = nullptr;
+    makecontext(&s_uc_co, &ucontextEntry, 0);
+
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rounds; ++i) swapcontext(&s_uc_main, &s_uc_co);
+    report("ucontext", begin, rounds);
+    StackPool::Unmap(stack, STACK_SIZE);
+}
+
+// ---------- asm ----------
+#if SUNSHINE_HAS_ASM_CONTEXT
+static void *s_asm_main = nullptr;
+static void *s_asm_co = nullptr;
+
+static void asmEntry(uintptr_t) {
+    for (;;) sunshine_ctx_swap(&s_asm_co, s_asm_main);
+}
+
+static void benchAsm(size_t rounds) {
+    void *stack = StackPool::Map(STACK_SIZE);
+    s_asm_co = MakeContext(stack, STACK_SIZE, &asmEntry, 0);
+
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rounds; ++i) sunshine_ctx_swap(&s_asm_main, s_asm_co);
+    report("asm", begin, rounds);
+    StackPool::Unmap(stack, STACK_SIZE);
+}
+#endif
+
+// ---------- Fiber ----------
+static void benchFiber(size_t rounds) {
+    Fiber::GetThis(); // 初始化主协程
+    Fiber::ptr fiber = std::make_shared<Fiber>([]() {
+        for (size_t i = 0; i < s_rounds; ++i) Fiber::YieldToHold();
+    });
+
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rounds; ++i) fiber->swapIn();
+    report(SUNSHINE_FIBER_ASM_CONTEXT ? "Fiber(asm)" : "Fiber(uc)", begin, rounds);
+    fiber->swapIn(); // 让协程结束
+}
+
+// ---------- Fiber 创建 ----------
+static void reportCreate(const char *name, std::chrono::steady_clock::time_point begin, size_t count) {
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    std::printf("%-10s %12.0f fibers/sec   %8.1f ns/fiber\n", name, count / sec, sec * 1e9 / count);
+    s_report->add(std::string("create/") + name, {{"fibers_per_sec", count / sec}, {"ns_per_fiber", sec * 1e9 / count}});
+}
+
+static void benchFiberCreate(size_t count) {
+    Fiber::GetThis();
+    size_t sink = 0;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        Fiber::ptr fiber = std::make_shared<Fiber>([&sink]() { ++sink; });
+        fiber->swapIn();
+    }
+    reportCreate("create", begin, count);
+
+    Fiber::ptr fiber = std::make_shared<Fiber>([&sink]() { ++sink; });
+    fiber->swapIn();
+    begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        fiber->reset([&sink]() { ++sink; });
+        fiber->swapIn();
+    }
+    reportCreate("reset", begin, count);
+    if (sink != 2 * count + 1) std::fprintf(stderr, "fiber create: ran %zu callbacks\n", sink);
+}
+
+int main(int argc, char **argv) {
+    BenchReport report("fiber_switch_bench", argc, argv);
+    s_report = &report;
+    size_t rounds = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 5000000;
+    s_rounds = rounds;
+
+    benchUcontext(rounds);
+#if SUNSHINE_HAS_ASM_CONTEXT
+    benchAsm(rounds);
+#else
+    std::printf("asm        not supported on this architecture\n");
+#endif
+    benchFiber(rounds);
+    benchFiberCreate(rounds / 10);
+    return 0;
+}
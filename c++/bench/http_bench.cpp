@@ -0,0 +1,155 @@
+// file: bench/http_bench.cpp
+// wrk 风格的 HTTP 压测：进程内启动 HttpServer（/plaintext 返回 "Hello, World!"），
+// 客户端是另一个 IOManager 上的协程，每个连接一个协程，每轮 pipelining 发出 depth 个请求，
+// 用 HttpParser(RESPONSE) 解析回来的响应；统计 req/s 与每个请求的 p50 / p99 延迟
+// （延迟从这一轮请求发出算到对应响应解析完，与 wrk 的 pipeline 模式一致）
+//
+// 用法：http_bench [连接数，默认 16] [秒数，默认 5] [pipeline 深度，默认 1] [服务端线程数，默认 1]
+#include "libs/address.h"
+#include "libs/http_parser.h"
+#include "libs/http_server.h"
+#include "libs/iomanager.h"
+#include "libs/socket.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace sunshine;
+
+static const char *REQUEST = "GET /plaintext HTTP/1.1\r\nHost: 127.0.0.1\r\nUser-Agent: http_bench\r\n"
+                             "Accept: text/plain\r\nConnection: keep-alive\r\n\r\n";
+
+static std::atomic<bool> s_stop{false};
+static std::atomic<uint64_t> s_requests{0};
+static std::atomic<uint64_t> s_errors{0};
+static std::mutex s_mutex;
+static std::vector<uint32_t> s_latency; // 微秒
+static std::atomic<size_t> s_done{0};
+
+static void client(Address::ptr addr, size_t depth) {
+    std::vector<uint32_t> lat;
+    lat.reserve(1 << 16);
+    uint64_t count = 0;
+
+    Socket::ptr sock = std::make_shared<Socket>(addr->getFamily(), SOCK_STREAM, 0);
+    if (!sock->connect(addr)) {
+        s_errors.fetch_add(1, std::memory_order_relaxed);
+        s_done.fetch_add(1);
+        return;
+    }
+    int on = 1;
+    sock->setOption(IPPROTO_TCP, TCP_NODELAY, on);
+
+    std::string batch;
+    for (size_t i = 0; i < depth; ++i) batch += REQUEST;
+
+    ByteArray in;
+    HttpParser parser(HttpParser::RESPONSE);
+    size_t end = 0, parsed = 0;
+    while (!s_stop.load(std::memory_order_relaxed)) {
+        auto begin = std::chrono::steady_clock::now();
+        for (size_t off = 0; off < batch.size();) {
+            int w = sock->send(batch.data() + off, batch.size() - off);
+            if (w <= 0) goto fail;
+            off += w;
+        }
+        for (size_t got = 0; got < depth;) {
+            in.setPosition(end);
+            int n = sock->recv(in, 16 * 1024);
+            if (n <= 0) goto fail;
+            end += n;
+            in.setPosition(parsed);
+            for (;;) {
+                HttpParser::Result r = parser.execute(in);
+                if (r == HttpParser::NEED_MORE) break;
+                if (r == HttpParser::ERROR || parser.getResponse().getStatus() != 200) goto fail;
+                parser.reset();
+                ++got;
+            }
+            parsed = in.getPosition();
+        }
+        // 一轮的响应都收齐了，缓冲区里没有未完成的报文
+        in.clear();
+        end = parsed = 0;
+        uint32_t us = static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count());
+        for (size_t i = 0; i < depth; ++i) lat.push_back(us);
+        count += depth;
+    }
+    goto done;
+fail:
+    s_errors.fetch_add(1, std::memory_order_relaxed);
+done:
+    sock->close();
+    s_requests.fetch_add(count, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        s_latency.insert(s_latency.end(), lat.begin(), lat.end());
+    }
+    s_done.fetch_add(1);
+}
+
+int main(int argc, char **argv) {
+    size_t conns = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 16;
+    double seconds = argc > 2 ? std::atof(argv[2]) : 5;
+    size_t depth = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 1;
+    size_t threads = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 1;
+    if (!conns) conns = 1;
+    if (!depth) depth = 1;
+    if (!threads) threads = 1;
+    signal(SIGPIPE, SIG_IGN);
+
+    IOManager server_iom(threads, false, "http");
+    IOManager client_iom(1, false, "client");
+    server_iom.start();
+    client_iom.start();
+
+    auto server = std::make_shared<HttpServer>(true, &server_iom, &server_iom);
+    server->getServletDispatch()->addServlet("/plaintext",
+                                             [](const HttpRequest &, HttpResponse &rsp, const Socket::ptr &) {
+                                                 rsp.setHeader("Content-Type", "text/plain");
+                                                 rsp.setBody("Hello, World!");
+                                             });
+    if (!server->bind(IPv4Address::Create("127.0.0.1", 0)) || !server->start()) {
+        std::fprintf(stderr, "bind 127.0.0.1 failed\n");
+        return 1;
+    }
+    Address::ptr addr = server->getLocalAddresses()[0];
+
+    std::printf("http_bench: %zu connections, pipeline %zu, %zu server thread(s), %.1fs\n", conns, depth, threads,
+                seconds);
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < conns; ++i) {
+        client_iom.scheduler([addr, depth]() { client(addr, depth); });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    s_stop.store(true);
+    while (s_done.load() < conns) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    server->stop();
+    client_iom.stop();
+    server_iom.stop();
+
+    uint64_t total = s_requests.load();
+    std::sort(s_latency.begin(), s_latency.end());
+    auto pct = [](double q) -> uint32_t {
+        if (s_latency.empty()) return 0;
+        return s_latency[std::min(s_latency.size() - 1, static_cast<size_t>(q * s_latency.size()))];
+    };
+    std::printf("  %llu requests in %.2fs, %llu errors\n", (unsigned long long)total, elapsed,
+                (unsigned long long)s_errors.load());
+    std::printf("  Requests/sec: %.0f\n", total / elapsed);
+    std::printf("  Latency: p50 %uus  p99 %uus  max %uus\n", pct(0.50), pct(0.99),
+                s_latency.empty() ? 0 : s_latency.back());
+    return 0;
+}
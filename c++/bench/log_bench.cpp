@@ -0,0 +1,129 @@
+// file: bench/log_bench.cpp
+// 日志吞吐与延迟基准：多个线程同时 LOG_INFO，统计总吞吐（lines/sec）和单次调用延迟的 p50 / p99 / p999
+// - file：FileoutAppender，所有线程在同一把文件锁上串行写
+// - async drop / async block：AsyncLogAppender，两种溢出策略；吞吐计到 flush() 返回为止（全部交给内核）
+// - async fmt：同 async block，但用 LOG_FMT_INFO 写入
+// - 最后单独测一次被级别过滤掉的 LOG_DEBUG 的开销（ns/次）
+//
+// 用法：log_bench [线程数，默认 16] [每线程行数，默认 200000] [输出文件，默认 /tmp/log_bench.log] [--json 结果文件]
+#include "bench_report.h"
+#include "libs/log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace sunshine;
+
+struct Result {
+    double linesPerSec = 0;
+    double p50 = 0;
+    double p99 = 0;
+    double p999 = 0;
+};
+
+static Result run(const char *name, LogAppender::ptr appender, size_t threads, size_t lines,
+                  const std::function<void()> &finish, bool fmt = false) {
+    Logger::ptr logger = std::make_shared<Logger>(name);
+    logger->addAppender(appender);
+
+    std::vector<std::vector<uint32_t>> lat(threads, std::vector<uint32_t>(lines));
+    std::vector<std::thread> workers;
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            auto &out = lat[t];
+            for (size_t i = 0; i < lines; ++i) {
+                auto t0 = std::chrono::steady_clock::now();
+                if (fmt) {
+                    LOG_FMT_INFO(logger, "worker {} line {} value={}", t, i, i * 31);
+                } else {
+                    LOG_INFO(logger) << "worker " << t << " line " << i << " value=" << i * 31;
+                }
+                auto t1 = std::chrono::steady_clock::now();
+                out[i] = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+            }
+        });
+    }
+    for (auto &w : workers) w.join();
+    finish();
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::vector<uint32_t> all;
+    all.reserve(threads * lines);
+    for (auto &v : lat) all.insert(all.end(), v.begin(), v.end());
+    std::sort(all.begin(), all.end());
+    auto pct = [&](double p) { return all[std::min(all.size() - 1, static_cast<size_t>(all.size() * p))] / 1000.0; };
+
+    Result r;
+    r.linesPerSec = threads * lines / sec;
+    r.p50 = pct(0.50);
+    r.p99 = pct(0.99);
+    r.p999 = pct(0.999);
+    return r;
+}
+
+static BenchReport *s_report = nullptr;
+
+static void print(const char *name, const Result &r, uint64_t dropped) {
+    std::printf("%-12s %12.0f lines/s   p50 %7.2f us   p99 %7.2f us   p999 %8.2f us   dropped %llu\n", name,
+                r.linesPerSec, r.p50, r.p99, r.p999, static_cast<unsigned long long>(dropped));
+    s_report->add(name, {{"lines_per_sec", r.linesPerSec},
+                         {"p50_us", r.p50},
+                         {"p99_us", r.p99},
+                         {"p999_us", r.p999},
+                         {"dropped", static_cast<double>(dropped)}});
+}
+
+int main(int argc, char **argv) {
+    BenchReport report("log_bench", argc, argv);
+    s_report = &report;
+    size_t threads = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 16;
+    size_t lines = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 200000;
+    const char *path = argc > 3 ? argv[3] : "/tmp/log_bench.log";
+    std::printf("%zu threads x %zu lines -> %s\n", threads, lines, path);
+
+    {
+        unlink(path);
+        auto app = std::make_shared<FileoutAppender>(path);
+        print("file", run("file", app, threads, lines, []() {}), 0);
+    }
+    {
+        unlink(path);
+        auto app = std::make_shared<AsyncLogAppender>(path, 1 << 20, 100, AsyncLogAppender::DROP);
+        Result r = run("async", app, threads, lines, [&]() { app->flush(); });
+        print("async drop", r, app->getDropped());
+    }
+    {
+        unlink(path);
+        auto app = std::make_shared<AsyncLogAppender>(path, 1 << 20, 100, AsyncLogAppender::BLOCK);
+        Result r = run("async", app, threads, lines, [&]() { app->flush(); });
+        print("async block", r, app->getDropped());
+    }
+    {
+        unlink(path);
+        auto app = std::make_shared<AsyncLogAppender>(path, 1 << 20, 100, AsyncLogAppender::BLOCK);
+        Result r = run("async", app, threads, lines, [&]() { app->flush(); }, true);
+        print("async fmt", r, app->getDropped());
+    }
+    unlink(path);
+
+    {
+        Logger::ptr logger = std::make_shared<Logger>("disabled");
+        logger->addAppender(std::make_shared<FileoutAppender>(path));
+        logger->setLevel(LogLevel::INFO);
+        const size_t n = 10000000;
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < n; ++i) LOG_DEBUG(logger) << "filtered " << i;
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / n;
+        std::printf("%-12s %8.2f ns/call\n", "disabled", ns);
+        report.add("disabled", {{"ns_per_call", ns}});
+    }
+    unlink(path);
+    return 0;
+}
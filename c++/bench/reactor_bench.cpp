@@ -0,0 +1,154 @@
+// file: bench/reactor_bench.cpp
+// 连接建立基准：短连接（connect -> 64 字节请求 -> 64 字节响应 -> close），统计每秒连接数与延迟分位
+// - single：默认的单 reactor 模式，所有工作线程共享一个 epoll，一个监听 socket
+// - multi：iomanager.multi_reactor，每个工作线程一个 epoll 和一个 SO_REUSEPORT 监听 socket，
+//   连接在哪个 reactor 上被 accept 就一直在那个线程上处理
+// 线程数依次取 1 / 2 / 4，客户端是普通线程（阻塞 socket）
+//
+// 用法：reactor_bench [客户端线程数，默认 4] [每个客户端的连接数，默认 5000]
+#include "libs/Config.h"
+#include "libs/fd_manager.h"
+#include "libs/hook.h"
+#include "libs/iomanager.h"
+#include "libs/reuseport.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <thread>
+#include <vector>
+
+using namespace sunshine;
+
+static const size_t MSG_SIZE = 64;
+
+static std::atomic<bool> s_stopping{false};
+
+static void handle(int fd) {
+    char buf[MSG_SIZE];
+    size_t got = 0;
+    while (got < sizeof(buf)) {
+        ssize_t n = read(fd, buf + got, sizeof(buf) - got);
+        if (n <= 0) break;
+        got += n;
+    }
+    if (got == sizeof(buf)) {
+        if (write(fd, buf, sizeof(buf)) == (ssize_t)sizeof(buf)) {
+            while (read(fd, buf, sizeof(buf)) > 0) {
+            }
+        }
+    }
+    close(fd);
+}
+
+// 监听 socket 上的 accept 循环：显式等待可读事件，停止时由 cancelAll 唤醒后退出
+static void acceptLoop(IOManager *iom, int lfd) {
+    while (!s_stopping.load()) {
+        int fd = accept_f(lfd, nullptr, nullptr);
+        if (fd >= 0) {
+            FdManager::GetInstance().get(fd, true);
+            if (iom->isMultiReactor()) {
+                iom->schedulerOnReactor(iom->getReactorIndex(), [fd]() { handle(fd); });
+            } else {
+                iom->scheduler([fd]() { handle(fd); });
+            }
+            continue;
+        }
+        if (errno != EAGAIN) break;
+        if (iom->addEvent(lfd, IOManager::READ) != 0) break;
+        Fiber::YieldToHold();
+    }
+}
+
+static void runOnce(bool multi, size_t threads, size_t clients, size_t conns) {
+    Config::Lookup<bool>("iomanager.multi_reactor")->setValue(multi);
+    s_stopping.store(false);
+
+    IOManager iom(threads, false, "reactor");
+    iom.start();
+
+    // 监听 socket 按 reactor 顺序创建（reuseport 组内序号 = 加入顺序）
+    size_t listeners = multi ? iom.getReactorCount() : 1;
+    std::vector<int> lfds;
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    for (size_t i = 0; i < listeners; ++i) {
+        int lfd = ReusePortListen((sockaddr *)&addr, sizeof(addr));
+        if (lfd < 0) {
+            std::perror("listen");
+            std::exit(1);
+        }
+        if (i == 0) {
+            socklen_t len = sizeof(addr);
+            getsockname(lfd, (sockaddr *)&addr, &len);
+        }
+        lfds.push_back(lfd);
+    }
+    if (multi) AttachReusePortCpuSteering(lfds[0], static_cast<uint32_t>(listeners));
+    for (size_t i = 0; i < listeners; ++i) {
+        int lfd = lfds[i];
+        iom.schedulerOnReactor(i, [&iom, lfd]() { acceptLoop(&iom, lfd); });
+    }
+
+    std::vector<std::vector<uint32_t>> latencies(clients);
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> ths;
+    for (size_t c = 0; c < clients; ++c) {
+        ths.emplace_back([&latencies, c, conns, addr]() {
+            char msg[MSG_SIZE] = {'x'};
+            char buf[MSG_SIZE];
+            latencies[c].reserve(conns);
+            for (size_t i = 0; i < conns; ++i) {
+                auto t0 = std::chrono::steady_clock::now();
+                int fd = socket(AF_INET, SOCK_STREAM, 0);
+                if (connect(fd, (const sockaddr *)&addr, sizeof(addr)) != 0) {
+                    std::perror("connect");
+                    std::exit(1);
+                }
+                if (write(fd, msg, sizeof(msg)) != (ssize_t)sizeof(msg)) std::exit(1);
+                size_t got = 0;
+                while (got < sizeof(buf)) {
+                    ssize_t n = read(fd, buf + got, sizeof(buf) - got);
+                    if (n <= 0) std::exit(1);
+                    got += n;
+                }
+                close(fd);
+                auto t1 = std::chrono::steady_clock::now();
+                latencies[c].push_back(
+                    static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count()));
+            }
+        });
+    }
+    for (auto &t : ths) t.join();
+    auto end = std::chrono::steady_clock::now();
+
+    s_stopping.store(true);
+    for (int lfd : lfds) iom.cancelAll(lfd);
+    iom.stop();
+    for (int lfd : lfds) close_f(lfd);
+
+    std::vector<uint32_t> all;
+    for (auto &v : latencies) all.insert(all.end(), v.begin(), v.end());
+    std::sort(all.begin(), all.end());
+    double sec = std::chrono::duration<double>(end - begin).count();
+    std::printf("%-6s threads %zu  conns/sec %8.0f  p50 %5u us  p99 %5u us\n", multi ? "multi" : "single",
+                threads, all.size() / sec, all[all.size() / 2], all[all.size() * 99 / 100]);
+}
+
+int main(int argc, char **argv) {
+    size_t clients = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4;
+    size_t conns = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 5000;
+
+    for (size_t threads : {1, 2, 4}) {
+        runOnce(false, threads, clients, conns);
+        runOnce(true, threads, clients, conns);
+    }
+    return 0;
+}
@@ -0,0 +1,167 @@
+// file: bench/rpc_bench.cpp
+// RPC 多路复用压测：进程内启动 RpcServer（"echo" 原样返回负载），客户端是另一个 IOManager 上的协程
+// - mux：所有调用协程共用一个 RpcClient（一条连接），统计 calls/s、p50 / p99 延迟与每次 writev 合并的帧数
+// - mux + slow：同上，另有一个协程不停调用耗时 20ms 的 "slow"，看快请求的延迟是否被它挡住
+// - per-call：每次调用新建一条连接（connect + call + close），对比每个请求一条连接的代价
+//
+// 用法：rpc_bench [调用协程数，默认 64] [每项秒数，默认 2] [负载字节数，默认 64] [服务端线程数，默认 1]
+#include "libs/address.h"
+#include "libs/iomanager.h"
+#include "libs/rpc.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <signal.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace sunshine;
+
+struct Stats {
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> errors{0};
+    std::atomic<size_t> done{0};
+    std::mutex mutex;
+    std::vector<uint32_t> latency; // 微秒
+
+    void record(std::vector<uint32_t> &lat, uint64_t n) {
+        calls.fetch_add(n, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(mutex);
+        latency.insert(latency.end(), lat.begin(), lat.end());
+    }
+    uint32_t pct(double q) const {
+        if (latency.empty()) return 0;
+        return latency[std::min(latency.size() - 1, static_cast<size_t>(q * latency.size()))];
+    }
+};
+
+static uint32_t SinceUs(std::chrono::steady_clock::time_point begin) {
+    return static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count());
+}
+
+// shared 为空时每次调用新建连接
+static void caller(Stats &st, RpcClient::ptr shared, Address::ptr addr, IOManager *iom, const std::string &payload) {
+    std::vector<uint32_t> lat;
+    lat.reserve(1 << 16);
+    uint64_t n = 0;
+    while (!st.stop.load(std::memory_order_relaxed)) {
+        auto begin = std::chrono::steady_clock::now();
+        RpcClient::Result r;
+        if (shared) {
+            r = shared->call("echo", payload);
+        } else {
+            auto client = std::make_shared<RpcClient>(iom);
+            if (!client->connect(addr)) {
+                st.errors.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+            r = client->call("echo", payload);
+            client->close();
+        }
+        if (!r.ok() || r.payload.size() != payload.size()) {
+            st.errors.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+        lat.push_back(SinceUs(begin));
+        ++n;
+    }
+    st.record(lat, n);
+    st.done.fetch_add(1);
+}
+
+static void runCase(const char *name, IOManager &iom, Address::ptr addr, size_t fibers, double seconds,
+                    const std::string &payload, bool multiplex, bool slow) {
+    Stats st;
+    RpcClient::ptr client;
+    if (multiplex) {
+        client = std::make_shared<RpcClient>(&iom);
+        if (!client->connect(addr)) {
+            std::fprintf(stderr, "connect failed\n");
+            std::exit(1);
+        }
+    }
+    std::atomic<bool> slow_stop{false};
+    std::atomic<bool> slow_done{!slow};
+    uint64_t slow_calls = 0;
+    if (slow) {
+        iom.scheduler([&]() {
+            while (!slow_stop.load()) {
+                if (client->call("slow", "").ok()) ++slow_calls;
+            }
+            slow_done.store(true);
+        });
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < fibers; ++i) {
+        iom.scheduler([&st, client, addr, &iom, &payload]() { caller(st, client, addr, &iom, payload); });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    st.stop.store(true);
+    slow_stop.store(true);
+    while (st.done.load() < fibers || !slow_done.load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::sort(st.latency.begin(), st.latency.end());
+    std::printf("  %-10s %9.0f calls/s  p50 %6uus  p99 %6uus  errors %llu", name, st.calls.load() / elapsed,
+                st.pct(0.50), st.pct(0.99), (unsigned long long)st.errors.load());
+    if (client) {
+        const auto &s = client->getSession();
+        std::printf("  frames/writev %.1f", s->getWrites() ? (double)s->getFramesSent() / s->getWrites() : 0.0);
+        client->close();
+    }
+    if (slow) std::printf("  slow calls %llu", (unsigned long long)slow_calls);
+    std::printf("\n");
+    // 等服务端处理完断开的连接
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+}
+
+int main(int argc, char **argv) {
+    size_t fibers = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64;
+    double seconds = argc > 2 ? std::atof(argv[2]) : 2;
+    size_t bytes = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 64;
+    size_t threads = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 1;
+    if (!fibers) fibers = 1;
+    if (!threads) threads = 1;
+    signal(SIGPIPE, SIG_IGN);
+
+    IOManager server_iom(threads, false, "rpc");
+    IOManager client_iom(1, false, "client");
+    server_iom.start();
+    client_iom.start();
+
+    auto server = std::make_shared<RpcServer>(&server_iom, &server_iom);
+    server->registerMethod("echo", [](const RpcMessage &req, std::string &rsp) {
+        rsp = req.payload.toString();
+        return RPC_OK;
+    });
+    server->registerMethod("slow", [](const RpcMessage &, std::string &) {
+        usleep(20 * 1000); // hook：只挂起这个请求的协程
+        return RPC_OK;
+    });
+    if (!server->bind(IPv4Address::Create("127.0.0.1", 0)) || !server->start()) {
+        std::fprintf(stderr, "bind 127.0.0.1 failed\n");
+        return 1;
+    }
+    Address::ptr addr = server->getLocalAddresses()[0];
+    std::string payload(bytes, 'x');
+
+    std::printf("rpc_bench: %zu caller fibers, %zu-byte payload, %zu server thread(s), %.1fs each\n", fibers, bytes,
+                threads, seconds);
+    runCase("mux", client_iom, addr, fibers, seconds, payload, true, false);
+    runCase("mux+slow", client_iom, addr, fibers, seconds, payload, true, true);
+    runCase("per-call", client_iom, addr, fibers, seconds, payload, false, false);
+
+    server->stop();
+    client_iom.stop();
+    server_iom.stop();
+    return 0;
+}
@@ -0,0 +1,67 @@
+# file: bench/run_benches.cmake
+# bench 目标调用的脚本（cmake -P）：依次运行基准套件，每个基准带 --json 写出自己的结果，
+# 最后汇总成一个文件：{"commit": "...", "benches": [<各基准的 JSON>...]}
+# 参数（-D 传入）：BENCH_BIN_DIR 基准程序所在目录，BENCHES 逗号分隔的基准名，RESULT_DIR 单个结果目录，
+#                  OUTPUT 汇总文件，SOURCE_DIR 源码目录（取 git 提交）
+# 规模取各基准默认值的一部分，整套在一两分钟内跑完；需要更大规模时直接运行单个基准
+
+foreach(var BENCH_BIN_DIR BENCHES RESULT_DIR OUTPUT SOURCE_DIR)
+  if(NOT DEFINED ${var})
+    message(FATAL_ERROR "run_benches.cmake: ${var} is not set")
+  endif()
+endforeach()
+
+# 每个基准的参数（--json 由脚本追加）
+set(fiber_switch_bench_ARGS 2000000)
+set(scheduler_bench_ARGS 200000)
+set(echo_bench_ARGS 2 1 64 1,16,64,256)
+set(varint_bench_ARGS 1000000 3)
+set(log_bench_ARGS 4 100000 ${RESULT_DIR}/log_bench.log)
+
+# 当前提交：写进每个基准的 JSON（BenchReport 读取环境变量 SUNSHINE_BENCH_COMMIT）
+execute_process(COMMAND git rev-parse HEAD
+                WORKING_DIRECTORY ${SOURCE_DIR}
+                OUTPUT_VARIABLE commit
+                OUTPUT_STRIP_TRAILING_WHITESPACE
+                ERROR_QUIET
+                RESULT_VARIABLE git_rc)
+if(NOT git_rc EQUAL 0)
+  set(commit "")
+endif()
+set(ENV{SUNSHINE_BENCH_COMMIT} "${commit}")
+
+file(MAKE_DIRECTORY ${RESULT_DIR})
+string(REPLACE "," ";" bench_list "${BENCHES}")
+# JSON 里可能有分号，不能当 CMake 列表拼接，直接按字符串追加
+set(joined "")
+set(failed "")
+foreach(bench IN LISTS bench_list)
+  set(json ${RESULT_DIR}/${bench}.json)
+  file(REMOVE ${json})
+  string(REPLACE ";" " " args "${${bench}_ARGS}")
+  message(STATUS "==== ${bench} ${args}")
+  execute_process(COMMAND ${BENCH_BIN_DIR}/${bench} ${${bench}_ARGS} --json ${json}
+                  RESULT_VARIABLE rc)
+  if(rc EQUAL 0 AND EXISTS ${json})
+    file(READ ${json} content)
+    string(STRIP "${content}" content)
+    if(NOT joined STREQUAL "")
+      string(APPEND joined ",\n")
+    endif()
+    string(APPEND joined "${content}")
+  else()
+    list(APPEND failed ${bench})
+  endif()
+endforeach()
+file(REMOVE ${RESULT_DIR}/log_bench.log)
+
+if(commit STREQUAL "")
+  set(commit_json "null")
+else()
+  set(commit_json "\"${commit}\"")
+endif()
+file(WRITE ${OUTPUT} "{\"commit\": ${commit_json}, \"benches\": [\n${joined}\n]}\n")
+message(STATUS "benchmark results: ${OUTPUT}")
+if(failed)
+  message(FATAL_ERROR "benchmarks failed: ${failed}")
+endif()
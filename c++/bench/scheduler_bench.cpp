@@ -0,0 +1,57 @@
+// file: bench/scheduler_bench.cpp
+// 调度器吞吐基准：线程数从 1 增加到 64，统计每秒完成的任务数（tasks/sec）
+// 每轮由外部线程提交若干 spawner 任务，每个 spawner 在工作线程内再提交一批叶子任务，
+// 这样同时覆盖"外部提交 -> 全局队列"与"工作线程提交 -> 本地队列 + 窃取"两条路径
+//
+// 用法：scheduler_bench [总任务数，默认 200000] [--json 结果文件]
+#include "bench_report.h"
+#include "libs/scheduler.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+using namespace sunshine;
+
+static double runOnce(size_t threads, size_t total_tasks) {
+    const size_t spawners = 64;
+    const size_t per_spawner = total_tasks / spawners;
+    const size_t expected = per_spawner * spawners;
+    std::atomic<size_t> done{0};
+
+    Scheduler sc(threads, false, "bench");
+    sc.start();
+
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < spawners; ++i) {
+        sc.scheduler([&sc, &done, per_spawner]() {
+            for (size_t j = 0; j < per_spawner; ++j) {
+                sc.scheduler([&done]() {
+                    done.fetch_add(1, std::memory_order_relaxed);
+                });
+            }
+        });
+    }
+    while (done.load(std::memory_order_relaxed) < expected) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    auto end = std::chrono::steady_clock::now();
+    sc.stop();
+
+    double sec = std::chrono::duration<double>(end - begin).count();
+    return expected / sec;
+}
+
+int main(int argc, char **argv) {
+    BenchReport report("scheduler_bench", argc, argv);
+    size_t total = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    std::printf("%-8s %16s\n", "threads", "tasks/sec");
+    for (size_t threads = 1; threads <= 64; threads *= 2) {
+        double rate = runOnce(threads, total);
+        std::printf("%-8zu %16.0f\n", threads, rate);
+        report.add("threads=" + std::to_string(threads), {{"tasks_per_sec", rate}});
+    }
+    return 0;
+}
@@ -0,0 +1,71 @@
+// file: bench/timer_bench.cpp
+// 定时器基准：插入 / 取消 / 到期收集的单次开销，验证百万级定时器下插入与取消为 O(1)
+//
+// 用法：timer_bench [定时器数量，默认 1000000]
+#include "libs/timer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace sunshine;
+
+// 测试用管理器：不需要唤醒任何等待者
+class BenchTimerManager : public TimerManager {
+protected:
+    void onTimerInsertedAtFront() override {
+    }
+};
+
+static double nsPerOp(std::chrono::steady_clock::time_point begin, size_t ops) {
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - begin).count() / ops;
+}
+
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    BenchTimerManager mgr;
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<uint64_t> dist(1, 1000);
+    size_t fired = 0;
+
+    std::vector<Timer::ptr> timers;
+    timers.reserve(count);
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        timers.push_back(mgr.addTimer(dist(rng), [&fired]() { ++fired; }));
+    }
+    std::printf("addTimer     %8.1f ns/op (%zu timers)\n", nsPerOp(begin, count), count);
+
+    begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i += 2) {
+        timers[i]->cancel();
+    }
+    std::printf("cancel       %8.1f ns/op\n", nsPerOp(begin, count / 2));
+
+    begin = std::chrono::steady_clock::now();
+    for (size_t i = 1; i < count; i += 4) {
+        timers[i]->refresh();
+    }
+    std::printf("refresh      %8.1f ns/op\n", nsPerOp(begin, count / 4));
+    timers.clear();
+
+    // 驱动时间轮直到全部到期（与 IOManager::idle 的用法一致）
+    std::vector<std::function<void()>> cbs;
+    size_t collected = 0;
+    begin = std::chrono::steady_clock::now();
+    while (mgr.hasTimer()) {
+        uint64_t next = mgr.getNextTimer();
+        if (next > 0 && next != ~0ull) std::this_thread::sleep_for(std::chrono::milliseconds(next));
+        cbs.clear();
+        mgr.listExpiredCb(cbs);
+        for (auto &cb : cbs) cb();
+        collected += cbs.size();
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    std::printf("expire       %zu callbacks fired in %.3f s\n", collected, sec);
+    return fired == count - count / 2 ? 0 : 1;
+}
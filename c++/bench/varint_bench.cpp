@@ -0,0 +1,144 @@
+// file: bench/varint_bench.cpp
+// ByteArray 序列化基准：逐个元素的 writeInt32 / readInt32 等与批量接口（SimdCodec 内核）对比，单位 ns/元素，
+// 另按编码后的字节数给出批量接口的编码 / 解码吞吐（MB/s）
+// - varint32 / varint64：zigzag varint，按取值分布分为 small（单字节）、mixed（1~3 字节）、full（整个取值范围）
+// - fixed32 native / swap：定长 uint32，swap 时 ByteArray 设为与主机相反的字节序，每个元素都需要翻转
+//
+// 用法：varint_bench [元素个数，默认 1000000] [重复次数，默认 5] [--json 结果文件]
+#include "bench_report.h"
+#include "libs/bytearray.h"
+#include "libs/simd_codec.h"
+
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace sunshine;
+
+static double nsPerOp(std::chrono::steady_clock::time_point begin, size_t ops) {
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - begin).count() / ops;
+}
+
+// 防止读出的结果被优化掉
+static volatile uint64_t s_sink = 0;
+
+struct Result {
+    double scalarWrite = 0;
+    double bulkWrite = 0;
+    double scalarRead = 0;
+    double bulkRead = 0;
+    double bytesPerElem = 0; // 编码后平均每个元素的字节数
+};
+
+template <class T, class WriteOne, class ReadOne, class WriteBulk, class ReadBulk>
+static Result run(const std::vector<T> &values, size_t rounds, bool swap, WriteOne writeOne, ReadOne readOne,
+                  WriteBulk writeBulk, ReadBulk readBulk) {
+    size_t n = values.size();
+    std::vector<T> out(n);
+    Result best{1e30, 1e30, 1e30, 1e30};
+    for (size_t r = 0; r < rounds; ++r) {
+        ByteArray ba;
+        if (swap) ba.setIsLittleEndian(std::endian::native != std::endian::little);
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < n; ++i) writeOne(ba, values[i]);
+        best.scalarWrite = std::min(best.scalarWrite, nsPerOp(t0, n));
+
+        ba.setPosition(0);
+        t0 = std::chrono::steady_clock::now();
+        uint64_t sum = 0;
+        for (size_t i = 0; i < n; ++i) sum += static_cast<uint64_t>(readOne(ba));
+        best.scalarRead = std::min(best.scalarRead, nsPerOp(t0, n));
+        s_sink = sum;
+
+        ByteArray bb;
+        if (swap) bb.setIsLittleEndian(std::endian::native != std::endian::little);
+        t0 = std::chrono::steady_clock::now();
+        writeBulk(bb, values.data(), n);
+        best.bulkWrite = std::min(best.bulkWrite, nsPerOp(t0, n));
+        best.bytesPerElem = static_cast<double>(bb.getPosition()) / n;
+
+        bb.setPosition(0);
+        t0 = std::chrono::steady_clock::now();
+        readBulk(bb, out.data(), n);
+        best.bulkRead = std::min(best.bulkRead, nsPerOp(t0, n));
+        if (out != values) {
+            std::fprintf(stderr, "bulk round trip mismatch\n");
+            std::exit(1);
+        }
+    }
+    return best;
+}
+
+static BenchReport *s_report = nullptr;
+
+static void print(const char *name, const Result &r) {
+    // 字节 / ns * 1000 = MB/s
+    double encode = r.bytesPerElem / r.bulkWrite * 1e3;
+    double decode = r.bytesPerElem / r.bulkRead * 1e3;
+    std::printf("%-16s write %6.2f -> %6.2f ns (x%4.1f)   read %6.2f -> %6.2f ns (x%4.1f)   bulk %7.0f / %7.0f MB/s\n",
+                name, r.scalarWrite, r.bulkWrite, r.scalarWrite / r.bulkWrite, r.scalarRead, r.bulkRead,
+                r.scalarRead / r.bulkRead, encode, decode);
+    s_report->add(name, {{"scalar_write_ns", r.scalarWrite},
+                         {"bulk_write_ns", r.bulkWrite},
+                         {"scalar_read_ns", r.scalarRead},
+                         {"bulk_read_ns", r.bulkRead},
+                         {"bytes_per_elem", r.bytesPerElem},
+                         {"bulk_encode_mb_per_sec", encode},
+                         {"bulk_decode_mb_per_sec", decode}});
+}
+
+int main(int argc, char **argv) {
+    BenchReport report("varint_bench", argc, argv);
+    s_report = &report;
+    size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    size_t rounds = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 5;
+    std::mt19937_64 rng(42);
+
+    std::printf("SimdCodec backend: %s, %zu elements, best of %zu\n", SimdCodec::Backend(), n, rounds);
+    std::printf("%-16s %-40s %-35s %s\n", "", "scalar -> bulk", "scalar -> bulk", "encode / decode");
+
+    auto varint32 = [&](const char *name, int32_t lo, int32_t hi) {
+        std::uniform_int_distribution<int32_t> dist(lo, hi);
+        std::vector<int32_t> values(n);
+        for (auto &v : values) v = dist(rng);
+        print(name, run(
+                        values, rounds, false, [](ByteArray &ba, int32_t v) { ba.writeInt32(v); },
+                        [](ByteArray &ba) { return ba.readInt32(); },
+                        [](ByteArray &ba, const int32_t *v, size_t c) { ba.writeVarintArray(v, c); },
+                        [](ByteArray &ba, int32_t *v, size_t c) { ba.readVarintArray(v, c); }));
+    };
+    varint32("varint32 small", -64, 63);
+    varint32("varint32 mixed", -(1 << 20), 1 << 20);
+    varint32("varint32 full", INT32_MIN, INT32_MAX);
+
+    auto varint64 = [&](const char *name, int64_t lo, int64_t hi) {
+        std::uniform_int_distribution<int64_t> dist(lo, hi);
+        std::vector<int64_t> values(n);
+        for (auto &v : values) v = dist(rng);
+        print(name, run(
+                        values, rounds, false, [](ByteArray &ba, int64_t v) { ba.writeInt64(v); },
+                        [](ByteArray &ba) { return ba.readInt64(); },
+                        [](ByteArray &ba, const int64_t *v, size_t c) { ba.writeVarintArray(v, c); },
+                        [](ByteArray &ba, int64_t *v, size_t c) { ba.readVarintArray(v, c); }));
+    };
+    varint64("varint64 small", -64, 63);
+    varint64("varint64 mixed", -(1ll << 20), 1ll << 20);
+    varint64("varint64 full", INT64_MIN, INT64_MAX);
+
+    std::vector<uint32_t> fixed(n);
+    for (auto &v : fixed) v = static_cast<uint32_t>(rng());
+    auto fixed32 = [&](const char *name, bool swap) {
+        print(name, run(
+                        fixed, rounds, swap, [](ByteArray &ba, uint32_t v) { ba.writeFuint32(v); },
+                        [](ByteArray &ba) { return ba.readFuint32(); },
+                        [](ByteArray &ba, const uint32_t *v, size_t c) { ba.writeFixedArray(v, c); },
+                        [](ByteArray &ba, uint32_t *v, size_t c) { ba.readFixedArray(v, c); }));
+    };
+    fixed32("fixed32 native", false);
+    fixed32("fixed32 swap", true);
+    return 0;
+}
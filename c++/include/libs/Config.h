@@ -16,6 +16,8 @@
 #include <typeinfo>
 #include <list>
 #include <algorithm>
+#include <atomic>
+#include <functional>
 #include <boost/lexical_cast.hpp>
 #include <yaml-cpp/node/node.h>
 #include <yaml-cpp/node/parse.h>
@@ -46,11 +48,84 @@ public:
     virtual std::string toString() = 0;
     virtual bool fromString(const std::string &val) = 0;
 
+    // 批量更新（供 Config::FromYaml 使用，调用方负责串行化）：
+    // prepare 直接从 YAML 节点解析并与当前值比较，有变化时暂存新值并返回 true；
+    // publish 发布暂存的新值；finish 在所有配置项发布、宽限期结束之后取出暂存状态，
+    // 返回调用监听器并释放旧值的闭包（没有变化时为空），由调用方在锁外执行
+    virtual bool prepare(const YAML::Node &node) = 0;
+    virtual void publish() = 0;
+    virtual std::function<void()> finish() = 0;
+
 protected:
     std::string m_name;
     std::string m_description;
 };
 
+// --------------------------- ConfigRcu ---------------------------
+// 配置读取用的用户态 RCU：读多写极少（启动、热加载），读侧不做任何原子读改写
+// - 每个读线程有一个自己的计数槽（第一次读时登记），进入临界区时写入当前宽限期编号，退出时写 0
+// - 写者发布新指针后推进宽限期编号，等待所有仍停留在旧编号的读者退出，之后旧数据才能释放
+// - 读者写完计数槽后需要 StoreLoad 屏障：内核支持 membarrier 时由写者用 membarrier 替读者执行，
+//   读侧只剩编译器屏障；不支持时读侧退回到 seq_cst fence
+// - 线程退出阶段（计数槽已注销）无法进入临界区，ReadGuard::locked() 返回 false，调用方改走加锁路径
+class ConfigRcu {
+    struct alignas(64) Reader {
+        std::atomic<uint64_t> ctr{0}; // 0 表示不在临界区，否则为进入时的宽限期编号
+        uint32_t nest = 0;            // 只由所属线程访问
+    };
+
+public:
+    class ReadGuard {
+    public:
+        ReadGuard() :
+            m_reader(Enter()) {
+        }
+        ~ReadGuard() {
+            if (m_reader) Exit(m_reader);
+        }
+        ReadGuard(const ReadGuard &) = delete;
+        ReadGuard &operator=(const ReadGuard &) = delete;
+
+        bool locked() const {
+            return m_reader != nullptr;
+        }
+
+    private:
+        Reader *m_reader;
+    };
+
+    // 等待在调用之前进入临界区的读者全部退出；不能在读侧临界区内调用
+    static void Synchronize();
+
+private:
+    friend struct ConfigRcuThreadExit;
+
+    static Reader *Enter() {
+        Reader *r = t_reader;
+        if (!r) {
+            r = Register();
+            if (!r) return nullptr;
+        }
+        if (r->nest++ == 0) {
+            r->ctr.store(s_gp.load(std::memory_order_acquire), std::memory_order_relaxed);
+            if (s_membarrier) {
+                std::atomic_signal_fence(std::memory_order_seq_cst);
+            } else {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+        }
+        return r;
+    }
+    static void Exit(Reader *r) {
+        if (--r->nest == 0) r->ctr.store(0, std::memory_order_release);
+    }
+    static Reader *Register();
+
+    inline static thread_local Reader *t_reader = nullptr;
+    inline static std::atomic<uint64_t> s_gp{1};
+    inline static bool s_membarrier = false;
+};
+
 // --------------------------- LexicalCast ---------------------------
 // 通用的类型转换小工具，默认使用 boost::lexical_cast
 template <class F, class T>
@@ -93,6 +168,44 @@ public:
     }
 };
 
+// string -> string：原样返回
+template <>
+class LexicalCast<std::string, std::string> {
+public:
+    std::string operator()(const std::string &val) {
+        return val;
+    }
+};
+
+// YAML 节点 -> T：标量直接转换 Scalar()，只有非标量（map 等）才 Dump 成文本再解析
+template <class T>
+class LexicalCast<YAML::Node, T> {
+public:
+    T operator()(const YAML::Node &node) {
+        if (node.IsScalar()) return LexicalCast<std::string, T>()(node.Scalar());
+        return LexicalCast<std::string, T>()(YAML::Dump(node));
+    }
+};
+
+// YAML 节点 -> vector<T>：逐个元素递归转换，不再 Dump / Load 往返
+// 与字符串版本不同，元素转换失败时抛出异常（由调用方保留旧值），而不是返回部分结果
+template <class T>
+class LexicalCast<YAML::Node, std::vector<T>> {
+public:
+    std::vector<T> operator()(const YAML::Node &node) {
+        std::vector<T> vec;
+        if (node.IsSequence()) {
+            vec.reserve(node.size());
+            for (const auto &n : node) {
+                vec.push_back(LexicalCast<YAML::Node, T>()(n));
+            }
+        } else if (node.IsScalar()) {
+            vec.push_back(LexicalCast<std::string, T>()(node.Scalar()));
+        }
+        return vec;
+    }
+};
+
 // vector<T> -> string 的特化（输出 YAML 序列文本）
 template <class T>
 class LexicalCast<std::vector<T>, std::string> {
@@ -113,10 +226,9 @@ public:
 };
 
 // --------------------------- ConfigVar<T> ---------------------------
-// 将 ConfigVar 改造成线程安全：使用 shared_mutex 实现读多写少的场景
-// - m_val: 由 m_mutex 保护，读时用 shared_lock，写时用 unique_lock
-// - m_cb: 监听器 map 也由同一把 mutex 保护，写时复制回调列表到本地后在锁外执行回调
-// 这样保证高并发读取时性能，同时安全地执行变更回调
+// 线程安全的配置项，读多写极少：
+// - m_val: 指向不可变快照，写时发布新快照，读者在 ConfigRcu 临界区内拷贝，不加锁也不做原子读改写
+// - m_mutex: 串行化写者并保护监听器 m_cb；写者等宽限期结束后再释放旧快照，监听器在锁外执行
 template <class T, class FromStr = LexicalCast<std::string, T>, class ToStr = LexicalCast<T, std::string>>
 class ConfigVar : public ConfigVarBase {
 public:
@@ -124,19 +236,21 @@ public:
     typedef std::function<void(const T &old_val, const T &new_val)> on_change_cb;
 
     ConfigVar(const std::string &name, const T &val, const std::string &description = "") :
-        ConfigVarBase(name, description), m_val(val) {
+        ConfigVarBase(name, description), m_val(new T(val)) {
+    }
+    ~ConfigVar() override {
+        delete m_val.load(std::memory_order_relaxed);
     }
 
     std::string toString() override {
         try {
-            std::shared_lock<std::shared_mutex> sl(m_mutex);
-            return ToStr()(m_val);
+            return ToStr()(getValue());
         } catch (const std::exception &e) {
             LOG_ERROR(LogManager::GetInstance().getRoot())
-                << "ConfigVar::toString exception: " << e.what() << " type: " << typeid(m_val).name();
+                << "ConfigVar::toString exception: " << e.what() << " type: " << typeid(T).name();
         } catch (...) {
             LOG_ERROR(LogManager::GetInstance().getRoot())
-                << "ConfigVar::toString unknown exception, type: " << typeid(m_val).name();
+                << "ConfigVar::toString unknown exception, type: " << typeid(T).name();
         }
         return std::string();
     }
@@ -148,70 +262,134 @@ public:
             return true;
         } catch (const std::exception &e) {
             LOG_ERROR(LogManager::GetInstance().getRoot())
-                << "ConfigVar::fromString exception: " << e.what() << " type: " << typeid(m_val).name();
+                << "ConfigVar::fromString exception: " << e.what() << " type: " << typeid(T).name();
         } catch (...) {
             LOG_ERROR(LogManager::GetInstance().getRoot())
-                << "ConfigVar::fromString unknown exception, type: " << typeid(m_val).name();
+                << "ConfigVar::fromString unknown exception, type: " << typeid(T).name();
         }
         return false;
     }
 
-    // 值访问（线程安全）
+    // 值访问（线程安全）：RCU 读，线程退出阶段退回到加锁读
     T getValue() const {
-        std::shared_lock<std::shared_mutex> sl(m_mutex);
-        return m_val;
+        ConfigRcu::ReadGuard rg;
+        if (rg.locked()) return *m_val.load(std::memory_order_acquire);
+        std::lock_guard<std::mutex> lk(m_mutex);
+        return *m_val.load(std::memory_order_relaxed);
     }
 
     void setValue(const T &v) {
-        // 采用写锁进行修改并安全地通知回调：
-        // 1) 获取 unique_lock，比较并更新 m_val
-        // 2) 在锁内拷贝回调列表到局部容器
-        // 3) 释放锁，逐个调用回调（避免在持锁期间调用用户代码）
-        std::unique_lock<std::shared_mutex> ul(m_mutex);
-        if (v == m_val) return;
-        T old = m_val;
-        m_val = v;
+        // 1) 持有 m_mutex，比较并发布新快照，拷贝回调列表
+        // 2) 等宽限期结束（没有读者还能看到旧快照）；期间一直持锁，加锁读的路径因此也不会读到旧快照
+        // 3) 释放锁，用旧快照逐个调用回调（避免在持锁期间调用用户代码），最后释放旧快照
+        std::unique_lock<std::mutex> ul(m_mutex);
+        const T *cur = m_val.load(std::memory_order_relaxed);
+        if (v == *cur) return;
+        std::unique_ptr<const T> old(cur);
+        m_val.store(new T(v), std::memory_order_release);
         // 复制回调到本地列表
         std::vector<on_change_cb> cbs;
         cbs.reserve(m_cb.size());
         for (auto &kv : m_cb) {
             if (kv.second) cbs.push_back(kv.second);
         }
+        ConfigRcu::Synchronize();
         ul.unlock();
 
         // 在锁外执行回调，避免回调中再尝试获取锁导致死锁
-        for (auto &cb : cbs) {
-            try {
-                cb(old, v);
-            } catch (const std::exception &e) {
-                LOG_ERROR(LogManager::GetInstance().getRoot()) << "ConfigVar callback exception: " << e.what();
-            } catch (...) {
-                LOG_ERROR(LogManager::GetInstance().getRoot()) << "ConfigVar callback unknown exception";
+        notify(cbs, *old, v);
+    }
+
+    bool prepare(const YAML::Node &node) override {
+        try {
+            std::unique_ptr<T> next;
+            if constexpr (std::is_same_v<FromStr, LexicalCast<std::string, T>>) {
+                next.reset(new T(LexicalCast<YAML::Node, T>()(node)));
+            } else {
+                next.reset(new T(FromStr()(node.IsScalar() ? node.Scalar() : YAML::Dump(node))));
             }
+            std::lock_guard<std::mutex> lk(m_mutex);
+            if (*next == *m_val.load(std::memory_order_relaxed)) return false;
+            m_batch.reset(new Batch);
+            m_batch->next = std::move(next);
+            return true;
+        } catch (const std::exception &e) {
+            LOG_ERROR(LogManager::GetInstance().getRoot())
+                << "ConfigVar::prepare " << m_name << " exception: " << e.what() << " type: " << typeid(T).name();
+        } catch (...) {
+            LOG_ERROR(LogManager::GetInstance().getRoot())
+                << "ConfigVar::prepare " << m_name << " unknown exception, type: " << typeid(T).name();
         }
+        return false;
+    }
+
+    void publish() override {
+        if (!m_batch) return;
+        std::lock_guard<std::mutex> lk(m_mutex);
+        const T *cur = m_val.load(std::memory_order_relaxed);
+        // prepare 之后被 setValue 改成了同样的值
+        if (*m_batch->next == *cur) {
+            m_batch.reset();
+            return;
+        }
+        m_batch->old.reset(cur);
+        m_batch->value.reset(new T(*m_batch->next));
+        m_val.store(m_batch->next.release(), std::memory_order_release);
+        for (auto &kv : m_cb) {
+            if (kv.second) m_batch->cbs.push_back(kv.second);
+        }
+    }
+
+    std::function<void()> finish() override {
+        if (!m_batch) return nullptr;
+        std::shared_ptr<Batch> b(std::move(m_batch));
+        if (!b->old) return nullptr;
+        return [b]() { notify(b->cbs, *b->old, *b->value); };
     }
 
     void addListener(uint64_t key, on_change_cb cb) {
-        std::unique_lock<std::shared_mutex> ul(m_mutex);
+        std::lock_guard<std::mutex> lk(m_mutex);
         m_cb[key] = std::move(cb);
     }
 
     void delListener(uint64_t key) {
-        std::unique_lock<std::shared_mutex> ul(m_mutex);
+        std::lock_guard<std::mutex> lk(m_mutex);
         m_cb.erase(key);
     }
 
     on_change_cb getListener(uint64_t key) {
-        std::shared_lock<std::shared_mutex> sl(m_mutex);
+        std::lock_guard<std::mutex> lk(m_mutex);
         auto it = m_cb.find(key);
         if (it == m_cb.end()) return on_change_cb();
         return it->second;
     }
 
 private:
-    mutable std::shared_mutex m_mutex; // 保护 m_val 与 m_cb
-    T m_val;
+    static void notify(const std::vector<on_change_cb> &cbs, const T &old_val, const T &new_val) {
+        for (auto &cb : cbs) {
+            try {
+                cb(old_val, new_val);
+            } catch (const std::exception &e) {
+                LOG_ERROR(LogManager::GetInstance().getRoot()) << "ConfigVar callback exception: " << e.what();
+            } catch (...) {
+                LOG_ERROR(LogManager::GetInstance().getRoot()) << "ConfigVar callback unknown exception";
+            }
+        }
+    }
+
+    // 一次批量更新的暂存状态：prepare 填 next，publish 之后 old / value / cbs 留给 finish
+    struct Batch {
+        std::unique_ptr<T> next;
+        std::unique_ptr<const T> old;
+        std::unique_ptr<T> value;
+        std::vector<on_change_cb> cbs;
+    };
+
+private:
+    mutable std::mutex m_mutex;   // 串行化写者，保护 m_cb
+    std::atomic<const T *> m_val; // 当前快照（RCU 发布）
     std::map<uint64_t, on_change_cb> m_cb;
+    std::unique_ptr<Batch> m_batch; // 只在 Config::FromYaml 的批量更新中使用（由其互斥锁串行化）
 };
 
 // --------------------------- Config 管理器 ---------------------------
@@ -230,12 +408,11 @@ public:
             throw std::invalid_argument("invalid config name: " + name);
         }
 
-        // 读多写少：先用 shared_lock 检查是否存在，若不存在再升级为 unique_lock 创建
+        // 读多写少：先无锁查找，若不存在再加写锁创建
         {
-            std::shared_lock<std::shared_mutex> sl(s_mutex);
-            auto it = s_datas.find(name);
-            if (it != s_datas.end()) {
-                auto tmp = std::dynamic_pointer_cast<ConfigVar<T>>(it->second);
+            ConfigVarBase::ptr found = LookupBase(name);
+            if (found) {
+                auto tmp = std::dynamic_pointer_cast<ConfigVar<T>>(found);
                 if (tmp) {
                     LOG_INFO(LogManager::GetInstance().getRoot()) << "Config::Lookup name = " << name << " exists, return existing";
                     return tmp;
@@ -246,36 +423,44 @@ public:
             }
         }
 
-        // 升级到写锁创建
-        std::unique_lock<std::shared_mutex> ul(s_mutex);
-        auto it2 = s_datas.find(name);
-        if (it2 != s_datas.end()) {
-            return std::dynamic_pointer_cast<ConfigVar<T>>(it2->second);
+        // 加写锁创建（再检查一次，避免竞争）
+        std::unique_lock<std::mutex> ul(s_mutex);
+        const ConfigMap *cur = s_datas.load(std::memory_order_relaxed);
+        if (cur) {
+            auto it2 = cur->find(name);
+            if (it2 != cur->end()) {
+                return std::dynamic_pointer_cast<ConfigVar<T>>(it2->second);
+            }
         }
 
         auto v = std::make_shared<ConfigVar<T>>(name, default_val, description);
-        s_datas[name] = v;
+        Publish(name, v);
+        ul.unlock();
         LOG_INFO(LogManager::GetInstance().getRoot()) << "Config::Lookup created config name = " << name;
         return v;
     }
 
     template <class T>
     static typename ConfigVar<T>::ptr Lookup(const std::string &name) {
-        std::shared_lock<std::shared_mutex> sl(s_mutex);
-        auto it = s_datas.find(name);
-        if (it == s_datas.end()) return nullptr;
-        return std::dynamic_pointer_cast<ConfigVar<T>>(it->second);
+        return std::dynamic_pointer_cast<ConfigVar<T>>(LookupBase(name));
     }
 
-    static ConfigMap getAll() {
-        std::shared_lock<std::shared_mutex> sl(s_mutex);
-        return s_datas;
-    }
+    static ConfigMap getAll();
 
     static void ListAllMember(const std::string &prefix, const YAML::Node &node,
                               std::list<std::pair<std::string, YAML::Node>> &output);
 
-    static void FromYaml(const YAML::Node &root);
+    // 把 YAML 中已注册的配置项作为一批更新：先逐个解析并与当前值比较，然后发布全部变化、
+    // 只等一次宽限期，最后逐个调用变化项的监听器，再调用一次批量监听器；返回变化的配置项个数
+    static size_t FromYaml(const YAML::Node &root);
+
+    // 读取并解析一次 YAML 文件后调用 FromYaml；读取或解析失败返回 -1（不修改任何配置项）
+    static int LoadFromFile(const std::string &path);
+
+    // 批量监听器：每次 FromYaml 有变化时调用一次，参数为变化的配置项名
+    typedef std::function<void(const std::vector<std::string> &changed)> on_reload_cb;
+    static uint64_t AddReloadListener(on_reload_cb cb);
+    static void DelReloadListener(uint64_t id);
 
 private:
     static bool ValidName(const std::string &s) {
@@ -289,10 +474,55 @@ private:
         return true;
     }
 
+    // 在持有 s_mutex 时复制一份加入新项的表并发布，等宽限期结束后释放旧表
+    static void Publish(const std::string &name, ConfigVarBase::ptr var);
+
 private:
-    inline static ConfigMap s_datas;
-    // s_mutex 改为 shared_mutex 以优化读多写少场景
-    inline static std::shared_mutex s_mutex;
+    // 配置表按 RCU 发布：查找时不加锁；只在注册新配置项时整表复制（只发生在启动阶段）
+    // 配置项注册后不会被删除，表本身在进程退出时也不释放（避免静态析构顺序问题），ConfigHandle 因此可以缓存裸指针
+    inline static std::atomic<const ConfigMap *> s_datas{nullptr};
+    inline static std::mutex s_mutex; // 串行化写者
+};
+
+// --------------------------- ConfigHandle<T> ---------------------------
+// 热路径上读取配置用的句柄：第一次使用时按名字解析并缓存 ConfigVar 的裸指针，
+// 之后每次读取只剩一次 RCU 读，不查表，也不碰 shared_ptr 的引用计数
+// 用法：static ConfigHandle<uint64_t> s_timeout("tcp.connect.timeout");  s_timeout.getValue(5000);
+template <class T>
+class ConfigHandle {
+public:
+    explicit ConfigHandle(std::string name) :
+        m_name(std::move(name)) {
+    }
+    explicit ConfigHandle(const typename ConfigVar<T>::ptr &var) :
+        m_name(var->getName()), m_var(var.get()) {
+    }
+
+    // 配置项还没有注册或类型不匹配时返回 nullptr（下次调用会重新尝试解析）
+    ConfigVar<T> *get() const {
+        ConfigVar<T> *v = m_var.load(std::memory_order_acquire);
+        if (!v) {
+            auto p = Config::Lookup<T>(m_name);
+            if (p) {
+                v = p.get();
+                m_var.store(v, std::memory_order_release);
+            }
+        }
+        return v;
+    }
+
+    T getValue(const T &def = T()) const {
+        ConfigVar<T> *v = get();
+        return v ? v->getValue() : def;
+    }
+
+    const std::string &getName() const {
+        return m_name;
+    }
+
+private:
+    std::string m_name;
+    mutable std::atomic<ConfigVar<T> *> m_var{nullptr};
 };
 
 } // namespace sunshine
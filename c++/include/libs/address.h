@@ -37,7 +37,7 @@ public:
 
     /**
      * @brief  通过 sockaddr 指针创建 Address
-     * @note   根据 sa_family 返回对应子类（IPv4/IPv6/Unknown）
+     * @note   根据 sa_family 返回对应子类（IPv4/IPv6/Unknown）；addrlen 不足以容纳该族的地址时返回 nullptr
      */
     static Address::ptr Create(const sockaddr *addr, socklen_t addrlen);
 
@@ -50,6 +50,7 @@ public:
      * @param   type        socket 类型（SOCK_STREAM、SOCK_DGRAM 等），若为 0 则不限制
      * @param   protocol    协议类型（IPPROTO_TCP、IPPROTO_UDP 等），若为 0 则不限制
      * @return  true 表示至少解析到一个地址并填充 result；false 表示解析失败或无结果
+     * @note    结果由 DnsResolver 缓存；协程里未命中时挂起协程等待解析线程，不阻塞工作线程
      */
     static bool Lookup(std::vector<Address::ptr> &result,
                        const std::string &host,
@@ -57,6 +58,16 @@ public:
                        int type = 0,
                        int protocol = 0);
 
+    /**
+     * @brief   不经过缓存，在当前线程同步调用 getaddrinfo（参数同 Lookup）
+     * @return  0 表示成功（result 可能为空），否则为 getaddrinfo 的 EAI_* 错误码
+     */
+    static int Resolve(std::vector<Address::ptr> &result,
+                       const std::string &host,
+                       int family = AF_INET,
+                       int type = 0,
+                       int protocol = 0);
+
     /**
      * @brief   通过 host 地址返回对应条件的任意 Address（第一个）
      */
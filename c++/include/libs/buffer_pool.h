@@ -0,0 +1,36 @@
+// file: libs/buffer_pool.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace sunshine {
+
+// 数据块分配器（ByteArray 的节点缓冲区使用）：按 2 的幂分成若干尺寸档，块起始地址按缓存行对齐
+// - 每个线程每个尺寸档一个空闲链表（侵入式，节点写在空闲块里），同线程的所有 ByteArray 共享，单线程访问无需加锁
+// - 线程缓存的总字节数上限由 bytearray.pool_max_bytes 配置，超出的直接释放
+// - 大于最大尺寸档的块不缓存，直接按缓存行对齐分配 / 释放
+class BufferPool {
+public:
+    static const size_t ALIGN = 64;                 // 缓存行
+    static const size_t MIN_CLASS = ALIGN;          // 最小尺寸档
+    static const size_t MAX_CLASS = 1024 * 1024;    // 最大尺寸档
+
+    // 分配至少 size 字节的块，失败抛出 std::bad_alloc
+    static void *Alloc(size_t size);
+
+    // 归还块（size 与 Alloc 时相同，或为 RoundSize 后的大小），可以在任意线程调用
+    static void Free(void *ptr, size_t size);
+
+    // size 实际占用的块大小（所在尺寸档；超过最大档时按缓存行取整）
+    static size_t RoundSize(size_t size);
+
+    // 当前线程缓存的空闲字节数
+    static size_t CachedBytes();
+
+    // 全局统计：实际向系统分配的次数 / 当前存活（已分配且未释放）的块数
+    static uint64_t TotalAllocated();
+    static uint64_t LiveBlocks();
+};
+
+} // namespace sunshine
@@ -1,15 +1,19 @@
 #ifndef __SUNSHINE_BYTEARRAY_H__
 #define __SUNSHINE_BYTEARRAY_H__
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <vector>
 #include <stdint.h>
 #include <sys/types.h>
 #include <sys/uio.h> // iovec
+#include <type_traits>
 
 namespace sunshine {
 
+class ByteSlice;
+
 class ByteArray {
 public:
     using ptr = std::shared_ptr<ByteArray>;
@@ -18,11 +22,22 @@ public:
     struct Node {
         Node(size_t s);
         Node();
+        // 外部内存（例如文件映射）：ptr 由 owner 管理，最后一个引用 owner 的节点释放时一起释放
+        Node(char *p, size_t s, std::shared_ptr<void> owner);
         ~Node();
 
         char *ptr;   // 数据缓冲区
         Node *next;  // 下一个块
         size_t size; // 本块大小
+        std::shared_ptr<void> owner; // 非空时 ptr 不是 BufferPool 分配的
+
+        // 引用计数：所属 ByteArray 持有 1，每个引用本块的 ByteSlice 片段再持有 1，减到 0 时释放
+        std::atomic<uint32_t> refs{1};
+        // [0, frozen) 曾被切片引用（只由所属 ByteArray 读写）；共享期间写入这段范围会先把本块复制一份
+        size_t frozen = 0;
+
+        // 引用计数减 1，减到 0 时释放本块（可以在任意线程调用）
+        static void Release(Node *node);
     };
 
     // 构造：指定每个块的大小（默认 4KB）
@@ -87,9 +102,38 @@ public:
     std::string readStringF64();
     std::string readStringVint();
 
+    // ---------- 批量接口 ----------
+    // varint 数组：编码与逐个 writeInt32 / writeInt64 / writeUint32 / writeUint64 完全相同，读写两端可以混用
+    // 编解码走 SimdCodec（按 CPU 特性选择 SIMD 实现），比逐个调用少了每字节一次的 read / write
+    void writeVarintArray(const int32_t *values, size_t n);
+    void writeVarintArray(const int64_t *values, size_t n);
+    void writeVarintArray(const uint32_t *values, size_t n);
+    void writeVarintArray(const uint64_t *values, size_t n);
+    void readVarintArray(int32_t *values, size_t n);
+    void readVarintArray(int64_t *values, size_t n);
+    void readVarintArray(uint32_t *values, size_t n);
+    void readVarintArray(uint64_t *values, size_t n);
+
+    // 定长数组（整数 / 浮点）：与逐个 writeFxxx 相同的字节序规则，字节序与主机不同时整段批量翻转
+    template <class T>
+    void writeFixedArray(const T *values, size_t n) {
+        static_assert(std::is_arithmetic<T>::value, "T must be arithmetic");
+        static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8, "unsupported width");
+        writeFixedArray(static_cast<const void *>(values), n, sizeof(T));
+    }
+    template <class T>
+    void readFixedArray(T *values, size_t n) {
+        static_assert(std::is_arithmetic<T>::value, "T must be arithmetic");
+        static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8, "unsupported width");
+        readFixedArray(static_cast<void *>(values), n, sizeof(T));
+    }
+
     // 清空（保留根节点）
     void clear();
 
+    // 预留至少 size 字节：在写入任何数据之前调用时，整段放进一个连续块（块大小随之改为 size 所在尺寸档）
+    void reserve(size_t size);
+
     // 基本读写（读会移动 m_position）
     void write(const void *buf, size_t size);
     void read(void *buf, size_t size);
@@ -106,6 +150,23 @@ public:
     bool writeToFile(const std::string name);
     void readFromFile(const std::string name);
 
+    // 文件映射模式：把文件映射进来直接作为块链，不经过 ifstream / ofstream 拷贝，加载耗时只剩缺页
+    // - writable = false：私有只读映射，position = 0，size = 文件长度；之后的写入只改内存副本，不影响文件
+    // - writable = true：共享映射，position = size = 文件长度（追加写）；写入直接落到文件页上，
+    //   容量不够时按块扩展文件并映射新的一块；unmapFile / 析构时把文件截断到实际长度
+    // chunk 为每块大小（按页取整，0 表示 DEFAULT_MAP_CHUNK），之后的块大小（getBaseSize）也随之改变
+    // 映射区域带 MADV_SEQUENTIAL 提示；失败返回 false，原有内容已被清空
+    bool mapFile(const std::string &name, bool writable = false, size_t chunk = 0);
+    // 结束文件映射（写模式下截断文件到实际长度），之后回到空的内存模式；clear() 在映射模式下等价于它
+    bool unmapFile();
+    // 写模式下把已写入的数据刷到磁盘（fdatasync）
+    bool syncFile();
+    bool isMapped() const {
+        return m_mapped;
+    }
+
+    static const size_t DEFAULT_MAP_CHUNK = 2 * 1024 * 1024;
+
     // 可读长度（从 m_position 开始）
     size_t getReadSize() const {
         return m_size - m_position;
@@ -127,7 +188,28 @@ public:
     uint64_t getReadBuffers(std::vector<iovec> &buffers, uint64_t len, uint64_t position) const;
     uint64_t getWriteBuffers(std::vector<iovec> &buffers, uint64_t len);
 
+    // 零拷贝切片：引用 [position, position + len) 这段已写入的数据，不拷贝（越界抛出 out_of_range）
+    // 切片存活期间 ByteArray 仍可正常读写：覆盖被引用的范围时先复制对应的块，切片看到的内容不变
+    // （例外：文件写映射模式下块就是文件页，覆盖写直接改文件，切片也会看到新内容）
+    ByteSlice slice(size_t position, size_t len) const;
+    // 从 m_position 起切出 len 字节并把 m_position 前移（相当于零拷贝的 read）
+    ByteSlice readSlice(size_t len);
+
 private:
+    void writeFixedArray(const void *values, size_t n, size_t width);
+    void readFixedArray(void *values, size_t n, size_t width);
+    // 当前字节序是否与主机不同（定长读写需要翻转）
+    bool needSwap() const;
+    // 从 m_position 起、当前块内连续可读的字节数
+    size_t contiguousReadSize() const;
+    // 在当前块内前移 n 字节（n 不超过 contiguousReadSize()），读到块尾时移到下一块
+    void skipInNode(size_t n);
+
+    // 即将写入 [m_position, m_position + len)：其中仍被切片引用的块先复制成独占的
+    void unshareForWrite(size_t len);
+    // 用 node 的独占副本替换它在链表中的位置，返回副本
+    Node *detachNode(Node *node);
+
     // 确保还有 size 大小的剩余容量，可扩容；返回是否成功
     bool addCapacity(size_t size);
     // 当前剩余可写容量（不改变任何状态）
@@ -143,6 +225,65 @@ private:
     int m_endian;      // 字节序标记（0 小端，1 大端）
     Node *m_cur;       // 当前节点指针（包含 m_position 的节点）
     Node *m_root;      // 根节点
+    Node *m_tail;      // 尾节点（扩容时直接追加，不用遍历链表）
+
+    bool m_mapped = false;     // 块链是否来自文件映射
+    int m_mapFd = -1;          // 写映射模式下的文件 fd（扩展 / 截断文件用）
+    size_t m_heapBaseSize = 0; // 映射前的块大小，unmapFile 后恢复
+};
+
+/**
+ * @brief 只读的字节切片：由若干段 ByteArray 块内存组成，每段持有所在块的引用计数
+ *
+ * 说明：
+ * - 复制切片只复制段表并增加引用计数，不拷贝数据；一份负载发给 N 个订阅者时共享同一批块
+ * - append 把另一个切片的各段按引用拼到末尾（例如每个连接各自的包头 + 共享的包体）
+ * - 块引用计数是原子的，切片可以交给其他线程发送；同一个切片对象的修改（append / 赋值）需要外部同步
+ */
+class ByteSlice {
+public:
+    using ptr = std::shared_ptr<ByteSlice>;
+
+    ByteSlice() = default;
+    ByteSlice(const ByteSlice &other);
+    ByteSlice(ByteSlice &&other) noexcept;
+    ByteSlice &operator=(ByteSlice other) noexcept;
+    ~ByteSlice();
+
+    size_t size() const {
+        return m_size;
+    }
+    bool empty() const {
+        return m_size == 0;
+    }
+
+    // [offset, offset + len) 的子切片（同样共享，越界部分截断）
+    ByteSlice sub(size_t offset, size_t len = ~0ull) const;
+    // 按引用追加另一个切片
+    void append(const ByteSlice &other);
+    void clear();
+
+    // 从 offset 开始最多 len 字节的 iovec（便于 writev / sendmsg），返回覆盖的字节数
+    uint64_t getIovecs(std::vector<iovec> &buffers, uint64_t offset = 0, uint64_t len = ~0ull) const;
+    // 拷贝 [offset, offset + len) 到 buf（越界抛出 out_of_range）
+    void copyTo(void *buf, size_t len, size_t offset = 0) const;
+    std::string toString() const;
+
+private:
+    friend class ByteArray;
+
+    struct Segment {
+        ByteArray::Node *node;
+        const char *ptr;
+        size_t len;
+    };
+
+    // 追加一段并持有 node 的引用
+    void push(ByteArray::Node *node, const char *ptr, size_t len);
+
+private:
+    std::vector<Segment> m_segs;
+    size_t m_size = 0;
 };
 
 } // namespace sunshine
@@ -0,0 +1,61 @@
+// file: libs/circular_buffer.h
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace sunshine {
+
+// CircularBuffer：可增长的环形缓冲区（非线程安全，由调用方加锁）
+// - 元素连续存放在一块数组里，入队 / 出队不分配节点；满时容量翻倍并整体搬移
+// - 调度器的全局队列使用它代替 std::list，避免每个任务一次链表节点分配
+template <class T>
+class CircularBuffer {
+public:
+    explicit CircularBuffer(size_t capacity = 64) {
+        size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        m_items.resize(cap);
+    }
+
+    void push_back(T &&v) {
+        if (m_size == m_items.size()) grow();
+        m_items[(m_head + m_size) & (m_items.size() - 1)] = std::move(v);
+        ++m_size;
+    }
+
+    // 弹出队首元素；为空返回 false
+    bool pop_front(T &out) {
+        if (m_size == 0) return false;
+        out = std::move(m_items[m_head]);
+        m_head = (m_head + 1) & (m_items.size() - 1);
+        --m_size;
+        return true;
+    }
+
+    size_t size() const {
+        return m_size;
+    }
+
+    bool empty() const {
+        return m_size == 0;
+    }
+
+private:
+    void grow() {
+        std::vector<T> items(m_items.size() * 2);
+        for (size_t i = 0; i < m_size; ++i) {
+            items[i] = std::move(m_items[(m_head + i) & (m_items.size() - 1)]);
+        }
+        m_items.swap(items);
+        m_head = 0;
+    }
+
+private:
+    std::vector<T> m_items; // 容量始终为 2 的幂
+    size_t m_head = 0;
+    size_t m_size = 0;
+};
+
+} // namespace sunshine
@@ -0,0 +1,54 @@
+// file: libs/config_watcher.h
+#pragma once
+
+#include "libs/iomanager.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+namespace sunshine {
+
+// ConfigWatcher：用 inotify 监视 YAML 配置文件，文件变化后在 IOManager 上重新加载（Config::LoadFromFile）
+// - 监视的是文件所在目录（IN_CLOSE_WRITE / IN_MOVED_TO / IN_CREATE），编辑器"写临时文件再 rename"的保存方式也能触发
+// - inotify fd 的可读事件注册在 IOManager 上，回调在协程里读出全部事件；同一文件的一串事件
+//   按 config.watch_debounce_ms 合并成一次重新加载（也减少读到保存了一半的文件的机会）
+// - 重新加载只解析一次文件，与当前值比较后把变化一起发布，监听器每次重新加载最多触发一次
+// - 回调只持有 weak_ptr，对象析构时注销事件并关闭 inotify fd
+class ConfigWatcher : public std::enable_shared_from_this<ConfigWatcher> {
+public:
+    typedef std::shared_ptr<ConfigWatcher> ptr;
+
+    static ptr Create(IOManager *iom = IOManager::GetThis());
+    ~ConfigWatcher();
+
+    // 立即加载一次 path，之后文件变化时自动重新加载；load_now 为 false 时只监视
+    // inotify 不可用或目录无法监视时返回 false
+    bool watch(const std::string &path, bool load_now = true);
+
+    // 已完成的重新加载次数（不含 watch 时的首次加载）
+    uint64_t getReloadCount() const {
+        return m_reloads.load(std::memory_order_relaxed);
+    }
+
+private:
+    explicit ConfigWatcher(IOManager *iom);
+    bool arm();
+    void onReadable();
+    void schedule(const std::string &path);
+    void reload(const std::string &path);
+
+private:
+    IOManager *m_iom;
+    int m_fd = -1;
+    std::mutex m_mutex;
+    std::map<int, std::string> m_dirs;                   // wd -> 目录
+    std::map<std::string, std::set<std::string>> m_files; // 目录 -> 监视的文件名
+    std::set<std::string> m_pending;                     // 已安排了重新加载定时器的文件
+    std::atomic<uint64_t> m_reloads{0};
+};
+
+} // namespace sunshine
@@ -0,0 +1,34 @@
+// file: libs/context.h
+#pragma once
+
+// 手写汇编的上下文切换（x86-64 / aarch64）
+// - 只保存 callee-saved 寄存器（以及 x86-64 的 MXCSR / x87 控制字），不像 swapcontext 那样
+//   每次切换都通过 rt_sigprocmask 系统调用保存 / 恢复信号掩码
+// - 上下文就是保存在栈上的寄存器帧，用一个栈指针表示
+// Fiber 是否使用它由构建选项 SUNSHINE_FIBER_CONTEXT（asm / ucontext）决定
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__aarch64__)
+#define SUNSHINE_HAS_ASM_CONTEXT 1
+#else
+#define SUNSHINE_HAS_ASM_CONTEXT 0
+#endif
+
+#if SUNSHINE_HAS_ASM_CONTEXT
+
+extern "C" {
+// 保存当前寄存器到当前栈上，栈指针写入 *from_sp，然后切换到 to_sp 表示的上下文
+void sunshine_ctx_swap(void **from_sp, void *to_sp);
+}
+
+namespace sunshine {
+
+// 在 [stack, stack + size) 上构造初始上下文：第一次切换进去时调用 fn(arg)
+// fn 不能返回（协程结束时必须主动切走）
+// 返回值：可以传给 sunshine_ctx_swap 的栈指针
+void *MakeContext(void *stack, size_t size, void (*fn)(uintptr_t), uintptr_t arg);
+
+} // namespace sunshine
+
+#endif
@@ -0,0 +1,113 @@
+// file: libs/dns_resolver.h
+#pragma once
+
+#include "libs/address.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace sunshine {
+
+// DnsResolver：带缓存、不阻塞工作线程的域名解析（Address::Lookup 的实现）
+// - 缓存按 (host, family, type, protocol) 分片，每个分片一把锁；命中时只是一次哈希查找加一次 shared_ptr 拷贝
+// - 解析成功的结果缓存 dns.cache_ttl_ms，域名不存在（EAI_NONAME / EAI_NODATA）缓存 dns.negative_ttl_ms；
+//   getaddrinfo 不返回记录的 TTL，因此两者都是配置值
+// - 过期的成功结果先照常返回，同时在后台刷新（同一 key 只有一个刷新在进行），热路径不会因为过期而等待
+// - 未命中时把 getaddrinfo 交给 dns.threads 个解析线程执行：调用方在协程里时挂起协程，
+//   结果出来后重新调度；不在协程里时在条件变量上等待。同一 key 的并发未命中共用一次查询
+// - 数值地址（IPv4 / IPv6 字面量）不进缓存，直接同步解析
+class DnsResolver {
+public:
+    typedef std::shared_ptr<const std::vector<Address::ptr>> Addrs;
+
+    static DnsResolver &GetInstance();
+
+    // 解析 host（格式同 Address::Lookup），失败或无结果时返回空指针
+    Addrs resolve(const std::string &host, int family = AF_INET, int type = 0, int protocol = 0);
+
+    // 清空缓存（进行中的查询不受影响）
+    void clear();
+
+    uint64_t getHits() const {
+        return m_hits.load(std::memory_order_relaxed);
+    }
+    uint64_t getMisses() const {
+        return m_misses.load(std::memory_order_relaxed);
+    }
+
+private:
+    DnsResolver() = default;
+
+    struct Key {
+        std::string host;
+        int family;
+        int type;
+        int protocol;
+    };
+    struct KeyView {
+        std::string_view host;
+        int family;
+        int type;
+        int protocol;
+    };
+    struct KeyHash {
+        using is_transparent = void;
+        size_t operator()(const KeyView &k) const;
+        size_t operator()(const Key &k) const {
+            return (*this)(KeyView{k.host, k.family, k.type, k.protocol});
+        }
+    };
+    struct KeyEqual {
+        using is_transparent = void;
+        template <class A, class B>
+        bool operator()(const A &a, const B &b) const {
+            return a.family == b.family && a.type == b.type && a.protocol == b.protocol &&
+                   std::string_view(a.host) == std::string_view(b.host);
+        }
+    };
+
+    // 一次进行中的 getaddrinfo；等待者是挂起的协程或条件变量上的线程
+    struct Query;
+    typedef std::shared_ptr<Query> QueryPtr;
+
+    struct Entry {
+        Addrs addrs;         // 为空表示负缓存
+        uint64_t expire = 0; // CLOCK_MONOTONIC_COARSE 毫秒
+        QueryPtr query;      // 进行中的查询（未命中或后台刷新）
+    };
+
+    static constexpr size_t SHARD_COUNT = 16;
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::unordered_map<Key, Entry, KeyHash, KeyEqual> map;
+    };
+
+    Shard &shardOf(size_t hash) {
+        return m_shards[hash % SHARD_COUNT];
+    }
+    void submit(const QueryPtr &query);
+    void work();
+    void complete(const QueryPtr &query, int error, Addrs addrs);
+    Addrs wait(const QueryPtr &query);
+
+private:
+    Shard m_shards[SHARD_COUNT];
+
+    std::mutex m_mutex; // 保护查询队列与解析线程
+    std::condition_variable m_cond;
+    std::deque<QueryPtr> m_queue;
+    size_t m_threadCount = 0; // 已启动的解析线程（detach，不回收）
+
+    std::atomic<uint64_t> m_hits{0};
+    std::atomic<uint64_t> m_misses{0};
+};
+
+} // namespace sunshine
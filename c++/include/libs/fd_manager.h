@@ -0,0 +1,94 @@
+// file: libs/fd_manager.h
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <shared_mutex>
+#include <vector>
+#include <cstdint>
+
+namespace sunshine {
+
+// 文件描述符上下文：记录 hook 需要的 fd 属性
+// - 是否为 socket、系统层是否已设为非阻塞、用户是否主动设置了非阻塞
+// - SO_RCVTIMEO / SO_SNDTIMEO 超时（毫秒，-1 表示不超时）
+class FdCtx : public std::enable_shared_from_this<FdCtx> {
+public:
+    using ptr = std::shared_ptr<FdCtx>;
+
+    FdCtx(int fd);
+    ~FdCtx();
+
+    bool isInit() const {
+        return m_isInit;
+    }
+    bool isSocket() const {
+        return m_isSocket;
+    }
+    bool isClose() const {
+        return m_isClosed.load(std::memory_order_acquire);
+    }
+    // close 在唤醒等待者之前标记：被唤醒的协程不再对这个 fd 号重试（它可能还没关闭，或已经被复用）
+    void setClose() {
+        m_isClosed.store(true, std::memory_order_release);
+    }
+
+    // 用户层面的非阻塞标记（用户主动 fcntl(O_NONBLOCK) 时不再替用户等待）
+    void setUserNonblock(bool v) {
+        m_userNonblock = v;
+    }
+    bool getUserNonblock() const {
+        return m_userNonblock;
+    }
+
+    // 系统层面的非阻塞标记（hook 为 socket 统一设置 O_NONBLOCK）
+    void setSysNonblock(bool v) {
+        m_sysNonblock = v;
+    }
+    bool getSysNonblock() const {
+        return m_sysNonblock;
+    }
+
+    // type: SO_RCVTIMEO / SO_SNDTIMEO
+    void setTimeout(int type, uint64_t v);
+    uint64_t getTimeout(int type) const;
+
+private:
+    bool init();
+
+private:
+    bool m_isInit = false;
+    bool m_isSocket = false;
+    bool m_sysNonblock = false;
+    bool m_userNonblock = false;
+    std::atomic<bool> m_isClosed{false};
+    int m_fd;
+    uint64_t m_recvTimeout = (uint64_t)-1;
+    uint64_t m_sendTimeout = (uint64_t)-1;
+};
+
+// fd 上下文管理器（全局单例）
+class FdManager {
+public:
+    static FdManager &GetInstance();
+
+    // 获取 fd 上下文；auto_create=true 时不存在则创建
+    FdCtx::ptr get(int fd, bool auto_create = false);
+    // 删除 fd 上下文，并重置所有 IOManager 里这个 fd 号的状态（唤醒等待者、撤销 reactor 绑定 / 持久注册 / io_uring 状态）
+    // - hook 的 close 在 close_f 之前调用
+    // - 拿到新 fd 时（socket / accept 的 hook、tcp_server 的监听 socket、reuseport）先调用一次：
+    //   旧 fd 可能是被 close_f 直接关闭的，没有经过这里，编号复用后旧状态会让新 socket 收不到就绪事件
+    void del(int fd);
+    // 为刚拿到的 fd 换上新的上下文并返回（旧的标记为关闭）：只取一次写锁，不经过 IOManager
+    // - 用于 tcp_server 的 accept 热路径：新 fd 上不会有等待者；连接都经 close 的 hook（del）关闭，
+    //   IOManager 里这个编号的状态已经重置
+    FdCtx::ptr reset(int fd);
+
+private:
+    FdManager();
+
+    mutable std::shared_mutex m_mutex;
+    std::vector<FdCtx::ptr> m_datas;
+};
+
+} // namespace sunshine
@@ -5,8 +5,21 @@
 #include <memory>
 #include <sys/ucontext.h>
 #include <ucontext.h>
+#include "libs/context.h"
+#include "libs/task.h"
 #include <functional>
 #include <cstdint>
+#include <atomic>
+#include <thread>
+
+// 上下文切换后端：构建选项 SUNSHINE_FIBER_CONTEXT=asm 时由 CMake 定义为 1
+// （只保存 callee-saved 寄存器，不触发 rt_sigprocmask），否则使用 ucontext
+#ifndef SUNSHINE_FIBER_ASM_CONTEXT
+#define SUNSHINE_FIBER_ASM_CONTEXT 0
+#endif
+#if SUNSHINE_FIBER_ASM_CONTEXT && !SUNSHINE_HAS_ASM_CONTEXT
+#error "asm fiber context is not supported on this architecture"
+#endif
 
 namespace sunshine {
 
@@ -21,12 +34,13 @@ public:
         READY // 就绪（可以被调度运行）
     };
 
-    // 创建一个新协程，传入回调和可选的栈大小
-    Fiber(std::function<void()> cb, size_t stacksize = 0);
+    // 创建一个新协程，传入回调和可选的栈大小（0 表示使用 fiber.stack_size）
+    // fiber.shared_stack 开启时协程运行在线程共享栈上，stacksize 被忽略
+    Fiber(Task cb, size_t stacksize = 0);
     ~Fiber();
 
     // 重置协程（只可用于已经结束的协程，或未使用的协程）
-    void reset(std::function<void()> cb);
+    void reset(Task cb);
     // 将当前线程切换到此协程（进入协程执行）
     void swapIn();
     // 将当前协程切回主协程/调度者（保存当前协程上下文并切换）
@@ -40,12 +54,25 @@ public:
     static void YieldToHold();
     // 返回当前线程创建的协程总数
     static uint64_t TotalFibers();
+    // 当前是否运行在线程的主协程上（不能在主协程上 YieldToHold）
+    static bool IsMainFiber();
 
     // 获取状态（调试用）
     State getState() const {
         return m_state;
     }
 
+    // 是否运行在线程共享栈上
+    bool isSharedStack() const {
+        return m_sharedStack;
+    }
+
+    // 共享栈协程绑定的线程（第一次运行的线程，之后只能在该线程恢复）；
+    // 独立栈协程返回空 id
+    std::thread::id getBoundThread() const {
+        return m_boundThread;
+    }
+
 private:
     // 私有默认构造，用于创建主协程（代表线程本身的上下文）
     Fiber();
@@ -53,13 +80,37 @@ private:
     // 协程运行的入口函数（makecontext 指向的静态函数）
     static void MainFunc(uintptr_t);
 
+    // 在 [stack, stack + size) 上建立协程入口上下文
+    void initContext(void *stack, size_t size);
+    // 保存当前上下文到 this，切换到 to 的上下文
+    void switchTo(Fiber *to);
+    // 共享栈：切入前把保存的栈内容拷回线程共享栈（首次运行时绑定线程并建立上下文）
+    void restoreSharedStack();
+    // 共享栈：切出后把共享栈上正在使用的部分拷贝到 m_saved
+    void saveSharedStack();
+
 private:
     uint64_t m_id = 0;          // 协程 id
     uint64_t m_stacksize = 0;   // 协程栈大小
+#if SUNSHINE_FIBER_ASM_CONTEXT
+    void *m_sp = nullptr;       // 协程上下文（保存的寄存器帧所在的栈指针）
+#else
     ucontext_t m_ctx;           // 协程上下文
+#endif
     State m_state = INIT;       // 当前状态
     void *m_stack = nullptr;    // 协程栈起始地址（向低地址增长）
-    std::function<void()> m_cb; // 协程运行的函数入口
+    Task m_cb;                  // 协程运行的函数入口
+    // 是否有线程正在运行（或正在切出）该协程；防止协程刚挂起就被其他线程唤醒时，
+    // 在原线程保存完上下文之前被切入
+    std::atomic<bool> m_running{false};
+
+    // 共享栈模式
+    bool m_sharedStack = false;     // 是否运行在线程共享栈上
+    std::thread::id m_boundThread;  // 绑定的线程
+    char *m_savedSp = nullptr;      // 切出时的栈顶位置（共享栈内的地址）
+    char *m_saved = nullptr;        // 切出后保存的栈内容
+    size_t m_savedSize = 0;         // 保存的字节数
+    size_t m_savedCap = 0;          // m_saved 的容量
 };
 
 } // namespace sunshine
@@ -0,0 +1,314 @@
+// file: libs/fiber_sync.h
+#pragma once
+
+// 协程同步原语：竞争时挂起的是协程而不是线程
+// - 等待者登记后 YieldToHold 让出，唤醒方通过 Scheduler::scheduler 把它重新放回运行队列，
+//   工作线程在此期间继续执行其他协程，不会睡在内核里
+// - 不在协程里（没有调度器，或运行在线程主协程上）调用时退化为线程阻塞，与 DnsResolver::wait 相同
+// - 未竞争时只有一次原子操作，登记 / 唤醒等待者的慢路径才加锁
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "libs/circular_buffer.h"
+#include "libs/fiber.h"
+#include "libs/ringqueue.h"
+#include "libs/scheduler.h"
+
+namespace sunshine {
+
+// 等待者队列：各同步原语共用的慢路径（调用方用自己的 std::mutex 保护，下文称 lk）
+// 等待方：lk 内 prepare() 登记 -> 重试一次快路径 -> 成功则 cancel()，失败则 park(lk) 挂起
+// 唤醒方：改完状态后 hasWaiters() 为真才加锁 dequeue()，解锁后再 Wake()
+// prepare / hasWaiters 里的 fence 配对：要么唤醒方看到登记，要么等待方的重试看到新状态
+class FiberWaitQueue {
+public:
+    // 一个等待者：协程（sched + fiber），或者阻塞在 m_threadCond 上的线程（done）
+    struct Waiter {
+        Scheduler *sched = nullptr;
+        Fiber::ptr fiber;
+        bool *done = nullptr;
+    };
+
+    FiberWaitQueue() :
+        m_waiters(4) {
+    }
+
+    FiberWaitQueue(const FiberWaitQueue &) = delete;
+    FiberWaitQueue &operator=(const FiberWaitQueue &) = delete;
+
+    // 登记一个即将挂起的等待者（持有 lk）
+    void prepare() {
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+    // 登记后重试成功，撤销登记（持有 lk）
+    void cancel() {
+        m_count.fetch_sub(1, std::memory_order_relaxed);
+    }
+    // 是否有登记的等待者（不需要持有 lk）
+    bool hasWaiters() const {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return m_count.load(std::memory_order_relaxed) > 0;
+    }
+
+    // 把当前协程（不在协程里时为当前线程）排到队尾，释放 lk 并挂起，被唤醒后返回（返回时不持有 lk）
+    void park(std::unique_lock<std::mutex> &lk);
+
+    // 取出最早的等待者（持有 lk），队列为空返回 false
+    // 线程等待者在这里（锁内）就被唤醒，out 为空；协程等待者由调用方解锁后 Wake(out)
+    bool dequeue(Waiter &out);
+    // 取出最多 n 个等待者追加到 out，返回取出的个数（持有 lk）
+    size_t dequeue(std::vector<Waiter> &out, size_t n = SIZE_MAX);
+
+    // 重新调度取出的协程（不需要持有 lk，也不再访问队列本身：被唤醒的协程可能已经销毁了同步对象）
+    static void Wake(Waiter &w) {
+        if (w.fiber) w.sched->scheduler(std::move(w.fiber));
+    }
+
+private:
+    CircularBuffer<Waiter> m_waiters;
+    std::atomic<size_t> m_count{0};       // 已登记（排队中或即将排队）的等待者数
+    std::condition_variable m_threadCond; // 线程等待者（不在协程里）阻塞在这里
+};
+
+// FiberMutex：协程互斥锁，满足 Lockable，可以配合 std::lock_guard / std::unique_lock 使用
+// 状态 0 = 未加锁，1 = 已加锁，2 = 已加锁且可能有等待者：
+// lock 的快路径是一次 CAS(0 -> 1)，unlock 是一次 exchange(0)，只有原值为 2 时才进慢路径唤醒
+// 被唤醒的等待者与新来的加锁者公平竞争（不直接移交），不是 FIFO
+class FiberMutex {
+public:
+    FiberMutex() = default;
+    FiberMutex(const FiberMutex &) = delete;
+    FiberMutex &operator=(const FiberMutex &) = delete;
+
+    void lock() {
+        uint32_t expected = UNLOCKED;
+        if (m_state.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire,
+                                            std::memory_order_relaxed)) {
+            return;
+        }
+        lockSlow();
+    }
+
+    bool try_lock() {
+        uint32_t expected = UNLOCKED;
+        return m_state.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire,
+                                               std::memory_order_relaxed);
+    }
+
+    void unlock() {
+        if (m_state.exchange(UNLOCKED, std::memory_order_release) == CONTENDED) unlockSlow();
+    }
+
+private:
+    void lockSlow();
+    void unlockSlow();
+
+private:
+    static constexpr uint32_t UNLOCKED = 0;
+    static constexpr uint32_t LOCKED = 1;
+    static constexpr uint32_t CONTENDED = 2;
+
+    std::atomic<uint32_t> m_state{UNLOCKED};
+    std::mutex m_mutex; // 保护 m_waiters
+    FiberWaitQueue m_waiters;
+};
+
+// FiberCondVar：配合 FiberMutex 的条件变量（语义同 std::condition_variable，等待前后都持有锁）
+// 没有等待者时 notify_one / notify_all 只读一次计数
+class FiberCondVar {
+public:
+    FiberCondVar() = default;
+    FiberCondVar(const FiberCondVar &) = delete;
+    FiberCondVar &operator=(const FiberCondVar &) = delete;
+
+    // 释放 lock 并挂起，被 notify 后重新加锁返回
+    void wait(std::unique_lock<FiberMutex> &lock);
+
+    template <class Predicate>
+    void wait(std::unique_lock<FiberMutex> &lock, Predicate pred) {
+        while (!pred()) wait(lock);
+    }
+
+    void notify_one();
+    void notify_all();
+
+private:
+    std::mutex m_mutex; // 保护 m_waiters
+    FiberWaitQueue m_waiters;
+};
+
+// FiberSemaphore：计数信号量
+// wait 的快路径是一次 CAS（计数 > 0 时减一），post 是一次 fetch_add，有等待者时才加锁唤醒
+class FiberSemaphore {
+public:
+    explicit FiberSemaphore(size_t initial = 0) :
+        m_count(static_cast<int64_t>(initial)) {
+    }
+    FiberSemaphore(const FiberSemaphore &) = delete;
+    FiberSemaphore &operator=(const FiberSemaphore &) = delete;
+
+    // 计数为 0 时挂起，直到 post
+    void wait() {
+        if (!tryWait()) waitSlow();
+    }
+
+    // 不挂起：计数 > 0 时减一并返回 true
+    bool tryWait() {
+        int64_t c = m_count.load(std::memory_order_relaxed);
+        while (c > 0) {
+            if (m_count.compare_exchange_weak(c, c - 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 计数加 n，唤醒最多 n 个等待者
+    void post(size_t n = 1) {
+        m_count.fetch_add(static_cast<int64_t>(n), std::memory_order_release);
+        if (m_waiters.hasWaiters()) postSlow(n);
+    }
+
+    // 当前计数（并发下仅作参考）
+    size_t getCount() const {
+        return static_cast<size_t>(m_count.load(std::memory_order_relaxed));
+    }
+
+private:
+    void waitSlow();
+    void postSlow(size_t n);
+
+private:
+    std::atomic<int64_t> m_count;
+    std::mutex m_mutex; // 保护 m_waiters
+    FiberWaitQueue m_waiters;
+};
+
+// Channel：有界的多生产者多消费者通道
+// - 缓冲区是 RingQueue（无锁，容量向上取整为 2 的幂，至少 2），未满 / 非空时 send / recv 不加锁，
+//   之后各读一次对方的等待计数决定是否唤醒
+// - 满时 send 挂起，空时 recv 挂起；close 之后 send 返回 false，recv 取完剩余元素后返回 false
+// - close 与 send 并发时，close 之前已经通过检查的 send 仍可能成功
+// - T 需要可默认构造、可移动赋值（RingQueue 的要求）
+template <class T>
+class Channel {
+public:
+    typedef std::shared_ptr<Channel> ptr;
+
+    explicit Channel(size_t capacity) :
+        m_queue(capacity) {
+    }
+    Channel(const Channel &) = delete;
+    Channel &operator=(const Channel &) = delete;
+
+    // 放入一个元素，通道满时挂起；已关闭返回 false
+    bool send(T v) {
+        for (;;) {
+            if (m_closed.load(std::memory_order_acquire)) return false;
+            if (m_queue.push(std::move(v))) {
+                wakeOne(m_receivers);
+                return true;
+            }
+            std::unique_lock<std::mutex> lk(m_mutex);
+            m_senders.prepare();
+            if (m_closed.load(std::memory_order_relaxed)) {
+                m_senders.cancel();
+                return false;
+            }
+            if (m_queue.push(std::move(v))) {
+                m_senders.cancel();
+                lk.unlock();
+                wakeOne(m_receivers);
+                return true;
+            }
+            m_senders.park(lk);
+        }
+    }
+
+    // 不挂起：放入成功返回 true（满或已关闭时 v 保持不变）
+    bool trySend(T &v) {
+        if (m_closed.load(std::memory_order_acquire) || !m_queue.push(std::move(v))) return false;
+        wakeOne(m_receivers);
+        return true;
+    }
+
+    // 取出一个元素，通道空时挂起；已关闭且取空时返回 false
+    bool recv(T &out) {
+        for (;;) {
+            if (m_queue.pop(out)) {
+                wakeOne(m_senders);
+                return true;
+            }
+            std::unique_lock<std::mutex> lk(m_mutex);
+            m_receivers.prepare();
+            if (m_queue.pop(out)) {
+                m_receivers.cancel();
+                lk.unlock();
+                wakeOne(m_senders);
+                return true;
+            }
+            if (m_closed.load(std::memory_order_relaxed)) {
+                m_receivers.cancel();
+                return false;
+            }
+            m_receivers.park(lk);
+        }
+    }
+
+    // 不挂起：取到返回 true
+    bool tryRecv(T &out) {
+        if (!m_queue.pop(out)) return false;
+        wakeOne(m_senders);
+        return true;
+    }
+
+    // 关闭通道并唤醒所有等待者（重复关闭无效果）
+    void close() {
+        if (m_closed.exchange(true)) return;
+        std::vector<FiberWaitQueue::Waiter> woken;
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_senders.dequeue(woken);
+            m_receivers.dequeue(woken);
+        }
+        for (auto &w : woken) FiberWaitQueue::Wake(w);
+    }
+
+    bool isClosed() const {
+        return m_closed.load(std::memory_order_acquire);
+    }
+
+    // 缓冲区中的元素数（并发下仅作参考）
+    size_t size() const {
+        return m_queue.sizeApprox();
+    }
+
+    size_t capacity() const {
+        return m_queue.capacity();
+    }
+
+private:
+    // 对方有等待者时唤醒一个：被唤醒者重新尝试，失败会再次登记挂起
+    void wakeOne(FiberWaitQueue &q) {
+        if (!q.hasWaiters()) return;
+        FiberWaitQueue::Waiter w;
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            if (!q.dequeue(w)) return;
+        }
+        FiberWaitQueue::Wake(w);
+    }
+
+private:
+    RingQueue<T> m_queue;
+    std::atomic<bool> m_closed{false};
+    std::mutex m_mutex; // 保护 m_senders / m_receivers
+    FiberWaitQueue m_senders;
+    FiberWaitQueue m_receivers;
+};
+
+} // namespace sunshine
@@ -0,0 +1,205 @@
+// file: libs/http.h
+#pragma once
+
+// HTTP/1.1 报文类型
+// - HttpRequest / HttpResponseView 由解析器填充：起始行与头部字段都是 string_view，
+//   指向接收缓冲区（ByteArray 的块）或解析器的拼接区，不拷贝；包体是共享块内存的 ByteSlice。
+//   视图在解析器 reset 之前、且接收缓冲区没有 clear 之前有效
+// - HttpResponse 是服务端构造响应用的，自己持有字符串；reset 后复用已有的容量
+#include "libs/bytearray.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace sunshine {
+
+enum class HttpMethod : uint8_t {
+    GET,
+    HEAD,
+    POST,
+    PUT,
+    DELETE,
+    CONNECT,
+    OPTIONS,
+    TRACE,
+    PATCH,
+    INVALID
+};
+
+// 方法名（区分大小写，RFC 9110）；未知方法返回 INVALID
+HttpMethod StringToHttpMethod(std::string_view m);
+const char *HttpMethodToString(HttpMethod m);
+
+// 常用状态码的原因短语，未知状态码返回 "Unknown"
+const char *HttpStatusReason(uint16_t status);
+
+// 不区分大小写的 ASCII 比较（头部字段名、Connection 等 token）
+bool HttpEqualsIgnoreCase(std::string_view a, std::string_view b);
+// 逗号分隔的 token 列表（如 Connection: keep-alive, Upgrade）里是否含有 token
+bool HttpHasToken(std::string_view list, std::string_view token);
+
+struct HttpHeader {
+    std::string_view name;
+    std::string_view value;
+};
+
+// 请求与响应共有的部分
+class HttpMessage {
+public:
+    // 0x10 = HTTP/1.0，0x11 = HTTP/1.1
+    uint8_t getVersion() const {
+        return m_version;
+    }
+    const std::vector<HttpHeader> &getHeaders() const {
+        return m_headers;
+    }
+    // 按字段名（不区分大小写）取第一个值，不存在时返回空视图
+    std::string_view getHeader(std::string_view name) const;
+    bool hasHeader(std::string_view name) const;
+
+    const ByteSlice &getBody() const {
+        return m_body;
+    }
+    // 包体拷贝成 string（小包体、调试用）
+    std::string getBodyString() const {
+        return m_body.toString();
+    }
+
+    // 按版本默认值与 Connection 头计算出的连接是否保持
+    bool isKeepAlive() const {
+        return m_keepAlive;
+    }
+    bool isChunked() const {
+        return m_chunked;
+    }
+    // Content-Length（没有时为 -1）
+    int64_t getContentLength() const {
+        return m_contentLength;
+    }
+
+    // 清空内容，保留头部数组的容量
+    void reset();
+
+protected:
+    friend class HttpParser;
+
+    uint8_t m_version = 0x11;
+    bool m_keepAlive = true;
+    bool m_chunked = false;
+    int64_t m_contentLength = -1;
+    std::vector<HttpHeader> m_headers;
+    ByteSlice m_body;
+};
+
+class HttpRequest : public HttpMessage {
+public:
+    HttpMethod getMethod() const {
+        return m_method;
+    }
+    std::string_view getMethodString() const {
+        return m_methodString;
+    }
+    // 原始的 request-target，以及从中切出来的 path / query / fragment（不含 '?' / '#'）
+    std::string_view getTarget() const {
+        return m_target;
+    }
+    std::string_view getPath() const {
+        return m_path;
+    }
+    std::string_view getQuery() const {
+        return m_query;
+    }
+    std::string_view getFragment() const {
+        return m_fragment;
+    }
+
+    void reset();
+
+private:
+    friend class HttpParser;
+
+    HttpMethod m_method = HttpMethod::INVALID;
+    std::string_view m_methodString;
+    std::string_view m_target;
+    std::string_view m_path;
+    std::string_view m_query;
+    std::string_view m_fragment;
+};
+
+// 解析出来的响应（客户端 / 基准程序用）
+class HttpResponseView : public HttpMessage {
+public:
+    uint16_t getStatus() const {
+        return m_status;
+    }
+    std::string_view getReason() const {
+        return m_reason;
+    }
+
+    void reset();
+
+private:
+    friend class HttpParser;
+
+    uint16_t m_status = 0;
+    std::string_view m_reason;
+};
+
+// 服务端构造的响应
+class HttpResponse {
+public:
+    uint16_t getStatus() const {
+        return m_status;
+    }
+    void setStatus(uint16_t v) {
+        m_status = v;
+    }
+    // 为空时使用 HttpStatusReason(status)
+    void setReason(std::string_view v) {
+        m_reason.assign(v);
+    }
+
+    // 追加一个头部字段（同名字段可以有多个）；Content-Length / Connection / Date 由 dump 生成，不要设置
+    void addHeader(std::string_view name, std::string_view value);
+    // 替换第一个同名字段，不存在时追加
+    void setHeader(std::string_view name, std::string_view value);
+    std::string_view getHeader(std::string_view name) const;
+
+    void setBody(std::string_view v) {
+        m_body.assign(v);
+    }
+    void appendBody(std::string_view v) {
+        m_body.append(v);
+    }
+    const std::string &getBody() const {
+        return m_body;
+    }
+
+    bool isKeepAlive() const {
+        return m_keepAlive;
+    }
+    void setKeepAlive(bool v) {
+        m_keepAlive = v;
+    }
+
+    // 把状态行、头部、Content-Length / Connection / Date 和包体写入 out
+    // version 为请求的版本（HTTP/1.0 保持连接时需要显式的 Connection: keep-alive）；
+    // with_body 为 false 时（HEAD 请求）只写 Content-Length 不写包体
+    void dump(ByteArray &out, uint8_t version = 0x11, bool with_body = true) const;
+
+    // 清空内容，已有字段的字符串与包体保留容量供下一个响应复用
+    void reset();
+
+private:
+    uint16_t m_status = 200;
+    bool m_keepAlive = true;
+    std::string m_reason;
+    std::vector<std::pair<std::string, std::string>> m_headers;
+    size_t m_headerCount = 0; // m_headers 中有效的个数，其余是留着复用的
+    std::string m_body;
+};
+
+} // namespace sunshine
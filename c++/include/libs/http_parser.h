@@ -0,0 +1,147 @@
+// file: libs/http_parser.h
+#pragma once
+
+// 增量式 HTTP/1.1 解析器（手写状态机），直接在 ByteArray 的块上解析
+// - execute 从 ByteArray 的 position 开始解析可读数据，position 前移已消费的字节；
+//   数据不完整时返回 NEED_MORE，之后追加数据再次调用即可从断点继续（状态不会回退重扫）
+// - 起始行与头部字段是指向块内存的 string_view；跨块的 token 拼接到解析器的拼接区，
+//   拼接区按 http.max_header_size 一次性预留，之后不再扩容，视图地址保持不变
+// - 包体（Content-Length / chunked）用 ByteArray::readSlice 切成共享块的 ByteSlice，不拷贝
+// - 一条报文解析完返回 DONE 并停在报文末尾，同一缓冲区里后面的数据（pipelining）留给下一次 execute；
+//   处理完报文后调用 reset 开始下一条
+// - 视图指向的内存在 reset 之前、且 ByteArray 没有 clear 之前有效；ByteArray 只在末尾追加写入时视图不受影响
+// 拒绝的报文：头部超过 http.max_header_size（431）、包体超过 http.max_body_size（413）、
+// 同时带 Content-Length 与 Transfer-Encoding 或 Content-Length 不一致（400）、非 chunked 的传输编码（501）
+#include "libs/bytearray.h"
+#include "libs/http.h"
+
+#include <cstdint>
+#include <string>
+#include <sys/uio.h>
+#include <vector>
+
+namespace sunshine {
+
+class HttpParser {
+public:
+    enum Result {
+        NEED_MORE, // 数据不完整
+        DONE,      // 一条报文解析完毕
+        ERROR      // 报文非法，getError() 为建议回复的状态码
+    };
+
+    // 请求解析器的 execute 填充 getRequest()，响应解析器填充 getResponse()
+    enum Type { REQUEST, RESPONSE };
+
+    explicit HttpParser(Type type = REQUEST);
+
+    Result execute(ByteArray &ba);
+    // 响应没有 Content-Length 也不是 chunked 时，包体直到连接关闭为止：读到 EOF 后调用，返回是否得到完整报文
+    bool finishOnEof();
+    // 响应解析：对应的请求是 HEAD 或状态码为 1xx / 204 / 304 时没有包体，HEAD 请求需要事先告知
+    void setHeadResponse(bool v) {
+        m_headResponse = v;
+    }
+
+    void reset();
+
+    // 当前报文还没有开始（没有视图指向接收缓冲区，可以安全地整理 / 清空它）
+    bool isIdle() const {
+        return m_state == S_START;
+    }
+    uint16_t getError() const {
+        return m_error;
+    }
+
+    const HttpRequest &getRequest() const {
+        return m_request;
+    }
+    const HttpResponseView &getResponse() const {
+        return m_response;
+    }
+
+private:
+    enum State {
+        S_START,        // 报文开始前（允许跳过空行）
+        S_METHOD,       // 请求：方法
+        S_TARGET,       // 请求：request-target
+        S_REQ_VERSION,  // 请求：HTTP/x.y
+        S_RSP_VERSION,  // 响应：HTTP/x.y
+        S_RSP_STATUS,   // 响应：三位状态码
+        S_RSP_REASON,   // 响应：原因短语
+        S_LINE_LF,      // 起始行 CR 之后等待 LF
+        S_HEADER_START, // 头部行开始（或空行结束头部）
+        S_HEADER_NAME,
+        S_HEADER_OWS,   // 冒号后的空白
+        S_HEADER_VALUE,
+        S_HEADER_LF,    // 头部行 CR 之后等待 LF
+        S_HEADERS_LF,   // 空行 CR 之后等待 LF
+        S_BODY,         // Content-Length 包体
+        S_BODY_EOF,     // 直到连接关闭的响应包体
+        S_CHUNK_SIZE,
+        S_CHUNK_EXT,    // chunk 扩展（忽略）
+        S_CHUNK_SIZE_LF,
+        S_CHUNK_DATA,
+        S_CHUNK_DATA_CR,
+        S_CHUNK_DATA_LF,
+        S_TRAILER_START, // 尾部字段行开始（忽略内容）
+        S_TRAILER_LINE,
+        S_TRAILER_LINE_LF,
+        S_TRAILER_LF,    // 结束空行 CR 之后等待 LF
+        S_DONE,
+        S_ERROR
+    };
+
+    HttpMessage &message() {
+        return m_type == REQUEST ? static_cast<HttpMessage &>(m_request) : m_response;
+    }
+    // 在一段连续内存上推进状态机，返回消费的字节数；进入包体数据 / 完成 / 出错时提前返回
+    size_t run(const char *begin, const char *end);
+    // 当前 token 的处理：open 记录起点，close 返回完整视图（跨块时拼接到 m_spill）
+    void openToken(const char *p) {
+        m_tokOpen = true;
+        m_tokBegin = p;
+        m_tokSpilled = false;
+    }
+    bool spillToken(const char *end);
+    std::string_view closeToken(const char *p);
+
+    bool onStartLine();
+    bool onHeader(std::string_view value);
+    void onHeadersComplete(const char *p);
+    void onMessageComplete();
+    void appendBody(ByteSlice &&slice);
+    void fail(uint16_t status) {
+        m_state = S_ERROR;
+        m_error = status;
+    }
+
+private:
+    Type m_type;
+    State m_state = S_START;
+    uint16_t m_error = 0;
+    bool m_headResponse = false;
+
+    size_t m_headerBytes = 0; // 当前报文起始行 + 头部已消费的字节数
+    size_t m_maxHeader;
+    uint64_t m_maxBody;
+    uint64_t m_remaining = 0; // 当前包体 / chunk 还差的字节数
+    uint64_t m_bodyBytes = 0;
+
+    bool m_tokOpen = false;
+    bool m_tokSpilled = false;
+    const char *m_tokBegin = nullptr;
+    size_t m_spillBegin = 0;
+    std::string m_spill; // 跨块 token 的拼接区（容量固定为 m_maxHeader）
+
+    const char *m_mark = nullptr; // 本段内头部阶段的起点（统计 m_headerBytes 用）
+    std::string_view m_field;     // 刚解析出的头部字段名
+    std::string_view m_version;   // 起始行里的版本
+    uint32_t m_digits = 0;        // 状态码 / chunk 大小已读的位数
+
+    std::vector<iovec> m_iov;
+    HttpRequest m_request;
+    HttpResponseView m_response;
+};
+
+} // namespace sunshine
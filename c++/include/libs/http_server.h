@@ -0,0 +1,130 @@
+// file: libs/http_server.h
+#pragma once
+
+#include "libs/http.h"
+#include "libs/http_parser.h"
+#include "libs/tcp_server.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace sunshine {
+
+// Servlet：处理一个请求，填写响应；在连接协程里调用，可以阻塞（hook 让出协程）
+class Servlet {
+public:
+    typedef std::shared_ptr<Servlet> ptr;
+
+    explicit Servlet(const std::string &name) :
+        m_name(name) {
+    }
+    virtual ~Servlet() = default;
+
+    virtual void handle(const HttpRequest &req, HttpResponse &rsp, const Socket::ptr &conn) = 0;
+
+    const std::string &getName() const {
+        return m_name;
+    }
+
+private:
+    std::string m_name;
+};
+
+class FunctionServlet : public Servlet {
+public:
+    typedef std::function<void(const HttpRequest &req, HttpResponse &rsp, const Socket::ptr &conn)> Callback;
+
+    explicit FunctionServlet(Callback cb) :
+        Servlet("FunctionServlet"), m_cb(std::move(cb)) {
+    }
+    void handle(const HttpRequest &req, HttpResponse &rsp, const Socket::ptr &conn) override {
+        m_cb(req, rsp, conn);
+    }
+
+private:
+    Callback m_cb;
+};
+
+class NotFoundServlet : public Servlet {
+public:
+    NotFoundServlet() :
+        Servlet("NotFoundServlet") {
+    }
+    void handle(const HttpRequest &req, HttpResponse &rsp, const Socket::ptr &conn) override;
+};
+
+// ServletDispatch：按 path 分发
+// - 精确匹配优先（哈希表，按 string_view 查找不构造 string），其次按注册顺序做 fnmatch 模糊匹配，
+//   都没有命中时交给默认 servlet（404）
+// - 分发表在请求路径上不加锁：需要在 HttpServer::start 之前注册完
+class ServletDispatch : public Servlet {
+public:
+    typedef std::shared_ptr<ServletDispatch> ptr;
+
+    ServletDispatch();
+    void handle(const HttpRequest &req, HttpResponse &rsp, const Socket::ptr &conn) override;
+
+    void addServlet(const std::string &uri, Servlet::ptr servlet);
+    void addServlet(const std::string &uri, FunctionServlet::Callback cb);
+    // uri 为 fnmatch 模式，例如 "/static/*"
+    void addGlobServlet(const std::string &uri, Servlet::ptr servlet);
+    void addGlobServlet(const std::string &uri, FunctionServlet::Callback cb);
+    void delServlet(const std::string &uri);
+    void delGlobServlet(const std::string &uri);
+
+    void setDefault(Servlet::ptr v) {
+        m_default = std::move(v);
+    }
+    const Servlet::ptr &getDefault() const {
+        return m_default;
+    }
+
+    Servlet::ptr getMatchedServlet(std::string_view path) const;
+
+private:
+    struct StringHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view s) const {
+            return std::hash<std::string_view>()(s);
+        }
+    };
+
+    std::unordered_map<std::string, Servlet::ptr, StringHash, std::equal_to<>> m_datas;
+    std::vector<std::pair<std::string, Servlet::ptr>> m_globs;
+    Servlet::ptr m_default;
+};
+
+// HttpServer：TcpServer 上的 HTTP/1.1 服务器
+// - 每个连接一个协程：读到的数据追加到接收 ByteArray，解析器从上次停下的位置继续解析
+// - pipelining：一次读到的多个完整请求依次处理，响应写进同一个发送 ByteArray，最后一次 send 发出
+// - keep-alive：按请求版本与 Connection 头决定；servlet 也可以 setKeepAlive(false) 要求关闭；
+//   空闲连接由 tcp_server.read_timeout 超时关闭
+// - 非法请求回复解析器给出的状态码（400 / 413 / 431 / 501 / 505）并关闭连接
+class HttpServer : public TcpServer {
+public:
+    typedef std::shared_ptr<HttpServer> ptr;
+
+    explicit HttpServer(bool keepalive = true, IOManager *worker = IOManager::GetThis(),
+                        IOManager *acceptor = IOManager::GetThis());
+
+    const ServletDispatch::ptr &getServletDispatch() const {
+        return m_dispatch;
+    }
+    void setServletDispatch(ServletDispatch::ptr v) {
+        m_dispatch = std::move(v);
+    }
+
+protected:
+    void handleClient(Socket::ptr client) override;
+
+private:
+    bool m_isKeepalive;
+    ServletDispatch::ptr m_dispatch;
+};
+
+} // namespace sunshine
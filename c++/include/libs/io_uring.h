@@ -0,0 +1,132 @@
+// file: libs/io_uring.h
+#pragma once
+
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace sunshine {
+
+// io_uring 实例的薄封装：直接使用 io_uring_setup / io_uring_enter / io_uring_register 系统调用，不依赖 liburing
+// 一个实例只能由一个线程填写 SQE、提交和收割 CQE（IOManager 的 io_uring 后端给每个 reactor 线程各建一个）
+class IoUring {
+public:
+    using ptr = std::unique_ptr<IoUring>;
+
+    // 创建有 entries 个 SQE 的 ring（CQ 为两倍），必须在之后提交它的线程上调用
+    // 内核支持时启用 SINGLE_ISSUER | DEFER_TASKRUN（完成事件只在本线程等待时处理），否则依次退回 COOP_TASKRUN / 无标志
+    // 失败返回 nullptr（设置 errno），例如内核不支持或 io_uring 被禁用
+    static ptr Create(unsigned entries);
+    ~IoUring();
+
+    IoUring(const IoUring &) = delete;
+    IoUring &operator=(const IoUring &) = delete;
+
+    // 取一个空闲 SQE（已清零）；SQ 已满时返回 nullptr，调用方先 submit() 再取
+    io_uring_sqe *getSqe();
+
+    // SQ 剩余空位（需要连续取多个 SQE 组成链时先检查）
+    unsigned sqSpace() const;
+
+    // 已填写但还没提交给内核的 SQE 数
+    unsigned pending() const {
+        return m_sqTail - m_sqSubmitted;
+    }
+
+    // 提交所有待提交的 SQE（不等待完成），返回提交数，失败返回 -errno
+    int submit();
+
+    // 提交待提交的 SQE 并等待至少 wait_nr 个完成事件
+    // timeout_ms < 0 表示不限时；wait_nr 为 0 时只提交并处理已到达的完成事件
+    // 返回提交数，超时返回 -ETIME，被信号打断返回 -EINTR
+    int submitAndWait(unsigned wait_nr, int timeout_ms);
+
+    // 依次处理已完成的 CQE（f(const io_uring_cqe &)），处理完一起推进 CQ head，返回处理数
+    template <class F>
+    unsigned reap(F &&f) {
+        unsigned head = *m_cqHead;
+        unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+        unsigned n = 0;
+        while (head != tail) {
+            f(m_cqes[head & m_cqMask]);
+            ++head;
+            ++n;
+        }
+        if (n) __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+        return n;
+    }
+
+    // 注册 provided buffer ring：count 个 size 字节的缓冲区（count 为 2 的幂），组号 bgid
+    // multishot recv 通过 IOSQE_BUFFER_SELECT 从这里取缓冲区，完成事件的 flags 高 16 位是缓冲区编号
+    bool setupBufRing(uint16_t bgid, unsigned count, unsigned size);
+
+    bool hasBufRing() const {
+        return m_bufRing != nullptr;
+    }
+    uint16_t bufGroup() const {
+        return m_bufGroup;
+    }
+    unsigned bufSize() const {
+        return m_bufSize;
+    }
+    char *bufAddr(uint16_t bid) const {
+        return m_bufBase + static_cast<size_t>(bid) * m_bufSize;
+    }
+
+    // 把 bid 号缓冲区还给内核
+    void recycleBuf(uint16_t bid);
+
+    // 注册固定缓冲区，之后可用 IORING_OP_READ_FIXED / WRITE_FIXED 按下标引用（省去每次请求固定用户页）
+    // 返回 0 成功，失败返回 -errno
+    int registerBuffers(const iovec *iovs, unsigned n);
+    int unregisterBuffers();
+
+    int fd() const {
+        return m_fd;
+    }
+    // 内核支持的特性（IORING_FEAT_*）
+    uint32_t features() const {
+        return m_features;
+    }
+
+private:
+    IoUring() = default;
+    bool init(unsigned entries, uint32_t flags);
+
+private:
+    int m_fd = -1;
+    uint32_t m_features = 0;
+
+    // SQ / CQ 映射
+    void *m_sqRing = nullptr;
+    size_t m_sqRingSize = 0;
+    void *m_cqRing = nullptr; // IORING_FEAT_SINGLE_MMAP 时与 m_sqRing 相同
+    size_t m_cqRingSize = 0;
+    io_uring_sqe *m_sqes = nullptr;
+    size_t m_sqesSize = 0;
+
+    unsigned *m_sqHead = nullptr;
+    unsigned *m_sqTailPtr = nullptr;
+    unsigned m_sqMask = 0;
+    unsigned m_sqEntries = 0;
+    unsigned m_sqTail = 0;      // 本地 tail：已填写的 SQE
+    unsigned m_sqSubmitted = 0; // 已提交给内核的 SQE
+
+    unsigned *m_cqHead = nullptr;
+    unsigned *m_cqTail = nullptr;
+    unsigned m_cqMask = 0;
+    io_uring_cqe *m_cqes = nullptr;
+
+    // provided buffer ring
+    io_uring_buf_ring *m_bufRing = nullptr;
+    size_t m_bufRingSize = 0;
+    char *m_bufBase = nullptr;
+    unsigned m_bufCount = 0;
+    unsigned m_bufSize = 0;
+    uint16_t m_bufGroup = 0;
+    uint16_t m_bufTail = 0;
+};
+
+} // namespace sunshine
@@ -2,8 +2,11 @@
 #pragma once
 
 // 标准库头文件：epoll事件、eventfd、系统调用等
+#include "libs/io_uring.h"
 #include "libs/scheduler.h"
+#include "libs/timer.h"
 #include <sys/epoll.h>
+#include <sys/socket.h>
 #include <sys/eventfd.h>
 #include <unistd.h>
 #include <vector>
@@ -11,13 +14,16 @@
 #include <mutex>
 #include <functional>
 #include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <errno.h>
 
 namespace sunshine {
 
 // IOManager 类：基于 epoll 的 I/O 多路复用调度器
 // 继承自 Scheduler，实现基于事件驱动的 I/O 操作
-class IOManager : public Scheduler {
+// 继承自 TimerManager，最近的定时器到期时间决定 epoll_wait 的超时
+class IOManager : public Scheduler, public TimerManager {
 public:
     // 智能指针类型别名
     using ptr = std::shared_ptr<IOManager>;
@@ -44,11 +50,11 @@ public:
     // 参数说明：
     // fd: 文件描述符
     // ev: 事件类型（READ/WRITE）
-    // cb: 事件触发时的回调函数
+    // cb: 事件触发时的回调函数（为空时事件触发后唤醒当前协程）
     // 返回值：
     // 0: 成功
     // -1: 失败（设置 errno）
-    int addEvent(int fd, Event ev, std::function<void()> cb);
+    int addEvent(int fd, Event ev, std::function<void()> cb = nullptr);
 
     // 删除事件监听（不触发回调）
     // 参数说明：
@@ -70,14 +76,119 @@ public:
     // 返回值：是否成功取消
     bool cancelAll(int fd);
 
+    // 在所有存活的 IOManager 上 cancelAll(fd)（FdManager::del 使用）
+    // fd 可能由别的 IOManager 管理，调用线程也可能不属于任何 IOManager，所以不能只看 GetThis()
+    static void CancelAllEverywhere(int fd);
+
+    // 是否为持久注册模式（构造时由 iomanager.persistent_et 决定）
+    // 持久模式下 fd 第一次等待事件时以 EPOLLIN|EPOLLOUT|EPOLLET 加入 epoll，直到 cancelAll（FdManager::del）
+    // 才移除；就绪状态锁存在 FdContext 里，等待 / 唤醒都不再调用 epoll_ctl
+    bool isPersistent() const {
+        return m_persistent;
+    }
+
+    // 是否为多 reactor 模式（构造时由 iomanager.multi_reactor 决定）
+    // 多 reactor 模式下每个工作线程有自己的 epoll 实例；fd 第一次被等待时绑定到当前线程的 reactor，
+    // 之后它上面的事件只由该线程等待，被唤醒的协程 / 回调也固定在该线程执行
+    bool isMultiReactor() const {
+        return m_multiReactor;
+    }
+
+    // reactor 数量（单 reactor 模式为 1）
+    size_t getReactorCount() const {
+        return m_reactors.size();
+    }
+
+    // 当前线程对应的 reactor 下标（非工作线程为 0）
+    size_t getReactorIndex() const;
+
+    // 在第 idx 个 reactor 的线程上执行 cb（start() 之后调用；单 reactor 模式下任意线程执行）
+    // 典型用法：每个 reactor 各创建一个 SO_REUSEPORT 监听 socket 并在本线程 accept（见 libs/reuseport.h）
+    void schedulerOnReactor(size_t idx, std::function<void()> cb);
+
+    // 是否为 io_uring 后端（构造时由 iomanager.io_uring 决定，隐含多 reactor 模式）
+    // 每个工作线程启动时创建自己的 ring，ring 上挂一个 multishot poll 监视本线程的 epoll 实例；
+    // 空闲时一次 io_uring_enter 同时提交本轮积累的请求、等待完成事件和 epoll 就绪
+    // addEvent / cancelEvent 仍然基于 epoll，语义不变；hook 的 read / recv / write / send / accept / connect
+    // 改为直接提交 io_uring 请求并让出协程，完成事件被收割后恢复（见下面的 uringXxx）
+    bool isUring() const {
+        return m_uring;
+    }
+
+    // io_uring 版本的 socket 操作（hook 对阻塞语义的 socket 调用）
+    // 返回 false 表示当前上下文不能走 io_uring（不在工作线程上、线程的 ring 创建失败、协程运行在共享栈上……），
+    // 调用方应退回 epoll 路径；返回 true 时 res 为系统调用语义的结果，失败时为 -errno
+    // timeout_ms 为 (uint64_t)-1 表示不超时，超时返回 -ETIMEDOUT；fd 被 close 时等待者返回 -EBADF
+    // 请求只在 fd 所属 reactor 的线程上提交，当前协程不在该线程时先迁移过去
+    // - uringRecv：flags 为 0 且开启 iomanager.io_uring_multishot_recv 时使用 multishot recv + provided buffer ring
+    //   （数据先落在 ring 的缓冲区里，读取时拷贝给调用方；这样的 fd 只能用 read / recv 读），否则每次一个 IORING_OP_RECV
+    // - uringAccept：multishot accept，已完成的连接排队在监听 fd 上；accept4 的 flags 以第一次调用为准
+    bool uringRecv(int fd, void *buf, size_t len, int flags, uint64_t timeout_ms, ssize_t &res);
+    bool uringSend(int fd, const void *buf, size_t len, int flags, uint64_t timeout_ms, ssize_t &res);
+    bool uringAccept(int fd, sockaddr *addr, socklen_t *addrlen, int flags, uint64_t timeout_ms, ssize_t &res);
+    bool uringConnect(int fd, const sockaddr *addr, socklen_t addrlen, uint64_t timeout_ms, ssize_t &res);
+
+    // 固定缓冲区：注册到当前线程的 ring（IORING_REGISTER_BUFFERS），返回 0 成功，-errno 失败
+    // 之后对绑定在该 reactor 上的 fd 用 uringReadFixed / uringWriteFixed 按下标读写，内核不再为每个请求固定用户页；
+    // 需要在哪些 reactor 上使用就通过 schedulerOnReactor 在哪些线程上各注册一次
+    int uringRegisterBuffers(const iovec *iovs, unsigned n);
+    bool uringReadFixed(int fd, void *buf, size_t len, uint16_t buf_index, uint64_t timeout_ms, ssize_t &res);
+    bool uringWriteFixed(int fd, const void *buf, size_t len, uint16_t buf_index, uint64_t timeout_ms,
+                         ssize_t &res);
+
 protected:
+    // 重写父类 run()：工作线程在调度期间开启系统调用 hook
+    void run() override;
+
     // 重写父类 tickle()：使用 eventfd 唤醒 epoll_wait
     void tickle() override;
 
-    // 重写父类 run()：实现 epoll 事件循环
-    void run() override;
+    // 重写父类 idle()：没有任务时阻塞在 epoll_wait 上，并分发就绪事件和到期定时器
+    void idle() override;
+
+    // 重写父类 pollIdle()：自旋期间非阻塞地轮询本线程的 epoll 和到期定时器
+    bool pollIdle() override;
+
+    // 新定时器早于当前 epoll_wait 的唤醒时间：tickle 让等待线程重新计算超时
+    void onTimerInsertedAtFront() override;
 
 private:
+    struct FdContext;
+
+    // io_uring 后端的一个在途请求（按 reactor 池化复用，只在所属 reactor 的线程上分配 / 释放）
+    // user_data 指向它；地址在请求完成前保持不变，链接超时的 timespec 也放在这里
+    struct UringRequest {
+        enum Kind : uint8_t {
+            ONESHOT,      // 单次请求：完成后恢复 fiber，由 fiber 取走结果并释放
+            MULTI_ACCEPT, // multishot accept：直到最后一个 CQE（没有 IORING_CQE_F_MORE）才释放
+            MULTI_RECV    // multishot recv
+        };
+        Kind kind = ONESHOT;
+        bool closed = false;     // 被 cancelAll（close）取消
+        int32_t res = 0;         // ONESHOT：CQE 结果
+        uint64_t seq = 0;        // 每次分配递增，跨线程取消时确认还是同一个请求
+        FdContext *ctx = nullptr;
+        Fiber::ptr fiber;        // ONESHOT：等待完成的协程
+        __kernel_timespec ts{};  // 链接超时
+    };
+
+    // fd 在 io_uring 后端的状态（第一次走 io_uring 时分配，随 FdContext 复用；由 ctx->mutex 保护）
+    struct UringState {
+        struct Chunk {
+            uint16_t bid; // provided buffer 编号
+            uint32_t len;
+            uint32_t off; // 已读走的字节数
+        };
+        UringRequest *ops[2] = {};     // 在途的单次请求（读 / 写各一个），close 时取消
+        UringRequest *multi = nullptr; // 在途的 multishot accept / recv
+        std::deque<int> accepted;      // multishot accept 已完成、还没交给调用方的连接
+        std::deque<Chunk> chunks;      // multishot recv 已收到、还没读完的数据
+        int error = 0;                 // multishot 收到的错误（正数 errno），交给下一次调用后清零
+        bool eof = false;              // multishot recv：对端已关闭
+        bool timedOut = false;         // 等待者因超时被唤醒
+        Fiber::ptr waiter;             // 等待 multishot 结果的协程
+    };
+
     // 文件描述符上下文结构体
     // 用于管理单个 fd 的事件注册状态
     struct FdContext {
@@ -110,28 +221,150 @@ private:
             events = NONE;
         }
 
-        MutexType mutex;          // 保护上下文的互斥锁
-        EventContext read, write; // 读/写事件上下文
-        int fd = -1;              // 文件描述符
-        Event events = NONE;      // 当前注册的事件掩码
+        MutexType mutex;                 // 保护上下文的互斥锁
+        EventContext read, write;        // 读/写事件上下文
+        int fd = -1;                     // 文件描述符
+        int reactor = -1;                // 绑定的 reactor 下标（-1 表示尚未等待过）
+        Event events = NONE;             // 当前注册的事件掩码（有等待者的事件）
+        std::atomic<uint32_t> ready{0};  // 持久模式：已到达但还没有等待者消费的就绪事件
+        bool registered = false;         // 持久模式：fd 是否已加入 epoll
+        std::unique_ptr<UringState> uring; // io_uring 后端的状态（按需分配）
     };
 
-    // 确保 m_fdContexts 能索引到指定 fd
-    // 扩容容器以容纳 fd（避免索引越界）
-    void resizeFdContext(size_t fd);
+    // 取 fd 对应的上下文（无锁）；auto_create 为 true 时按需分配所在的块
+    // fd 为负或超出表容量时返回 nullptr
+    FdContext *getFdContext(int fd, bool auto_create);
+
+    // 移除一个事件后按剩余事件 newEvents 更新 epoll 注册（MOD 或 DEL）；持久模式下不需要，直接返回
+    // 调用方持有 ctx->mutex
+    void disarmEvent(FdContext *ctx, Event newEvents);
+
+    // 持久模式的 addEvent：消费锁存的就绪状态或登记等待者（调用方持有 ctx->mutex）
+    int addPersistentEvent(FdContext *ctx, Event ev, std::function<void()> cb);
+
+    // 一个 epoll 实例及其唤醒用的 eventfd
+    struct Reactor {
+        int epfd = -1;
+        int eventfd = -1;
+        std::atomic<bool> sleeping{false}; // 多 reactor 模式：线程是否（即将）阻塞在 epoll_wait 上
+
+        // io_uring 后端（以下成员只由该 reactor 的线程访问）
+        IoUring::ptr ring;                                  // 线程启动时创建，失败时为空（该线程退回 epoll）
+        std::atomic<bool> uringReady{false};                // ring 可用（其他线程迁移协程前检查）
+        bool pollArmed = false;                             // epfd 上的 multishot poll 是否在途
+        uint64_t nextSeq = 0;                               // UringRequest::seq 的分配器
+        std::vector<std::unique_ptr<UringRequest>> requests; // 请求池（全部请求，线程退出时释放）
+        std::vector<UringRequest *> freeRequests;           // 空闲的请求
+    };
 
-    // 触发事件回调（由 epoll 事件循环调用）
-    // 将事件回调提交到调度器执行
-    void triggerEvent(int fd, Event ev);
+    // fd 所属 reactor 的线程（单 reactor 模式返回空 id）
+    std::thread::id reactorThread(const FdContext *ctx) const;
+
+    // 写 eventfd 唤醒指定 reactor
+    void wakeReactor(size_t idx);
+
+    // 唤醒一个正在睡眠的 reactor（多 reactor 模式），返回是否唤醒了
+    bool wakeOneSleeping();
+
+    // 单 reactor 模式的空闲槽位（leader / follower）：
+    // 同一时刻只有一个线程（leader，m_poller）阻塞在共享的 epoll_wait 上，其余空闲线程（follower）
+    // 各自睡在自己的条件变量上，pinned 任务可以直接唤醒目标线程（共享的 eventfd 被谁读走不确定）
+    struct IdleSlot {
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::atomic<bool> notified{false}; // 被直接唤醒（follower 醒来，leader 不再阻塞）
+        std::atomic<bool> sleeping{false}; // 线程是否（即将）空闲等待
+    };
+
+    // 单 reactor 模式：当前线程的槽位（工作线程用自己的下标，use_caller 的调用线程用最后一个）
+    size_t idleSlotIndex() const;
+
+    // 单 reactor 模式：直接唤醒第 idx 个槽位的线程（follower 通知条件变量，leader 写共享的 eventfd）
+    void wakeIdleSlot(size_t idx);
+
+    // 单 reactor 模式：唤醒一个空闲线程，优先唤醒 follower，没有时写共享的 eventfd 唤醒 leader
+    void wakeOneIdle();
+
+    // 单 reactor 模式的 idle()（见 idle() 的 5）
+    void sharedIdle(Reactor &reactor);
+
+    // 触发事件（由 epoll 事件循环调用）
+    // 取出等待该事件的回调 / 协程追加到 cbs / fibers，由调用方整批提交给调度器
+    void triggerEvent(FdContext *ctx, Event ev, std::vector<std::function<void()>> &cbs,
+                      std::vector<Fiber::ptr> &fibers);
+
+    // 分发一批 epoll 事件（eventfd / fd 读写就绪）
+    void dispatchEpollEvents(Reactor &reactor, const epoll_event *events, int n,
+                             std::vector<std::function<void()>> &cbs, std::vector<Fiber::ptr> &fibers);
+
+    // 把一轮收集到的回调 / 协程交给调度器
+    void submitReady(std::vector<std::function<void()>> &cbs, std::vector<Fiber::ptr> &fibers);
+
+    // io_uring 后端：工作线程启动 / 退出时创建 / 销毁本线程的 ring
+    void uringThreadInit();
+    void uringThreadFini();
+
+    // io_uring 后端的 idle()：提交 + 等待 + 收割，epoll 就绪时再非阻塞地 epoll_wait 一次
+    void uringIdle(Reactor &reactor);
+
+    // 在 epfd 上布置 multishot poll（epoll 有就绪事件时产生一个 CQE）
+    void uringArmEpoll(Reactor &reactor);
+
+    // 处理一个请求的 CQE，需要恢复的协程追加到 fibers
+    void uringComplete(Reactor &reactor, const io_uring_cqe &cqe, std::vector<Fiber::ptr> &fibers);
+
+    // 让当前协程进入 ctx 所属 reactor 的线程（未绑定时绑定到当前线程），返回该 reactor；不能走 io_uring 时返回 nullptr
+    Reactor *uringEnter(FdContext *ctx);
+
+    UringRequest *uringAlloc(Reactor &reactor, UringRequest::Kind kind, FdContext *ctx);
+    void uringFree(Reactor &reactor, UringRequest *req);
+
+    // 取一个 SQE，SQ 放不下 n 个时先提交；提交失败返回 nullptr
+    io_uring_sqe *uringSqe(Reactor &reactor, unsigned n = 1);
+
+    // 提交一个单次请求（prep 填写 SQE）并让出协程直到完成，返回 CQE 结果；slot 为 READ / WRITE
+    template <class Prep>
+    int32_t uringWait(Reactor &reactor, FdContext *ctx, Event slot, uint64_t timeout_ms, Prep &&prep);
+
+    // 同 uringWait；请求返回 -EAGAIN 时先在 ring 上 poll 到 fd 就绪再重试
+    template <class Prep>
+    int32_t uringCall(Reactor &reactor, FdContext *ctx, Event slot, uint64_t timeout_ms, Prep &&prep);
+
+    // multishot 等待：登记等待者（可选超时）并让出，调用方持有 lock，返回时重新持有
+    void uringWaitMulti(FdContext *ctx, std::unique_lock<std::mutex> &lock, uint64_t timeout_ms, Timer::ptr &timer,
+                        std::shared_ptr<int> &token);
+
+    // cancelAll 的 io_uring 部分：取消 fd 上在途的请求，丢弃排队的连接 / 数据并唤醒等待者（调用方持有 ctx->mutex）
+    void uringCancel(FdContext *ctx, int reactor);
+
+    // 在 reactor 线程上提交 IORING_OP_ASYNC_CANCEL 并回收 provided buffer
+    void uringCancelOn(Reactor &reactor, const std::vector<std::pair<UringRequest *, uint64_t>> &reqs,
+                       const std::vector<uint16_t> &bids);
 
 private:
-    int m_epfd{-1};                                       // epoll 文件描述符
-    int m_eventfd{-1};                                    // eventfd 文件描述符（用于唤醒 epoll）
-    std::vector<std::shared_ptr<FdContext>> m_fdContexts; // fd 上下文容器
-    std::mutex m_mutex;                                   // 保护 m_fdContexts 的互斥锁
+    std::vector<std::unique_ptr<Reactor>> m_reactors;     // reactor 列表（单 reactor 模式只有一个，所有线程共享）
+    std::vector<std::unique_ptr<IdleSlot>> m_idleSlots;   // 单 reactor 模式：每个工作线程一个，再加调用线程一个
+    std::atomic<int> m_poller{-1};                        // 单 reactor 模式：leader 的槽位下标（-1 表示没有）
     std::atomic<size_t> m_pendingEventCount{0};           // 待处理事件计数（用于优化）
+    bool m_persistent = false;                            // 持久注册模式
+    bool m_multiReactor = false;                          // 多 reactor 模式
+    bool m_uring = false;                                 // io_uring 后端
+    bool m_multishotRecv = false;                         // io_uring 后端：read / recv 使用 multishot recv
+
+    static const int MAX_EVENTS = 1024;   // epoll 事件最大数量
+    static const int MAX_TIMEOUT = 5000;  // epoll_wait 最长超时（毫秒）
+
+    static const unsigned URING_ENTRIES = 256;      // 每个 ring 的 SQE 数
+    static const unsigned URING_SUBMIT_BATCH = 32;  // 积累这么多 SQE 就立即提交（否则等到 idle 一起提交）
+    static const unsigned URING_RECV_BUFS = 256;    // multishot recv 的 provided buffer 数
+    static const unsigned URING_RECV_BUF_SIZE = 4096;
 
-    static const int MAX_EVENTS = 1024; // epoll 事件最大数量
+    // fd 上下文表：FD_MAX_CHUNKS 个块指针，每块内嵌 FD_CHUNK_SIZE 个 FdContext
+    // 扩容只是发布新块，已有的 FdContext 不会移动，读取无需加锁；最多容纳 2^20 个 fd（Linux nr_open 默认上限）
+    static const size_t FD_CHUNK_BITS = 10;
+    static const size_t FD_CHUNK_SIZE = 1u << FD_CHUNK_BITS;
+    static const size_t FD_MAX_CHUNKS = 1024;
+    std::atomic<FdContext *> m_fdChunks[FD_MAX_CHUNKS] = {};
 };
 
 } // namespace sunshine
\ No newline at end of file
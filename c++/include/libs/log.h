@@ -10,11 +10,14 @@
 #include <iostream>
 #include <vector>
 #include <mutex>
+#include <condition_variable>
 #include <shared_mutex>
 #include <unordered_map>
 #include <thread>
 #include <atomic>
 #include <ctime>
+#include <charconv>
+#include <type_traits>
 
 namespace sunshine {
 
@@ -24,7 +27,40 @@ class LogFormatter;
 class LogAppender;
 
 //
-// LogEvent: 表示一次日志（包含用于格式化的信息和用于流式写入的 stringstream）
+// LogStream: 追加写入 std::string 的输出流，clear() 只清空内容、保留容量，给线程本地缓冲区反复复用
+//
+class LogStream : public std::ostream {
+public:
+    LogStream() :
+        std::ostream(&m_buf) {
+    }
+    const std::string &str() const {
+        return m_buf.str;
+    }
+    std::string &buffer() {
+        return m_buf.str;
+    }
+    void clear() {
+        m_buf.str.clear();
+    }
+
+private:
+    struct Buf : public std::streambuf {
+        int_type overflow(int_type c) override {
+            if (c != traits_type::eof()) str.push_back(static_cast<char>(c));
+            return c;
+        }
+        std::streamsize xsputn(const char *s, std::streamsize n) override {
+            str.append(s, static_cast<size_t>(n));
+            return n;
+        }
+        std::string str;
+    };
+    Buf m_buf;
+};
+
+//
+// LogEvent: 表示一次日志（包含用于格式化的信息和用于流式写入的缓冲区）
 //
 class LogEvent {
 public:
@@ -40,14 +76,27 @@ public:
              int32_t fiberid,
              int level);
 
+    // 取一个可以写入的事件：优先复用当前线程缓存的那个（没有其他地方持有时），
+    // 缓冲区保留上次的容量，常规日志不需要分配内存
+    static ptr Acquire(const std::string &logger_name, const char *file, int32_t line, int level);
+
     // 直接通过流拼接消息（流式风格）
-    std::ostringstream &getSS() {
+    std::ostream &getSS() {
         return m_ss;
     }
-    std::string getContent() const {
+    const std::string &getContent() const {
         return m_ss.str();
     }
 
+    // fmt 风格：依次用参数替换 fmt 里的 "{}"（"{{" / "}}" 输出花括号，不支持格式说明符），直接写入事件缓冲区
+    // 整数走 std::to_chars，其余类型用 operator<<；多余的参数忽略，多余的 "{}" 原样输出
+    template <class... Args>
+    void format(const char *fmt, const Args &...args) {
+        const char *p = fmt;
+        (formatArg(p, args), ...);
+        while (p && (p = appendLiteral(p))) m_ss.write("{}", 2);
+    }
+
     // 基本字段（public 便于 formatter 访问）
     const char *m_file = nullptr;
     uint32_t m_elapse = 0;    //计时器，用于记录启动到现在多久了
@@ -55,11 +104,28 @@ public:
     uint32_t m_threadid = 0;  //线程id
     uint32_t m_fiberid = 0;   //协程id
     uint64_t m_time = 0;      //时间戳
+    uint32_t m_nsec = 0;      //时间戳秒内的纳秒部分（%ms / %us 使用）
     std::string m_context;    // 可选上下文字段（额外）
     std::string m_loggerName; //对应的日志器名称
     int m_level = 0;          // LogLevel::Level
 private:
-    std::ostringstream m_ss;
+    // 写出 fmt 里下一个 "{}" 之前的文本，返回 "{}" 之后的位置；没有占位符时写完整个 fmt 并返回 nullptr
+    const char *appendLiteral(const char *fmt);
+
+    template <class T>
+    void formatArg(const char *&fmt, const T &v) {
+        if (!fmt || !(fmt = appendLiteral(fmt))) return;
+        if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, char>) {
+            char buf[24];
+            auto r = std::to_chars(buf, buf + sizeof(buf), v);
+            m_ss.write(buf, r.ptr - buf);
+        } else {
+            m_ss << v;
+        }
+    }
+
+private:
+    LogStream m_ss;
 };
 
 //
@@ -89,17 +155,22 @@ public:
 
 //
 // LogFormatter: 支持类似 "%d{%Y-%m-%d %H:%M:%S} [%p] %c %t %f:%l %m%n" 的 pattern
+// - %d 的结果按线程缓存，同一秒内的事件直接复用上次 strftime 的输出
+// - %ms / %us：秒内的毫秒（3 位）/ 微秒（6 位），例如 "%d.%ms"
+//   注意 %ms 优先于 %m：以前的 "%ms" 表示消息后跟字面量 s，现在需要这个含义时写 "%m{}s"
 //
 class LogFormatter {
 public:
     typedef std::shared_ptr<LogFormatter> ptr;
     LogFormatter(const std::string &pattern = "%d{%Y-%m-%d %H:%M:%S} [%p] %c %t %f:%l %m%n");
     std::string format(std::shared_ptr<LogEvent> event);
+    // 直接写入调用方的流（appender 用线程本地的 LogStream，避免每条日志构造 ostringstream）
+    void format(std::ostream &os, const std::shared_ptr<LogEvent> &event);
     class FormatItem {
     public:
         typedef std::shared_ptr<FormatItem> ptr;
         virtual ~FormatItem();
-        virtual void format(std::ostream &os, std::shared_ptr<LogEvent> event) = 0;
+        virtual void format(std::ostream &os, const std::shared_ptr<LogEvent> &event) = 0;
     };
 
     //解析日志内容
@@ -182,9 +253,12 @@ public:
     }
 
 private:
+    typedef std::vector<LogAppender::ptr> AppenderList;
+
     std::atomic<LogLevel::Level> m_level{LogLevel::DEBUG};
     std::string m_name;
-    std::list<LogAppender::ptr> m_appenders;
+    // 写时复制：log() 只在读锁下拷贝一份 shared_ptr，不再逐条拷贝整个列表
+    std::shared_ptr<const AppenderList> m_appenders;
     LogFormatter::ptr m_formatter;     // logger 默认格式器（appender 没有则使用它）
     mutable std::shared_mutex m_mutex; // 允许并发读（log 输出时），写操作进行独占
 };
@@ -211,22 +285,95 @@ private:
     std::mutex m_file_mutex;    //文件流互斥（写文件时互斥）
 };
 
+//
+// AsyncLogAppender: 异步输出，日志线程只做格式化和一次内存拷贝
+// - 每个写日志的线程有一个自己的 SPSC 字节环（第一次写时注册），生产者之间互不竞争
+// - 后台线程按 flush 间隔（或某个环超过半满时被唤醒）把所有环里的内容用 writev 批量写出
+// - 环满时按策略丢弃（DROP，计入 getDropped）或阻塞等待后台线程腾出空间（BLOCK）
+// - 只保证同一线程内的日志顺序，不同线程的日志按批次交错
+//
+class AsyncLogAppender : public LogAppender {
+public:
+    typedef std::shared_ptr<AsyncLogAppender> ptr;
+    enum OverflowPolicy {
+        DROP = 0,
+        BLOCK = 1
+    };
+
+    // filename 为空时输出到 stdout；ring_size 是每个线程的环大小（向上取整为 2 的幂）
+    AsyncLogAppender(const std::string &filename = "",
+                     size_t ring_size = 256 * 1024,
+                     uint32_t flush_interval_ms = 100,
+                     OverflowPolicy policy = DROP);
+    ~AsyncLogAppender() override;
+
+    void log(LogLevel::Level level, std::shared_ptr<LogEvent> event) override;
+    // 重新打开输出文件（日志切割后调用）
+    bool reopen();
+    // 等到调用前写入的日志全部交给内核
+    void flush();
+
+    uint64_t getDropped() const {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+    OverflowPolicy getPolicy() const {
+        return m_policy;
+    }
+
+    struct Ring;
+
+private:
+    Ring *localRing();
+    bool push(Ring &ring, const char *data, size_t len);
+    void writeAll(const char *data, size_t len);
+    void wakeup();
+    void run();
+    bool drain();
+
+private:
+    const uint64_t m_id;       // 线程本地缓存用它区分 appender（不用地址，避免析构后地址复用）
+    std::string m_filename;
+    int m_fd = -1;
+    std::mutex m_fdMutex;      // 保护 m_fd 的替换（reopen）和超长行的直接写出
+    size_t m_ringSize;
+    uint32_t m_flushInterval;
+    OverflowPolicy m_policy;
+
+    std::mutex m_ringsMutex;
+    std::vector<std::shared_ptr<Ring>> m_rings;
+
+    std::mutex m_waitMutex;
+    std::condition_variable m_cond;      // 唤醒后台线程
+    std::condition_variable m_spaceCond; // 一轮写出完成，通知 BLOCK 的生产者和 flush
+    std::atomic<bool> m_signaled{false};
+    bool m_stop = false;
+    std::atomic<uint64_t> m_dropped{0};
+    std::thread m_thread;
+};
+
 //
 // LogEventWrap: RAII 帮助类，支持流式写法，析构时把内容发给 Logger
 // 用法： LOG_DEBUG(logger) << "x=" << x;
+//       LOG_FMT_DEBUG(logger, "x={} y={}", x, y);
 //
 class LogEventWrap {
 public:
     LogEventWrap(Logger::ptr logger, std::shared_ptr<LogEvent> event);
+    // 宏使用的构造：logger 由调用方的表达式保证存活，这里不增加引用计数；事件取线程本地缓存
+    LogEventWrap(const Logger::ptr &logger, LogLevel::Level level, const char *file, int32_t line);
     ~LogEventWrap();
 
     //返回event的文本内容
     std::ostream &getSS() {
         return m_event->getSS();
     }
+    const std::shared_ptr<LogEvent> &getEvent() const {
+        return m_event;
+    }
 
 private:
-    Logger::ptr m_logger;
+    Logger *m_logger;
+    Logger::ptr m_owner; // 只有第一个构造函数会持有
     std::shared_ptr<LogEvent> m_event;
 };
 
@@ -246,11 +393,12 @@ private:
     mutable std::shared_mutex m_mutex; // 读多写少：大部分是获取 logger
 };
 
-#define LOG_EVENT(logger_ptr, level)                                                                                                                           \
-    sunshine::LogEventWrap((logger_ptr), std::make_shared<sunshine::LogEvent>((logger_ptr)->getName(),                                                         \
-                                                                              static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id())), \
-                                                                              __FILE__, __LINE__, static_cast<uint64_t>(time(nullptr)), 0, "", 0, level))      \
-        .getSS()
+// 先检查 logger 的级别：被过滤掉的日志不构造事件，<< 后面的表达式也不会求值
+// logger 表达式只求值一次；if/else 形式保证宏后面接的 else 仍然属于调用方的 if
+#define LOG_EVENT(logger_ptr, level)                                                                   \
+    if (auto &&sunshine_log_logger = (logger_ptr); (level) < sunshine_log_logger->getLevel()) {        \
+    } else                                                                                             \
+        sunshine::LogEventWrap(sunshine_log_logger, level, __FILE__, __LINE__).getSS()
 
 #define LOG_DEBUG(logger) LOG_EVENT(logger, sunshine::LogLevel::DEBUG)
 #define LOG_INFO(logger) LOG_EVENT(logger, sunshine::LogLevel::INFO)
@@ -258,4 +406,16 @@ private:
 #define LOG_ERROR(logger) LOG_EVENT(logger, sunshine::LogLevel::ERROR)
 #define LOG_FATAL(logger) LOG_EVENT(logger, sunshine::LogLevel::FATAL)
 
+// fmt 风格：LOG_FMT_INFO(logger, "x={} y={}", x, y)，同样先检查级别
+#define LOG_FMT_EVENT(logger_ptr, level, ...)                                                          \
+    if (auto &&sunshine_log_logger = (logger_ptr); (level) < sunshine_log_logger->getLevel()) {        \
+    } else                                                                                             \
+        sunshine::LogEventWrap(sunshine_log_logger, level, __FILE__, __LINE__).getEvent()->format(__VA_ARGS__)
+
+#define LOG_FMT_DEBUG(logger, ...) LOG_FMT_EVENT(logger, sunshine::LogLevel::DEBUG, __VA_ARGS__)
+#define LOG_FMT_INFO(logger, ...) LOG_FMT_EVENT(logger, sunshine::LogLevel::INFO, __VA_ARGS__)
+#define LOG_FMT_WARN(logger, ...) LOG_FMT_EVENT(logger, sunshine::LogLevel::WARN, __VA_ARGS__)
+#define LOG_FMT_ERROR(logger, ...) LOG_FMT_EVENT(logger, sunshine::LogLevel::ERROR, __VA_ARGS__)
+#define LOG_FMT_FATAL(logger, ...) LOG_FMT_EVENT(logger, sunshine::LogLevel::FATAL, __VA_ARGS__)
+
 } // namespace sunshine
@@ -0,0 +1,30 @@
+// file: libs/metrics.h
+#pragma once
+
+// 运行时指标导出：把调度器 / IOManager 的指标快照渲染成 Prometheus 文本格式（exposition format 0.0.4）
+// - 每线程计数带 scheduler / thread 标签（use_caller 的调用线程 thread="caller"），直方图按调度器汇总
+// - 同名调度器按创建顺序加后缀 "#2"、"#3"...，保证时间序列不重复
+// - 通过 HttpServer 暴露：dispatch->addServlet("/metrics", std::make_shared<MetricsServlet>())
+#include "libs/http_server.h"
+#include "libs/scheduler.h"
+
+#include <string>
+#include <vector>
+
+namespace sunshine {
+
+// 渲染给定的快照，追加到 out
+void RenderPrometheus(const std::vector<Scheduler::Metrics> &all, std::string &out);
+// 渲染所有存活调度器的当前指标
+std::string RenderPrometheus();
+
+// GET 返回 RenderPrometheus() 的结果
+class MetricsServlet : public Servlet {
+public:
+    MetricsServlet() :
+        Servlet("MetricsServlet") {
+    }
+    void handle(const HttpRequest &req, HttpResponse &rsp, const Socket::ptr &conn) override;
+};
+
+} // namespace sunshine
@@ -0,0 +1,22 @@
+// file: libs/reuseport.h
+#pragma once
+
+// SO_REUSEPORT 分片监听：多 reactor 模式下每个 reactor 各持有一个绑定到同一地址的监听 socket，
+// 内核按四元组哈希（或挂上的 BPF 程序）把新连接分给其中一个，accept 不再在线程之间争抢
+#include <cstdint>
+#include <sys/socket.h>
+
+namespace sunshine {
+
+// 创建开启 SO_REUSEADDR / SO_REUSEPORT 的 TCP 监听 socket，绑定 addr 并 listen
+// socket 登记到 FdManager（系统层非阻塞），在开启 hook 的线程上 accept 会让出协程等待
+// 返回值：监听 fd，失败返回 -1（设置 errno）
+int ReusePortListen(const sockaddr *addr, socklen_t addrlen, int backlog = SOMAXCONN);
+
+// 给 reuseport 组挂上按 CPU 分发的 cBPF 程序：新连接交给组内第 (处理该包的 CPU % groups) 个 socket
+// 组内序号就是 socket 加入组（bind）的顺序；配合 reactor 线程绑核使用，连接从网卡中断到 accept 都在同一个核上
+// 对组内任意一个 socket 调用一次即可
+// 返回值：是否成功（内核不支持时返回 false，退回默认的哈希分发）
+bool AttachReusePortCpuSteering(int fd, uint32_t groups);
+
+} // namespace sunshine
@@ -0,0 +1,115 @@
+// file: libs/ringqueue.h
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace sunshine {
+
+// RingQueue：有界、无锁的多生产者多消费者环形队列（Vyukov bounded MPMC queue）
+// - 每个槽位自带序号 seq，生产者/消费者通过 CAS 抢占 tail/head 位置后再读写槽位，
+//   因此槽位里可以直接存放非平凡类型（构造/析构都在抢到位置之后进行）
+// - 容量向上取整为 2 的幂，满时 push 返回 false（由调用方决定溢出策略）
+// - 调度器用它做每个工作线程的本地队列：owner 从 tail 压入、从 head 弹出，
+//   其他线程"窃取"时同样从 head 弹出，整个过程不需要互斥锁
+template <class T>
+class RingQueue {
+public:
+    explicit RingQueue(size_t capacity = 1024) {
+        size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        m_mask = cap - 1;
+        m_cells.reset(new Cell[cap]);
+        for (size_t i = 0; i < cap; ++i) {
+            m_cells[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~RingQueue() {
+        // 析构残留元素
+        T tmp;
+        while (pop(tmp)) {
+        }
+    }
+
+    RingQueue(const RingQueue &) = delete;
+    RingQueue &operator=(const RingQueue &) = delete;
+
+    // 压入一个元素；队列已满返回 false（v 保持不变）
+    bool push(T &&v) {
+        Cell *cell;
+        size_t pos = m_tail.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+            if (dif == 0) {
+                if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (dif < 0) {
+                return false; // 满
+            } else {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+        new (cell->storage) T(std::move(v));
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 弹出一个元素；队列为空返回 false
+    bool pop(T &out) {
+        Cell *cell;
+        size_t pos = m_head.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (dif == 0) {
+                if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (dif < 0) {
+                return false; // 空
+            } else {
+                pos = m_head.load(std::memory_order_relaxed);
+            }
+        }
+        T *elem = std::launder(reinterpret_cast<T *>(cell->storage));
+        out = std::move(*elem);
+        elem->~T();
+        cell->seq.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 近似长度（并发下仅作参考）
+    size_t sizeApprox() const {
+        size_t t = m_tail.load(std::memory_order_relaxed);
+        size_t h = m_head.load(std::memory_order_relaxed);
+        return t > h ? t - h : 0;
+    }
+
+    bool emptyApprox() const {
+        return sizeApprox() == 0;
+    }
+
+    size_t capacity() const {
+        return m_mask + 1;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    static constexpr size_t kCacheLine = 64;
+
+    std::unique_ptr<Cell[]> m_cells;
+    size_t m_mask = 0;
+    alignas(kCacheLine) std::atomic<size_t> m_head{0}; // 消费位置（owner 与窃取者共享）
+    alignas(kCacheLine) std::atomic<size_t> m_tail{0}; // 生产位置
+};
+
+} // namespace sunshine
@@ -0,0 +1,219 @@
+// file: libs/rpc.h
+#pragma once
+
+// 二进制 RPC：长度前缀分帧 + 一条连接上多路复用
+// 帧格式（定长字段按网络字节序，变长字段为 varint）：
+//   | magic u8 | version u8 | type u8 | flags u8 | length fuint32 |   定长头 8 字节，length 为后面的字节数
+//   | id varint | REQUEST / ONEWAY：method（varint 长度 + 字节）；RESPONSE：status varint | payload... |
+// - 每个请求带一个连接内唯一的 id，响应按 id 找回发起调用的协程，所以同一连接上可以有任意多个在途请求，
+//   响应也不必按请求的顺序返回（慢请求不会挡住后面的请求）
+// - 发送：调用方只把帧编码进连接的发送队列；连接的发送协程一次取走整个队列，用一次 writev 发出
+// - 接收：连接的接收协程解出帧后唤醒对应的调用方（客户端），或把请求交给 worker 的独立协程执行（服务端）
+#include "libs/bytearray.h"
+#include "libs/fiber.h"
+#include "libs/iomanager.h"
+#include "libs/socket.h"
+#include "libs/tcp_server.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace sunshine {
+
+// 响应状态码：小于 RPC_USER 的由框架使用，handler 可以返回 RPC_USER 起的自定义状态
+enum RpcStatus : uint32_t {
+    RPC_OK = 0,
+    RPC_NOT_FOUND = 1,     // 服务端没有注册这个方法
+    RPC_HANDLER_ERROR = 2, // handler 抛出异常，负载为异常信息
+    // 以下只在客户端本地产生，不会出现在线上
+    RPC_TIMEOUT = 100, // 超时没有收到响应
+    RPC_CLOSED = 101,  // 连接未建立或已断开
+    RPC_TOO_LARGE = 102, // 请求帧超过 rpc.max_frame_size，没有发送（连接不受影响）
+    RPC_USER = 1000
+};
+
+struct RpcMessage {
+    enum Type : uint8_t { REQUEST = 1, RESPONSE = 2, ONEWAY = 3 };
+
+    Type type = REQUEST;
+    uint64_t id = 0;
+    uint32_t status = RPC_OK; // RESPONSE
+    std::string method;       // REQUEST / ONEWAY
+    ByteSlice payload;        // 共享接收缓冲区的块，不拷贝
+};
+
+// 帧的编解码：编码追加到 out 的 position 处，解码从 in 的 position 开始
+class RpcCodec {
+public:
+    enum Result { NEED_MORE, DONE, ERROR };
+
+    static const uint8_t MAGIC = 0xA7;
+    static const uint8_t VERSION = 1;
+    static const size_t HEAD_SIZE = 8;
+
+    // 帧头之后的长度，与 Decode 的 max_frame 比较；发送前先检查，超过 4 GiB 也不会被截断
+    static size_t RequestSize(uint64_t id, std::string_view method, std::string_view payload);
+    static size_t ResponseSize(uint64_t id, uint32_t status, std::string_view payload);
+
+    static void EncodeRequest(ByteArray &out, RpcMessage::Type type, uint64_t id, std::string_view method,
+                              std::string_view payload);
+    static void EncodeResponse(ByteArray &out, uint64_t id, uint32_t status, std::string_view payload);
+    // 帧不完整时返回 NEED_MORE 且不移动 position；magic / version 不对、长度超过 max_frame 或字段越界返回 ERROR
+    static Result Decode(ByteArray &in, RpcMessage &msg, uint32_t max_frame);
+};
+
+// RpcSession：一条 RPC 连接的发送端，客户端与服务端共用
+// - send* 可以在任意线程 / 协程调用：帧编码进发送队列后立即返回，发送协程空闲时顺便唤醒它
+// - 发送协程把队列整个换出来写：之前排队的所有帧共用一次 writev（Socket::send(ByteArray&)）
+// - close 立即 shutdown 连接（接收协程随之读到 EOF），还在排队的帧被丢弃；fd 等接收 / 发送协程都放下
+//   Socket 的引用后才关闭，不会有协程读写到被复用的 fd
+// - 帧长超过 rpc.max_frame_size 时 send* 不入队、返回 false：对端会把这样的帧当作非法帧断开连接，
+//   连带失败同一连接上的其他调用
+class RpcSession : public std::enable_shared_from_this<RpcSession> {
+public:
+    typedef std::shared_ptr<RpcSession> ptr;
+
+    RpcSession(Socket::ptr sock, IOManager *iom);
+
+    // 在 iom 上启动发送协程
+    void start();
+    void close();
+
+    bool sendRequest(RpcMessage::Type type, uint64_t id, std::string_view method, std::string_view payload);
+    bool sendResponse(uint64_t id, uint32_t status, std::string_view payload);
+
+    bool isClosed() const;
+    uint32_t getMaxFrame() const {
+        return m_maxFrame;
+    }
+    const Socket::ptr &getSocket() const {
+        return m_sock;
+    }
+    // 已发送的帧数与写调用次数：两者之比就是平均每次 writev 合并的帧数
+    uint64_t getFramesSent() const {
+        return m_frames.load(std::memory_order_relaxed);
+    }
+    uint64_t getWrites() const {
+        return m_writes.load(std::memory_order_relaxed);
+    }
+
+private:
+    template <class Encode>
+    bool enqueue(Encode &&encode);
+    void sendLoop();
+
+private:
+    Socket::ptr m_sock;
+    IOManager *m_iom;
+    uint32_t m_maxFrame;
+
+    mutable std::mutex m_mutex;
+    std::unique_ptr<ByteArray> m_queue;   // 待发送的帧（m_mutex 保护）
+    std::unique_ptr<ByteArray> m_writing; // 发送协程正在写的一批
+    uint64_t m_queued = 0;                // m_queue 里的帧数
+    Fiber::ptr m_sendFiber;
+    bool m_sendIdle = false; // 发送协程挂起等待新帧
+    bool m_closed = false;
+
+    std::atomic<uint64_t> m_frames{0};
+    std::atomic<uint64_t> m_writes{0};
+};
+
+// RpcClient：一条连接上的多路复用客户端，对象必须由 shared_ptr 持有
+// - call 在协程里调用时挂起当前协程等待响应（不占线程），在普通线程里调用时阻塞在条件变量上
+// - 任意多个协程 / 线程可以同时 call，共用同一条连接
+// - 连接断开时所有在途调用以 RPC_CLOSED 返回；之后需要重新 connect
+// - 请求帧超过 rpc.max_frame_size 时只有这次 call 以 RPC_TOO_LARGE 返回（notify 返回 false）
+// - 连接存续期间接收协程持有客户端的引用，不再使用时需要 close
+class RpcClient : public std::enable_shared_from_this<RpcClient> {
+public:
+    typedef std::shared_ptr<RpcClient> ptr;
+
+    struct Result {
+        uint32_t status = RPC_OK;
+        ByteSlice payload;
+
+        bool ok() const {
+            return status == RPC_OK;
+        }
+    };
+
+    // 接收 / 发送协程运行在 iom 上
+    explicit RpcClient(IOManager *iom = IOManager::GetThis());
+    ~RpcClient();
+
+    bool connect(Address::ptr addr, uint64_t timeout_ms = ~0ull);
+    void close();
+    bool isConnected() const;
+
+    // timeout_ms 为 0 时取 rpc.call_timeout，~0ull 表示不超时
+    Result call(std::string_view method, std::string_view payload, uint64_t timeout_ms = 0);
+    // 单向消息：不分配 id 的等待项，也没有响应
+    bool notify(std::string_view method, std::string_view payload);
+
+    size_t getPendingCount() const;
+    const RpcSession::ptr &getSession() const {
+        return m_session;
+    }
+
+private:
+    struct Call {
+        Scheduler *sched = nullptr;
+        Fiber::ptr fiber; // 为空表示调用方是普通线程
+        bool done = false;
+        Result result;
+    };
+
+    void recvLoop(RpcSession::ptr session);
+    void complete(uint64_t id, uint32_t status, ByteSlice &&payload);
+    // 连接断开：还没完成的调用全部以 status 结束
+    void failAll(uint32_t status);
+
+private:
+    IOManager *m_iom;
+    RpcSession::ptr m_session;
+    std::atomic<uint64_t> m_nextId{1};
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::unordered_map<uint64_t, Call> m_calls;
+    bool m_connected = false;
+};
+
+// RpcServer：TcpServer 上的 RPC 服务端
+// - 每个连接一个接收协程，一次读到的请求用一次批量提交交给 worker，每个请求在自己的协程里执行 handler，
+//   handler 可以阻塞，完成后各自把响应放进连接的发送队列（响应顺序与请求顺序无关）
+// - 方法表在请求路径上不加锁：需要在 start 之前注册完
+// - 连接的读超时同样取 tcp_server.read_timeout，客户端需要在空闲超时后重连（或把它配成 0）
+class RpcServer : public TcpServer {
+public:
+    typedef std::shared_ptr<RpcServer> ptr;
+    // 返回状态码，响应负载写到 rsp
+    typedef std::function<uint32_t(const RpcMessage &req, std::string &rsp)> Handler;
+
+    explicit RpcServer(IOManager *worker = IOManager::GetThis(), IOManager *acceptor = IOManager::GetThis());
+
+    void registerMethod(const std::string &name, Handler handler);
+
+protected:
+    void handleClient(Socket::ptr client) override;
+
+private:
+    struct StringHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view s) const {
+            return std::hash<std::string_view>()(s);
+        }
+    };
+
+    std::unordered_map<std::string, Handler, StringHash, std::equal_to<>> m_methods;
+};
+
+} // namespace sunshine
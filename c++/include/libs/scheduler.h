@@ -3,6 +3,7 @@
 
 // 标准库头文件：基础类型、容器、线程同步工具等
 #include <cstddef>
+#include <cstdint>
 #include <list>
 #include <memory>
 #include <mutex>
@@ -15,6 +16,10 @@
 // 自定义头文件：协程和日志模块
 #include "libs/fiber.h"
 #include "libs/log.h"
+#include "libs/ringqueue.h"
+#include "libs/circular_buffer.h"
+#include "libs/task.h"
+#include "libs/thread.h"
 
 namespace sunshine {
 
@@ -58,33 +63,27 @@ public:
 
     // 提交单个任务（支持协程或函数对象）
     // 参数说明：
-    // fc: 任务（Fiber::ptr或std::function<void()>）
+    // fc: 任务（Fiber::ptr或任意 void() 可调用对象，右值会被直接移动进任务队列）
     // thr: 指定执行线程ID（默认在任意线程执行）
     // 逻辑：
-    // 1. 加锁确保线程安全
-    // 2. 调用无锁提交函数
-    // 3. 若队列为空则唤醒工作线程
+    // 1. 工作线程提交且未指定线程：无锁压入本线程的本地队列
+    // 2. 指定了线程：直接压入目标工作线程的 pinned 队列
+    // 3. 其他情况（外部线程提交 / 本地队列已满）：压入全局队列（加锁）
+    // 4. 若有空闲线程则唤醒
     template <class FiberOrCb>
-    void scheduler(FiberOrCb fc, std::thread::id thr = std::thread::id()) {
-        bool need_tickle = false;
-        {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            need_tickle = schedulerNoLock(fc, thr); // 无锁提交
-        }
+    void scheduler(FiberOrCb &&fc, std::thread::id thr = std::thread::id()) {
+        bool need_tickle = schedulerNoLock(std::forward<FiberOrCb>(fc), thr);
         if (need_tickle) tickle(); // 唤醒等待的线程
     }
 
     // 批量提交任务（迭代器范围）
-    // 逻辑同单任务提交，但支持批量处理
+    // 逻辑同单任务提交，但整批最多唤醒一次；传入 move_iterator 可避免拷贝回调
     template <class InputIterator>
     void scheduler(InputIterator begin, InputIterator end, std::thread::id thr = std::thread::id()) {
         bool need_tickle = false;
-        {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            while (begin != end) {
-                need_tickle = schedulerNoLock(*begin, thr) || need_tickle;
-                ++begin;
-            }
+        while (begin != end) {
+            need_tickle = schedulerNoLock(*begin, thr) || need_tickle;
+            ++begin;
         }
         if (need_tickle) tickle();
     }
@@ -96,67 +95,215 @@ public:
     int getActiveCount() const {
         return m_activeThreadCount.load();
     }                             // 活跃线程数（正在执行任务）
-    size_t getTaskCount() const { // 任务队列长度
-        std::lock_guard<std::mutex> lock(m_mutex);
-        return m_fibers.size();
+    size_t getTaskCount() const { // 待执行任务数（所有队列之和，无锁近似值）
+        return m_taskCount.load(std::memory_order_relaxed);
     }
 
+    // 运行时指标（自 start 起累计，用于区分延迟来自调度还是 I/O）
+    // 队列等待：任务从入队到开始执行的时间，按 scheduler.queue_wait_sample 采样（直方图的总数是样本数，
+    // 不是任务数）；第 0 桶 < 1us，第 k 桶 [2^(k-1), 2^k) us，最后一桶为溢出
+    static constexpr size_t QUEUE_WAIT_BUCKETS = 22;
+    // 每次 reactor 唤醒（epoll_wait / io_uring_enter 返回）取到的事件数：第 0 桶为 0 个，
+    // 第 k 桶 [2^(k-1), 2^k)，最后一桶为溢出
+    static constexpr size_t WAKEUP_EVENT_BUCKETS = 12;
+
+    // 一个线程（或若干线程之和）的计数快照
+    struct ThreadStats {
+        uint64_t tasks = 0;           // 执行的任务数
+        uint64_t fiberResumes = 0;    // 其中恢复协程任务的次数（挂起后被唤醒 / 直接提交的协程），其余是回调任务
+        uint64_t queueWaitNs = 0;     // 采样任务的队列等待时间之和
+        uint64_t queueWait[QUEUE_WAIT_BUCKETS] = {};
+        uint64_t stealAttempts = 0;   // 尝试从其他线程（非空的）本地队列窃取的次数
+        uint64_t steals = 0;          // 其中取到任务的次数
+        uint64_t ticklesSent = 0;     // 本线程发出的唤醒
+        uint64_t ticklesReceived = 0; // 本线程被唤醒（读到 eventfd / 条件变量返回）的次数
+        uint64_t wakeups = 0;         // IOManager：reactor 唤醒次数
+        uint64_t wakeupEvents = 0;    // IOManager：唤醒取到的事件总数
+        uint64_t eventsPerWakeup[WAKEUP_EVENT_BUCKETS] = {};
+        uint64_t spinHits = 0;        // 空闲自旋期间等到了任务（省掉一次睡眠 / 唤醒）
+        uint64_t spinTimeouts = 0;    // 自旋预算用完仍没有任务、转入睡眠
+
+        void merge(const ThreadStats &o);
+    };
+
+    // 调度器的指标快照
+    struct Metrics {
+        std::string name;
+        size_t threads = 0;
+        bool useCaller = false;
+        int active = 0;
+        int idle = 0;
+        size_t queued = 0;
+        uint64_t externalTickles = 0;     // 非本调度器线程发出的唤醒
+        ThreadStats total;                // 所有线程之和（ticklesSent 含 externalTickles）
+        std::vector<ThreadStats> workers; // 每个工作线程；use_caller 时最后一项是调用线程
+    };
+
+    // 取快照：计数器单写者、无锁，读取与工作线程并发（各字段之间不保证是同一时刻）
+    void getMetrics(Metrics &out) const;
+    // 所有存活调度器的快照（按创建顺序）
+    static void GetAllMetrics(std::vector<Metrics> &out);
+
 protected:
     // 唤醒策略（子类可重载，如IOManager需要特殊唤醒）
     // 默认实现：唤醒等待的条件变量
     virtual void tickle();
 
-    // 主循环（虚函数，允许子类覆盖如IOManager）
+    // 主循环（IOManager 等子类通过重载 idle() 定制空闲行为）
     // 工作线程的执行入口：
     // 1. 标记活跃线程
     // 2. 循环从任务队列取任务执行
-    // 3. 空闲时等待条件变量
+    // 3. 取不到任务时调用 idle()
     virtual void run();
 
+    // 空闲处理：没有可执行任务时调用，返回后 run() 会重新尝试取任务
+    // 默认实现：在条件变量上等待新任务或停止信号
+    virtual void idle();
+
+    // 当前线程是否还有可执行的任务（供 idle() 判断是否需要阻塞）
+    bool hasPendingTask() const;
+
+    // 睡眠前的短暂自旋（scheduler.spin_max_us）：用 pause 忙等新任务，每隔若干轮调用一次 pollIdle()
+    // 返回 true 表示等到了任务（或正在停止），调用方直接返回 run() 取任务；返回 false 表示应当睡眠
+    // - 只有工作线程自旋，同时自旋的线程不超过工作线程数的一半
+    // - 一开始就有任务时返回 false，交给调用方原有的处理（例如 IOManager 仍会先轮询一次 epoll）
+    // - 自旋时长按结果自适应：等到任务时加倍，超时减半（上限 spin_max_us，下限其 1/16）
+    bool spinIdle();
+
+    // 自旋期间的非阻塞轮询（IOManager 重载为 epoll_wait(0) + 到期定时器），有新任务就绪返回 true
+    virtual bool pollIdle() {
+        return false;
+    }
+
+    // tickle() 是否可以省掉：有线程正在自旋，且它一定能执行新任务（没有 pinned 任务、不在停止）
+    // 其中的 fence 与 spinIdle() 退出时 "m_spinningCount 减一 -> fence -> 检查任务" 配对：
+    // 要么这里看到有人在自旋，要么自旋的线程看到新任务
+    bool spinnerWillSee() const;
+
+    // 批量入队但不唤醒，返回是否有空闲线程（调用方合并多批任务后自行决定是否 tickle）
+    template <class InputIterator>
+    bool schedulerNoTickle(InputIterator begin, InputIterator end, std::thread::id thr = std::thread::id()) {
+        bool has_idle = false;
+        while (begin != end) {
+            has_idle = schedulerNoLock(*begin, thr) || has_idle;
+            ++begin;
+        }
+        return has_idle;
+    }
+
+    // 当前线程是否是本调度器的工作线程（工作线程提交的任务进入自己的本地队列）
+    bool isWorkerThread() const {
+        return currentWorkerIndex() >= 0;
+    }
+
+    // 当前线程在本调度器中的工作线程下标（非工作线程返回 -1）
+    int currentWorkerIndex() const;
+
+    // 第 idx 个工作线程的线程 id（start() 之后有效，越界返回空 id）
+    std::thread::id workerThreadId(size_t idx) const;
+
+    // 第 idx 个工作线程的 pinned 队列是否（近似）为空
+    bool workerPinnedEmpty(size_t idx) const;
+
     // 绑定当前线程到调度器（用于主协程）
     void setThis();
 
-private:
-    // 无锁提交任务（关键内部函数）
-    // 返回值：是否需要唤醒线程（队列从空变非空）
-    template <class FiberOrCb>
-    bool schedulerNoLock(FiberOrCb fc, std::thread::id thr);
+    // 单写者计数器：只由所属线程写（load + store，不需要 lock 前缀），其他线程随时可以读
+    struct StatCounter {
+        std::atomic<uint64_t> v{0};
+
+        void add(uint64_t n = 1) {
+            v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+        uint64_t get() const {
+            return v.load(std::memory_order_relaxed);
+        }
+    };
 
-    // 从队列取一个任务（原子操作）
-    // 输出参数：
-    // out_fiber: 协程对象（若任务是协程）
-    // out_cb: 函数对象（若任务是函数）
-    bool takeOneTask(Fiber::ptr &out_fiber, std::function<void()> &out_cb);
+    // 每个线程一份计数，按缓存行对齐：不同线程的计数不会落在同一行上互相失效
+    struct alignas(64) ThreadCounters {
+        StatCounter tasks;
+        StatCounter fiberResumes;
+        StatCounter queueWaitNs;
+        StatCounter queueWait[QUEUE_WAIT_BUCKETS];
+        StatCounter stealAttempts;
+        StatCounter steals;
+        StatCounter ticklesSent;
+        StatCounter ticklesReceived;
+        StatCounter wakeups;
+        StatCounter wakeupEvents;
+        StatCounter eventsPerWakeup[WAKEUP_EVENT_BUCKETS];
+        StatCounter spinHits;
+        StatCounter spinTimeouts;
+
+        void snapshot(ThreadStats &out) const;
+    };
+
+    // 当前线程在本调度器中的计数（不是本调度器的线程返回 nullptr）
+    ThreadCounters *localCounters() const;
+    // 记录一次唤醒：本调度器的线程记在自己的计数里，其他线程记在共享的 externalTickles 上
+    void countTickleSent();
+    // IOManager：一次 reactor 唤醒取到 n 个事件
+    void countWakeup(int n);
+    // 条件变量唤醒，不计数（tickle 与 IOManager 单 reactor 模式共用）
+    void notifyWaiters();
 
 private:
     // 任务结构体：保存任务和所属线程ID
+    // 回调使用只能移动的 Task（小对象内联存放），整个结构体在队列之间只移动不拷贝
     struct FiberAndThread {
         std::thread::id threadid; // 任务指定执行的线程ID
-        std::function<void()> cb; // 函数式任务
+        Task cb;                  // 函数式任务
         Fiber::ptr fiber;         // 协程任务
+        uint64_t enqueued = 0;    // 入队时间（单调时钟 ns，0 表示未采样），用于队列等待直方图
 
-        // 默认构造
         FiberAndThread() = default;
-        // 协程构造
-        FiberAndThread(Fiber::ptr f, std::thread::id thr) :
-            threadid(thr), fiber(f) {
-        }
-        // 函数对象构造
-        FiberAndThread(const std::function<void()> &f, std::thread::id thr) :
-            threadid(thr), cb(f) {
+        FiberAndThread(FiberAndThread &&) noexcept = default;
+        FiberAndThread &operator=(FiberAndThread &&) noexcept = default;
+    };
+
+    // 每个工作线程的运行队列
+    // local: 未指定线程的任务，owner 无锁压入/弹出，其他线程空闲时从这里窃取
+    // pinned: 指定到该线程执行的任务，任意线程可压入，只有 owner 消费（不会被窃取）
+    struct Worker {
+        explicit Worker(size_t capacity) :
+            local(capacity), pinned(capacity) {
         }
+        RingQueue<FiberAndThread> local;
+        RingQueue<FiberAndThread> pinned;
+        std::thread::id threadId;
+        ThreadCounters counters;
+        uint64_t spinBudgetNs = 0; // 本线程当前的自旋时长（只由本线程读写）
     };
 
+    // 构造任务结构体并入队（模板部分，负责类型分派）
+    // 返回值：是否需要唤醒线程（有空闲线程）
+    template <class FiberOrCb>
+    bool schedulerNoLock(FiberOrCb &&fc, std::thread::id thr);
+
+    // 按规则把任务放入本地 / pinned / 全局队列
+    bool enqueue(FiberAndThread &&ft);
+
+    // 取一个任务：pinned -> 本地 -> 全局 -> 窃取其他工作线程
+    bool takeOneTask(FiberAndThread &out);
+
+    // 根据线程 id 找到对应的工作线程下标（找不到返回 -1）
+    int workerIndexOf(std::thread::id thr) const;
+
 protected:
-    // 工作线程列表（管理线程生命周期）
-    std::vector<std::shared_ptr<std::thread>> m_threads;
+    // 工作线程列表（管理线程生命周期，线程名为 "<调度器名>_<下标>"）
+    std::vector<Thread::ptr> m_threads;
     // 工作线程ID列表（用于线程绑定检查）
     std::vector<std::thread::id> threadIds;
-    // 任务队列：存储FiberAndThread结构体
-    std::list<FiberAndThread> m_fibers;
+    // 每个工作线程的运行队列（start() 时创建，之后不再增删）
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    // 全局任务队列：外部线程提交、本地队列溢出的任务
+    CircularBuffer<FiberAndThread> m_fibers;
+    // 全局 pinned 队列：目标不是工作线程（如 use_caller 的调用线程）或目标 pinned 队列已满的任务
+    CircularBuffer<FiberAndThread> m_pinnedFibers;
     // 调度器名称（用于日志标识）
     std::string m_name;
-    // 任务队列互斥锁（保护m_fibers）
+    // 全局队列互斥锁（保护m_fibers / m_pinnedFibers，同时配合m_cond使用）
     mutable std::mutex m_mutex;
     // 条件变量：工作线程等待任务
     std::condition_variable m_cond;
@@ -166,6 +313,23 @@ protected:
     // 线程状态计数器（原子操作，避免锁开销）
     std::atomic<int> m_activeThreadCount{0}; // 正在执行任务的线程数
     std::atomic<int> m_idleThreadCount{0};   // 空闲线程数
+    std::atomic<size_t> m_taskCount{0};      // 所有队列中待执行的任务总数
+    std::atomic<size_t> m_pinnedCount{0};    // 其中位于 pinned 队列的任务数
+    std::atomic<size_t> m_globalCount{0};    // 其中位于全局队列的任务数
+
+    // 运行时指标：工作线程的计数在各自的 Worker 里，这里是调用线程（use_caller）的计数与外部线程的唤醒数
+    std::unique_ptr<ThreadCounters> m_rootCounters;
+    std::atomic<uint64_t> m_externalTickles{0};
+    uint32_t m_waitSample = 0; // 队列等待采样间隔（构造时读取 scheduler.queue_wait_sample）
+
+    // 工作线程绑核（构造时读取 scheduler.affinity / scheduler.affinity_cpus）
+    std::string m_affinity;
+    std::vector<int> m_affinityCpus;
+
+    // 空闲自旋（构造时读取 scheduler.spin_max_us，0 表示关闭）
+    uint64_t m_spinMaxNs = 0;
+    int m_spinLimit = 1;                 // 同时自旋的线程数上限
+    std::atomic<int> m_spinningCount{0}; // 当前正在自旋的线程数
 
     // 停止状态
     std::atomic<bool> m_stopping{true}; // 是否正在停止
@@ -175,29 +339,34 @@ protected:
     // 主协程相关
     std::thread::id m_rootThread; // 主协程所在线程ID
     Fiber::ptr m_rootFiber;       // 主协程对象
+
+    // 每个工作线程本地队列 / pinned 队列的容量（溢出时落到全局队列）
+    static constexpr size_t LOCAL_QUEUE_CAPACITY = 1024;
+    // 每个线程回收的已结束协程数量上限（复用给后续的回调任务）
+    static constexpr size_t FIBER_POOL_CAPACITY = 32;
+    // 自旋时每隔多少次 pause 调用一次 pollIdle() 并检查是否超时
+    static constexpr uint32_t SPIN_POLL_INTERVAL = 32;
 };
 
-// 模板函数实现：无锁提交任务
+// 模板函数实现：构造任务并入队
 template <class FiberOrCb>
-bool Scheduler::schedulerNoLock(FiberOrCb fc, std::thread::id thr) {
-    bool need_tickle = m_fibers.empty(); // 任务队列是否为空（用于判断是否需要唤醒线程）
-    FiberAndThread ft;                   // 创建任务结构体
+bool Scheduler::schedulerNoLock(FiberOrCb &&fc, std::thread::id thr) {
+    FiberAndThread ft; // 创建任务结构体
 
     // 类型判断：根据任务类型填充结构体
     if constexpr (std::is_same_v<std::decay_t<FiberOrCb>, Fiber::ptr>) {
-        ft.fiber = fc; // 任务是协程
-    } else if constexpr (std::is_same_v<std::decay_t<FiberOrCb>, std::function<void()>>) {
-        ft.cb = fc; // 任务是函数
+        if (!fc) return false;
+        // 共享栈协程只能在绑定的线程上恢复：绑定线程优先于调用方指定的线程
+        // （多 reactor 模式下 fd 的唤醒指定为 fd 所在 reactor 的线程，它可能不是协程绑定的线程）
+        std::thread::id bound = fc->getBoundThread();
+        if (bound != std::thread::id()) thr = bound;
+        ft.fiber = std::forward<FiberOrCb>(fc); // 任务是协程
     } else {
-        ft.cb = (std::function<void()>)fc; // 其他类型转换为函数对象
+        ft.cb = Task(std::forward<FiberOrCb>(fc)); // 任务是函数（右值直接移动进来）
+        if (!ft.cb) return false;
     }
     ft.threadid = thr; // 记录任务指定线程ID
-
-    // 有效任务才入队
-    if (ft.fiber || ft.cb) {
-        m_fibers.push_back(std::move(ft));
-    }
-    return need_tickle; // 返回是否需要唤醒（队列从空变非空）
+    return enqueue(std::move(ft));
 }
 
 } // namespace sunshine
\ No newline at end of file
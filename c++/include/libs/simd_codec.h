@@ -0,0 +1,36 @@
+// file: libs/simd_codec.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace sunshine {
+
+// ByteArray 批量接口使用的编解码内核：LEB128 varint 编解码与数组字节序翻转
+// - 编码格式与 ByteArray::writeUint32 / writeUint64 逐个写出的完全相同（每字节 7 位，高位为续接位），可以混用
+// - 首次调用时按 CPU 特性选择实现：x86-64 上 AVX2(+BMI2) / SSE4.1，aarch64 上 NEON，其余为标量实现
+// - 解码思路同 masked-VByte：一次取 16 / 32 字节，用续接位掩码定位窗口内每个值的结束字节，
+//   全是单字节值时直接整段零扩展写出
+class SimdCodec {
+public:
+    // 32 位 varint 最长 5 字节，64 位最长 10 字节
+    static const size_t MAX_VARINT32 = 5;
+    static const size_t MAX_VARINT64 = 10;
+
+    // 把 n 个值编码到 out（容量至少 n * MAX_VARINTxx），返回写入的字节数
+    static size_t EncodeVarint32(const uint32_t *in, size_t n, uint8_t *out);
+    static size_t EncodeVarint64(const uint64_t *in, size_t n, uint8_t *out);
+
+    // 从 in[0, len) 解出最多 n 个完整的值，返回解出的个数，*consumed 为消耗的字节数
+    // 遇到在 len 内没有结束的值就停下（留给调用方跨块处理）；超长的值与 readUint32 / readUint64 一样按最大长度截断
+    static size_t DecodeVarint32(const uint8_t *in, size_t len, uint32_t *out, size_t n, size_t *consumed);
+    static size_t DecodeVarint64(const uint8_t *in, size_t len, uint64_t *out, size_t n, size_t *consumed);
+
+    // n 个 width（2 / 4 / 8）字节元素逐个翻转字节序，dst 与 src 可以相同
+    static void ByteSwap(void *dst, const void *src, size_t n, size_t width);
+
+    // 当前使用的实现："avx2" / "sse4.1" / "neon" / "scalar"
+    static const char *Backend();
+};
+
+} // namespace sunshine
@@ -6,6 +6,7 @@
 #include <ostream>
 #include <cstdint>
 #include "libs/address.h"
+#include "libs/bytearray.h"
 #include "libs/log.h"
 
 namespace sunshine {
@@ -20,6 +21,7 @@ namespace sunshine {
  */
 class Socket : public std::enable_shared_from_this<Socket> {
 public:
+    using ptr = std::shared_ptr<Socket>;
     using shared_ptr = std::shared_ptr<Socket>;
     using weak_ptr = std::weak_ptr<Socket>;
 
@@ -50,8 +52,13 @@ public:
     Socket::shared_ptr accept(); // 接受客户端连接（服务器端）
 
     bool init(int sock);                                                       // 由外部句柄创建并接管
+    // 接管 accept4(SOCK_CLOEXEC) 得到的已连接 fd：远端地址直接用 accept 返回的 peer，
+    // 本地地址按需 getsockname，只设置 TCP_NODELAY（init 的 getsockopt / getsockname / getpeername 都省掉）
+    bool initAccepted(int sock, const sockaddr *peer, socklen_t peerlen);
     bool bind(const Address::ptr addr);                                        // 绑定
     bool connect(const Address::ptr addr, uint64_t timeout_ms = (uint64_t)-1); // 连接（支持超时）
+    // 按域名连接（"host:port"），经 DnsResolver 缓存解析为本 socket 的协议族，依次尝试直到连上
+    bool connect(const std::string &host, uint64_t timeout_ms = (uint64_t)-1);
     bool listen(int backlog = SOMAXCONN);                                      // 监听
     bool close();                                                              // 关闭
 
@@ -71,6 +78,32 @@ public:
     int recvFrom(void *buff, size_t length, Address::ptr &peer, int flags = 0);
     int recvFrom(iovec *buff, size_t length, Address::ptr &peer, int flags = 0);
 
+    // 直接在 ByteArray 的节点链上 sendmsg / recvmsg，不经过临时 string
+    // send：发送从 position 开始最多 length 字节的可读数据，成功后 position 前移实际发送的字节数
+    // recv：最多接收 length 字节写到 position 处（按需扩容），成功后 position 与 size 前移实际接收的字节数
+    // 单次调用的 iovec 数不超过 IOV_MAX，超出部分需要再次调用；返回值同 send / recv
+    int send(ByteArray &ba, size_t length = ~0ull, int flags = 0);
+    int recv(ByteArray &ba, size_t length, int flags = 0);
+    // 发送切片中从 offset 开始的数据（一次 sendmsg，iovec 直接指向共享块），返回值同 send
+    // 部分发送时由调用方累加 offset 继续发送；广播时多个连接可以共享同一个切片
+    int send(const ByteSlice &slice, size_t offset = 0, int flags = 0);
+
+    // MSG_ZEROCOPY：开启后 send(ByteArray&) 中不小于 socket.zerocopy_threshold 的发送不再拷贝到内核，
+    // 内核直接引用用户页，发送完成后通过错误队列通知。收到完成通知之前 ByteArray 的这段内存不能被改写或释放
+    // 开启失败（内核不支持 / 非 TCP）返回 false
+    bool setZeroCopy(bool v);
+    bool isZeroCopy() const {
+        return m_zeroCopy;
+    }
+    // 非阻塞地读取错误队列上的完成通知，返回本次确认完成的零拷贝发送次数，失败返回 -1
+    int reapZeroCopy();
+    // 已发出但还没收到完成通知的零拷贝发送次数
+    uint32_t getZeroCopyPending() const {
+        return m_zcSent - m_zcDone;
+    }
+    // 等到所有零拷贝发送都完成（timeout_ms 为 -1 表示不限时），超时返回 false
+    bool waitZeroCopy(int64_t timeout_ms = -1);
+
     // 本地/远端地址
     Address::ptr getLocalAddress();
     Address::ptr getRemoteAddress();
@@ -112,6 +145,9 @@ private:
     int m_type;
     int m_protocol;
     bool m_isConnected;
+    bool m_zeroCopy = false;
+    uint32_t m_zcSent = 0; // 带 MSG_ZEROCOPY 且成功的发送次数（与内核的通知序号一一对应）
+    uint32_t m_zcDone = 0; // 已收到完成通知的发送次数
 
     Address::ptr m_localAddress;
     Address::ptr m_remoteAddress;
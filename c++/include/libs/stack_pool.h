@@ -0,0 +1,41 @@
+// file: libs/stack_pool.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace sunshine {
+
+// 协程栈分配器：mmap 分配，低地址一侧带一个 PROT_NONE 保护页
+// - 栈溢出会立即触发 SIGSEGV，而不是悄悄踩坏堆内存
+// - 每个线程一个空闲链表（侵入式，节点就放在空闲栈的内存里），归还的栈优先缓存复用，
+//   单线程访问无需加锁；缓存上限由 fiber.stack_pool_max 配置，超出的直接 munmap
+// - 只缓存 fiber.stack_size 大小的栈，其他尺寸直接 mmap / munmap
+class StackPool {
+public:
+    // 分配一块可用大小至少为 size 的栈，返回可用区域的起始地址（保护页之上）
+    // 失败抛出 std::bad_alloc
+    static void *Alloc(size_t &size);
+
+    // 归还栈（size 为 Alloc 返回的实际大小），可以在任意线程调用
+    static void Free(void *stack, size_t size);
+
+    // 向上取整到页大小
+    static size_t RoundToPage(size_t size);
+
+    // 默认协程栈大小（fiber.stack_size，已按页取整）
+    static size_t DefaultSize();
+
+    // 当前线程缓存的空闲栈数量
+    static size_t CachedCount();
+
+    // 全局统计：实际执行过的 mmap 次数 / 当前存活（已分配且未 munmap）的栈数量
+    static uint64_t TotalMapped();
+    static uint64_t LiveStacks();
+
+    // 直接 mmap / munmap 一块带保护页的栈（不经过缓存；共享栈等长期持有的栈使用）
+    static void *Map(size_t size);
+    static void Unmap(void *stack, size_t size);
+};
+
+} // namespace sunshine
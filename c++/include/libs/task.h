@@ -0,0 +1,139 @@
+// file: libs/task.h
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace sunshine {
+
+// Task：只能移动的 void() 可调用对象，调度器任务与协程入口使用
+// - 不超过 INLINE_SIZE 字节、且移动不抛异常的可调用对象直接存放在对象内部（小对象优化），
+//   不发生堆分配；更大的才放到堆上
+// - 与 std::function 不同，不要求可拷贝，也不会在拷贝时复制被捕获的状态
+// - 空的 std::function / 函数指针构造出空 Task
+class Task {
+public:
+    static constexpr size_t INLINE_SIZE = 48;
+
+    Task() noexcept = default;
+    Task(std::nullptr_t) noexcept {
+    }
+
+    template <class F, class Fn = std::decay_t<F>,
+              class = std::enable_if_t<!std::is_same_v<Fn, Task> && std::is_invocable_r_v<void, Fn &>>>
+    Task(F &&f) {
+        if constexpr (std::is_constructible_v<bool, const Fn &>) {
+            if (!static_cast<bool>(f)) return; // 空 std::function / 空函数指针
+        }
+        if constexpr (IsInline<Fn>()) {
+            new (m_buf) Fn(std::forward<F>(f));
+            m_ops = &InlineOps<Fn>::ops;
+        } else {
+            *reinterpret_cast<Fn **>(m_buf) = new Fn(std::forward<F>(f));
+            m_ops = &HeapOps<Fn>::ops;
+        }
+    }
+
+    Task(Task &&other) noexcept {
+        moveFrom(other);
+    }
+
+    Task &operator=(Task &&other) noexcept {
+        if (this != &other) {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    Task &operator=(std::nullptr_t) noexcept {
+        reset();
+        return *this;
+    }
+
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+
+    ~Task() {
+        reset();
+    }
+
+    explicit operator bool() const noexcept {
+        return m_ops != nullptr;
+    }
+
+    void operator()() {
+        if (!m_ops) throw std::bad_function_call();
+        m_ops->invoke(m_buf);
+    }
+
+    // 释放持有的可调用对象
+    void reset() noexcept {
+        if (m_ops) {
+            m_ops->destroy(m_buf);
+            m_ops = nullptr;
+        }
+    }
+
+private:
+    struct Ops {
+        void (*invoke)(void *self);
+        void (*move)(void *dst, void *src) noexcept; // 移动构造到 dst 并析构 src
+        void (*destroy)(void *self) noexcept;
+    };
+
+    template <class Fn>
+    static constexpr bool IsInline() {
+        return sizeof(Fn) <= INLINE_SIZE && alignof(Fn) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible_v<Fn>;
+    }
+
+    // 内联存放：对象本身在 m_buf 里
+    template <class Fn>
+    struct InlineOps {
+        static void invoke(void *self) {
+            (*std::launder(reinterpret_cast<Fn *>(self)))();
+        }
+        static void move(void *dst, void *src) noexcept {
+            Fn *s = std::launder(reinterpret_cast<Fn *>(src));
+            new (dst) Fn(std::move(*s));
+            s->~Fn();
+        }
+        static void destroy(void *self) noexcept {
+            std::launder(reinterpret_cast<Fn *>(self))->~Fn();
+        }
+        static constexpr Ops ops = {&invoke, &move, &destroy};
+    };
+
+    // 堆上存放：m_buf 里只有一个指针，移动时只搬指针
+    template <class Fn>
+    struct HeapOps {
+        static void invoke(void *self) {
+            (**reinterpret_cast<Fn **>(self))();
+        }
+        static void move(void *dst, void *src) noexcept {
+            *reinterpret_cast<Fn **>(dst) = *reinterpret_cast<Fn **>(src);
+        }
+        static void destroy(void *self) noexcept {
+            delete *reinterpret_cast<Fn **>(self);
+        }
+        static constexpr Ops ops = {&invoke, &move, &destroy};
+    };
+
+    void moveFrom(Task &other) noexcept {
+        if (other.m_ops) {
+            other.m_ops->move(m_buf, other.m_buf);
+            m_ops = other.m_ops;
+            other.m_ops = nullptr;
+        }
+    }
+
+private:
+    alignas(std::max_align_t) unsigned char m_buf[INLINE_SIZE];
+    const Ops *m_ops = nullptr;
+};
+
+} // namespace sunshine
@@ -0,0 +1,75 @@
+// file: libs/tcp_server.h
+#pragma once
+
+#include "libs/address.h"
+#include "libs/iomanager.h"
+#include "libs/socket.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace sunshine {
+
+// TcpServer：通用 TCP 服务器
+// - 可以绑定多个地址（bindConfigPorts 按 server.ports 绑定），每个监听 socket 在 acceptor 上有一个 accept 协程
+// - accept 协程等监听 fd 可读后循环 accept4，直到 EAGAIN 或取满 tcp_server.accept_batch 个；
+//   这一批连接用一次批量提交交给 worker，每个连接在自己的协程里执行 handleClient
+// - 取满一批时先让出再继续取，不等下一次可读事件；fd 用完（EMFILE 等）时暂停 100ms 再 accept
+// - 客户端 socket 的读超时取 tcp_server.read_timeout（直接写入 FdCtx，不额外调用 setsockopt）
+// - stop 只停止 accept 并关闭监听 socket，已建立的连接由各自的 handleClient 处理完（读超时保证不会无限等待）
+// 子类重写 handleClient；对象必须由 shared_ptr 持有（accept 协程与连接协程都持有服务器的引用）
+class TcpServer : public std::enable_shared_from_this<TcpServer> {
+public:
+    typedef std::shared_ptr<TcpServer> ptr;
+
+    // worker 运行连接协程，acceptor 运行 accept 协程；两者可以是同一个 IOManager
+    explicit TcpServer(IOManager *worker = IOManager::GetThis(), IOManager *acceptor = IOManager::GetThis());
+    virtual ~TcpServer();
+
+    // 绑定并监听 addr（backlog 取 tcp_server.backlog）
+    virtual bool bind(Address::ptr addr);
+    // 依次绑定 addrs，绑定失败的地址放到 fails；有失败时关闭已绑定的全部 socket 并返回 false
+    virtual bool bind(const std::vector<Address::ptr> &addrs, std::vector<Address::ptr> &fails);
+    // 在 host 上绑定 server.ports 配置的所有端口
+    bool bindConfigPorts(const std::string &host = "0.0.0.0");
+
+    // 在 acceptor 上为每个监听 socket 启动 accept 协程；已启动或没有监听 socket 时返回 false
+    virtual bool start();
+    // 停止 accept 并关闭监听 socket（可以在任意线程调用，重复调用无效果）
+    virtual void stop();
+
+    bool isStop() const {
+        return m_stopping.load(std::memory_order_acquire);
+    }
+    // 当前正在 handleClient 里的连接数
+    uint64_t getConnections() const {
+        return m_connections.load(std::memory_order_relaxed);
+    }
+    const std::string &getName() const {
+        return m_name;
+    }
+    void setName(const std::string &v) {
+        m_name = v;
+    }
+    std::vector<Address::ptr> getLocalAddresses() const;
+
+protected:
+    // 在 worker 的协程里处理一个连接，返回后连接的 Socket 引用被释放；默认实现直接关闭
+    virtual void handleClient(Socket::ptr client);
+
+private:
+    void acceptLoop(Socket::ptr sock);
+
+private:
+    IOManager *m_worker;
+    IOManager *m_acceptor;
+    std::vector<Socket::ptr> m_socks;
+    std::string m_name = "sunshine/1.0";
+    std::atomic<bool> m_started{false};
+    std::atomic<bool> m_stopping{false};
+    std::atomic<uint64_t> m_connections{0};
+};
+
+} // namespace sunshine
@@ -1,30 +1,77 @@
-#include <thread>
-#include <memory>
+// file: libs/thread.h
+#pragma once
+
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <pthread.h>
+#include <semaphore>
 #include <string>
+#include <vector>
+
 namespace sunshine {
+
+// Thread：带名字与 CPU 亲和性的 pthread 封装
+// - 构造返回时线程已经启动，并且已经设置好名字（pthread_setname_np，截断到 15 字符）与亲和性，
+//   getId() 可以直接读取内核 tid
+// - 亲和性在执行回调之前设置：回调里首次访问的内存按 first-touch 分配在线程所在的 NUMA 节点上
+// - 析构时未 join 的线程被 detach
 class Thread {
 public:
     typedef std::shared_ptr<Thread> ptr;
-    Thread(std::function<void()> cb, std::string &name);
+
+    // cpus 为空表示不绑定（继承创建线程的亲和性）
+    Thread(std::function<void()> cb, const std::string &name, std::vector<int> cpus = {});
     ~Thread();
-    uint32_t getId();
-    const std::string &getName() const;
-    void join(); //阻塞线程，等待这个线程结束
-    static Thread *GetThis();
-    static void SetName(const std::string name);
 
-protected:
     Thread(const Thread &) = delete;
-    Thread(const Thread &&) = delete;
     Thread &operator=(const Thread &) = delete;
+
+    uint32_t getId() const {
+        return m_id;
+    }
+    const std::string &getName() const {
+        return m_name;
+    }
+    const std::vector<int> &getCpus() const {
+        return m_cpus;
+    }
+    // 阻塞等待线程结束
+    void join();
+
+    // 当前线程对应的 Thread（不是 Thread 创建的线程返回 nullptr）
+    static Thread *GetThis();
+    // 当前线程的名字（不是 Thread 创建、也没有调用过 SetName 的线程为 "UNKNOWN"）
+    static const std::string &GetName();
+    // 设置当前线程的名字
+    static void SetName(const std::string &name);
+    // 把当前线程绑定到 cpus 上，失败返回 false
+    static bool SetAffinity(const std::vector<int> &cpus);
+
+private:
     static void *run(void *arg);
 
 private:
-    uint32_t m_id = -1;         //线程id
-    pthread_t m_thread = 0;     //线程
-    std::string m_name;         //线程名
-    std::function<void()> m_cb; //方法
+    uint32_t m_id = 0;          // 内核线程 id
+    pthread_t m_thread = 0;
+    std::string m_name;
+    std::vector<int> m_cpus;
+    std::function<void()> m_cb;
+    std::binary_semaphore m_started{0}; // run() 设置好 id / 名字 / 亲和性后通知构造函数返回
 };
-} // namespace sunshine
\ No newline at end of file
+
+// CPU 拓扑：可用 CPU 取自进程的亲和性掩码，NUMA 节点读取 /sys/devices/system/node（只读一次）
+// 没有 NUMA 信息（内核不支持或非 Linux）时视为所有 CPU 在同一个节点 0 上
+class CpuTopology {
+public:
+    // 进程允许运行的 CPU（升序）
+    static const std::vector<int> &AllowedCpus();
+    // 有可用 CPU 的 NUMA 节点（升序）
+    static const std::vector<int> &Nodes();
+    // 节点 node 上可用的 CPU（升序）
+    static std::vector<int> NodeCpus(int node);
+    // cpu 所在的节点（未知返回 0）
+    static int NodeOf(int cpu);
+};
+
+} // namespace sunshine
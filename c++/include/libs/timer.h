@@ -0,0 +1,119 @@
+// file: libs/timer.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace sunshine {
+
+class TimerManager;
+
+// 定时器：由 TimerManager::addTimer / addConditionTimer 创建
+// 支持取消、刷新（从当前时间重新计时）、重设超时时间
+class Timer : public std::enable_shared_from_this<Timer> {
+    friend class TimerManager;
+
+public:
+    using ptr = std::shared_ptr<Timer>;
+
+    // 取消定时器（回调不会再被执行）；已到期或已取消返回 false
+    bool cancel();
+    // 从当前时间重新开始计时（间隔不变）
+    bool refresh();
+    // 重设间隔：from_now=true 从当前时间开始计时，否则从原来的起点开始计时
+    bool reset(uint64_t ms, bool from_now);
+
+private:
+    Timer(uint64_t ms, std::function<void()> cb, bool recurring, TimerManager *manager);
+
+private:
+    bool m_recurring = false;         // 是否循环定时器
+    uint64_t m_ms = 0;                // 执行间隔（毫秒）
+    uint64_t m_next = 0;              // 绝对到期时间（毫秒，单调时钟）
+    std::function<void()> m_cb;       // 回调
+    TimerManager *m_manager = nullptr; // 所属管理器
+
+    // 时间轮槽位中的侵入式双向链表节点（O(1) 插入 / 摘除）
+    Timer *m_prev = nullptr;
+    Timer *m_nextNode = nullptr;
+    Timer **m_slot = nullptr; // 所在槽位的链表头（nullptr 表示不在时间轮中）
+    int m_level = -1;         // 所在层级
+    int m_index = -1;         // 所在槽位下标
+    ptr m_self;               // 挂在时间轮上期间由时间轮持有自身引用
+};
+
+// 定时器管理器：分层时间轮（hierarchical timing wheel）
+// - 精度 1ms；第 0 层 256 个槽位，第 1~4 层各 64 个槽位，覆盖 2^32ms（约 49 天）
+// - 插入 / 取消 / 刷新均为 O(1)；到期时高层槽位按需向低层"下放"（cascade）
+// - 每层维护非空槽位的位图，getNextTimer() 可以快速找到最近的到期点
+class TimerManager {
+    friend class Timer;
+
+public:
+    TimerManager();
+    virtual ~TimerManager();
+
+    // 添加定时器
+    // ms: 超时时间（毫秒）
+    // cb: 到期回调
+    // recurring: 是否循环执行
+    Timer::ptr addTimer(uint64_t ms, std::function<void()> cb, bool recurring = false);
+
+    // 添加条件定时器：到期时若 weak_cond 指向的对象已释放则不执行回调
+    Timer::ptr addConditionTimer(uint64_t ms, std::function<void()> cb,
+                                 std::weak_ptr<void> weak_cond, bool recurring = false);
+
+    // 距离最近一个定时器到期还有多少毫秒（没有定时器返回 ~0ull）
+    // 最近的定时器不在第 0 层时返回下一次 cascade 的时间点（不晚于真实到期时间）
+    uint64_t getNextTimer();
+
+    // 取出所有已到期定时器的回调（循环定时器会重新挂回时间轮）
+    void listExpiredCb(std::vector<std::function<void()>> &cbs);
+
+    // 是否还有未到期的定时器
+    bool hasTimer();
+
+    // 单调时钟当前毫秒数
+    static uint64_t GetCurrentMS();
+
+protected:
+    // 新插入的定时器早于当前等待的唤醒时间点时调用（IOManager 用它打断 epoll_wait）
+    virtual void onTimerInsertedAtFront() = 0;
+
+private:
+    static const size_t WHEEL0_BITS = 8;
+    static const size_t WHEELN_BITS = 6;
+    static const size_t WHEEL0_SIZE = 1 << WHEEL0_BITS; // 256
+    static const size_t WHEELN_SIZE = 1 << WHEELN_BITS; // 64
+    static const size_t LEVELS = 5;
+
+    // 把定时器挂到对应层级的槽位上（调用方持有 m_mutex）
+    void link(Timer::ptr timer);
+    // 从时间轮上摘下定时器，返回时间轮持有的那份引用（调用方持有 m_mutex）
+    Timer::ptr unlink(Timer *timer);
+    // 挂入后判断是否需要通知（新定时器早于当前唤醒点）
+    bool checkInsertedAtFront(const Timer::ptr &timer);
+    // 把第 level 层 index 槽位的定时器重新分配到低层
+    void cascade(size_t level, size_t index);
+    // 推进时间轮到 now，到期定时器放入 expired
+    void advance(uint64_t now, std::vector<Timer::ptr> &expired);
+    // 第 0 层从 from 开始（含）到 255 之间第一个非空槽位，没有返回 -1
+    int findWheel0(size_t from) const;
+
+private:
+    std::mutex m_mutex;
+    Timer *m_wheel0[WHEEL0_SIZE] = {};                // 第 0 层槽位
+    Timer *m_wheelN[LEVELS - 1][WHEELN_SIZE] = {};    // 第 1~4 层槽位
+    uint64_t m_bits0[WHEEL0_SIZE / 64] = {};          // 第 0 层非空位图
+    uint64_t m_bitsN[LEVELS - 1] = {};                // 第 1~4 层非空位图
+    uint64_t m_current = 0;                           // 时间轮当前时间（之前的定时器都已处理）
+    size_t m_count = 0;                               // 时间轮上的定时器数量
+    uint64_t m_nextWake = ~0ull;                      // 最近一次 getNextTimer 计算出的唤醒时间点
+    bool m_tickled = false;                           // 唤醒点之前是否已经通知过
+};
+
+} // namespace sunshine
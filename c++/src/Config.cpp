@@ -1,19 +1,137 @@
 // --------------------------- config.cpp ---------------------------
 #include "libs/log.h"
 #include <libs/Config.h>
+#include <linux/membarrier.h>
 #include <ostream>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
 
 namespace sunshine {
 
-// 返回基础指针（线程安全读取）
+// ---------------- ConfigRcu ----------------
+namespace {
+
+struct RcuState {
+    RcuState() {
+        // membarrier PRIVATE_EXPEDITED 需要先登记；成功后 Synchronize 可以替所有读线程执行内存屏障
+        long cmds = syscall(__NR_membarrier, MEMBARRIER_CMD_QUERY, 0, 0);
+        membarrier = cmds > 0 && (cmds & MEMBARRIER_CMD_PRIVATE_EXPEDITED) &&
+                     syscall(__NR_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0;
+    }
+    std::mutex mutex; // 保护 readers，同时串行化 Synchronize
+    std::vector<void *> readers;
+    bool membarrier = false;
+};
+
+// 函数内静态对象，且故意不析构：线程在静态析构阶段退出时仍可能要注销读者
+RcuState &rcuState() {
+    static RcuState *s_state = new RcuState;
+    return *s_state;
+}
+
+void rcuBarrier(const RcuState &st) {
+    if (st.membarrier) {
+        syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0);
+    } else {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+// 读者状态：0 未登记，1 已登记，2 线程已退出（计数槽已注销）
+thread_local int t_rcu_state = 0;
+
+} // namespace
+
+// 线程退出时注销计数槽；整个对象只用来挂析构函数
+struct ConfigRcuThreadExit {
+    ConfigRcu::Reader *reader = nullptr;
+    ~ConfigRcuThreadExit() {
+        t_rcu_state = 2;
+        if (!reader) return;
+        RcuState &st = rcuState();
+        {
+            std::lock_guard<std::mutex> lk(st.mutex);
+            auto &v = st.readers;
+            v.erase(std::remove(v.begin(), v.end(), reader), v.end());
+        }
+        ConfigRcu::t_reader = nullptr;
+        delete reader;
+    }
+};
+static thread_local ConfigRcuThreadExit t_rcu_exit;
+
+ConfigRcu::Reader *ConfigRcu::Register() {
+    if (t_rcu_state == 2) return nullptr;
+    RcuState &st = rcuState();
+    // 只在第一次登记时写一次；其他线程都要先经过这里的静态初始化，之后才会读 s_membarrier
+    static const bool s_init = (s_membarrier = st.membarrier, true);
+    (void)s_init;
+    Reader *r = new Reader;
+    {
+        std::lock_guard<std::mutex> lk(st.mutex);
+        st.readers.push_back(r);
+    }
+    t_rcu_exit.reader = r;
+    t_rcu_state = 1;
+    t_reader = r;
+    return r;
+}
+
+// 1) 屏障：写者之前发布的新指针对所有读者可见，读者已经写入的计数槽对本线程可见
+// 2) 推进宽限期编号，再做一次屏障
+// 3) 等每个读者要么不在临界区（0），要么是在新编号下进入的（一定能看到新指针）
+void ConfigRcu::Synchronize() {
+    RcuState &st = rcuState();
+    std::lock_guard<std::mutex> lk(st.mutex);
+    rcuBarrier(st);
+    uint64_t gp = s_gp.load(std::memory_order_relaxed) + 1;
+    s_gp.store(gp, std::memory_order_release);
+    rcuBarrier(st);
+    for (void *p : st.readers) {
+        Reader *r = static_cast<Reader *>(p);
+        for (;;) {
+            uint64_t c = r->ctr.load(std::memory_order_acquire);
+            if (c == 0 || c == gp) break;
+            sched_yield();
+        }
+    }
+}
+
+// ---------------- Config ----------------
+// 返回基础指针（无锁读取；线程退出阶段退回到加锁读取）
 ConfigVarBase::ptr Config::LookupBase(const std::string &name) {
-    std::shared_lock<std::shared_mutex> sl(s_mutex);
-    auto it = s_datas.find(name);
-    if (it == s_datas.end())
+    ConfigRcu::ReadGuard rg;
+    std::unique_lock<std::mutex> lk(s_mutex, std::defer_lock);
+    if (!rg.locked()) lk.lock();
+    const ConfigMap *m = s_datas.load(std::memory_order_acquire);
+    if (!m) return nullptr;
+    auto it = m->find(name);
+    if (it == m->end())
         return nullptr;
     return it->second;
 }
 
+Config::ConfigMap Config::getAll() {
+    ConfigRcu::ReadGuard rg;
+    std::unique_lock<std::mutex> lk(s_mutex, std::defer_lock);
+    if (!rg.locked()) lk.lock();
+    const ConfigMap *m = s_datas.load(std::memory_order_acquire);
+    return m ? *m : ConfigMap();
+}
+
+void Config::Publish(const std::string &name, ConfigVarBase::ptr var) {
+    const ConfigMap *cur = s_datas.load(std::memory_order_relaxed);
+    ConfigMap *next = cur ? new ConfigMap(*cur) : new ConfigMap;
+    (*next)[name] = std::move(var);
+    s_datas.store(next, std::memory_order_release);
+    if (cur) {
+        ConfigRcu::Synchronize();
+        delete cur;
+    }
+}
+
 // 递归列出 YAML 所有成员（将 nested map 转为 dotted keys）
 void Config::ListAllMember(const std::string &prefix, const YAML::Node &node,
                            std::list<std::pair<std::string, YAML::Node>> &output) {
@@ -34,26 +152,95 @@ void Config::ListAllMember(const std::string &prefix, const YAML::Node &node,
     }
 }
 
-// 根据 YAML 根节点把值写入已注册的 ConfigVar（如果存在）
-void Config::FromYaml(const YAML::Node &root) {
+namespace {
+
+// 批量更新互斥和批量监听器（函数内静态，避免静态初始化顺序问题）
+struct ReloadState {
+    std::mutex applyMutex; // 串行化 FromYaml（ConfigVar 的批量暂存状态依赖它）
+    std::mutex cbMutex;
+    std::map<uint64_t, Config::on_reload_cb> cbs;
+    uint64_t nextId = 1;
+};
+
+ReloadState &reloadState() {
+    static ReloadState s_state;
+    return s_state;
+}
+
+} // namespace
+
+// 根据 YAML 根节点把值写入已注册的 ConfigVar（如果存在），有变化的作为一批发布
+size_t Config::FromYaml(const YAML::Node &root) {
     std::list<std::pair<std::string, YAML::Node>> all;
     ListAllMember("", root, all);
 
-    for (auto &kv : all) {
-        const std::string &key = kv.first;
-        const YAML::Node &node = kv.second;
-        if (key.empty()) continue;
-        auto base = LookupBase(key);
-        if (!base) continue;
-
-        if (node.IsScalar()) {
-            base->fromString(node.Scalar());
-        } else {
-            std::stringstream ss;
-            ss << node;
-            base->fromString(ss.str());
+    ReloadState &rs = reloadState();
+    std::vector<ConfigVarBase::ptr> changed;
+    std::vector<std::function<void()>> notifies;
+    {
+        std::lock_guard<std::mutex> lk(rs.applyMutex);
+        for (auto &kv : all) {
+            const std::string &key = kv.first;
+            if (key.empty()) continue;
+            auto base = LookupBase(key);
+            if (!base) continue;
+            if (base->prepare(kv.second)) changed.push_back(base);
+        }
+        if (changed.empty()) return 0;
+
+        // 所有变化一起发布、只等一次宽限期，之后才调用监听器：监听器看到的是整批更新后的配置
+        for (auto &var : changed) var->publish();
+        ConfigRcu::Synchronize();
+        for (auto &var : changed) {
+            auto fn = var->finish();
+            if (fn) notifies.push_back(std::move(fn));
         }
     }
+    for (auto &fn : notifies) fn();
+
+    std::vector<std::string> names;
+    names.reserve(changed.size());
+    for (auto &var : changed) names.push_back(var->getName());
+    std::vector<on_reload_cb> cbs;
+    {
+        std::lock_guard<std::mutex> lk(rs.cbMutex);
+        for (auto &kv : rs.cbs) cbs.push_back(kv.second);
+    }
+    for (auto &cb : cbs) {
+        try {
+            cb(names);
+        } catch (const std::exception &e) {
+            LOG_ERROR(LogManager::GetInstance().getRoot()) << "Config reload callback exception: " << e.what();
+        } catch (...) {
+            LOG_ERROR(LogManager::GetInstance().getRoot()) << "Config reload callback unknown exception";
+        }
+    }
+    return changed.size();
+}
+
+int Config::LoadFromFile(const std::string &path) {
+    YAML::Node root;
+    try {
+        root = YAML::LoadFile(path);
+    } catch (const std::exception &e) {
+        LOG_ERROR(LogManager::GetInstance().getRoot()) << "Config::LoadFromFile " << path << " failed: " << e.what();
+        return -1;
+    }
+    return static_cast<int>(FromYaml(root));
+}
+
+uint64_t Config::AddReloadListener(on_reload_cb cb) {
+    ReloadState &rs = reloadState();
+    std::lock_guard<std::mutex> lk(rs.cbMutex);
+    uint64_t id = rs.nextId++;
+    rs.cbs[id] = std::move(cb);
+    return id;
+}
+
+void Config::DelReloadListener(uint64_t id) {
+    ReloadState &rs = reloadState();
+    std::lock_guard<std::mutex> lk(rs.cbMutex);
+    rs.cbs.erase(id);
 }
 
 } // namespace sunshine
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "libs/address.h"
+#include "libs/dns_resolver.h"
 #include "libs/log.h"
 #include <memory>
 #include <sstream>
@@ -57,9 +58,11 @@ Address::ptr Address::Create(const sockaddr *addr, socklen_t addrlen) {
     Address::ptr result;
     switch (addr->sa_family) {
     case AF_INET:
+        if (addrlen < sizeof(sockaddr_in)) return nullptr; // 截断的地址
         result.reset(new IPv4Address(*(const sockaddr_in *)addr));
         break;
     case AF_INET6:
+        if (addrlen < sizeof(sockaddr_in6)) return nullptr;
         result.reset(new IPv6Address(*(const sockaddr_in6 *)addr));
         break;
     default:
@@ -71,18 +74,36 @@ Address::ptr Address::Create(const sockaddr *addr, socklen_t addrlen) {
 
 /////////////////////////////////////////////////////////////////
 // Address::Lookup
+// 经过 DnsResolver 的缓存解析，协程里未命中时不阻塞工作线程
+/////////////////////////////////////////////////////////////////
+bool Address::Lookup(std::vector<Address::ptr> &result,
+                     const std::string &host,
+                     int family,
+                     int type,
+                     int protocol) {
+    DnsResolver::Addrs addrs = DnsResolver::GetInstance().resolve(host, family, type, protocol);
+    if (!addrs) {
+        result.clear();
+        return false;
+    }
+    result.assign(addrs->begin(), addrs->end());
+    return !result.empty();
+}
+
+/////////////////////////////////////////////////////////////////
+// Address::Resolve
 // 使用 getaddrinfo 解析 host（支持 "host" / "host:port" / "[ipv6]:port" 等格式）
 // family/type/protocol 用于 hints（可传 AF_UNSPEC/0/0 表示不限定）
 // 解析到的每个 ai_addr 都转换成对应的 Address 并 push 到 result。
 /////////////////////////////////////////////////////////////////
-bool Address::Lookup(std::vector<Address::ptr> &result,
+int Address::Resolve(std::vector<Address::ptr> &result,
                      const std::string &host,
                      int family,
                      int type,
                      int protocol) {
     result.clear();
     if (host.empty()) {
-        return false;
+        return EAI_NONAME;
     }
 
     // 准备 hints
@@ -126,9 +147,9 @@ bool Address::Lookup(std::vector<Address::ptr> &result,
     addrinfo *results = nullptr;
     int error = getaddrinfo(node.c_str(), service, &hints, &results);
     if (error) {
-        LOG_DEBUG(g_logger) << "Address::Lookup getaddrinfo(" << host
+        LOG_DEBUG(g_logger) << "Address::Resolve getaddrinfo(" << host
                             << ") error=" << error << " errmsg=" << gai_strerror(error);
-        return false;
+        return error;
     }
 
     // 遍历链表并转换
@@ -138,7 +159,7 @@ bool Address::Lookup(std::vector<Address::ptr> &result,
     }
 
     freeaddrinfo(results);
-    return !result.empty();
+    return 0;
 }
 
 /////////////////////////////////////////////////////////////////
@@ -0,0 +1,136 @@
+// file: libs/buffer_pool.cpp
+#include "libs/buffer_pool.h"
+#include "libs/Config.h"
+
+#include <atomic>
+#include <new>
+
+namespace sunshine {
+
+static ConfigVar<uint32_t>::ptr g_bytearray_pool_max_bytes = Config::Lookup<uint32_t>(
+    "bytearray.pool_max_bytes", 4 * 1024 * 1024, "max cached ByteArray node bytes per thread");
+
+// 配置缓存：Alloc / Free 在每个节点的分配 / 释放路径上，避免每次都去拿 ConfigVar 的读锁
+static std::atomic<size_t> s_pool_max_bytes{0};
+
+static std::atomic<uint64_t> s_total_allocated{0};
+static std::atomic<uint64_t> s_live_blocks{0};
+
+namespace {
+
+struct _BufferPoolIniter {
+    _BufferPoolIniter() {
+        s_pool_max_bytes = g_bytearray_pool_max_bytes->getValue();
+        g_bytearray_pool_max_bytes->addListener(0x42554650, [](const uint32_t &, const uint32_t &new_val) {
+            s_pool_max_bytes = new_val;
+        });
+    }
+};
+
+static _BufferPoolIniter s_buffer_pool_initer;
+
+// 尺寸档：MIN_CLASS << i，i 在 [0, CLASS_COUNT)
+static const size_t MIN_SHIFT = 6;
+static const size_t CLASS_COUNT = 15; // 64B .. 1MB
+static_assert((BufferPool::MIN_CLASS << (CLASS_COUNT - 1)) == BufferPool::MAX_CLASS, "class table mismatch");
+static_assert((size_t(1) << MIN_SHIFT) == BufferPool::MIN_CLASS, "class table mismatch");
+
+struct FreeBlock {
+    FreeBlock *next;
+};
+
+// 线程局部的空闲块缓存
+struct ThreadCache {
+    FreeBlock *heads[CLASS_COUNT] = {};
+    size_t bytes = 0;
+
+    ~ThreadCache();
+};
+
+// 线程退出析构缓存之后，仍可能有 ByteArray 在该线程销毁（例如静态对象），
+// 这时直接释放；该标记是平凡类型，析构后依然可读
+static thread_local bool t_cache_destroyed = false;
+static thread_local ThreadCache t_cache;
+
+static void *RawAlloc(size_t size) {
+    void *p = ::operator new(size, std::align_val_t(BufferPool::ALIGN));
+    s_total_allocated.fetch_add(1, std::memory_order_relaxed);
+    s_live_blocks.fetch_add(1, std::memory_order_relaxed);
+    return p;
+}
+
+static void RawFree(void *p) {
+    ::operator delete(p, std::align_val_t(BufferPool::ALIGN));
+    s_live_blocks.fetch_sub(1, std::memory_order_relaxed);
+}
+
+ThreadCache::~ThreadCache() {
+    t_cache_destroyed = true;
+    for (size_t i = 0; i < CLASS_COUNT; ++i) {
+        while (heads[i]) {
+            FreeBlock *b = heads[i];
+            heads[i] = b->next;
+            RawFree(b);
+        }
+    }
+    bytes = 0;
+}
+
+// size 所在的尺寸档下标（size <= MAX_CLASS）
+static size_t ClassIndex(size_t size) {
+    if (size <= BufferPool::MIN_CLASS) return 0;
+    return (sizeof(unsigned long) * 8 - __builtin_clzl(size - 1)) - MIN_SHIFT;
+}
+
+} // namespace
+
+size_t BufferPool::RoundSize(size_t size) {
+    if (size > MAX_CLASS) return (size + ALIGN - 1) & ~(ALIGN - 1);
+    return MIN_CLASS << ClassIndex(size);
+}
+
+void *BufferPool::Alloc(size_t size) {
+    if (size > MAX_CLASS) return RawAlloc(RoundSize(size));
+    size_t idx = ClassIndex(size);
+    if (!t_cache_destroyed) {
+        ThreadCache &cache = t_cache;
+        FreeBlock *b = cache.heads[idx];
+        if (b) {
+            cache.heads[idx] = b->next;
+            cache.bytes -= MIN_CLASS << idx;
+            return b;
+        }
+    }
+    return RawAlloc(MIN_CLASS << idx);
+}
+
+void BufferPool::Free(void *ptr, size_t size) {
+    if (!ptr) return;
+    if (size <= MAX_CLASS && !t_cache_destroyed) {
+        size_t idx = ClassIndex(size);
+        size_t bytes = MIN_CLASS << idx;
+        ThreadCache &cache = t_cache;
+        if (cache.bytes + bytes <= s_pool_max_bytes.load(std::memory_order_relaxed)) {
+            FreeBlock *b = static_cast<FreeBlock *>(ptr);
+            b->next = cache.heads[idx];
+            cache.heads[idx] = b;
+            cache.bytes += bytes;
+            return;
+        }
+    }
+    RawFree(ptr);
+}
+
+size_t BufferPool::CachedBytes() {
+    return t_cache_destroyed ? 0 : t_cache.bytes;
+}
+
+uint64_t BufferPool::TotalAllocated() {
+    return s_total_allocated.load(std::memory_order_relaxed);
+}
+
+uint64_t BufferPool::LiveBlocks() {
+    return s_live_blocks.load(std::memory_order_relaxed);
+}
+
+} // namespace sunshine
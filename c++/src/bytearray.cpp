@@ -1,4 +1,6 @@
 #include "libs/bytearray.h"
+#include "libs/buffer_pool.h"
+#include "libs/simd_codec.h"
 #include <boost/endian/conversion.hpp>
 #include <bit> // std::endian
 #include <fstream>
@@ -8,45 +10,63 @@
 #include <iomanip>
 #include <cmath> // ceil
 #include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace sunshine {
 
 /* ========================= Node 实现 ========================= */
 
+// 节点缓冲区来自线程局部的 BufferPool（按尺寸档复用、缓存行对齐），不再每块 new / delete
 ByteArray::Node::Node(size_t s) :
-    ptr(new char[s]), size(s), next(nullptr) {
+    ptr(static_cast<char *>(BufferPool::Alloc(s))), next(nullptr), size(s) {
 }
 
 ByteArray::Node::Node() :
-    ptr(nullptr), size(0), next(nullptr) {
+    ptr(nullptr), next(nullptr), size(0) {
+}
+
+ByteArray::Node::Node(char *p, size_t s, std::shared_ptr<void> o) :
+    ptr(p), next(nullptr), size(s), owner(std::move(o)) {
 }
 
 ByteArray::Node::~Node() {
-    if (ptr) {
-        delete[] ptr;
+    if (ptr && !owner) {
+        BufferPool::Free(ptr, size);
         ptr = nullptr;
     }
 }
 
+void ByteArray::Node::Release(Node *node) {
+    if (node && node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete node;
+}
+
 /* ========================= ByteArray 构造/析构 ========================= */
 
 ByteArray::ByteArray(size_t base_size) :
-    m_size(0),
-    m_capacity(base_size),
     m_baseSize(base_size),
     m_position(0),
+    m_size(0),
+    m_capacity(base_size),
     m_endian((std::endian::native == std::endian::little) ? 0 : 1),
     m_root(new Node(base_size)) {
     m_cur = m_root;
+    m_tail = m_root;
     // 构造时分配一个根节点，m_capacity = base_size
 }
 
 ByteArray::~ByteArray() {
+    if (m_mapFd >= 0) {
+        (void)::ftruncate(m_mapFd, static_cast<off_t>(m_size));
+        ::close(m_mapFd);
+    }
     Node *tmp = m_root;
     while (tmp) {
         Node *n = tmp;
         tmp = tmp->next;
-        delete n;
+        Node::Release(n);
     }
     m_root = nullptr;
     m_cur = nullptr;
@@ -292,10 +312,10 @@ int16_t ByteArray::readInt16() {
     return readFint16();
 }
 int32_t ByteArray::readInt32() {
-    return DecodeZigzag32(readFuint32());
+    return DecodeZigzag32(readUint32());
 }
 int64_t ByteArray::readInt64() {
-    return DecodeZigzag64(readFuint64());
+    return DecodeZigzag64(readUint64());
 }
 
 uint8_t ByteArray::readUint8() {
@@ -374,9 +394,242 @@ std::string ByteArray::readStringVint() {
     return s;
 }
 
+/* ========================= 文件映射 ========================= */
+
+bool ByteArray::mapFile(const std::string &name, bool writable, size_t chunk) {
+    unmapFile();
+    clear();
+
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    if (chunk == 0) chunk = DEFAULT_MAP_CHUNK;
+    chunk = (chunk + page - 1) & ~(page - 1);
+
+    int fd = ::open(name.c_str(), writable ? (O_RDWR | O_CREAT | O_CLOEXEC) : (O_RDONLY | O_CLOEXEC), 0644);
+    if (fd < 0) return false;
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    size_t fsize = static_cast<size_t>(st.st_size);
+    size_t count = std::max<size_t>(1, (fsize + chunk - 1) / chunk);
+    size_t total = count * chunk;
+
+    void *base = MAP_FAILED;
+    if (writable) {
+        // 文件先扩展到整块，最后一块的剩余容量也能直接写（结束时再截断回实际长度）
+        if (::ftruncate(fd, static_cast<off_t>(total)) == 0) {
+            base = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+    } else {
+        // 先占一段完整块大小的匿名私有映射，再把文件覆盖映射到开头：
+        // 文件末尾之后是普通匿名内存，访问不会 SIGBUS；写入只改私有副本
+        base = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base != MAP_FAILED && fsize > 0
+            && ::mmap(base, fsize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+            ::munmap(base, total);
+            base = MAP_FAILED;
+        }
+    }
+    if (base == MAP_FAILED) {
+        int e = errno;
+        if (writable) (void)::ftruncate(fd, static_cast<off_t>(fsize));
+        ::close(fd);
+        errno = e;
+        return false;
+    }
+    ::madvise(base, total, MADV_SEQUENTIAL);
+    std::shared_ptr<void> owner(base, [total](void *p) { ::munmap(p, total); });
+
+    // 用映射出的块替换当前（刚清空的）根节点
+    Node::Release(m_root);
+    m_root = nullptr;
+    Node *tail = nullptr;
+    for (size_t i = 0; i < count; ++i) {
+        Node *n = new Node(static_cast<char *>(base) + i * chunk, chunk, owner);
+        if (tail) {
+            tail->next = n;
+        } else {
+            m_root = n;
+        }
+        tail = n;
+    }
+    m_tail = tail;
+    m_heapBaseSize = m_baseSize;
+    m_baseSize = chunk;
+    m_capacity = total;
+    m_size = fsize;
+    m_mapped = true;
+    if (writable) {
+        m_mapFd = fd;
+    } else {
+        ::close(fd); // 映射本身持有文件引用
+    }
+    m_cur = m_root;
+    setPosition(writable ? fsize : 0);
+    return true;
+}
+
+bool ByteArray::unmapFile() {
+    if (!m_mapped) return true;
+    bool ok = true;
+    if (m_mapFd >= 0) {
+        ok = ::ftruncate(m_mapFd, static_cast<off_t>(m_size)) == 0;
+        ::close(m_mapFd);
+        m_mapFd = -1;
+    }
+    m_mapped = false;
+
+    // 释放映射块（被切片引用的块在切片释放后才 munmap），回到一个空的内存根节点
+    Node *tmp = m_root;
+    while (tmp) {
+        Node *n = tmp;
+        tmp = tmp->next;
+        Node::Release(n);
+    }
+    m_baseSize = m_heapBaseSize;
+    m_root = new Node(m_baseSize);
+    m_cur = m_root;
+    m_tail = m_root;
+    m_capacity = m_baseSize;
+    m_position = 0;
+    m_size = 0;
+    return ok;
+}
+
+bool ByteArray::syncFile() {
+    if (m_mapFd < 0) return false;
+    return ::fdatasync(m_mapFd) == 0;
+}
+
+/* ========================= 批量接口（varint 数组 / 定长数组） ========================= */
+
+// 每批编码 / 翻转的元素个数（缓冲区放在栈上）
+static const size_t BULK_CHUNK = 256;
+
+void ByteArray::writeVarintArray(const uint32_t *values, size_t n) {
+    uint8_t buf[BULK_CHUNK * SimdCodec::MAX_VARINT32];
+    for (size_t i = 0; i < n; i += BULK_CHUNK) {
+        size_t cnt = std::min(BULK_CHUNK, n - i);
+        write(buf, SimdCodec::EncodeVarint32(values + i, cnt, buf));
+    }
+}
+
+void ByteArray::writeVarintArray(const uint64_t *values, size_t n) {
+    uint8_t buf[BULK_CHUNK * SimdCodec::MAX_VARINT64];
+    for (size_t i = 0; i < n; i += BULK_CHUNK) {
+        size_t cnt = std::min(BULK_CHUNK, n - i);
+        write(buf, SimdCodec::EncodeVarint64(values + i, cnt, buf));
+    }
+}
+
+void ByteArray::writeVarintArray(const int32_t *values, size_t n) {
+    uint32_t tmp[BULK_CHUNK];
+    for (size_t i = 0; i < n; i += BULK_CHUNK) {
+        size_t cnt = std::min(BULK_CHUNK, n - i);
+        for (size_t j = 0; j < cnt; ++j) tmp[j] = EncodeZigzag32(values[i + j]);
+        writeVarintArray(tmp, cnt);
+    }
+}
+
+void ByteArray::writeVarintArray(const int64_t *values, size_t n) {
+    uint64_t tmp[BULK_CHUNK];
+    for (size_t i = 0; i < n; i += BULK_CHUNK) {
+        size_t cnt = std::min(BULK_CHUNK, n - i);
+        for (size_t j = 0; j < cnt; ++j) tmp[j] = EncodeZigzag64(values[i + j]);
+        writeVarintArray(tmp, cnt);
+    }
+}
+
+/*
+ * 批量解码：每次在当前块内连续可读的区间上调用 SimdCodec 解出尽量多的值，
+ * 剩下一个跨块（或数据不完整）的值交给逐字节的 readUint32 / readUint64，数据不足时同样抛出 out_of_range
+ */
+void ByteArray::readVarintArray(uint32_t *values, size_t n) {
+    size_t i = 0;
+    while (i < n) {
+        size_t avail = contiguousReadSize();
+        if (avail > 0) {
+            const uint8_t *src = reinterpret_cast<const uint8_t *>(m_cur->ptr) + m_position % m_baseSize;
+            size_t used = 0;
+            i += SimdCodec::DecodeVarint32(src, avail, values + i, n - i, &used);
+            skipInNode(used);
+        }
+        if (i < n) values[i++] = readUint32();
+    }
+}
+
+void ByteArray::readVarintArray(uint64_t *values, size_t n) {
+    size_t i = 0;
+    while (i < n) {
+        size_t avail = contiguousReadSize();
+        if (avail > 0) {
+            const uint8_t *src = reinterpret_cast<const uint8_t *>(m_cur->ptr) + m_position % m_baseSize;
+            size_t used = 0;
+            i += SimdCodec::DecodeVarint64(src, avail, values + i, n - i, &used);
+            skipInNode(used);
+        }
+        if (i < n) values[i++] = readUint64();
+    }
+}
+
+void ByteArray::readVarintArray(int32_t *values, size_t n) {
+    uint32_t *u = reinterpret_cast<uint32_t *>(values);
+    readVarintArray(u, n);
+    for (size_t i = 0; i < n; ++i) values[i] = DecodeZigzag32(u[i]);
+}
+
+void ByteArray::readVarintArray(int64_t *values, size_t n) {
+    uint64_t *u = reinterpret_cast<uint64_t *>(values);
+    readVarintArray(u, n);
+    for (size_t i = 0; i < n; ++i) values[i] = DecodeZigzag64(u[i]);
+}
+
+bool ByteArray::needSwap() const {
+    return m_endian != ((std::endian::native == std::endian::big) ? 1 : 0);
+}
+
+void ByteArray::writeFixedArray(const void *values, size_t n, size_t width) {
+    if (width == 1 || !needSwap()) {
+        write(values, n * width);
+        return;
+    }
+    // 字节序不同：分批翻转到栈上缓冲再写
+    alignas(64) uint8_t buf[BULK_CHUNK * sizeof(uint64_t)];
+    const uint8_t *src = static_cast<const uint8_t *>(values);
+    size_t per = sizeof(buf) / width;
+    for (size_t i = 0; i < n; i += per) {
+        size_t cnt = std::min(per, n - i);
+        SimdCodec::ByteSwap(buf, src + i * width, cnt, width);
+        write(buf, cnt * width);
+    }
+}
+
+void ByteArray::readFixedArray(void *values, size_t n, size_t width) {
+    read(values, n * width);
+    if (width > 1 && needSwap()) SimdCodec::ByteSwap(values, values, n, width);
+}
+
+size_t ByteArray::contiguousReadSize() const {
+    size_t readable = getReadSize();
+    if (readable == 0 || !m_cur) return 0;
+    return std::min(m_cur->size - m_position % m_baseSize, readable);
+}
+
+void ByteArray::skipInNode(size_t n) {
+    if (n == 0) return;
+    size_t npos = m_position % m_baseSize;
+    m_position += n;
+    if (npos + n == m_cur->size) m_cur = m_cur->next;
+}
+
 /* ========================= clear / write / read（基于块链） ========================= */
 
 void ByteArray::clear() {
+    if (m_mapped) {
+        unmapFile();
+        return;
+    }
     // 重置位置与已用长度、保留根节点、删除后续节点
     m_position = 0;
     m_size = 0;
@@ -386,10 +639,18 @@ void ByteArray::clear() {
     while (tmp) {
         Node *n = tmp;
         tmp = tmp->next;
-        delete n;
+        Node::Release(n);
     }
     m_root->next = nullptr;
+    // 根节点还被切片引用时换一块新的，之后的写入不会改到切片里的数据
+    if (m_root->refs.load(std::memory_order_acquire) > 1) {
+        Node::Release(m_root);
+        m_root = new Node(m_baseSize);
+    } else {
+        m_root->frozen = 0;
+    }
     m_cur = m_root;
+    m_tail = m_root;
 }
 
 /*
@@ -408,9 +669,21 @@ void ByteArray::write(const void *buf, size_t size) {
 
     const uint8_t *src = reinterpret_cast<const uint8_t *>(buf);
     size_t npos = m_position % m_baseSize; // 当前块内偏移
-    size_t ncap = m_cur->size - npos;      // 当前块剩余可写字节
+    // 只写当前块且没有覆盖被切片引用的范围时（常见情况）不需要检查共享
+    if (m_cur->frozen > npos || size >= m_cur->size - npos) {
+        unshareForWrite(size);
+    }
+    size_t ncap = m_cur->size - npos; // 当前块剩余可写字节
     size_t bpos = 0;                       // src 已写偏移
 
+    // 快速路径：整段落在当前块内（定长整数等小写入的常见情况），一次 memcpy，不用移动 m_cur
+    if (size < ncap) {
+        std::memcpy(m_cur->ptr + npos, src, size);
+        m_position += size;
+        if (m_position > m_size) m_size = m_position;
+        return;
+    }
+
     while (size > 0) {
         if (!m_cur) throw std::runtime_error("ByteArray::write: null current node");
 
@@ -463,6 +736,13 @@ void ByteArray::read(void *buf, size_t size) {
     size_t ncap = m_cur->size - npos;
     size_t bpos = 0;
 
+    // 快速路径：整段落在当前块内，一次 memcpy
+    if (size < ncap) {
+        std::memcpy(dst, m_cur->ptr + npos, size);
+        m_position += size;
+        return;
+    }
+
     while (size > 0) {
         if (!m_cur) throw std::runtime_error("ByteArray::read: null current node inside loop");
 
@@ -703,6 +983,7 @@ uint64_t ByteArray::getWriteBuffers(std::vector<iovec> &buffers, uint64_t len) {
     if (len == 0) return 0;
     // 确保有足够写入空间
     addCapacity(len);
+    unshareForWrite(len);
 
     uint64_t ret = len;
     size_t npos = m_position % m_baseSize;
@@ -728,8 +1009,218 @@ uint64_t ByteArray::getWriteBuffers(std::vector<iovec> &buffers, uint64_t len) {
     return ret;
 }
 
+/* ========================= 切片（共享块，写时复制） ========================= */
+
+ByteSlice ByteArray::slice(size_t position, size_t len) const {
+    if (position > m_size || len > m_size - position) {
+        throw std::out_of_range("ByteArray::slice: out of range");
+    }
+    ByteSlice s;
+    if (len == 0) return s;
+
+    size_t npos = position % m_baseSize;
+    size_t idx = position / m_baseSize;
+    Node *cur = m_root;
+    while (idx > 0 && cur) {
+        cur = cur->next;
+        --idx;
+    }
+    while (len > 0 && cur) {
+        size_t n = std::min(cur->size - npos, len);
+        // 标记被引用的范围，之后覆盖这段数据时 unshareForWrite 会先复制本块
+        cur->frozen = std::max(cur->frozen, npos + n);
+        s.push(cur, cur->ptr + npos, n);
+        len -= n;
+        npos = 0;
+        cur = cur->next;
+    }
+    return s;
+}
+
+ByteSlice ByteArray::readSlice(size_t len) {
+    if (len > getReadSize()) {
+        throw std::out_of_range("ByteArray::readSlice: not enough data");
+    }
+    ByteSlice s = slice(m_position, len);
+    setPosition(m_position + len);
+    return s;
+}
+
+void ByteArray::unshareForWrite(size_t len) {
+    Node *cur = m_cur;
+    size_t npos = m_position % m_baseSize;
+    while (len > 0 && cur) {
+        size_t n = std::min(cur->size - npos, len);
+        Node *next = cur->next;
+        // 写映射的块就是文件页，复制出去的写入不会落到文件上，这里不做写时复制
+        if (npos < cur->frozen && !(cur->owner && m_mapFd >= 0)) {
+            if (cur->refs.load(std::memory_order_acquire) > 1) {
+                detachNode(cur);
+            } else {
+                cur->frozen = 0; // 切片都已释放
+            }
+        }
+        len -= n;
+        npos = 0;
+        cur = next;
+    }
+}
+
+ByteArray::Node *ByteArray::detachNode(Node *node) {
+    Node *copy = new Node(node->size);
+    std::memcpy(copy->ptr, node->ptr, node->size);
+    copy->next = node->next;
+    if (m_root == node) {
+        m_root = copy;
+    } else {
+        Node *prev = m_root;
+        while (prev->next != node) prev = prev->next;
+        prev->next = copy;
+    }
+    if (m_cur == node) m_cur = copy;
+    if (m_tail == node) m_tail = copy;
+    node->next = nullptr;
+    Node::Release(node);
+    return copy;
+}
+
+/* ========================= ByteSlice ========================= */
+
+ByteSlice::ByteSlice(const ByteSlice &other) :
+    m_segs(other.m_segs), m_size(other.m_size) {
+    for (auto &seg : m_segs) seg.node->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+ByteSlice::ByteSlice(ByteSlice &&other) noexcept :
+    m_segs(std::move(other.m_segs)), m_size(other.m_size) {
+    other.m_segs.clear();
+    other.m_size = 0;
+}
+
+ByteSlice &ByteSlice::operator=(ByteSlice other) noexcept {
+    m_segs.swap(other.m_segs);
+    std::swap(m_size, other.m_size);
+    return *this;
+}
+
+ByteSlice::~ByteSlice() {
+    clear();
+}
+
+void ByteSlice::clear() {
+    for (auto &seg : m_segs) ByteArray::Node::Release(seg.node);
+    m_segs.clear();
+    m_size = 0;
+}
+
+void ByteSlice::push(ByteArray::Node *node, const char *ptr, size_t len) {
+    node->refs.fetch_add(1, std::memory_order_relaxed);
+    m_segs.push_back(Segment{node, ptr, len});
+    m_size += len;
+}
+
+ByteSlice ByteSlice::sub(size_t offset, size_t len) const {
+    ByteSlice s;
+    if (offset >= m_size) return s;
+    if (len > m_size - offset) len = m_size - offset;
+    for (auto &seg : m_segs) {
+        if (len == 0) break;
+        if (offset >= seg.len) {
+            offset -= seg.len;
+            continue;
+        }
+        size_t n = std::min(seg.len - offset, len);
+        s.push(seg.node, seg.ptr + offset, n);
+        len -= n;
+        offset = 0;
+    }
+    return s;
+}
+
+void ByteSlice::append(const ByteSlice &other) {
+    if (&other == this) {
+        ByteSlice copy(other);
+        append(copy);
+        return;
+    }
+    m_segs.reserve(m_segs.size() + other.m_segs.size());
+    for (auto &seg : other.m_segs) push(seg.node, seg.ptr, seg.len);
+}
+
+uint64_t ByteSlice::getIovecs(std::vector<iovec> &buffers, uint64_t offset, uint64_t len) const {
+    if (offset >= m_size) return 0;
+    if (len > m_size - offset) len = m_size - offset;
+    uint64_t ret = len;
+    for (auto &seg : m_segs) {
+        if (len == 0) break;
+        if (offset >= seg.len) {
+            offset -= seg.len;
+            continue;
+        }
+        size_t n = std::min<uint64_t>(seg.len - offset, len);
+        iovec iov;
+        iov.iov_base = const_cast<char *>(seg.ptr + offset);
+        iov.iov_len = n;
+        buffers.push_back(iov);
+        len -= n;
+        offset = 0;
+    }
+    return ret;
+}
+
+void ByteSlice::copyTo(void *buf, size_t len, size_t offset) const {
+    if (offset > m_size || len > m_size - offset) {
+        throw std::out_of_range("ByteSlice::copyTo: out of range");
+    }
+    char *dst = static_cast<char *>(buf);
+    for (auto &seg : m_segs) {
+        if (len == 0) break;
+        if (offset >= seg.len) {
+            offset -= seg.len;
+            continue;
+        }
+        size_t n = std::min(seg.len - offset, len);
+        std::memcpy(dst, seg.ptr + offset, n);
+        dst += n;
+        len -= n;
+        offset = 0;
+    }
+}
+
+std::string ByteSlice::toString() const {
+    std::string s;
+    s.resize(m_size);
+    if (m_size) copyTo(&s[0], m_size);
+    return s;
+}
+
 /* ========================= 扩容实现 ========================= */
 
+/*
+ * reserve(size):
+ * - 空 ByteArray（未写入任何数据）且 size 大于块大小时，把块大小改为 size 所在的 BufferPool 尺寸档，
+ *   根节点换成一整块，大小已知的消息写入 / 读取都不会跨块
+ * - 其他情况等价于确保从 m_position 起至少还有 size 字节容量（按现有块大小追加）
+ */
+void ByteArray::reserve(size_t size) {
+    if (size == 0) return;
+    if (m_size == 0 && m_position == 0 && size > m_baseSize && !m_mapped) {
+        Node *tmp = m_root;
+        while (tmp) {
+            Node *n = tmp;
+            tmp = tmp->next;
+            Node::Release(n);
+        }
+        m_baseSize = BufferPool::RoundSize(size);
+        m_root = new Node(m_baseSize);
+        m_cur = m_root;
+        m_tail = m_root;
+        m_capacity = m_baseSize;
+        return;
+    }
+    addCapacity(size);
+}
+
 /*
  * addCapacity(size):
  * - 确保剩余可写容量 >= size
@@ -747,18 +1238,30 @@ bool ByteArray::addCapacity(size_t size) {
     // 需要的块数（整数上取整）
     size_t count = (need + m_baseSize - 1) / m_baseSize;
 
-    // 找到链表尾部（注意这里没有维护尾指针，遍历一次）
-    Node *tail = m_root;
-    while (tail->next) tail = tail->next;
+    Node *tail = m_tail;
+
+    // 写映射模式：先把文件扩展 count 块，再把新增部分映射成一段，切成 count 个块
+    char *mapped = nullptr;
+    std::shared_ptr<void> owner;
+    if (m_mapFd >= 0) {
+        size_t bytes = count * m_baseSize;
+        if (::ftruncate(m_mapFd, static_cast<off_t>(m_capacity + bytes)) != 0) return false;
+        void *p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_mapFd, static_cast<off_t>(m_capacity));
+        if (p == MAP_FAILED) return false;
+        ::madvise(p, bytes, MADV_SEQUENTIAL);
+        mapped = static_cast<char *>(p);
+        owner.reset(p, [bytes](void *q) { ::munmap(q, bytes); });
+    }
 
     Node *first_new = nullptr;
     for (size_t i = 0; i < count; ++i) {
-        Node *n = new Node(m_baseSize);
+        Node *n = mapped ? new Node(mapped + i * m_baseSize, m_baseSize, owner) : new Node(m_baseSize);
         tail->next = n;
         tail = n;
         if (!first_new) first_new = n;
         m_capacity += m_baseSize;
     }
+    m_tail = tail;
 
     // 如果原来剩余容量为 0，则 m_cur 可能指向末尾（或为 nullptr），
     // 此时把 m_cur 指向新追加的第一块以便写操作直接写入。
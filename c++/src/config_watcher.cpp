@@ -0,0 +1,135 @@
+// file: libs/config_watcher.cpp
+#include "libs/config_watcher.h"
+#include "libs/Config.h"
+#include "libs/log.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace sunshine {
+
+static Logger::ptr g_logger = LogManager::GetInstance().getRoot();
+
+static ConfigVar<uint64_t>::ptr g_watch_debounce_ms =
+    Config::Lookup<uint64_t>("config.watch_debounce_ms", 100, "delay before reloading a changed config file");
+
+static const uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+
+ConfigWatcher::ptr ConfigWatcher::Create(IOManager *iom) {
+    if (!iom) return nullptr;
+    ptr watcher(new ConfigWatcher(iom));
+    if (watcher->m_fd < 0) return nullptr;
+    return watcher;
+}
+
+ConfigWatcher::ConfigWatcher(IOManager *iom) :
+    m_iom(iom) {
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0) {
+        LOG_ERROR(g_logger) << "ConfigWatcher inotify_init1 failed errno=" << errno << " " << strerror(errno);
+    }
+}
+
+ConfigWatcher::~ConfigWatcher() {
+    if (m_fd < 0) return;
+    m_iom->delEvent(m_fd, IOManager::READ);
+    close(m_fd);
+}
+
+bool ConfigWatcher::watch(const std::string &path, bool load_now) {
+    size_t slash = path.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    if (name.empty()) return false;
+
+    int wd = inotify_add_watch(m_fd, dir.c_str(), WATCH_MASK);
+    if (wd < 0) {
+        LOG_ERROR(g_logger) << "ConfigWatcher inotify_add_watch(" << dir << ") failed errno=" << errno << " "
+                            << strerror(errno);
+        return false;
+    }
+
+    bool first;
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        first = m_dirs.empty();
+        m_dirs[wd] = dir;
+        m_files[dir].insert(name);
+    }
+    if (load_now) Config::LoadFromFile(path);
+    // 第一次监视时注册可读事件，之后由 onReadable 每次处理完重新注册
+    if (first && !arm()) return false;
+    return true;
+}
+
+bool ConfigWatcher::arm() {
+    std::weak_ptr<ConfigWatcher> weak = shared_from_this();
+    if (m_iom->addEvent(m_fd, IOManager::READ, [weak]() {
+            if (auto self = weak.lock()) self->onReadable();
+        }) != 0) {
+        LOG_ERROR(g_logger) << "ConfigWatcher addEvent failed errno=" << errno;
+        return false;
+    }
+    return true;
+}
+
+// 读出 inotify 的全部事件，把命中监视文件的安排重新加载，然后重新注册可读事件
+void ConfigWatcher::onReadable() {
+    alignas(struct inotify_event) char buf[4096];
+    for (;;) {
+        ssize_t n = read(m_fd, buf, sizeof(buf));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN) break;
+            LOG_ERROR(g_logger) << "ConfigWatcher read failed errno=" << errno << " " << strerror(errno);
+            return;
+        }
+        if (n == 0) return;
+
+        for (char *p = buf; p < buf + n;) {
+            auto *ev = reinterpret_cast<struct inotify_event *>(p);
+            p += sizeof(struct inotify_event) + ev->len;
+            if (ev->len == 0) continue;
+            std::string path;
+            {
+                std::lock_guard<std::mutex> lk(m_mutex);
+                auto dit = m_dirs.find(ev->wd);
+                if (dit == m_dirs.end()) continue;
+                auto &names = m_files[dit->second];
+                if (!names.count(ev->name)) continue;
+                path = dit->second + "/" + ev->name;
+            }
+            schedule(path);
+        }
+    }
+    arm();
+}
+
+// 同一文件在定时器到期前的后续事件都合并到这一次重新加载
+void ConfigWatcher::schedule(const std::string &path) {
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        if (!m_pending.insert(path).second) return;
+    }
+    std::weak_ptr<ConfigWatcher> weak = shared_from_this();
+    m_iom->addTimer(g_watch_debounce_ms->getValue(), [weak, path]() {
+        if (auto self = weak.lock()) self->reload(path);
+    });
+}
+
+void ConfigWatcher::reload(const std::string &path) {
+    // 先移出等待集合：加载期间文件又被修改时会重新安排一次
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_pending.erase(path);
+    }
+    int changed = Config::LoadFromFile(path);
+    m_reloads.fetch_add(1, std::memory_order_relaxed);
+    if (changed >= 0) {
+        LOG_INFO(g_logger) << "ConfigWatcher reloaded " << path << ", " << changed << " value(s) changed";
+    }
+}
+
+} // namespace sunshine
@@ -0,0 +1,124 @@
+// file: libs/context.cpp
+#include "libs/context.h"
+
+#if SUNSHINE_HAS_ASM_CONTEXT
+
+#include <cstring>
+
+// 保存帧布局（从低地址到高地址），sunshine_ctx_swap 与 MakeContext 必须保持一致
+#if defined(__x86_64__)
+// [mxcsr(4) fpucw(2) pad(10)] r12 r13 r14 r15 rbx rbp [返回地址]
+__asm__(
+    ".text\n"
+    ".globl sunshine_ctx_swap\n"
+    ".type sunshine_ctx_swap,@function\n"
+    ".align 16\n"
+    "sunshine_ctx_swap:\n"
+    "    pushq %rbp\n"
+    "    pushq %rbx\n"
+    "    pushq %r15\n"
+    "    pushq %r14\n"
+    "    pushq %r13\n"
+    "    pushq %r12\n"
+    "    subq $16, %rsp\n"
+    "    stmxcsr (%rsp)\n"
+    "    fnstcw 4(%rsp)\n"
+    "    movq %rsp, (%rdi)\n"
+    "    movq %rsi, %rsp\n"
+    "    ldmxcsr (%rsp)\n"
+    "    fldcw 4(%rsp)\n"
+    "    addq $16, %rsp\n"
+    "    popq %r12\n"
+    "    popq %r13\n"
+    "    popq %r14\n"
+    "    popq %r15\n"
+    "    popq %rbx\n"
+    "    popq %rbp\n"
+    "    ret\n"
+    ".size sunshine_ctx_swap,.-sunshine_ctx_swap\n"
+    // 新上下文第一次被切入时从这里开始：r12 = arg，r13 = fn
+    ".globl sunshine_ctx_trampoline\n"
+    ".type sunshine_ctx_trampoline,@function\n"
+    ".align 16\n"
+    "sunshine_ctx_trampoline:\n"
+    "    movq %r12, %rdi\n"
+    "    callq *%r13\n"
+    "    ud2\n"
+    ".size sunshine_ctx_trampoline,.-sunshine_ctx_trampoline\n");
+#elif defined(__aarch64__)
+// d8-d15 x19-x28 x29 x30，共 176 字节
+__asm__(
+    ".text\n"
+    ".globl sunshine_ctx_swap\n"
+    ".type sunshine_ctx_swap,%function\n"
+    ".align 4\n"
+    "sunshine_ctx_swap:\n"
+    "    sub sp, sp, #176\n"
+    "    stp d8, d9, [sp, #0]\n"
+    "    stp d10, d11, [sp, #16]\n"
+    "    stp d12, d13, [sp, #32]\n"
+    "    stp d14, d15, [sp, #48]\n"
+    "    stp x19, x20, [sp, #64]\n"
+    "    stp x21, x22, [sp, #80]\n"
+    "    stp x23, x24, [sp, #96]\n"
+    "    stp x25, x26, [sp, #112]\n"
+    "    stp x27, x28, [sp, #128]\n"
+    "    stp x29, x30, [sp, #144]\n"
+    "    mov x9, sp\n"
+    "    str x9, [x0]\n"
+    "    mov sp, x1\n"
+    "    ldp d8, d9, [sp, #0]\n"
+    "    ldp d10, d11, [sp, #16]\n"
+    "    ldp d12, d13, [sp, #32]\n"
+    "    ldp d14, d15, [sp, #48]\n"
+    "    ldp x19, x20, [sp, #64]\n"
+    "    ldp x21, x22, [sp, #80]\n"
+    "    ldp x23, x24, [sp, #96]\n"
+    "    ldp x25, x26, [sp, #112]\n"
+    "    ldp x27, x28, [sp, #128]\n"
+    "    ldp x29, x30, [sp, #144]\n"
+    "    add sp, sp, #176\n"
+    "    ret\n"
+    ".size sunshine_ctx_swap,.-sunshine_ctx_swap\n"
+    // 新上下文第一次被切入时从这里开始：x19 = arg，x20 = fn
+    ".globl sunshine_ctx_trampoline\n"
+    ".type sunshine_ctx_trampoline,%function\n"
+    ".align 4\n"
+    "sunshine_ctx_trampoline:\n"
+    "    mov x0, x19\n"
+    "    blr x20\n"
+    "    brk #0\n"
+    ".size sunshine_ctx_trampoline,.-sunshine_ctx_trampoline\n");
+#endif
+
+extern "C" void sunshine_ctx_trampoline();
+
+namespace sunshine {
+
+void *MakeContext(void *stack, size_t size, void (*fn)(uintptr_t), uintptr_t arg) {
+    uintptr_t top = (reinterpret_cast<uintptr_t>(stack) + size) & ~(uintptr_t)15;
+#if defined(__x86_64__)
+    // ret 之后 rsp 需要 16 字节对齐（trampoline 里的 call 再压入返回地址）
+    uint64_t *sp = reinterpret_cast<uint64_t *>(top - 88);
+    memset(sp, 0, 88);
+    uint32_t mxcsr = 0x1F80; // 默认值：屏蔽所有浮点异常，就近舍入
+    uint16_t fpucw = 0x037F;
+    memcpy(sp, &mxcsr, sizeof(mxcsr));
+    memcpy(reinterpret_cast<char *>(sp) + 4, &fpucw, sizeof(fpucw));
+    sp[2] = arg;                                                      // r12
+    sp[3] = reinterpret_cast<uint64_t>(fn);                           // r13
+    sp[8] = reinterpret_cast<uint64_t>(&sunshine_ctx_trampoline);     // 返回地址
+    return sp;
+#elif defined(__aarch64__)
+    uint64_t *sp = reinterpret_cast<uint64_t *>(top - 176);
+    memset(sp, 0, 176);
+    sp[8] = arg;                                                      // x19
+    sp[9] = reinterpret_cast<uint64_t>(fn);                           // x20
+    sp[19] = reinterpret_cast<uint64_t>(&sunshine_ctx_trampoline);    // x30
+    return sp;
+#endif
+}
+
+} // namespace sunshine
+
+#endif
@@ -0,0 +1,236 @@
+// file: libs/dns_resolver.cpp
+#include "libs/dns_resolver.h"
+#include "libs/Config.h"
+#include "libs/fiber.h"
+#include "libs/scheduler.h"
+
+#include <algorithm>
+#include <netdb.h>
+#include <thread>
+#include <time.h>
+
+namespace sunshine {
+
+static ConfigVar<uint64_t>::ptr g_cache_ttl_ms =
+    Config::Lookup<uint64_t>("dns.cache_ttl_ms", 60000, "how long a resolved host stays cached");
+static ConfigVar<uint64_t>::ptr g_negative_ttl_ms =
+    Config::Lookup<uint64_t>("dns.negative_ttl_ms", 5000, "how long a nonexistent host stays cached");
+static ConfigVar<uint32_t>::ptr g_cache_size =
+    Config::Lookup<uint32_t>("dns.cache_size", 4096, "max cached hosts");
+static ConfigVar<uint32_t>::ptr g_threads =
+    Config::Lookup<uint32_t>("dns.threads", 2, "getaddrinfo worker threads");
+
+struct DnsResolver::Query {
+    Key key;
+    size_t hash;
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool done = false;
+    Addrs addrs;
+    std::vector<std::pair<Scheduler *, Fiber::ptr>> fibers; // 挂起等待结果的协程
+};
+
+// 数值地址：node 部分只含数字和 '.'，或者是 IPv6 字面量（带 '[' 或多个 ':'）
+// 判断错了只影响是否缓存，不影响结果
+static bool IsNumericHost(const std::string &host) {
+    if (host.front() == '[') return true;
+    size_t colon = host.find(':');
+    if (colon != std::string::npos && host.find(':', colon + 1) != std::string::npos) return true;
+    size_t end = colon == std::string::npos ? host.size() : colon;
+    for (size_t i = 0; i < end; ++i) {
+        char c = host[i];
+        if ((c < '0' || c > '9') && c != '.') return false;
+    }
+    return end > 0;
+}
+
+// TTL 只需要毫秒精度，用 COARSE 时钟，比 steady_clock 便宜
+static uint64_t NowMS() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return ts.tv_sec * 1000ull + ts.tv_nsec / 1000000;
+}
+
+static bool IsNegativeError(int error) {
+#ifdef EAI_NODATA
+    if (error == EAI_NODATA) return true;
+#endif
+    return error == EAI_NONAME;
+}
+
+// 解析线程与单例都不析构：进程退出时解析线程可能还阻塞在 getaddrinfo 里
+DnsResolver &DnsResolver::GetInstance() {
+    static DnsResolver *s_inst = new DnsResolver;
+    return *s_inst;
+}
+
+size_t DnsResolver::KeyHash::operator()(const KeyView &k) const {
+    size_t h = std::hash<std::string_view>()(k.host);
+    h ^= (static_cast<size_t>(k.family) << 16) ^ (static_cast<size_t>(k.type) << 8) ^ static_cast<size_t>(k.protocol);
+    return h;
+}
+
+DnsResolver::Addrs DnsResolver::resolve(const std::string &host, int family, int type, int protocol) {
+    if (host.empty()) return nullptr;
+    if (IsNumericHost(host)) {
+        std::vector<Address::ptr> result;
+        if (Address::Resolve(result, host, family, type, protocol) != 0 || result.empty()) return nullptr;
+        return std::make_shared<const std::vector<Address::ptr>>(std::move(result));
+    }
+
+    KeyView kv{host, family, type, protocol};
+    size_t hash = KeyHash()(kv);
+    Shard &shard = shardOf(hash);
+    uint64_t now = NowMS();
+
+    QueryPtr query;
+    Addrs stale;
+    bool start = false;
+    {
+        std::lock_guard<std::mutex> lk(shard.mutex);
+        auto it = shard.map.find(kv);
+        if (it != shard.map.end()) {
+            Entry &e = it->second;
+            if (now < e.expire) {
+                m_hits.fetch_add(1, std::memory_order_relaxed);
+                return e.addrs;
+            }
+            if (!e.query) {
+                e.query = std::make_shared<Query>();
+                e.query->key = it->first;
+                e.query->hash = hash;
+                start = true;
+            }
+            query = e.query;
+            stale = e.addrs;
+        } else {
+            size_t cap = std::max<size_t>(1, g_cache_size->getValue() / SHARD_COUNT);
+            if (shard.map.size() >= cap) {
+                // 先清过期的，仍然满时随便淘汰一个没有进行中查询的
+                for (auto i = shard.map.begin(); i != shard.map.end();) {
+                    if (!i->second.query && i->second.expire <= now) {
+                        i = shard.map.erase(i);
+                    } else {
+                        ++i;
+                    }
+                }
+                for (auto i = shard.map.begin(); shard.map.size() >= cap && i != shard.map.end();) {
+                    if (!i->second.query) {
+                        i = shard.map.erase(i);
+                    } else {
+                        ++i;
+                    }
+                }
+            }
+            Key key{host, family, type, protocol};
+            query = std::make_shared<Query>();
+            query->key = key;
+            query->hash = hash;
+            shard.map.emplace(std::move(key), Entry{nullptr, 0, query});
+            start = true;
+        }
+    }
+
+    if (start) submit(query);
+    // 过期的成功结果：先返回旧值，刷新在后台完成
+    if (stale) {
+        m_hits.fetch_add(1, std::memory_order_relaxed);
+        return stale;
+    }
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    return wait(query);
+}
+
+void DnsResolver::clear() {
+    for (auto &shard : m_shards) {
+        std::lock_guard<std::mutex> lk(shard.mutex);
+        shard.map.clear();
+    }
+}
+
+// 解析线程按需创建，数量不超过 dns.threads
+void DnsResolver::submit(const QueryPtr &query) {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_queue.push_back(query);
+    if (m_threadCount < std::max<uint32_t>(1, g_threads->getValue())) {
+        std::thread([this]() { work(); }).detach();
+        ++m_threadCount;
+    }
+    m_cond.notify_one();
+}
+
+void DnsResolver::work() {
+    for (;;) {
+        QueryPtr query;
+        {
+            std::unique_lock<std::mutex> lk(m_mutex);
+            m_cond.wait(lk, [this]() { return !m_queue.empty(); });
+            query = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        const Key &k = query->key;
+        std::vector<Address::ptr> result;
+        int error = Address::Resolve(result, k.host, k.family, k.type, k.protocol);
+        Addrs addrs;
+        if (error == 0 && !result.empty()) {
+            addrs = std::make_shared<const std::vector<Address::ptr>>(std::move(result));
+        }
+        complete(query, error, addrs);
+    }
+}
+
+// 先更新缓存再唤醒等待者：等待者醒来后的下一次 resolve 一定能命中
+void DnsResolver::complete(const QueryPtr &query, int error, Addrs addrs) {
+    uint64_t now = NowMS();
+    {
+        Shard &shard = shardOf(query->hash);
+        std::lock_guard<std::mutex> lk(shard.mutex);
+        auto it = shard.map.find(query->key);
+        // clear() 之后条目可能已不存在或换成了新的查询，这时只唤醒等待者
+        if (it != shard.map.end() && it->second.query == query) {
+            Entry &e = it->second;
+            e.query.reset();
+            if (addrs) {
+                e.addrs = addrs;
+                e.expire = now + g_cache_ttl_ms->getValue();
+            } else if (error == 0 || IsNegativeError(error)) {
+                e.addrs.reset();
+                e.expire = now + g_negative_ttl_ms->getValue();
+            } else if (e.addrs) {
+                // 刷新时的临时错误（EAI_AGAIN 等）：继续使用旧结果，过一个负缓存周期再试
+                e.expire = now + g_negative_ttl_ms->getValue();
+            } else {
+                shard.map.erase(it);
+            }
+        }
+    }
+
+    std::vector<std::pair<Scheduler *, Fiber::ptr>> fibers;
+    {
+        std::lock_guard<std::mutex> lk(query->mutex);
+        query->done = true;
+        query->addrs = addrs;
+        fibers.swap(query->fibers);
+    }
+    query->cond.notify_all();
+    for (auto &w : fibers) w.first->scheduler(std::move(w.second));
+}
+
+// 协程里挂起等待，由 complete 重新调度；否则在条件变量上阻塞
+DnsResolver::Addrs DnsResolver::wait(const QueryPtr &query) {
+    std::unique_lock<std::mutex> lk(query->mutex);
+    if (!query->done) {
+        Scheduler *sched = Scheduler::GetThis();
+        if (sched && !Fiber::IsMainFiber()) {
+            query->fibers.emplace_back(sched, Fiber::GetThis()->shared_from_this());
+            lk.unlock();
+            Fiber::YieldToHold();
+            lk.lock();
+        } else {
+            query->cond.wait(lk, [&]() { return query->done; });
+        }
+    }
+    return query->addrs;
+}
+
+} // namespace sunshine
@@ -0,0 +1,126 @@
+// file: libs/fd_manager.cpp
+#include "libs/fd_manager.h"
+#include "libs/hook.h"
+#include "libs/iomanager.h"
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <mutex>
+#include <utility>
+
+namespace sunshine {
+
+// ---------- FdCtx ----------
+
+FdCtx::FdCtx(int fd) :
+    m_fd(fd) {
+    init();
+}
+
+FdCtx::~FdCtx() = default;
+
+// 初始化：判断是否为 socket，socket 统一设置为系统层非阻塞
+bool FdCtx::init() {
+    if (m_isInit) return true;
+
+    struct stat fd_stat;
+    if (fstat(m_fd, &fd_stat) == -1) {
+        m_isInit = false;
+        m_isSocket = false;
+    } else {
+        m_isInit = true;
+        m_isSocket = S_ISSOCK(fd_stat.st_mode);
+    }
+
+    if (m_isSocket) {
+        // 使用原始 fcntl，避免被 hook 记录成用户设置的非阻塞
+        int flags = fcntl_f(m_fd, F_GETFL, 0);
+        if (!(flags & O_NONBLOCK)) {
+            fcntl_f(m_fd, F_SETFL, flags | O_NONBLOCK);
+        }
+        m_sysNonblock = true;
+    } else {
+        m_sysNonblock = false;
+    }
+
+    m_userNonblock = false;
+    m_isClosed = false;
+    return m_isInit;
+}
+
+void FdCtx::setTimeout(int type, uint64_t v) {
+    if (type == SO_RCVTIMEO) {
+        m_recvTimeout = v;
+    } else {
+        m_sendTimeout = v;
+    }
+}
+
+uint64_t FdCtx::getTimeout(int type) const {
+    if (type == SO_RCVTIMEO) return m_recvTimeout;
+    return m_sendTimeout;
+}
+
+// ---------- FdManager ----------
+
+FdManager::FdManager() {
+    m_datas.resize(64);
+}
+
+FdManager &FdManager::GetInstance() {
+    static FdManager s_inst;
+    return s_inst;
+}
+
+FdCtx::ptr FdManager::get(int fd, bool auto_create) {
+    if (fd < 0) return nullptr;
+    {
+        std::shared_lock<std::shared_mutex> sl(m_mutex);
+        if ((size_t)fd < m_datas.size()) {
+            if (m_datas[fd] || !auto_create) return m_datas[fd];
+        } else if (!auto_create) {
+            return nullptr;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> ul(m_mutex);
+    if ((size_t)fd >= m_datas.size()) {
+        m_datas.resize(fd * 3 / 2 + 1);
+    }
+    if (!m_datas[fd]) {
+        m_datas[fd] = std::make_shared<FdCtx>(fd);
+    }
+    return m_datas[fd];
+}
+
+// 先标记旧上下文关闭再唤醒等待者：被唤醒的协程看到关闭后直接返回 EBADF，不会对这个 fd 号重新等待
+// cancelAll 在锁外调用（会调度被唤醒的协程）；fd 不在表里也要调用，addEvent 可以直接用于没有登记的 fd
+void FdManager::del(int fd) {
+    if (fd < 0) return;
+    FdCtx::ptr ctx;
+    {
+        std::unique_lock<std::shared_mutex> ul(m_mutex);
+        if ((size_t)fd < m_datas.size()) ctx = std::move(m_datas[fd]);
+    }
+    if (ctx) ctx->setClose();
+    IOManager::CancelAllEverywhere(fd);
+}
+
+// 新上下文在锁外构造（init 里有 fstat / fcntl），旧上下文也在锁外释放
+FdCtx::ptr FdManager::reset(int fd) {
+    if (fd < 0) return nullptr;
+    FdCtx::ptr ctx = std::make_shared<FdCtx>(fd);
+    FdCtx::ptr old;
+    {
+        std::unique_lock<std::shared_mutex> ul(m_mutex);
+        if ((size_t)fd >= m_datas.size()) {
+            m_datas.resize(fd * 3 / 2 + 1);
+        }
+        old = std::exchange(m_datas[fd], ctx);
+    }
+    if (old) old->setClose();
+    return ctx;
+}
+
+} // namespace sunshine
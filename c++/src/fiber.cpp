@@ -1,7 +1,10 @@
 #include "libs/fiber.h"
+#include "libs/Config.h"
+#include "libs/stack_pool.h"
 #include <cassert>
 #include <cstddef>
 #include <cstdlib>
+#include <cstring>
 #include <atomic>
 #include <bits/types/stack_t.h>
 #include <new>
@@ -19,12 +22,43 @@ namespace sunshine {
 // t_cur_fiber:  指向当前正在执行的协程（可能是主协程或用户创建的协程）
 static thread_local Fiber *t_main_fiber = nullptr; // 主协程地址（线程私有）
 static thread_local Fiber *t_cur_fiber = nullptr;  // 当前协程地址（线程私有）
+// 刚刚切回主协程的那个协程：主协程在 swapIn 返回后清除它的 m_running 标记
+static thread_local Fiber *t_switched_out = nullptr;
 
 // 全局（跨线程安全）协程计数器：用来统计已创建的 Fiber 数量
 static std::atomic<uint64_t> s_fiber_count(0);
 
-// 默认协程栈大小（字节），如果用户未指定则使用此值
-static const size_t DEFAULT_STACK_SIZE = 128 * 1024; // 128 KB
+// 共享栈模式：所有协程轮流使用线程的一块大栈，切出时只把实际用到的部分拷走，
+// 大量空闲协程只占用各自保存下来的几 KB。代价是每次切换多一次拷贝，且协程绑定线程
+static ConfigVar<bool>::ptr g_fiber_shared_stack =
+    Config::Lookup<bool>("fiber.shared_stack", false, "run fibers on a per-thread shared stack");
+static ConfigVar<uint32_t>::ptr g_fiber_shared_stack_size =
+    Config::Lookup<uint32_t>("fiber.shared_stack_size", 1024 * 1024, "per-thread shared stack size");
+
+// 保存共享栈时在切出点之下多保存的字节数（覆盖上下文切换函数的调用帧）
+static const size_t SHARED_STACK_SAVE_MARGIN = 512;
+
+// 线程共享栈：第一次有共享栈协程在该线程运行时分配
+// occupant 只用于比较：栈上的内容仍属于它时切回无需再拷贝
+struct SharedStack {
+    char *base = nullptr;
+    size_t size = 0;
+    Fiber *occupant = nullptr;
+
+    ~SharedStack() {
+        if (base) StackPool::Unmap(base, size);
+    }
+};
+static thread_local SharedStack t_shared_stack;
+
+static SharedStack &GetSharedStack() {
+    SharedStack &ss = t_shared_stack;
+    if (!ss.base) {
+        ss.size = StackPool::RoundToPage(g_fiber_shared_stack_size->getValue());
+        ss.base = static_cast<char *>(StackPool::Map(ss.size));
+    }
+    return ss;
+}
 
 // ---------- 构造 / 析构 ----------
 
@@ -34,11 +68,14 @@ Fiber::Fiber() {
     // 生成唯一 id（简单自增）
     m_id = ++s_fiber_count;
 
+#if !SUNSHINE_FIBER_ASM_CONTEXT
     // 获取当前上下文（保存到 m_ctx），以便后续 swapcontext 能切回来
     // getcontext 通常不会改变寄存器状态，只是把当前 execution context 保存到 m_ctx
+    // （asm 后端不需要：第一次切出时自然保存到 m_sp）
     if (getcontext(&m_ctx) != 0) {
         throw std::runtime_error("getcontext failed foe main fiber");
     }
+#endif
 
     // 将线程局部的当前协程和主协程指向自己
     // 主协程指代线程的原始执行上下文（非 heap 分配的用户协程）
@@ -50,59 +87,124 @@ Fiber::Fiber() {
 }
 
 // 普通协程构造：创建一个具有独立栈并将在 makecontext 中绑定 MainFunc 的协程
-Fiber::Fiber(std::function<void()> cb, size_t stacksize) :
-    m_cb(move(cb)) {
+// 栈来自 StackPool（mmap + 保护页，线程内缓存复用）；共享栈协程在第一次切入时再建立上下文
+Fiber::Fiber(Task cb, size_t stacksize) :
+    m_cb(std::move(cb)) {
     // 分配 id
     m_id = ++s_fiber_count;
 
-    // 如果用户未指定则使用默认栈大小
-    m_stacksize = stacksize;
-    if (stacksize == 0) {
-        m_stacksize = DEFAULT_STACK_SIZE;
-    }
-
     // 初始状态设为 INIT（尚未执行）
     m_state = INIT;
 
-    // 分配栈（使用 malloc 而非 new[]，因为 ucontext 接口期望裸内存）
-    m_stack = malloc(m_stacksize);
-    if (!m_stack) {
-        throw std::bad_alloc();
+    if (g_fiber_shared_stack->getValue()) {
+        m_sharedStack = true;
+        return;
+    }
+
+    // 如果用户未指定则使用默认栈大小；Alloc 会按页取整并回写实际大小
+    m_stacksize = stacksize ? stacksize : StackPool::DefaultSize();
+    m_stack = StackPool::Alloc(m_stacksize);
+
+    try {
+        initContext(m_stack, m_stacksize);
+    } catch (...) {
+        StackPool::Free(m_stack, m_stacksize);
+        m_stack = nullptr;
+        throw;
+    }
+}
+
+// 析构：归还协程栈（如果存在）/ 释放共享栈的保存区
+Fiber::~Fiber() {
+    if (m_stack) {
+        StackPool::Free(m_stack, m_stacksize);
+        m_stack = nullptr;
     }
+    if (m_saved) {
+        std::free(m_saved);
+        m_saved = nullptr;
+    }
+}
 
-    // 初始化上下文
+// initContext: 获取上下文并绑定栈和入口函数
+void Fiber::initContext(void *stack, size_t size) {
+#if SUNSHINE_FIBER_ASM_CONTEXT
+    // 在栈顶构造初始寄存器帧，第一次切入时进入 MainFunc(this)
+    m_sp = MakeContext(stack, size, &Fiber::MainFunc, (uintptr_t)this);
+#else
     if (getcontext(&m_ctx) != 0) {
-        // 如果 getcontext 失败，释放已分配栈
-        std::free(m_stack);
         throw std::runtime_error("getcontext failed");
     }
 
-    // 将分配的栈与上下文关联
-    m_ctx.uc_stack.ss_sp = m_stack;       // 栈底（起始地址）
-    m_ctx.uc_stack.ss_size = m_stacksize; // 栈大小
-    m_ctx.uc_link = nullptr;              // 协程函数返回时的上下文（nullptr 表示没有自动回链）
+    // 将栈与上下文关联
+    m_ctx.uc_stack.ss_sp = stack;   // 栈底（起始地址）
+    m_ctx.uc_stack.ss_size = size;  // 栈大小
+    m_ctx.uc_link = nullptr;        // 协程函数返回时的上下文（nullptr 表示没有自动回链）
 
     // 将协程入口函数 MainFunc 绑定到上下文，并把当前 this 作为参数传入
     // 注意：makecontext 的可变参数需要与 MainFunc 的签名匹配（这里使用 uintptr_t 传指针）
     // 强转写法在大多数 x86_64/linux 下可行，但可移植性需注意。
     makecontext(&m_ctx, (void (*)()) & Fiber::MainFunc, 1, (uintptr_t)this);
+#endif
 }
 
-// 析构：释放为协程分配的栈（如果存在）
-Fiber::~Fiber() {
-    if (m_stack) {
-        free(m_stack);
-        m_stack = nullptr;
+// switchTo: 保存当前上下文到 this，并切换到 to
+// asm 后端只保存 callee-saved 寄存器；ucontext 后端每次切换都会保存 / 恢复信号掩码（一次系统调用）
+void Fiber::switchTo(Fiber *to) {
+#if SUNSHINE_FIBER_ASM_CONTEXT
+    sunshine_ctx_swap(&m_sp, to->m_sp);
+#else
+    if (swapcontext(&m_ctx, &to->m_ctx) != 0) {
+        throw std::runtime_error("swapcontext failed");
     }
+#endif
+}
+
+// restoreSharedStack: 切入共享栈协程前调用（运行在主协程栈上）
+// - INIT：绑定当前线程，在线程共享栈上建立入口上下文
+// - 其他：共享栈上的内容不是自己的（中间有别的协程用过），把保存的内容拷回原位置
+void Fiber::restoreSharedStack() {
+    SharedStack &ss = GetSharedStack();
+    if (m_state == INIT) {
+        m_boundThread = std::this_thread::get_id();
+        m_savedSize = 0;
+        initContext(ss.base, ss.size);
+    } else {
+        if (m_boundThread != std::this_thread::get_id()) {
+            throw std::logic_error("shared stack fiber resumed on another thread");
+        }
+        if (ss.occupant != this && m_savedSize) {
+            memcpy(ss.base + ss.size - m_savedSize, m_saved, m_savedSize);
+        }
+    }
+    ss.occupant = this;
+}
+
+// saveSharedStack: 共享栈协程切回主协程后调用（运行在主协程栈上）
+// 只保存 [切出点 - margin, 栈顶) 这一段，通常只有几 KB
+void Fiber::saveSharedStack() {
+    SharedStack &ss = t_shared_stack;
+    char *top = ss.base + ss.size;
+    char *sp = m_savedSp - SHARED_STACK_SAVE_MARGIN;
+    if (sp < ss.base) sp = ss.base;
+    size_t n = static_cast<size_t>(top - sp);
+    if (n > m_savedCap) {
+        char *buf = static_cast<char *>(std::realloc(m_saved, n));
+        if (!buf) throw std::bad_alloc();
+        m_saved = buf;
+        m_savedCap = n;
+    }
+    memcpy(m_saved, sp, n);
+    m_savedSize = n;
 }
 
 // ---------- 协程复用 / 重置 ----------
 
 // reset: 在协程处于 INIT 或 TERM 时可以复用该对象（重新绑定回调并重建上下文）
 // 仅在该 Fiber 有独立栈（即非主协程）时允许 reset
-void Fiber::reset(std::function<void()> cb) {
+void Fiber::reset(Task cb) {
     // 不允许对主协程或没有栈的协程 reset
-    if (!m_stack) {
+    if (!m_stack && !m_sharedStack) {
         throw std::logic_error("can't reset a main fiber or a fiber without stack");
     }
 
@@ -112,19 +214,15 @@ void Fiber::reset(std::function<void()> cb) {
     }
 
     // 赋新回调并复位状态
-    m_cb = move(cb);
+    m_cb = std::move(cb);
     m_state = INIT;
 
-    // 重新获取上下文并绑定栈（与构造时相同）
-    if (getcontext(&m_ctx) != 0) {
-        throw std::runtime_error("getcontext failed in reset");
+    // 重新获取上下文并绑定栈（与构造时相同）；共享栈协程在下次切入时重新建立
+    if (m_sharedStack) {
+        m_savedSize = 0;
+        return;
     }
-
-    m_ctx.uc_stack.ss_sp = m_stack;
-    m_ctx.uc_stack.ss_size = m_stacksize;
-    m_ctx.uc_link = nullptr;
-
-    makecontext(&m_ctx, (void (*)()) & Fiber::MainFunc, 1, (uintptr_t)this);
+    initContext(m_stack, m_stacksize);
 }
 
 // ---------- 上下文切换接口 ----------
@@ -142,6 +240,22 @@ void Fiber::swapIn() {
     // 如果要切换的是当前协程，则无需切换
     if (this == t_cur_fiber) return;
 
+    // 协程可能在挂起后立刻被其他线程调度（例如 I/O 事件先于 swapOut 完成到达），
+    // 等原线程把它的上下文完整保存后再切入
+    while (m_running.exchange(true, std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+
+    // 共享栈协程：先把自己的栈内容放回共享栈
+    if (m_sharedStack) {
+        try {
+            restoreSharedStack();
+        } catch (...) {
+            m_running.store(false, std::memory_order_release);
+            throw;
+        }
+    }
+
     // 设置目标协程状态为执行中
     m_state = EXEC;
 
@@ -149,10 +263,17 @@ void Fiber::swapIn() {
     auto pre = t_cur_fiber;
     t_cur_fiber = this;
 
-    // swapcontext: 保存 pre 的上下文到 pre->m_ctx，并切到 this 的 m_ctx
+    // 保存 pre 的上下文，并切到 this 的上下文
     // 返回时表示后续有上下文切回到 pre（即其他协程切回了 pre）
-    if (swapcontext(&pre->m_ctx, &m_ctx) != 0) {
-        throw std::runtime_error("swapcontext swapIn failed");
+    pre->switchTo(this);
+
+    // 切回来了：切出的协程上下文已保存完毕，允许其他线程切入
+    // 共享栈协程在此之前把栈内容拷走（结束的协程不需要）
+    if (t_switched_out) {
+        Fiber *out = t_switched_out;
+        t_switched_out = nullptr;
+        if (out->m_sharedStack && out->m_state != TERM) out->saveSharedStack();
+        out->m_running.store(false, std::memory_order_release);
     }
 }
 
@@ -168,16 +289,18 @@ void Fiber::swapOut() {
         m_state = HOLD;
     }
 
-    // 注意：这里使用 t_cur_fiber（当前协程）来做 swapcontext 的源，
+    // 注意：这里使用 t_cur_fiber（当前协程）来做上下文切换的源，
     //      并把 t_cur_fiber 切回到主协程指针。
     //      也可以写成 Fiber *self = this; 语义更明确（this 应等于 t_cur_fiber）
     Fiber *self = t_cur_fiber;
     t_cur_fiber = t_main_fiber;
+    t_switched_out = self;
+    // 记录切出点（共享栈协程据此决定要保存多少栈内容）
+    volatile char marker = 0;
+    self->m_savedSp = const_cast<char *>(&marker);
 
-    // 保存当前协程上下文到 self->m_ctx，并切换到主协程上下文
-    if (swapcontext(&self->m_ctx, &t_main_fiber->m_ctx) != 0) {
-        throw std::runtime_error("swapcontext swapOut failed");
-    }
+    // 保存当前协程上下文，并切换到主协程上下文
+    self->switchTo(t_main_fiber);
 }
 
 // ---------- 辅助静态接口 ----------
@@ -213,6 +336,11 @@ uint64_t Fiber::TotalFibers() {
     return s_fiber_count;
 }
 
+// IsMainFiber: 当前是否运行在线程主协程上（尚未使用过协程的线程也视为主协程）
+bool Fiber::IsMainFiber() {
+    return !t_cur_fiber || t_cur_fiber == t_main_fiber;
+}
+
 // ---------- 协程入口函数（由 makecontext 调用） ----------
 // MainFunc 的签名接受一个 uintptr_t，用来传递 this 指针（不同平台上需注意调用约定）
 void Fiber::MainFunc(uintptr_t raw) {
@@ -244,10 +372,14 @@ void Fiber::MainFunc(uintptr_t raw) {
     // 协程结束后，把当前协程指向主协程并切回主协程上下文
     Fiber *self = f;
     t_cur_fiber = t_main_fiber;
-    if (swapcontext(&self->m_ctx, &t_main_fiber->m_ctx) != 0) {
+    t_switched_out = self;
+    try {
+        self->switchTo(t_main_fiber);
+    } catch (...) {
         // 如果切换失败，无法恢复到主协程，直接终止程序
-        std::terminate();
     }
+    // 结束的协程不会再被切回；走到这里说明切换失败
+    std::terminate();
 }
 
 } // namespace sunshine
@@ -0,0 +1,131 @@
+// file: libs/fiber_sync.cpp
+#include "libs/fiber_sync.h"
+
+namespace sunshine {
+
+// ---------- FiberWaitQueue ----------
+
+// 协程：排队后先解锁再让出；唤醒方可能在让出之前就重新调度了它，
+// Fiber::swapIn 会等本线程切出完成（m_running）后才切入，不会丢失上下文
+// 线程：在 m_threadCond 上等 done（由 dequeue 在锁内置位），与 lk 是同一把锁
+void FiberWaitQueue::park(std::unique_lock<std::mutex> &lk) {
+    Scheduler *sched = Scheduler::GetThis();
+    if (sched && !Fiber::IsMainFiber()) {
+        Waiter w;
+        w.sched = sched;
+        w.fiber = Fiber::GetThis()->shared_from_this();
+        m_waiters.push_back(std::move(w));
+        lk.unlock();
+        Fiber::YieldToHold();
+        return;
+    }
+    bool done = false;
+    Waiter w;
+    w.done = &done;
+    m_waiters.push_back(std::move(w));
+    m_threadCond.wait(lk, [&done]() { return done; });
+    lk.unlock();
+}
+
+bool FiberWaitQueue::dequeue(Waiter &out) {
+    if (!m_waiters.pop_front(out)) return false;
+    m_count.fetch_sub(1, std::memory_order_relaxed);
+    if (out.done) {
+        // 线程等待者在锁内唤醒：解锁之后不再访问本队列
+        *out.done = true;
+        out.done = nullptr;
+        m_threadCond.notify_all();
+    }
+    return true;
+}
+
+size_t FiberWaitQueue::dequeue(std::vector<Waiter> &out, size_t n) {
+    size_t count = 0;
+    Waiter w;
+    while (count < n && dequeue(w)) {
+        if (w.fiber) out.push_back(std::move(w));
+        w = Waiter();
+        ++count;
+    }
+    return count;
+}
+
+// ---------- FiberMutex ----------
+
+// 置为 CONTENDED 再检查原值：原值为 UNLOCKED 说明抢到了锁（之后的 unlock 会多走一次慢路径，无害）
+// 否则持锁者 unlock 时一定看到 CONTENDED，而它唤醒前要先拿 m_mutex，此时本等待者已经排好队
+void FiberMutex::lockSlow() {
+    std::unique_lock<std::mutex> lk(m_mutex);
+    while (m_state.exchange(CONTENDED, std::memory_order_acquire) != UNLOCKED) {
+        m_waiters.prepare();
+        m_waiters.park(lk);
+        lk.lock();
+    }
+}
+
+void FiberMutex::unlockSlow() {
+    FiberWaitQueue::Waiter w;
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        if (!m_waiters.dequeue(w)) return;
+    }
+    FiberWaitQueue::Wake(w);
+}
+
+// ---------- FiberCondVar ----------
+
+// 先拿 m_mutex 再释放用户的锁：notify 需要 m_mutex 才能取等待者，此时本等待者已经登记
+void FiberCondVar::wait(std::unique_lock<FiberMutex> &lock) {
+    std::unique_lock<std::mutex> lk(m_mutex);
+    m_waiters.prepare();
+    lock.unlock();
+    m_waiters.park(lk);
+    lock.lock();
+}
+
+void FiberCondVar::notify_one() {
+    if (!m_waiters.hasWaiters()) return;
+    FiberWaitQueue::Waiter w;
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        if (!m_waiters.dequeue(w)) return;
+    }
+    FiberWaitQueue::Wake(w);
+}
+
+void FiberCondVar::notify_all() {
+    if (!m_waiters.hasWaiters()) return;
+    std::vector<FiberWaitQueue::Waiter> woken;
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_waiters.dequeue(woken);
+    }
+    for (auto &w : woken) FiberWaitQueue::Wake(w);
+}
+
+// ---------- FiberSemaphore ----------
+
+// 被唤醒后重新竞争：期间新来的 tryWait 可能先拿走计数，失败则再次登记挂起
+void FiberSemaphore::waitSlow() {
+    std::unique_lock<std::mutex> lk(m_mutex);
+    for (;;) {
+        m_waiters.prepare();
+        if (tryWait()) {
+            m_waiters.cancel();
+            return;
+        }
+        m_waiters.park(lk);
+        lk.lock();
+    }
+}
+
+void FiberSemaphore::postSlow(size_t n) {
+    std::vector<FiberWaitQueue::Waiter> woken;
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_waiters.dequeue(woken, n);
+    }
+    for (auto &w : woken) FiberWaitQueue::Wake(w);
+}
+
+} // namespace sunshine
@@ -0,0 +1,512 @@
+// file: libs/hook.cpp
+#include "libs/hook.h"
+#include "libs/Config.h"
+#include "libs/fd_manager.h"
+#include "libs/fiber.h"
+#include "libs/iomanager.h"
+#include "libs/log.h"
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <sys/time.h>
+
+namespace sunshine {
+
+// 线程局部：当前线程是否开启 hook（IOManager 工作线程在 run() 中开启）
+static thread_local bool t_hook_enable = false;
+
+// tcp.connect.timeout：hook 后的 connect() 默认超时（毫秒，-1 表示不超时）
+// 放在函数内静态变量里，避免与 Config 的静态成员产生初始化顺序问题
+static ConfigVar<int>::ptr GetConnectTimeoutVar() {
+    static ConfigVar<int>::ptr s_var =
+        Config::Lookup<int>("tcp.connect.timeout", 5000, "tcp connect timeout");
+    return s_var;
+}
+
+#define HOOK_FUN(XX) \
+    XX(sleep)        \
+    XX(usleep)       \
+    XX(nanosleep)    \
+    XX(socket)       \
+    XX(connect)      \
+    XX(accept)       \
+    XX(accept4)      \
+    XX(read)         \
+    XX(readv)        \
+    XX(recv)         \
+    XX(recvfrom)     \
+    XX(recvmsg)      \
+    XX(write)        \
+    XX(writev)       \
+    XX(send)         \
+    XX(sendto)       \
+    XX(sendmsg)      \
+    XX(close)        \
+    XX(fcntl)        \
+    XX(ioctl)        \
+    XX(getsockopt)   \
+    XX(setsockopt)
+
+// 通过 dlsym(RTLD_NEXT) 取得 libc 中的原始实现
+static void hook_init() {
+    static bool is_inited = false;
+    if (is_inited) return;
+    is_inited = true;
+#define XX(name) name##_f = (name##_fun)dlsym(RTLD_NEXT, #name);
+    HOOK_FUN(XX);
+#undef XX
+}
+
+// 尽早初始化：其他编译单元的静态对象构造时就可能调用 write 等函数
+struct _HookIniter {
+    _HookIniter() {
+        hook_init();
+    }
+};
+static _HookIniter s_hook_initer __attribute__((init_priority(101)));
+
+bool is_hook_enable() {
+    return t_hook_enable;
+}
+
+void set_hook_enable(bool flag) {
+    t_hook_enable = flag;
+}
+
+// 当前上下文能否让出协程等待：需要开启 hook、处于 IOManager 线程、且不在主协程上
+static IOManager *yieldableIOManager() {
+    if (!t_hook_enable || Fiber::IsMainFiber()) return nullptr;
+    return IOManager::GetThis();
+}
+
+// __errno_location 被声明为 const 函数，编译器会在同一个函数内复用 errno 的地址；
+// 协程让出后可能在另一个线程上恢复，因此这里统一通过非内联函数读写 errno
+__attribute__((noinline)) static int get_errno() {
+    return errno;
+}
+
+__attribute__((noinline)) static void set_errno(int e) {
+    errno = e;
+}
+
+// 协程版 sleep：挂一个定时器到期后重新调度当前协程；无法让出时返回 false
+static bool fiber_sleep(uint64_t ms) {
+    IOManager *iom = yieldableIOManager();
+    if (!iom) return false;
+    Fiber::ptr fiber = Fiber::GetThis()->shared_from_this();
+    iom->addTimer(ms, [iom, fiber]() {
+        iom->scheduler(fiber);
+    });
+    Fiber::YieldToHold();
+    return true;
+}
+
+// 超时状态：定时器先到期时记录 ETIMEDOUT 并取消事件（事件取消会唤醒等待的协程）
+struct timer_info {
+    int cancelled = 0;
+};
+
+// 通用 I/O 模板：
+// 1. 未开启 hook / 非 socket / 用户设置了非阻塞：直接调用原始函数
+// 2. 调用原始函数，EAGAIN 时注册 fd 事件（可选超时定时器）并让出协程
+// 3. 被唤醒后若是超时则返回 -1（errno=ETIMEDOUT），否则重试
+template <typename OriginFun, typename... Args>
+static ssize_t do_io(int fd, OriginFun fun, uint32_t event, int timeout_so, Args &&...args) {
+    if (!t_hook_enable) {
+        return fun(fd, std::forward<Args>(args)...);
+    }
+
+    FdCtx::ptr ctx = FdManager::GetInstance().get(fd);
+    if (!ctx) {
+        return fun(fd, std::forward<Args>(args)...);
+    }
+    if (ctx->isClose()) {
+        set_errno(EBADF);
+        return -1;
+    }
+    if (!ctx->isSocket() || ctx->getUserNonblock()) {
+        return fun(fd, std::forward<Args>(args)...);
+    }
+
+    uint64_t to = ctx->getTimeout(timeout_so);
+    std::shared_ptr<timer_info> tinfo(new timer_info);
+
+retry:
+    ssize_t n = fun(fd, args...);
+    while (n == -1 && get_errno() == EINTR) {
+        n = fun(fd, args...);
+    }
+    if (n == -1 && get_errno() == EAGAIN) {
+        IOManager *iom = yieldableIOManager();
+        if (!iom) return n;
+
+        Timer::ptr timer;
+        std::weak_ptr<timer_info> winfo(tinfo);
+        if (to != (uint64_t)-1) {
+            timer = iom->addConditionTimer(to, [winfo, fd, iom, event]() {
+                auto t = winfo.lock();
+                if (!t || t->cancelled) return;
+                t->cancelled = ETIMEDOUT;
+                iom->cancelEvent(fd, (IOManager::Event)(event));
+            }, winfo);
+        }
+
+        int rt = iom->addEvent(fd, (IOManager::Event)(event));
+        if (rt != 0) {
+            LOG_ERROR(LogManager::GetInstance().getRoot())
+                << "do_io addEvent(" << fd << ", " << event << ") error errno=" << get_errno();
+            if (timer) timer->cancel();
+            return -1;
+        }
+
+        Fiber::YieldToHold();
+        if (timer) timer->cancel();
+        if (tinfo->cancelled) {
+            set_errno(tinfo->cancelled);
+            return -1;
+        }
+        if (ctx->isClose()) {
+            set_errno(EBADF);
+            return -1;
+        }
+        goto retry;
+    }
+    return n;
+}
+
+// io_uring 后端：fd 是 hook 管理、阻塞语义的 socket 且当前协程可以让出时，由 op(iom, timeout, res) 提交 io_uring 请求
+// 返回 false 表示不走 io_uring（调用方走 do_io 的 epoll 路径）；返回 true 时 n 为调用结果（失败为 -1 并设置 errno）
+template <typename Op>
+static bool uring_io(int fd, int timeout_so, ssize_t &n, Op &&op) {
+    if (!t_hook_enable) return false;
+    IOManager *iom = yieldableIOManager();
+    if (!iom || !iom->isUring()) return false;
+    FdCtx::ptr ctx = FdManager::GetInstance().get(fd);
+    if (!ctx || ctx->isClose() || !ctx->isSocket() || ctx->getUserNonblock()) return false;
+
+    ssize_t res = 0;
+    if (!op(iom, ctx->getTimeout(timeout_so), res)) return false;
+    if (res < 0) {
+        set_errno(static_cast<int>(-res));
+        n = -1;
+    } else {
+        n = res;
+    }
+    return true;
+}
+
+} // namespace sunshine
+
+extern "C" {
+
+#define XX(name) name##_fun name##_f = nullptr;
+HOOK_FUN(XX);
+#undef XX
+
+unsigned int sleep(unsigned int seconds) {
+    if (!sunshine::fiber_sleep(seconds * 1000ull)) return sleep_f(seconds);
+    return 0;
+}
+
+int usleep(useconds_t usec) {
+    if (!sunshine::fiber_sleep(usec / 1000)) return usleep_f(usec);
+    return 0;
+}
+
+int nanosleep(const struct timespec *req, struct timespec *rem) {
+    if (!req) return nanosleep_f(req, rem);
+    uint64_t ms = req->tv_sec * 1000ull + req->tv_nsec / 1000000;
+    if (!sunshine::fiber_sleep(ms)) return nanosleep_f(req, rem);
+    return 0;
+}
+
+int socket(int domain, int type, int protocol) {
+    int fd = socket_f(domain, type, protocol);
+    if (fd == -1) return fd;
+    // 新 fd 的编号可能属于一个被 close_f 直接关闭的旧 fd：先丢弃旧的状态
+    sunshine::FdManager::GetInstance().del(fd);
+    if (!sunshine::t_hook_enable) return fd;
+    auto ctx = sunshine::FdManager::GetInstance().get(fd, true);
+    if (ctx && (type & SOCK_NONBLOCK)) ctx->setUserNonblock(true);
+    return fd;
+}
+
+int connect_with_timeout(int fd, const struct sockaddr *addr, socklen_t addrlen, uint64_t timeout_ms) {
+    if (!sunshine::t_hook_enable) return connect_f(fd, addr, addrlen);
+
+    sunshine::FdCtx::ptr ctx = sunshine::FdManager::GetInstance().get(fd);
+    if (!ctx) return connect_f(fd, addr, addrlen);
+    if (ctx->isClose()) {
+        sunshine::set_errno(EBADF);
+        return -1;
+    }
+    if (!ctx->isSocket() || ctx->getUserNonblock()) return connect_f(fd, addr, addrlen);
+
+    ssize_t un;
+    if (sunshine::uring_io(fd, SO_SNDTIMEO, un, [&](sunshine::IOManager *iom, uint64_t, ssize_t &res) {
+            return iom->uringConnect(fd, addr, addrlen, timeout_ms, res);
+        })) {
+        return static_cast<int>(un);
+    }
+
+    int n = connect_f(fd, addr, addrlen);
+    if (n == 0) return 0;
+    if (n != -1 || sunshine::get_errno() != EINPROGRESS) return n;
+
+    sunshine::IOManager *iom = sunshine::yieldableIOManager();
+    if (!iom) return n;
+
+    sunshine::Timer::ptr timer;
+    std::shared_ptr<sunshine::timer_info> tinfo(new sunshine::timer_info);
+    std::weak_ptr<sunshine::timer_info> winfo(tinfo);
+    if (timeout_ms != (uint64_t)-1) {
+        timer = iom->addConditionTimer(timeout_ms, [winfo, fd, iom]() {
+            auto t = winfo.lock();
+            if (!t || t->cancelled) return;
+            t->cancelled = ETIMEDOUT;
+            iom->cancelEvent(fd, sunshine::IOManager::WRITE);
+        }, winfo);
+    }
+
+    int rt = iom->addEvent(fd, sunshine::IOManager::WRITE);
+    if (rt == 0) {
+        sunshine::Fiber::YieldToHold();
+        if (timer) timer->cancel();
+        if (tinfo->cancelled) {
+            sunshine::set_errno(tinfo->cancelled);
+            return -1;
+        }
+        if (ctx->isClose()) {
+            sunshine::set_errno(EBADF);
+            return -1;
+        }
+    } else {
+        if (timer) timer->cancel();
+        LOG_ERROR(sunshine::LogManager::GetInstance().getRoot())
+            << "connect addEvent(" << fd << ", WRITE) error";
+    }
+
+    int error = 0;
+    socklen_t len = sizeof(int);
+    if (getsockopt_f(fd, SOL_SOCKET, SO_ERROR, &error, &len) == -1) return -1;
+    if (error == 0) return 0;
+    sunshine::set_errno(error);
+    return -1;
+}
+
+int connect(int sockfd, const struct sockaddr *addr, socklen_t addrlen) {
+    int timeout = sunshine::t_hook_enable ? sunshine::GetConnectTimeoutVar()->getValue() : -1;
+    return connect_with_timeout(sockfd, addr, addrlen, timeout < 0 ? (uint64_t)-1 : (uint64_t)timeout);
+}
+
+int accept(int s, struct sockaddr *addr, socklen_t *addrlen) {
+    ssize_t n;
+    int fd;
+    if (sunshine::uring_io(s, SO_RCVTIMEO, n, [&](sunshine::IOManager *iom, uint64_t to, ssize_t &res) {
+            return iom->uringAccept(s, addr, addrlen, 0, to, res);
+        })) {
+        fd = static_cast<int>(n);
+    } else {
+        fd = sunshine::do_io(s, accept_f, sunshine::IOManager::READ, SO_RCVTIMEO, addr, addrlen);
+    }
+    if (fd >= 0) {
+        sunshine::FdManager::GetInstance().del(fd); // 同 socket()
+        if (sunshine::t_hook_enable) sunshine::FdManager::GetInstance().get(fd, true);
+    }
+    return fd;
+}
+
+int accept4(int s, struct sockaddr *addr, socklen_t *addrlen, int flags) {
+    ssize_t n;
+    int fd;
+    if (sunshine::uring_io(s, SO_RCVTIMEO, n, [&](sunshine::IOManager *iom, uint64_t to, ssize_t &res) {
+            return iom->uringAccept(s, addr, addrlen, flags, to, res);
+        })) {
+        fd = static_cast<int>(n);
+    } else {
+        fd = sunshine::do_io(s, accept4_f, sunshine::IOManager::READ, SO_RCVTIMEO, addr, addrlen, flags);
+    }
+    if (fd >= 0) {
+        sunshine::FdManager::GetInstance().del(fd); // 同 socket()
+        if (sunshine::t_hook_enable) {
+            auto ctx = sunshine::FdManager::GetInstance().get(fd, true);
+            if (ctx && (flags & SOCK_NONBLOCK)) ctx->setUserNonblock(true);
+        }
+    }
+    return fd;
+}
+
+ssize_t read(int fd, void *buf, size_t count) {
+    ssize_t n;
+    if (sunshine::uring_io(fd, SO_RCVTIMEO, n, [&](sunshine::IOManager *iom, uint64_t to, ssize_t &res) {
+            return iom->uringRecv(fd, buf, count, 0, to, res);
+        })) {
+        return n;
+    }
+    return sunshine::do_io(fd, read_f, sunshine::IOManager::READ, SO_RCVTIMEO, buf, count);
+}
+
+ssize_t readv(int fd, const struct iovec *iov, int iovcnt) {
+    return sunshine::do_io(fd, readv_f, sunshine::IOManager::READ, SO_RCVTIMEO, iov, iovcnt);
+}
+
+// MSG_DONTWAIT 要求不阻塞，不走 io_uring
+ssize_t recv(int sockfd, void *buf, size_t len, int flags) {
+    ssize_t n;
+    if (!(flags & MSG_DONTWAIT) &&
+        sunshine::uring_io(sockfd, SO_RCVTIMEO, n, [&](sunshine::IOManager *iom, uint64_t to, ssize_t &res) {
+            return iom->uringRecv(sockfd, buf, len, flags, to, res);
+        })) {
+        return n;
+    }
+    return sunshine::do_io(sockfd, recv_f, sunshine::IOManager::READ, SO_RCVTIMEO, buf, len, flags);
+}
+
+ssize_t recvfrom(int sockfd, void *buf, size_t len, int flags, struct sockaddr *src_addr, socklen_t *addrlen) {
+    return sunshine::do_io(sockfd, recvfrom_f, sunshine::IOManager::READ, SO_RCVTIMEO, buf, len, flags, src_addr, addrlen);
+}
+
+ssize_t recvmsg(int sockfd, struct msghdr *msg, int flags) {
+    return sunshine::do_io(sockfd, recvmsg_f, sunshine::IOManager::READ, SO_RCVTIMEO, msg, flags);
+}
+
+ssize_t write(int fd, const void *buf, size_t count) {
+    ssize_t n;
+    if (sunshine::uring_io(fd, SO_SNDTIMEO, n, [&](sunshine::IOManager *iom, uint64_t to, ssize_t &res) {
+            return iom->uringSend(fd, buf, count, 0, to, res);
+        })) {
+        return n;
+    }
+    return sunshine::do_io(fd, write_f, sunshine::IOManager::WRITE, SO_SNDTIMEO, buf, count);
+}
+
+ssize_t writev(int fd, const struct iovec *iov, int iovcnt) {
+    return sunshine::do_io(fd, writev_f, sunshine::IOManager::WRITE, SO_SNDTIMEO, iov, iovcnt);
+}
+
+ssize_t send(int s, const void *msg, size_t len, int flags) {
+    ssize_t n;
+    if (!(flags & MSG_DONTWAIT) &&
+        sunshine::uring_io(s, SO_SNDTIMEO, n, [&](sunshine::IOManager *iom, uint64_t to, ssize_t &res) {
+            return iom->uringSend(s, msg, len, flags, to, res);
+        })) {
+        return n;
+    }
+    return sunshine::do_io(s, send_f, sunshine::IOManager::WRITE, SO_SNDTIMEO, msg, len, flags);
+}
+
+ssize_t sendto(int s, const void *msg, size_t len, int flags, const struct sockaddr *to, socklen_t tolen) {
+    return sunshine::do_io(s, sendto_f, sunshine::IOManager::WRITE, SO_SNDTIMEO, msg, len, flags, to, tolen);
+}
+
+ssize_t sendmsg(int s, const struct msghdr *msg, int flags) {
+    return sunshine::do_io(s, sendmsg_f, sunshine::IOManager::WRITE, SO_SNDTIMEO, msg, flags);
+}
+
+// close：取消 fd 上所有等待的事件（唤醒等待的协程）并删除 fd 上下文（见 FdManager::del）
+// 普通线程里关闭、或 fd 属于别的 IOManager 时也一样：否则等待的协程永远不会被唤醒，
+// IOManager 里的 reactor 绑定 / 持久注册 / io_uring 状态以及 FdCtx 都会留给复用这个 fd 号的新 socket
+int close(int fd) {
+    sunshine::FdManager::GetInstance().del(fd);
+    return close_f(fd);
+}
+
+// fcntl：对 hook 管理的 socket，O_NONBLOCK 只记录为用户标记，系统层始终保持非阻塞
+int fcntl(int fd, int cmd, ... /* arg */) {
+    va_list va;
+    va_start(va, cmd);
+    switch (cmd) {
+    case F_SETFL: {
+        int arg = va_arg(va, int);
+        va_end(va);
+        sunshine::FdCtx::ptr ctx = sunshine::FdManager::GetInstance().get(fd);
+        if (!ctx || ctx->isClose() || !ctx->isSocket()) return fcntl_f(fd, cmd, arg);
+        ctx->setUserNonblock(arg & O_NONBLOCK);
+        if (ctx->getSysNonblock()) {
+            arg |= O_NONBLOCK;
+        } else {
+            arg &= ~O_NONBLOCK;
+        }
+        return fcntl_f(fd, cmd, arg);
+    }
+    case F_GETFL: {
+        va_end(va);
+        int arg = fcntl_f(fd, cmd);
+        sunshine::FdCtx::ptr ctx = sunshine::FdManager::GetInstance().get(fd);
+        if (!ctx || ctx->isClose() || !ctx->isSocket()) return arg;
+        if (ctx->getUserNonblock()) return arg | O_NONBLOCK;
+        return arg & ~O_NONBLOCK;
+    }
+    case F_DUPFD:
+    case F_DUPFD_CLOEXEC:
+    case F_SETFD:
+    case F_SETOWN:
+    case F_SETSIG:
+    case F_SETLEASE:
+    case F_NOTIFY:
+#ifdef F_SETPIPE_SZ
+    case F_SETPIPE_SZ:
+#endif
+    {
+        int arg = va_arg(va, int);
+        va_end(va);
+        return fcntl_f(fd, cmd, arg);
+    }
+    case F_GETFD:
+    case F_GETOWN:
+    case F_GETSIG:
+    case F_GETLEASE:
+#ifdef F_GETPIPE_SZ
+    case F_GETPIPE_SZ:
+#endif
+    {
+        va_end(va);
+        return fcntl_f(fd, cmd);
+    }
+    default: {
+        // 其余命令（F_SETLK / F_GETLK / F_GETOWN_EX ...）的参数都是指针
+        void *arg = va_arg(va, void *);
+        va_end(va);
+        return fcntl_f(fd, cmd, arg);
+    }
+    }
+}
+
+// ioctl：FIONBIO 同 fcntl(O_NONBLOCK)，对 hook 管理的 socket 只记录用户标记
+int ioctl(int d, unsigned long int request, ...) {
+    va_list va;
+    va_start(va, request);
+    void *arg = va_arg(va, void *);
+    va_end(va);
+
+    if (request == FIONBIO) {
+        sunshine::FdCtx::ptr ctx = sunshine::FdManager::GetInstance().get(d);
+        if (ctx && !ctx->isClose() && ctx->isSocket()) {
+            ctx->setUserNonblock(!!*(int *)arg);
+            return 0;
+        }
+    }
+    return ioctl_f(d, request, arg);
+}
+
+int getsockopt(int sockfd, int level, int optname, void *optval, socklen_t *optlen) {
+    return getsockopt_f(sockfd, level, optname, optval, optlen);
+}
+
+// setsockopt：记录 SO_RCVTIMEO / SO_SNDTIMEO，供 do_io 设置等待超时
+int setsockopt(int sockfd, int level, int optname, const void *optval, socklen_t optlen) {
+    if (!sunshine::t_hook_enable) return setsockopt_f(sockfd, level, optname, optval, optlen);
+    if (level == SOL_SOCKET && (optname == SO_RCVTIMEO || optname == SO_SNDTIMEO) && optval) {
+        sunshine::FdCtx::ptr ctx = sunshine::FdManager::GetInstance().get(sockfd);
+        if (ctx) {
+            const timeval *v = (const timeval *)optval;
+            uint64_t ms = v->tv_sec * 1000ull + v->tv_usec / 1000;
+            // 内核语义：0 表示不超时
+            ctx->setTimeout(optname, ms == 0 ? (uint64_t)-1 : ms);
+        }
+    }
+    return setsockopt_f(sockfd, level, optname, optval, optlen);
+}
+
+} // extern "C"
@@ -0,0 +1,255 @@
+// file: libs/http.cpp
+#include "libs/http.h"
+
+#include <charconv>
+#include <cstring>
+#include <ctime>
+
+namespace sunshine {
+
+static const struct {
+    HttpMethod method;
+    std::string_view name;
+} s_methods[] = {
+    {HttpMethod::GET, "GET"},         {HttpMethod::HEAD, "HEAD"},       {HttpMethod::POST, "POST"},
+    {HttpMethod::PUT, "PUT"},         {HttpMethod::DELETE, "DELETE"},   {HttpMethod::CONNECT, "CONNECT"},
+    {HttpMethod::OPTIONS, "OPTIONS"}, {HttpMethod::TRACE, "TRACE"},     {HttpMethod::PATCH, "PATCH"},
+};
+
+HttpMethod StringToHttpMethod(std::string_view m) {
+    for (auto &i : s_methods) {
+        if (i.name == m) return i.method;
+    }
+    return HttpMethod::INVALID;
+}
+
+const char *HttpMethodToString(HttpMethod m) {
+    for (auto &i : s_methods) {
+        if (i.method == m) return i.name.data();
+    }
+    return "<invalid>";
+}
+
+const char *HttpStatusReason(uint16_t status) {
+    switch (status) {
+    case 100: return "Continue";
+    case 101: return "Switching Protocols";
+    case 200: return "OK";
+    case 201: return "Created";
+    case 202: return "Accepted";
+    case 204: return "No Content";
+    case 206: return "Partial Content";
+    case 301: return "Moved Permanently";
+    case 302: return "Found";
+    case 304: return "Not Modified";
+    case 307: return "Temporary Redirect";
+    case 308: return "Permanent Redirect";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 408: return "Request Timeout";
+    case 411: return "Length Required";
+    case 413: return "Content Too Large";
+    case 414: return "URI Too Long";
+    case 415: return "Unsupported Media Type";
+    case 429: return "Too Many Requests";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 502: return "Bad Gateway";
+    case 503: return "Service Unavailable";
+    case 504: return "Gateway Timeout";
+    case 505: return "HTTP Version Not Supported";
+    default: return "Unknown";
+    }
+}
+
+static inline char LowerAscii(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+bool HttpEqualsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (LowerAscii(a[i]) != LowerAscii(b[i])) return false;
+    }
+    return true;
+}
+
+bool HttpHasToken(std::string_view list, std::string_view token) {
+    size_t i = 0;
+    while (i < list.size()) {
+        size_t comma = list.find(',', i);
+        if (comma == std::string_view::npos) comma = list.size();
+        size_t b = i, e = comma;
+        while (b < e && (list[b] == ' ' || list[b] == '\t')) ++b;
+        while (e > b && (list[e - 1] == ' ' || list[e - 1] == '\t')) --e;
+        if (HttpEqualsIgnoreCase(list.substr(b, e - b), token)) return true;
+        i = comma + 1;
+    }
+    return false;
+}
+
+// ---------- HttpMessage ----------
+
+std::string_view HttpMessage::getHeader(std::string_view name) const {
+    for (auto &h : m_headers) {
+        if (HttpEqualsIgnoreCase(h.name, name)) return h.value;
+    }
+    return {};
+}
+
+bool HttpMessage::hasHeader(std::string_view name) const {
+    for (auto &h : m_headers) {
+        if (HttpEqualsIgnoreCase(h.name, name)) return true;
+    }
+    return false;
+}
+
+void HttpMessage::reset() {
+    m_version = 0x11;
+    m_keepAlive = true;
+    m_chunked = false;
+    m_contentLength = -1;
+    m_headers.clear();
+    m_body.clear();
+}
+
+void HttpRequest::reset() {
+    HttpMessage::reset();
+    m_method = HttpMethod::INVALID;
+    m_methodString = {};
+    m_target = {};
+    m_path = {};
+    m_query = {};
+    m_fragment = {};
+}
+
+void HttpResponseView::reset() {
+    HttpMessage::reset();
+    m_status = 0;
+    m_reason = {};
+}
+
+// ---------- HttpResponse ----------
+
+void HttpResponse::addHeader(std::string_view name, std::string_view value) {
+    if (m_headerCount == m_headers.size()) m_headers.emplace_back();
+    auto &h = m_headers[m_headerCount++];
+    h.first.assign(name);
+    h.second.assign(value);
+}
+
+void HttpResponse::setHeader(std::string_view name, std::string_view value) {
+    for (size_t i = 0; i < m_headerCount; ++i) {
+        if (HttpEqualsIgnoreCase(m_headers[i].first, name)) {
+            m_headers[i].second.assign(value);
+            return;
+        }
+    }
+    addHeader(name, value);
+}
+
+std::string_view HttpResponse::getHeader(std::string_view name) const {
+    for (size_t i = 0; i < m_headerCount; ++i) {
+        if (HttpEqualsIgnoreCase(m_headers[i].first, name)) return m_headers[i].second;
+    }
+    return {};
+}
+
+void HttpResponse::reset() {
+    m_status = 200;
+    m_keepAlive = true;
+    m_reason.clear();
+    m_headerCount = 0;
+    m_body.clear();
+}
+
+// Date 头每秒只格式化一次（每个线程一份）
+struct HttpDateCache {
+    time_t sec = -1;
+    char buf[32];
+    size_t len = 0;
+};
+static thread_local HttpDateCache t_http_date;
+
+static std::string_view HttpDate() {
+    time_t now = time(nullptr);
+    if (now != t_http_date.sec) {
+        std::tm tm;
+        gmtime_r(&now, &tm);
+        t_http_date.len = strftime(t_http_date.buf, sizeof(t_http_date.buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+        t_http_date.sec = now;
+    }
+    return {t_http_date.buf, t_http_date.len};
+}
+
+// 头部先拼在栈上的缓冲区里，满了再写入 ByteArray，避免每个字段一次 write
+namespace {
+struct HeadWriter {
+    explicit HeadWriter(ByteArray &o) :
+        out(o) {
+    }
+    ~HeadWriter() {
+        flush();
+    }
+    void put(std::string_view s) {
+        if (len + s.size() > sizeof(buf)) {
+            flush();
+            if (s.size() > sizeof(buf)) {
+                out.write(s.data(), s.size());
+                return;
+            }
+        }
+        memcpy(buf + len, s.data(), s.size());
+        len += s.size();
+    }
+    void put(uint64_t v) {
+        char tmp[24];
+        auto r = std::to_chars(tmp, tmp + sizeof(tmp), v);
+        put(std::string_view(tmp, r.ptr - tmp));
+    }
+    void flush() {
+        if (len) out.write(buf, len);
+        len = 0;
+    }
+
+    ByteArray &out;
+    char buf[1024];
+    size_t len = 0;
+};
+} // namespace
+
+void HttpResponse::dump(ByteArray &out, uint8_t version, bool with_body) const {
+    HeadWriter w(out);
+    w.put("HTTP/1.1 ");
+    w.put(static_cast<uint64_t>(m_status));
+    w.put(" ");
+    w.put(m_reason.empty() ? std::string_view(HttpStatusReason(m_status)) : std::string_view(m_reason));
+    w.put("\r\n");
+    for (size_t i = 0; i < m_headerCount; ++i) {
+        w.put(m_headers[i].first);
+        w.put(": ");
+        w.put(m_headers[i].second);
+        w.put("\r\n");
+    }
+    w.put("Date: ");
+    w.put(HttpDate());
+    w.put("\r\nContent-Length: ");
+    w.put(static_cast<uint64_t>(m_body.size()));
+    w.put("\r\n");
+    if (!m_keepAlive) {
+        w.put("Connection: close\r\n");
+    } else if (version == 0x10) {
+        w.put("Connection: keep-alive\r\n");
+    }
+    w.put("\r\n");
+    if (with_body && !m_body.empty()) {
+        // 小包体跟头部一起写，大包体单独写一次
+        w.put(m_body);
+    }
+}
+
+} // namespace sunshine
@@ -0,0 +1,576 @@
+// file: libs/http_parser.cpp
+#include "libs/http_parser.h"
+#include "libs/Config.h"
+
+#include <algorithm>
+
+namespace sunshine {
+
+static ConfigVar<uint32_t>::ptr g_max_header_size =
+    Config::Lookup<uint32_t>("http.max_header_size", 16 * 1024, "max bytes of an HTTP start line plus headers");
+static ConfigVar<uint64_t>::ptr g_max_body_size =
+    Config::Lookup<uint64_t>("http.max_body_size", 8 * 1024 * 1024, "max bytes of an HTTP message body");
+
+// RFC 9110 tchar："!#$%&'*+-.^_`|~"、数字、字母
+struct TcharTable {
+    bool v[256] = {};
+    constexpr TcharTable() {
+        for (int c = '0'; c <= '9'; ++c) v[c] = true;
+        for (int c = 'a'; c <= 'z'; ++c) v[c] = true;
+        for (int c = 'A'; c <= 'Z'; ++c) v[c] = true;
+        for (char c : std::string_view("!#$%&'*+-.^_`|~")) v[static_cast<unsigned char>(c)] = true;
+    }
+};
+static constexpr TcharTable s_tchar;
+
+static inline bool IsTchar(char c) {
+    return s_tchar.v[static_cast<unsigned char>(c)];
+}
+
+static inline int HexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// "HTTP/1.x"：返回 0x10 / 0x11（1.x 的更高小版本按 1.1 处理），主版本不是 1 时返回 0
+static uint8_t ParseVersion(std::string_view v) {
+    if (v.size() != 8 || v.substr(0, 5) != "HTTP/" || v[6] != '.' || v[5] < '0' || v[5] > '9' || v[7] < '0' ||
+        v[7] > '9') {
+        return 0xff;
+    }
+    if (v[5] != '1') return 0;
+    return v[7] == '0' ? 0x10 : 0x11;
+}
+
+HttpParser::HttpParser(Type type) :
+    m_type(type), m_maxHeader(g_max_header_size->getValue()), m_maxBody(g_max_body_size->getValue()) {
+    m_spill.reserve(m_maxHeader);
+    m_request.m_headers.reserve(32);
+    m_response.m_headers.reserve(32);
+}
+
+void HttpParser::reset() {
+    m_state = S_START;
+    m_error = 0;
+    m_headResponse = false;
+    m_headerBytes = 0;
+    m_remaining = 0;
+    m_bodyBytes = 0;
+    m_tokOpen = false;
+    m_tokSpilled = false;
+    m_tokBegin = nullptr;
+    m_spill.clear();
+    m_field = {};
+    m_version = {};
+    m_digits = 0;
+    m_request.reset();
+    m_response.reset();
+}
+
+bool HttpParser::spillToken(const char *end) {
+    size_t n = end - m_tokBegin;
+    if (!m_tokSpilled) {
+        m_spillBegin = m_spill.size();
+        m_tokSpilled = true;
+    }
+    // 拼接区不能扩容（之前交出去的视图会失效）
+    if (m_spill.size() + n > m_spill.capacity()) return false;
+    m_spill.append(m_tokBegin, n);
+    return true;
+}
+
+std::string_view HttpParser::closeToken(const char *p) {
+    m_tokOpen = false;
+    if (!m_tokSpilled) return std::string_view(m_tokBegin, p - m_tokBegin);
+    bool ok = spillToken(p);
+    m_tokSpilled = false;
+    if (!ok) {
+        fail(431);
+        return {};
+    }
+    return std::string_view(m_spill.data() + m_spillBegin, m_spill.size() - m_spillBegin);
+}
+
+HttpParser::Result HttpParser::execute(ByteArray &ba) {
+    for (;;) {
+        switch (m_state) {
+        case S_DONE:
+            return DONE;
+        case S_ERROR:
+            return ERROR;
+        case S_BODY:
+        case S_CHUNK_DATA: {
+            size_t avail = ba.getReadSize();
+            if (!avail) return NEED_MORE;
+            size_t n = static_cast<size_t>(std::min<uint64_t>(avail, m_remaining));
+            appendBody(ba.readSlice(n));
+            m_remaining -= n;
+            m_bodyBytes += n;
+            if (!m_remaining) {
+                if (m_state == S_BODY) {
+                    onMessageComplete();
+                } else {
+                    m_state = S_CHUNK_DATA_CR;
+                }
+            }
+            break;
+        }
+        case S_BODY_EOF: {
+            size_t avail = ba.getReadSize();
+            if (!avail) return NEED_MORE;
+            if (m_bodyBytes + avail > m_maxBody) {
+                fail(413);
+                break;
+            }
+            appendBody(ba.readSlice(avail));
+            m_bodyBytes += avail;
+            break;
+        }
+        default: {
+            size_t avail = ba.getReadSize();
+            if (!avail) return NEED_MORE;
+            size_t pos = ba.getPosition();
+            m_iov.clear();
+            ba.getReadBuffers(m_iov, avail, pos);
+            size_t used = 0;
+            for (auto &v : m_iov) {
+                const char *b = static_cast<const char *>(v.iov_base);
+                size_t k = run(b, b + v.iov_len);
+                used += k;
+                // 状态机转入包体数据 / 完成 / 出错时停下，剩下的交给上面的分支
+                if (k < v.iov_len || m_state == S_BODY || m_state == S_BODY_EOF || m_state == S_CHUNK_DATA ||
+                    m_state == S_DONE || m_state == S_ERROR) {
+                    break;
+                }
+            }
+            ba.setPosition(pos + used);
+            break;
+        }
+        }
+    }
+}
+
+// 包体只有一段（Content-Length 且一次读完）时直接接管切片，不再复制段表
+void HttpParser::appendBody(ByteSlice &&slice) {
+    ByteSlice &body = message().m_body;
+    if (body.empty()) {
+        body = std::move(slice);
+    } else {
+        body.append(slice);
+    }
+}
+
+bool HttpParser::finishOnEof() {
+    if (m_state != S_BODY_EOF) return false;
+    onMessageComplete();
+    return true;
+}
+
+// 各状态的循环都在本段内尽量多走几个字节；走到段尾时当前 token 的已读部分拼接到 m_spill
+size_t HttpParser::run(const char *begin, const char *end) {
+    const char *p = begin;
+    if (m_tokOpen) m_tokBegin = begin;
+    m_mark = begin;
+
+#define HTTP_FAIL(code)      \
+    do {                     \
+        fail(code);          \
+        return p - begin;    \
+    } while (0)
+#define HTTP_CHECK()                          \
+    do {                                      \
+        if (m_state == S_ERROR) return p - begin; \
+    } while (0)
+
+    while (p < end) {
+        switch (m_state) {
+        case S_START:
+            // 报文之间多余的空行直接跳过
+            if (*p == '\r' || *p == '\n') {
+                ++p;
+                break;
+            }
+            m_state = m_type == REQUEST ? S_METHOD : S_RSP_VERSION;
+            break;
+
+        case S_METHOD:
+            if (!m_tokOpen) openToken(p);
+            while (p < end && IsTchar(*p)) ++p;
+            if (p == end) break;
+            if (*p != ' ' || (p == m_tokBegin && !m_tokSpilled)) HTTP_FAIL(400);
+            m_request.m_methodString = closeToken(p);
+            HTTP_CHECK();
+            ++p;
+            m_state = S_TARGET;
+            break;
+
+        case S_TARGET:
+            if (!m_tokOpen) {
+                if (*p == ' ') HTTP_FAIL(400);
+                openToken(p);
+            }
+            while (p < end && static_cast<unsigned char>(*p) > 0x20 && *p != 0x7f) ++p;
+            if (p == end) break;
+            if (*p != ' ') HTTP_FAIL(400);
+            m_request.m_target = closeToken(p);
+            HTTP_CHECK();
+            ++p;
+            m_state = S_REQ_VERSION;
+            break;
+
+        case S_REQ_VERSION:
+            if (!m_tokOpen) openToken(p);
+            while (p < end && *p != '\r' && *p != '\n') ++p;
+            if (p == end) break;
+            m_version = closeToken(p);
+            HTTP_CHECK();
+            if (*p++ == '\r') {
+                m_state = S_LINE_LF;
+            } else {
+                if (!onStartLine()) return p - begin;
+                m_state = S_HEADER_START;
+            }
+            break;
+
+        case S_RSP_VERSION:
+            if (!m_tokOpen) openToken(p);
+            while (p < end && *p != ' ') {
+                if (*p == '\r' || *p == '\n') HTTP_FAIL(400);
+                ++p;
+            }
+            if (p == end) break;
+            m_version = closeToken(p);
+            HTTP_CHECK();
+            ++p;
+            m_state = S_RSP_STATUS;
+            m_digits = 0;
+            break;
+
+        case S_RSP_STATUS:
+            if (*p >= '0' && *p <= '9' && m_digits < 3) {
+                m_response.m_status = static_cast<uint16_t>(m_response.m_status * 10 + (*p - '0'));
+                ++m_digits;
+                ++p;
+                break;
+            }
+            if (m_digits != 3) HTTP_FAIL(400);
+            if (*p == ' ') {
+                ++p;
+                m_state = S_RSP_REASON;
+            } else if (*p == '\r' || *p == '\n') {
+                m_state = S_RSP_REASON;
+            } else {
+                HTTP_FAIL(400);
+            }
+            break;
+
+        case S_RSP_REASON:
+            if (!m_tokOpen) openToken(p);
+            while (p < end && *p != '\r' && *p != '\n') ++p;
+            if (p == end) break;
+            m_response.m_reason = closeToken(p);
+            HTTP_CHECK();
+            if (*p++ == '\r') {
+                m_state = S_LINE_LF;
+            } else {
+                if (!onStartLine()) return p - begin;
+                m_state = S_HEADER_START;
+            }
+            break;
+
+        case S_LINE_LF:
+            if (*p++ != '\n') HTTP_FAIL(400);
+            if (!onStartLine()) return p - begin;
+            m_state = S_HEADER_START;
+            break;
+
+        case S_HEADER_START:
+            if (*p == '\r') {
+                ++p;
+                m_state = S_HEADERS_LF;
+            } else if (*p == '\n') {
+                ++p;
+                onHeadersComplete(p);
+                return p - begin;
+            } else if (*p == ' ' || *p == '\t') {
+                // obs-fold（续行）已被废弃，按 RFC 9112 直接拒绝
+                HTTP_FAIL(400);
+            } else {
+                m_state = S_HEADER_NAME;
+            }
+            break;
+
+        case S_HEADER_NAME:
+            if (!m_tokOpen) openToken(p);
+            while (p < end && IsTchar(*p)) ++p;
+            if (p == end) break;
+            if (*p != ':' || (p == m_tokBegin && !m_tokSpilled)) HTTP_FAIL(400);
+            m_field = closeToken(p);
+            HTTP_CHECK();
+            ++p;
+            m_state = S_HEADER_OWS;
+            break;
+
+        case S_HEADER_OWS:
+            while (p < end && (*p == ' ' || *p == '\t')) ++p;
+            if (p == end) break;
+            m_state = S_HEADER_VALUE;
+            break;
+
+        case S_HEADER_VALUE: {
+            if (!m_tokOpen) openToken(p);
+            while (p < end) {
+                unsigned char c = static_cast<unsigned char>(*p);
+                if (c == '\r' || c == '\n') break;
+                if ((c < 0x20 && c != '\t') || c == 0x7f) HTTP_FAIL(400);
+                ++p;
+            }
+            if (p == end) break;
+            std::string_view value = closeToken(p);
+            HTTP_CHECK();
+            while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.remove_suffix(1);
+            if (!onHeader(value)) return p - begin;
+            m_state = *p++ == '\r' ? S_HEADER_LF : S_HEADER_START;
+            break;
+        }
+
+        case S_HEADER_LF:
+            if (*p++ != '\n') HTTP_FAIL(400);
+            m_state = S_HEADER_START;
+            break;
+
+        case S_HEADERS_LF:
+            if (*p++ != '\n') HTTP_FAIL(400);
+            onHeadersComplete(p);
+            return p - begin;
+
+        case S_CHUNK_SIZE: {
+            int h = HexValue(*p);
+            if (h >= 0) {
+                // 16 位十六进制已经远超 max_body_size
+                if (++m_digits > 15) HTTP_FAIL(413);
+                m_remaining = (m_remaining << 4) | static_cast<uint64_t>(h);
+                ++p;
+                break;
+            }
+            if (m_digits == 0) HTTP_FAIL(400);
+            if (*p == ';' || *p == ' ' || *p == '\t') {
+                m_state = S_CHUNK_EXT;
+            } else if (*p == '\r') {
+                ++p;
+                m_state = S_CHUNK_SIZE_LF;
+            } else if (*p == '\n') {
+                m_state = S_CHUNK_SIZE_LF;
+            } else {
+                HTTP_FAIL(400);
+            }
+            break;
+        }
+
+        case S_CHUNK_EXT:
+            while (p < end && *p != '\r' && *p != '\n') ++p;
+            if (p == end) break;
+            if (*p == '\r') ++p;
+            m_state = S_CHUNK_SIZE_LF;
+            break;
+
+        case S_CHUNK_SIZE_LF:
+            if (*p++ != '\n') HTTP_FAIL(400);
+            m_digits = 0;
+            if (m_remaining == 0) {
+                m_state = S_TRAILER_START;
+                break;
+            }
+            if (m_bodyBytes + m_remaining > m_maxBody) HTTP_FAIL(413);
+            m_state = S_CHUNK_DATA;
+            return p - begin;
+
+        case S_CHUNK_DATA_CR:
+            if (*p == '\r') {
+                ++p;
+                m_state = S_CHUNK_DATA_LF;
+            } else if (*p == '\n') {
+                m_state = S_CHUNK_DATA_LF;
+            } else {
+                HTTP_FAIL(400);
+            }
+            break;
+
+        case S_CHUNK_DATA_LF:
+            if (*p++ != '\n') HTTP_FAIL(400);
+            m_state = S_CHUNK_SIZE;
+            break;
+
+        case S_TRAILER_START:
+            if (*p == '\r') {
+                ++p;
+                m_state = S_TRAILER_LF;
+            } else if (*p == '\n') {
+                ++p;
+                onMessageComplete();
+                return p - begin;
+            } else {
+                m_state = S_TRAILER_LINE;
+            }
+            break;
+
+        case S_TRAILER_LINE:
+            while (p < end && *p != '\r' && *p != '\n') ++p;
+            if (p == end) break;
+            m_state = *p++ == '\r' ? S_TRAILER_LINE_LF : S_TRAILER_START;
+            break;
+
+        case S_TRAILER_LINE_LF:
+            if (*p++ != '\n') HTTP_FAIL(400);
+            m_state = S_TRAILER_START;
+            break;
+
+        case S_TRAILER_LF:
+            if (*p++ != '\n') HTTP_FAIL(400);
+            onMessageComplete();
+            return p - begin;
+
+        default:
+            return p - begin;
+        }
+    }
+
+    // 段尾：头部阶段累计字节数，未结束的 token 先拼接起来
+    if (m_state < S_BODY) {
+        m_headerBytes += end - m_mark;
+        if (m_headerBytes > m_maxHeader) HTTP_FAIL(431);
+    }
+    if (m_tokOpen && !spillToken(end)) HTTP_FAIL(431);
+    return p - begin;
+
+#undef HTTP_CHECK
+#undef HTTP_FAIL
+}
+
+bool HttpParser::onStartLine() {
+    HttpMessage &msg = message();
+    uint8_t version = ParseVersion(m_version);
+    if (version == 0xff) {
+        fail(400);
+        return false;
+    }
+    if (version == 0) {
+        fail(505);
+        return false;
+    }
+    msg.m_version = version;
+    msg.m_keepAlive = version == 0x11;
+
+    if (m_type == REQUEST) {
+        m_request.m_method = StringToHttpMethod(m_request.m_methodString);
+        if (m_request.m_method == HttpMethod::INVALID) {
+            fail(501);
+            return false;
+        }
+        // absolute-form（http://host/path?x）先跳过 scheme 与 authority
+        std::string_view t = m_request.m_target;
+        size_t scheme = t.find("://");
+        if (!t.empty() && t.front() != '/' && scheme != std::string_view::npos) {
+            size_t slash = t.find('/', scheme + 3);
+            t = slash == std::string_view::npos ? std::string_view("/") : t.substr(slash);
+        }
+        size_t hash = t.find('#');
+        if (hash != std::string_view::npos) {
+            m_request.m_fragment = t.substr(hash + 1);
+            t = t.substr(0, hash);
+        }
+        size_t q = t.find('?');
+        if (q != std::string_view::npos) {
+            m_request.m_query = t.substr(q + 1);
+            t = t.substr(0, q);
+        }
+        m_request.m_path = t;
+    }
+    return true;
+}
+
+bool HttpParser::onHeader(std::string_view value) {
+    HttpMessage &msg = message();
+    msg.m_headers.push_back(HttpHeader{m_field, value});
+
+    if (HttpEqualsIgnoreCase(m_field, "Content-Length")) {
+        if (value.empty() || value.size() > 18) {
+            fail(value.size() > 18 ? 413 : 400);
+            return false;
+        }
+        int64_t len = 0;
+        for (char c : value) {
+            if (c < '0' || c > '9') {
+                fail(400);
+                return false;
+            }
+            len = len * 10 + (c - '0');
+        }
+        if (msg.m_contentLength >= 0 && msg.m_contentLength != len) {
+            fail(400);
+            return false;
+        }
+        msg.m_contentLength = len;
+    } else if (HttpEqualsIgnoreCase(m_field, "Transfer-Encoding")) {
+        if (!HttpEqualsIgnoreCase(value, "chunked")) {
+            fail(501);
+            return false;
+        }
+        msg.m_chunked = true;
+    } else if (HttpEqualsIgnoreCase(m_field, "Connection")) {
+        if (HttpHasToken(value, "close")) {
+            msg.m_keepAlive = false;
+        } else if (HttpHasToken(value, "keep-alive")) {
+            msg.m_keepAlive = true;
+        }
+    }
+    return true;
+}
+
+void HttpParser::onHeadersComplete(const char *p) {
+    m_headerBytes += p - m_mark;
+    if (m_headerBytes > m_maxHeader) {
+        fail(431);
+        return;
+    }
+    HttpMessage &msg = message();
+    // 两个长度来源同时出现是请求走私的典型手法（RFC 9112 6.3）
+    if (msg.m_chunked && msg.m_contentLength >= 0) {
+        fail(400);
+        return;
+    }
+
+    if (m_type == RESPONSE) {
+        uint16_t s = m_response.m_status;
+        if (m_headResponse || (s >= 100 && s < 200) || s == 204 || s == 304) {
+            onMessageComplete();
+            return;
+        }
+    }
+    if (msg.m_chunked) {
+        m_remaining = 0;
+        m_digits = 0;
+        m_state = S_CHUNK_SIZE;
+    } else if (msg.m_contentLength > 0) {
+        if (static_cast<uint64_t>(msg.m_contentLength) > m_maxBody) {
+            fail(413);
+            return;
+        }
+        m_remaining = static_cast<uint64_t>(msg.m_contentLength);
+        m_state = S_BODY;
+    } else if (m_type == RESPONSE && msg.m_contentLength < 0) {
+        // 没有长度的响应：包体一直到连接关闭，连接不能复用
+        msg.m_keepAlive = false;
+        m_state = S_BODY_EOF;
+    } else {
+        onMessageComplete();
+    }
+}
+
+void HttpParser::onMessageComplete() {
+    m_state = S_DONE;
+}
+
+} // namespace sunshine
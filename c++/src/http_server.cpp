@@ -0,0 +1,161 @@
+// file: libs/http_server.cpp
+#include "libs/http_server.h"
+#include "libs/log.h"
+
+#include <fnmatch.h>
+
+namespace sunshine {
+
+static Logger::ptr g_logger = std::make_shared<Logger>("system");
+
+// 每次 recv 最多读多少：pipelining 时一次能取到更多请求
+static const size_t HTTP_RECV_CHUNK = 16 * 1024;
+
+// ---------- Servlet ----------
+
+void NotFoundServlet::handle(const HttpRequest &, HttpResponse &rsp, const Socket::ptr &) {
+    rsp.setStatus(404);
+    rsp.setHeader("Content-Type", "text/html");
+    rsp.setBody("<html><head><title>404 Not Found</title></head><body><center><h1>404 Not Found</h1></center>"
+                "</body></html>");
+}
+
+ServletDispatch::ServletDispatch() :
+    Servlet("ServletDispatch"), m_default(std::make_shared<NotFoundServlet>()) {
+}
+
+void ServletDispatch::handle(const HttpRequest &req, HttpResponse &rsp, const Socket::ptr &conn) {
+    // 精确匹配直接用表里的引用，不复制 shared_ptr
+    auto it = m_datas.find(req.getPath());
+    if (it != m_datas.end()) {
+        it->second->handle(req, rsp, conn);
+        return;
+    }
+    Servlet::ptr slt = getMatchedServlet(req.getPath());
+    if (slt) slt->handle(req, rsp, conn);
+}
+
+void ServletDispatch::addServlet(const std::string &uri, Servlet::ptr servlet) {
+    m_datas[uri] = std::move(servlet);
+}
+
+void ServletDispatch::addServlet(const std::string &uri, FunctionServlet::Callback cb) {
+    addServlet(uri, std::make_shared<FunctionServlet>(std::move(cb)));
+}
+
+void ServletDispatch::addGlobServlet(const std::string &uri, Servlet::ptr servlet) {
+    delGlobServlet(uri);
+    m_globs.emplace_back(uri, std::move(servlet));
+}
+
+void ServletDispatch::addGlobServlet(const std::string &uri, FunctionServlet::Callback cb) {
+    addGlobServlet(uri, std::make_shared<FunctionServlet>(std::move(cb)));
+}
+
+void ServletDispatch::delServlet(const std::string &uri) {
+    m_datas.erase(uri);
+}
+
+void ServletDispatch::delGlobServlet(const std::string &uri) {
+    for (auto it = m_globs.begin(); it != m_globs.end(); ++it) {
+        if (it->first == uri) {
+            m_globs.erase(it);
+            return;
+        }
+    }
+}
+
+Servlet::ptr ServletDispatch::getMatchedServlet(std::string_view path) const {
+    auto it = m_datas.find(path);
+    if (it != m_datas.end()) return it->second;
+    if (!m_globs.empty()) {
+        std::string p(path); // fnmatch 需要以 '\0' 结尾
+        for (auto &g : m_globs) {
+            if (!fnmatch(g.first.c_str(), p.c_str(), 0)) return g.second;
+        }
+    }
+    return m_default;
+}
+
+// ---------- HttpServer ----------
+
+HttpServer::HttpServer(bool keepalive, IOManager *worker, IOManager *acceptor) :
+    TcpServer(worker, acceptor), m_isKeepalive(keepalive), m_dispatch(std::make_shared<ServletDispatch>()) {
+}
+
+// 接收缓冲区 in 的布局：[0, parsed) 已被解析器消费，[parsed, end) 是还没解析的数据，
+// msgStart 是当前（未完成）报文的起点。整理规则：
+// - 解析器空闲时 parsed == end，直接 clear，块还给 BufferPool
+// - 报文跨越多次读取且前面还积着至少一个块的已处理数据时，把未完成报文搬到缓冲区开头，
+//   解析器 reset 后从头重新解析这一条（视图都指向旧块，不能直接沿用），每条报文最多搬一次
+void HttpServer::handleClient(Socket::ptr client) {
+    ByteArray in, out;
+    HttpParser parser(HttpParser::REQUEST);
+    HttpResponse rsp;
+    std::string carry; // 整理时暂存未完成报文
+    size_t end = 0, parsed = 0, msgStart = 0;
+
+    for (;;) {
+        in.setPosition(end);
+        int n = client->recv(in, HTTP_RECV_CHUNK);
+        if (n <= 0) break; // 对端关闭、出错或读超时
+        end += n;
+        in.setPosition(parsed);
+
+        bool close = false;
+        for (;;) {
+            HttpParser::Result r = parser.execute(in);
+            if (r == HttpParser::NEED_MORE) break;
+            rsp.reset();
+            if (r == HttpParser::ERROR) {
+                LOG_DEBUG(g_logger) << "HttpServer bad request from " << client->getRemoteAddress()->toString()
+                                    << " status=" << parser.getError();
+                rsp.setStatus(parser.getError());
+                rsp.setKeepAlive(false);
+                rsp.dump(out);
+                close = true;
+                break;
+            }
+            const HttpRequest &req = parser.getRequest();
+            rsp.setKeepAlive(m_isKeepalive && req.isKeepAlive());
+            rsp.addHeader("Server", getName());
+            m_dispatch->handle(req, rsp, client);
+            rsp.dump(out, req.getVersion(), req.getMethod() != HttpMethod::HEAD);
+            close = !rsp.isKeepAlive();
+            parser.reset();
+            msgStart = in.getPosition();
+            if (close) break;
+        }
+        parsed = in.getPosition();
+
+        // 本次读到的所有请求的响应一起发出
+        if (out.getPosition() > 0) {
+            out.setPosition(0);
+            while (out.getReadSize() > 0) {
+                if (client->send(out) <= 0) return;
+            }
+            out.clear();
+        }
+        if (close) break;
+
+        if (parser.isIdle()) {
+            in.clear();
+            end = parsed = msgStart = 0;
+        } else if (msgStart >= in.getBaseSize()) {
+            carry.resize(end - msgStart);
+            in.read(&carry[0], carry.size(), msgStart);
+            in.clear();
+            in.write(carry.data(), carry.size());
+            parser.reset();
+            end = carry.size();
+            parsed = msgStart = 0;
+            // 重新解析搬过来的数据（一定还是 NEED_MORE，但状态要追上来）
+            in.setPosition(0);
+            parser.execute(in);
+            parsed = in.getPosition();
+        }
+    }
+    client->close();
+}
+
+} // namespace sunshine
@@ -0,0 +1,215 @@
+// file: libs/io_uring.cpp
+#include "libs/io_uring.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace sunshine {
+
+static int sys_io_uring_setup(unsigned entries, io_uring_params *p) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));
+}
+
+static int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags, const void *arg,
+                              size_t argsz) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, argsz));
+}
+
+static int sys_io_uring_register(int fd, unsigned opcode, const void *arg, unsigned nr_args) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+// 依次尝试的 setup 标志：老内核不认识的标志会返回 EINVAL
+static const uint32_t s_setup_flags[] = {
+    IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN | IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN,
+    IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN,
+    0,
+};
+
+IoUring::ptr IoUring::Create(unsigned entries) {
+    for (uint32_t flags : s_setup_flags) {
+        ptr ring(new IoUring);
+        if (ring->init(entries, flags)) return ring;
+        if (errno != EINVAL) return nullptr;
+    }
+    return nullptr;
+}
+
+// 建立 ring：io_uring_setup 之后映射 SQ / CQ 环和 SQE 数组
+// SQ 的间接数组固定为恒等映射（第 i 个槽位就是第 i 个 SQE），之后只需要推进 tail
+bool IoUring::init(unsigned entries, uint32_t flags) {
+    io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    p.flags = flags;
+    m_fd = sys_io_uring_setup(entries, &p);
+    if (m_fd < 0) return false;
+    m_features = p.features;
+
+    m_sqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    m_cqRingSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+    if (single) m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+
+    m_sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+    if (m_sqRing == MAP_FAILED) {
+        m_sqRing = nullptr;
+        return false;
+    }
+    if (single) {
+        m_cqRing = m_sqRing;
+    } else {
+        m_cqRing =
+            mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+        if (m_cqRing == MAP_FAILED) {
+            m_cqRing = nullptr;
+            return false;
+        }
+    }
+    m_sqesSize = p.sq_entries * sizeof(io_uring_sqe);
+    void *sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) return false;
+    m_sqes = static_cast<io_uring_sqe *>(sqes);
+
+    char *sq = static_cast<char *>(m_sqRing);
+    m_sqHead = reinterpret_cast<unsigned *>(sq + p.sq_off.head);
+    m_sqTailPtr = reinterpret_cast<unsigned *>(sq + p.sq_off.tail);
+    m_sqMask = *reinterpret_cast<unsigned *>(sq + p.sq_off.ring_mask);
+    m_sqEntries = *reinterpret_cast<unsigned *>(sq + p.sq_off.ring_entries);
+    unsigned *array = reinterpret_cast<unsigned *>(sq + p.sq_off.array);
+    for (unsigned i = 0; i < m_sqEntries; ++i) array[i] = i;
+    m_sqTail = m_sqSubmitted = *m_sqTailPtr;
+
+    char *cq = static_cast<char *>(m_cqRing);
+    m_cqHead = reinterpret_cast<unsigned *>(cq + p.cq_off.head);
+    m_cqTail = reinterpret_cast<unsigned *>(cq + p.cq_off.tail);
+    m_cqMask = *reinterpret_cast<unsigned *>(cq + p.cq_off.ring_mask);
+    m_cqes = reinterpret_cast<io_uring_cqe *>(cq + p.cq_off.cqes);
+    return true;
+}
+
+// 关闭 ring fd 时内核会取消所有在途请求
+IoUring::~IoUring() {
+    if (m_bufRing) munmap(m_bufRing, m_bufRingSize);
+    if (m_bufBase) munmap(m_bufBase, static_cast<size_t>(m_bufCount) * m_bufSize);
+    if (m_sqes) munmap(m_sqes, m_sqesSize);
+    if (m_cqRing && m_cqRing != m_sqRing) munmap(m_cqRing, m_cqRingSize);
+    if (m_sqRing) munmap(m_sqRing, m_sqRingSize);
+    if (m_fd >= 0) close(m_fd);
+}
+
+unsigned IoUring::sqSpace() const {
+    unsigned head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+    return m_sqEntries - (m_sqTail - head);
+}
+
+io_uring_sqe *IoUring::getSqe() {
+    if (sqSpace() == 0) return nullptr;
+    io_uring_sqe *sqe = &m_sqes[m_sqTail & m_sqMask];
+    ++m_sqTail;
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+int IoUring::submit() {
+    unsigned n = pending();
+    if (n == 0) return 0;
+    __atomic_store_n(m_sqTailPtr, m_sqTail, __ATOMIC_RELEASE);
+    int ret = sys_io_uring_enter(m_fd, n, 0, 0, nullptr, 0);
+    if (ret < 0) return -errno;
+    m_sqSubmitted += static_cast<unsigned>(ret);
+    return ret;
+}
+
+int IoUring::submitAndWait(unsigned wait_nr, int timeout_ms) {
+    unsigned n = pending();
+    __atomic_store_n(m_sqTailPtr, m_sqTail, __ATOMIC_RELEASE);
+
+    // DEFER_TASKRUN 下完成事件只在 GETEVENTS 时处理，wait_nr 为 0 也要带上
+    unsigned flags = IORING_ENTER_GETEVENTS;
+    io_uring_getevents_arg arg;
+    __kernel_timespec ts;
+    const void *argp = nullptr;
+    size_t argsz = 0;
+    if (wait_nr > 0 && timeout_ms >= 0) {
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = (timeout_ms % 1000) * 1000000ll;
+        memset(&arg, 0, sizeof(arg));
+        arg.sigmask_sz = _NSIG / 8;
+        arg.ts = reinterpret_cast<uint64_t>(&ts);
+        flags |= IORING_ENTER_EXT_ARG;
+        argp = &arg;
+        argsz = sizeof(arg);
+    }
+    int ret = sys_io_uring_enter(m_fd, n, wait_nr, flags, argp, argsz);
+    if (ret < 0) return -errno;
+    m_sqSubmitted += static_cast<unsigned>(ret);
+    return ret;
+}
+
+// provided buffer ring：环本身和缓冲区都用匿名映射（环要求页对齐）
+bool IoUring::setupBufRing(uint16_t bgid, unsigned count, unsigned size) {
+    if (m_bufRing || count == 0 || (count & (count - 1)) || count > 32768) {
+        errno = EINVAL;
+        return false;
+    }
+    m_bufRingSize = count * sizeof(io_uring_buf);
+    void *ring = mmap(nullptr, m_bufRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring == MAP_FAILED) return false;
+    void *base = mmap(nullptr, static_cast<size_t>(count) * size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        munmap(ring, m_bufRingSize);
+        return false;
+    }
+    // 注册前先写一遍：内核注册时固定这些页，未触碰的匿名页会被固定成共享零页
+    memset(ring, 0, m_bufRingSize);
+
+    io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(ring);
+    reg.ring_entries = count;
+    reg.bgid = bgid;
+    if (sys_io_uring_register(m_fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        int e = errno;
+        munmap(base, static_cast<size_t>(count) * size);
+        munmap(ring, m_bufRingSize);
+        errno = e;
+        return false;
+    }
+
+    m_bufRing = static_cast<io_uring_buf_ring *>(ring);
+    m_bufBase = static_cast<char *>(base);
+    m_bufCount = count;
+    m_bufSize = size;
+    m_bufGroup = bgid;
+    m_bufTail = 0;
+    for (unsigned i = 0; i < count; ++i) recycleBuf(static_cast<uint16_t>(i));
+    return true;
+}
+
+void IoUring::recycleBuf(uint16_t bid) {
+    // 不用 m_bufRing->bufs：内核头文件的 __DECLARE_FLEX_ARRAY 在 C++ 下含一个 1 字节的空结构体，bufs 会偏移 8 字节
+    io_uring_buf &buf = reinterpret_cast<io_uring_buf *>(m_bufRing)[m_bufTail & (m_bufCount - 1)];
+    buf.addr = reinterpret_cast<uint64_t>(bufAddr(bid));
+    buf.len = m_bufSize;
+    buf.bid = bid;
+    ++m_bufTail;
+    __atomic_store_n(&m_bufRing->tail, m_bufTail, __ATOMIC_RELEASE);
+}
+
+int IoUring::registerBuffers(const iovec *iovs, unsigned n) {
+    if (sys_io_uring_register(m_fd, IORING_REGISTER_BUFFERS, iovs, n) < 0) return -errno;
+    return 0;
+}
+
+int IoUring::unregisterBuffers() {
+    if (sys_io_uring_register(m_fd, IORING_UNREGISTER_BUFFERS, nullptr, 0) < 0) return -errno;
+    return 0;
+}
+
+} // namespace sunshine
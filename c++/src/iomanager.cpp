@@ -5,10 +5,50 @@
 #include <fcntl.h>
 #include <string.h>
 #include <iostream>
+#include <algorithm>
+#include <iterator>
+#include <poll.h>
+#include <shared_mutex>
+#include "libs/Config.h"
 #include "libs/log.h"
+#include "libs/hook.h"
 
 namespace sunshine {
 
+// 持久注册模式：fd 在整个生命周期内保持 EPOLLIN|EPOLLOUT|EPOLLET 注册，就绪状态锁存在 FdContext，
+// 连续读写的 fd 每次等待不再需要 epoll_ctl 注册 / 撤销两次系统调用
+static ConfigVar<bool>::ptr g_iomanager_persistent_et =
+    Config::Lookup<bool>("iomanager.persistent_et", false, "keep fds registered in epoll for their lifetime");
+
+// 多 reactor 模式：每个工作线程一个 epoll 实例，fd 固定在第一次等待它的线程的 reactor 上，
+// 就绪的协程只在该线程恢复；避免所有线程阻塞在同一个 epoll 上的惊群唤醒和连接在核间漂移
+static ConfigVar<bool>::ptr g_iomanager_multi_reactor =
+    Config::Lookup<bool>("iomanager.multi_reactor", false, "one epoll instance per worker thread");
+
+// io_uring 后端：hook 的 socket 读写 / accept / connect 直接提交 io_uring 请求（隐含多 reactor 模式）
+static ConfigVar<bool>::ptr g_iomanager_io_uring =
+    Config::Lookup<bool>("iomanager.io_uring", false, "submit hooked socket I/O through io_uring");
+
+// io_uring 后端：read / recv(flags = 0) 使用 multishot recv，数据先落在 ring 的 provided buffer 里
+// 开启后这样的 fd 只能通过 read / recv 读取（readv / recvmsg 等仍走 epoll 路径，会与已缓冲的数据乱序）
+static ConfigVar<bool>::ptr g_iomanager_multishot_recv = Config::Lookup<bool>(
+    "iomanager.io_uring_multishot_recv", false, "use multishot recv with provided buffers for read/recv");
+
+// epfd 上 multishot poll 的 user_data（请求的 user_data 都是 UringRequest 指针，0 表示不关心的 CQE）
+static const uint64_t URING_EPOLL_TAG = 1;
+
+// 存活的 IOManager（构造完成时登记，析构时移除），CancelAllEverywhere 遍历它
+// 用函数内静态变量，避免与其他全局对象的初始化顺序问题
+struct IOManagerRegistry {
+    std::shared_mutex mutex;
+    std::vector<IOManager *> list;
+};
+
+static IOManagerRegistry &Registry() {
+    static IOManagerRegistry s_registry;
+    return s_registry;
+}
+
 // 设置文件描述符为非阻塞模式
 // 返回值：0 成功，-1 失败（设置 errno）
 static int setNonBlock(int fd) {
@@ -19,21 +59,16 @@ static int setNonBlock(int fd) {
     return 0;
 }
 
-// 构造函数：初始化 epoll 和 eventfd
-// 1. 创建 epoll 实例（epoll_create1）
-// 2. 创建 eventfd（用于唤醒 epoll_wait）
-// 3. 将 eventfd 注册到 epoll 监听可读事件
-// 4. 预分配 fd 上下文容器（128 个元素）
-IOManager::IOManager(size_t threads, bool use_caller, const std::string &name) :
-    Scheduler(threads, use_caller, name) {
-    m_epfd = epoll_create1(EPOLL_CLOEXEC);
-    if (m_epfd == -1) {
+// 创建一个 reactor：epoll 实例 + 注册在上面的 eventfd（data.ptr 为 nullptr 表示 eventfd）
+static void openReactor(int &epfd, int &evfd) {
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd == -1) {
         perror("epoll_create1");
         throw std::runtime_error("epoll_create1 failed");
     }
-    m_eventfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
-    if (m_eventfd == -1) {
-        close(m_epfd);
+    evfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (evfd == -1) {
+        close(epfd);
         perror("eventfd");
         throw std::runtime_error("eventfd failed");
     }
@@ -42,44 +77,119 @@ IOManager::IOManager(size_t threads, bool use_caller, const std::string &name) :
     epoll_event ev{};
     ev.events = EPOLLIN;   // 监听可读事件
     ev.data.ptr = nullptr; // 特殊标记：nullptr 表示 eventfd
-    if (epoll_ctl(m_epfd, EPOLL_CTL_ADD, m_eventfd, &ev) == -1) {
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, evfd, &ev) == -1) {
         perror("epoll_ctl add eventfd");
-        close(m_epfd);
-        close(m_eventfd);
+        close(epfd);
+        close(evfd);
         throw std::runtime_error("epoll_ctl add eventfd failed");
     }
+}
+
+// 构造函数：初始化 reactor
+// 1. 单 reactor 模式（默认）：一个 epoll 实例，同一时刻只有一个线程（leader）阻塞在它上面（见 sharedIdle）
+// 2. 多 reactor 模式：每个工作线程一个 epoll 实例（use_caller 的调用线程共用 0 号）
+// 3. 每个 reactor 创建 eventfd（用于唤醒 epoll_wait）并注册到自己的 epoll
+// 4. io_uring 后端按多 reactor 模式划分，ring 在各工作线程启动时创建（见 run()）
+IOManager::IOManager(size_t threads, bool use_caller, const std::string &name) :
+    Scheduler(threads, use_caller, name) {
+    m_persistent = g_iomanager_persistent_et->getValue();
+    m_multiReactor = g_iomanager_multi_reactor->getValue();
+    m_uring = g_iomanager_io_uring->getValue();
+    m_multishotRecv = m_uring && g_iomanager_multishot_recv->getValue();
+    // 每个 ring 只能由一个线程提交，io_uring 后端按线程划分 reactor
+    if (m_uring) m_multiReactor = true;
 
-    // 预分配 fd 上下文容器（避免动态扩容）
-    m_fdContexts.resize(128);
+    size_t count = 1;
+    if (m_multiReactor) {
+        size_t workers = m_threadCount - (m_useCaller ? 1 : 0);
+        count = std::max<size_t>(workers, 1);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        auto r = std::make_unique<Reactor>();
+        try {
+            openReactor(r->epfd, r->eventfd);
+        } catch (...) {
+            for (auto &o : m_reactors) {
+                close(o->epfd);
+                close(o->eventfd);
+            }
+            throw;
+        }
+        m_reactors.push_back(std::move(r));
+    }
+    if (!m_multiReactor) {
+        size_t slots = m_threadCount - (m_useCaller ? 1 : 0) + 1;
+        for (size_t i = 0; i < slots; ++i) m_idleSlots.push_back(std::make_unique<IdleSlot>());
+    }
+    IOManagerRegistry &reg = Registry();
+    std::unique_lock<std::shared_mutex> lock(reg.mutex);
+    reg.list.push_back(this);
 }
 
 // 析构函数：清理 epoll 和 eventfd 资源
 // 确保调度器停止后关闭文件描述符
+// 停止期间协程仍可能 close 自己的 fd，所以停止之后才从登记表移除
 IOManager::~IOManager() {
     stop(); // 先停止调度器
-    if (m_epfd != -1) close(m_epfd);
-    if (m_eventfd != -1) close(m_eventfd);
+    {
+        IOManagerRegistry &reg = Registry();
+        std::unique_lock<std::shared_mutex> lock(reg.mutex);
+        reg.list.erase(std::remove(reg.list.begin(), reg.list.end(), this), reg.list.end());
+    }
+    for (auto &r : m_reactors) {
+        if (r->epfd != -1) close(r->epfd);
+        if (r->eventfd != -1) close(r->eventfd);
+    }
+    for (auto &chunk : m_fdChunks) delete[] chunk.load(std::memory_order_relaxed);
 }
 
 IOManager *IOManager::GetThis() {
     return dynamic_cast<IOManager *>(Scheduler::GetThis());
 }
 
-// 扩容 fd 上下文容器（确保能索引到指定 fd）
-// 1. 通过 m_mutex 保护 m_fdContexts
-// 2. 如果 fd 超过当前容器大小，则扩容至 2 倍
-// 3. 如果当前 fd 上下文不存在，则创建
-void IOManager::resizeFdContext(size_t fd) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    if (fd >= m_fdContexts.size()) {
-        size_t newsz = m_fdContexts.size();
-        while (fd >= newsz) newsz *= 2; // 扩容至 2 倍
-        m_fdContexts.resize(newsz);
-    }
-    if (!m_fdContexts[fd]) {
-        m_fdContexts[fd] = std::make_shared<FdContext>();
-        m_fdContexts[fd]->fd = (int)fd;
+// 当前线程对应的 reactor：多 reactor 模式下第 i 个工作线程用第 i 个，其他线程用 0 号
+size_t IOManager::getReactorIndex() const {
+    if (!m_multiReactor) return 0;
+    int self = currentWorkerIndex();
+    if (self < 0 || static_cast<size_t>(self) >= m_reactors.size()) return 0;
+    return static_cast<size_t>(self);
+}
+
+// fd 所属 reactor 的线程：多 reactor 模式下该 fd 的等待者只在这个线程恢复
+// 单 reactor 模式（或 reactor 没有对应的工作线程）返回空 id，表示任意线程
+std::thread::id IOManager::reactorThread(const FdContext *ctx) const {
+    if (!m_multiReactor || ctx->reactor < 0) return std::thread::id();
+    return workerThreadId(static_cast<size_t>(ctx->reactor));
+}
+
+// 在第 idx 个 reactor 的线程上执行 cb（start() 之后调用）
+void IOManager::schedulerOnReactor(size_t idx, std::function<void()> cb) {
+    std::thread::id thr = m_multiReactor ? workerThreadId(idx) : std::thread::id();
+    scheduler(std::move(cb), thr);
+}
+
+// 查找 fd 上下文（两级表：fd 高位选块，低位选块内下标）
+// 1. 读路径只有一次 acquire 加载，不加锁
+// 2. 块第一次被用到时按需分配，CAS 发布；竞争失败的一方释放自己的块改用胜出者的
+// 3. 块一旦发布就不再移动或释放（直到 IOManager 析构），FdContext 指针可以长期保存在 epoll 里
+IOManager::FdContext *IOManager::getFdContext(int fd, bool auto_create) {
+    if (fd < 0) return nullptr;
+    size_t idx = static_cast<size_t>(fd) >> FD_CHUNK_BITS;
+    if (idx >= FD_MAX_CHUNKS) return nullptr;
+
+    FdContext *chunk = m_fdChunks[idx].load(std::memory_order_acquire);
+    if (!chunk) {
+        if (!auto_create) return nullptr;
+        FdContext *fresh = new FdContext[FD_CHUNK_SIZE];
+        for (size_t i = 0; i < FD_CHUNK_SIZE; ++i) fresh[i].fd = static_cast<int>((idx << FD_CHUNK_BITS) + i);
+        if (m_fdChunks[idx].compare_exchange_strong(chunk, fresh, std::memory_order_acq_rel,
+                                                    std::memory_order_acquire)) {
+            chunk = fresh;
+        } else {
+            delete[] fresh; // chunk 已被更新为胜出者的块
+        }
     }
+    return &chunk[static_cast<size_t>(fd) & (FD_CHUNK_SIZE - 1)];
 }
 
 // 添加 I/O 事件监听
@@ -89,8 +199,11 @@ int IOManager::addEvent(int fd, Event ev, std::function<void()> cb) {
         errno = EINVAL;
         return -1;
     }
-    resizeFdContext(fd); // 确保 fd 上下文存在
-    auto ctx = m_fdContexts[fd];
+    FdContext *ctx = getFdContext(fd, true); // 确保 fd 上下文存在
+    if (!ctx) {
+        errno = EMFILE; // 超出 fd 表容量
+        return -1;
+    }
     std::lock_guard<std::mutex> lock(ctx->mutex);
 
     // 检查是否已注册相同事件
@@ -99,6 +212,12 @@ int IOManager::addEvent(int fd, Event ev, std::function<void()> cb) {
         return -1;
     }
 
+    // fd 第一次被等待时绑定到当前线程的 reactor，直到 cancelAll（close）才解除
+    if (ctx->reactor < 0) ctx->reactor = static_cast<int>(getReactorIndex());
+    int epfd = m_reactors[ctx->reactor]->epfd;
+
+    if (m_persistent) return addPersistentEvent(ctx, ev, std::move(cb));
+
     // 确定 epoll 操作类型（ADD 或 MOD）
     int op = ctx->events == NONE ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
     epoll_event epevent{};
@@ -115,19 +234,19 @@ int IOManager::addEvent(int fd, Event ev, std::function<void()> cb) {
     // 设置 epoll 事件标志（ET 模式 + 错误处理）
     events |= EPOLLET | EPOLLERR | EPOLLHUP;
     epevent.events = events;
-    epevent.data.ptr = ctx.get(); // 关联上下文指针
+    epevent.data.ptr = ctx; // 关联上下文指针
 
     // 注册到 epoll
-    if (epoll_ctl(m_epfd, op, fd, &epevent) == -1) {
+    if (epoll_ctl(epfd, op, fd, &epevent) == -1) {
         // 处理 epoll_ctl 竞争条件（ADD vs MOD）
         if (op == EPOLL_CTL_ADD && errno == EEXIST) {
             // 改为 MOD 操作
-            if (epoll_ctl(m_epfd, EPOLL_CTL_MOD, fd, &epevent) == -1) {
+            if (epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &epevent) == -1) {
                 return -1;
             }
         } else if (op == EPOLL_CTL_MOD && errno == ENOENT) {
             // 改为 ADD 操作
-            if (epoll_ctl(m_epfd, EPOLL_CTL_ADD, fd, &epevent) == -1) {
+            if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &epevent) == -1) {
                 return -1;
             }
         } else {
@@ -139,28 +258,62 @@ int IOManager::addEvent(int fd, Event ev, std::function<void()> cb) {
     ctx->events = static_cast<Event>(ctx->events | ev);
     auto &ectx = ctx->getContext(ev);
     ectx.scheduler = this; // 关联调度器
-    if (cb)
+    if (cb) {
         ectx.cb = std::move(cb); // 保存回调
-    else
+    } else {
+        // 没有回调：事件触发时重新调度当前协程（hook 的 I/O 等待走这条路径）
         ectx.cb = nullptr;
+        ectx.fiber = Fiber::GetThis()->shared_from_this();
+    }
 
     // 更新待处理事件计数
     m_pendingEventCount.fetch_add(1, std::memory_order_relaxed);
     return 0;
 }
 
-// 删除事件监听（不触发回调）
-bool IOManager::delEvent(int fd, Event ev) {
-    if (fd < 0) return false;
-    if (fd >= (int)m_fdContexts.size()) return false;
-    auto ctx = m_fdContexts[fd];
-    if (!ctx) return false;
+// 持久模式的 addEvent（调用方持有 ctx->mutex，且 ev 上还没有等待者）
+// 1. fd 第一次等待时加入 epoll，之后一直保持注册
+// 2. 已锁存 ev 的就绪状态：消费掉并立即调度等待者（可能是上次读写之前的旧边沿，
+//    hook 的 do_io 会重试系统调用，重新得到 EAGAIN 后再次等待）
+// 3. 否则登记等待者，由 epoll 事件循环唤醒
+int IOManager::addPersistentEvent(FdContext *ctx, Event ev, std::function<void()> cb) {
+    if (!ctx->registered) {
+        int epfd = m_reactors[ctx->reactor]->epfd;
+        epoll_event epevent{};
+        epevent.events = EPOLLIN | EPOLLOUT | EPOLLET | EPOLLERR | EPOLLHUP;
+        epevent.data.ptr = ctx;
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, ctx->fd, &epevent) == -1) {
+            if (errno != EEXIST || epoll_ctl(epfd, EPOLL_CTL_MOD, ctx->fd, &epevent) == -1) return -1;
+        }
+        ctx->registered = true;
+    }
 
-    std::lock_guard<std::mutex> lock(ctx->mutex);
-    if ((ctx->events & ev) == 0) return false; // 未注册
+    if (ctx->ready.fetch_and(~ev, std::memory_order_relaxed) & ev) {
+        if (cb) {
+            scheduler(std::move(cb), reactorThread(ctx));
+        } else {
+            scheduler(Fiber::GetThis()->shared_from_this(), reactorThread(ctx));
+        }
+        return 0;
+    }
 
-    // 计算新事件掩码
-    Event newEvents = static_cast<Event>(ctx->events & ~ev);
+    ctx->events = static_cast<Event>(ctx->events | ev);
+    auto &ectx = ctx->getContext(ev);
+    ectx.scheduler = this;
+    if (cb) {
+        ectx.cb = std::move(cb);
+    } else {
+        ectx.cb = nullptr;
+        ectx.fiber = Fiber::GetThis()->shared_from_this();
+    }
+    m_pendingEventCount.fetch_add(1, std::memory_order_relaxed);
+    return 0;
+}
+
+// 移除一个事件后更新 epoll 注册：还有剩余事件改为 MOD，否则 DEL
+// 持久模式下 fd 始终保持注册，不需要任何系统调用
+void IOManager::disarmEvent(FdContext *ctx, Event newEvents) {
+    if (m_persistent) return;
     uint32_t events = 0;
     if (newEvents & READ) events |= EPOLLIN;
     if (newEvents & WRITE) events |= EPOLLOUT;
@@ -168,17 +321,25 @@ bool IOManager::delEvent(int fd, Event ev) {
 
     epoll_event epevent{};
     epevent.events = events;
-    epevent.data.ptr = ctx.get();
-
-    // 确定 epoll 操作
+    epevent.data.ptr = ctx;
     int op = (newEvents == NONE) ? EPOLL_CTL_DEL : EPOLL_CTL_MOD;
     // 删除操作时传 nullptr
-    if (epoll_ctl(m_epfd, op, fd, (op == EPOLL_CTL_DEL) ? nullptr : &epevent) == -1) {
-        // 忽略 ENOENT 错误（已删除）
-        if (!(op == EPOLL_CTL_DEL && errno == ENOENT)) {
-            // 其他错误打印日志（实际可忽略）
-        }
+    if (epoll_ctl(m_reactors[ctx->reactor]->epfd, op, ctx->fd, (op == EPOLL_CTL_DEL) ? nullptr : &epevent) == -1) {
+        // 忽略错误（例如 fd 已关闭的 ENOENT / EBADF）
     }
+}
+
+// 删除事件监听（不触发回调）
+bool IOManager::delEvent(int fd, Event ev) {
+    FdContext *ctx = getFdContext(fd, false);
+    if (!ctx) return false;
+
+    std::lock_guard<std::mutex> lock(ctx->mutex);
+    if ((ctx->events & ev) == 0) return false; // 未注册
+
+    // 计算新事件掩码并更新 epoll
+    Event newEvents = static_cast<Event>(ctx->events & ~ev);
+    disarmEvent(ctx, newEvents);
 
     // 更新上下文
     ctx->events = newEvents;
@@ -189,16 +350,16 @@ bool IOManager::delEvent(int fd, Event ev) {
 
 // 取消事件监听（触发回调）
 bool IOManager::cancelEvent(int fd, Event ev) {
-    if (fd < 0) return false;
-    if (fd >= (int)m_fdContexts.size()) return false;
-    auto ctx = m_fdContexts[fd];
+    FdContext *ctx = getFdContext(fd, false);
     if (!ctx) return false;
 
     std::function<void()> cb;
     Fiber::ptr f;
+    std::thread::id thr;
     {
         std::lock_guard<std::mutex> lock(ctx->mutex);
         if ((ctx->events & ev) == 0) return false; // 未注册
+        thr = reactorThread(ctx);
 
         // 提取回调和协程
         auto &ectx = ctx->getContext(ev);
@@ -207,18 +368,7 @@ bool IOManager::cancelEvent(int fd, Event ev) {
 
         // 更新 epoll 事件
         Event newEvents = static_cast<Event>(ctx->events & ~ev);
-        uint32_t events = 0;
-        if (newEvents & READ) events |= EPOLLIN;
-        if (newEvents & WRITE) events |= EPOLLOUT;
-        events |= EPOLLET | EPOLLERR | EPOLLHUP;
-
-        epoll_event epevent{};
-        epevent.events = events;
-        epevent.data.ptr = ctx.get();
-        int op = (newEvents == NONE) ? EPOLL_CTL_DEL : EPOLL_CTL_MOD;
-        if (epoll_ctl(m_epfd, op, fd, (op == EPOLL_CTL_DEL) ? nullptr : &epevent) == -1) {
-            // 容错处理（忽略部分错误）
-        }
+        disarmEvent(ctx, newEvents);
 
         // 更新上下文
         ctx->events = newEvents;
@@ -228,23 +378,37 @@ bool IOManager::cancelEvent(int fd, Event ev) {
 
     // 在锁外触发回调（提交到调度器）
     if (cb)
-        scheduler(cb); // 调度器执行回调
+        scheduler(std::move(cb), thr); // 调度器执行回调
     else if (f)
-        scheduler(f); // 调度器执行协程
+        scheduler(std::move(f), thr); // 调度器执行协程
     return true;
 }
 
 // 取消并触发所有注册在 fd 上的事件
 bool IOManager::cancelAll(int fd) {
-    if (fd < 0) return false;
-    if (fd >= (int)m_fdContexts.size()) return false;
-    auto ctx = m_fdContexts[fd];
+    FdContext *ctx = getFdContext(fd, false);
     if (!ctx) return false;
 
     std::function<void()> cb_r, cb_w;
     Fiber::ptr f_r, f_w;
+    std::thread::id thr;
     {
         std::lock_guard<std::mutex> lock(ctx->mutex);
+        if (ctx->reactor < 0) return false; // 从未等待过
+        int epfd = m_reactors[ctx->reactor]->epfd;
+        thr = reactorThread(ctx);
+        // io_uring 后端：取消在途的请求，丢弃排队的连接 / 数据
+        if (ctx->uring) uringCancel(ctx, ctx->reactor);
+        // fd 即将关闭（之后编号可能被复用）：解除 reactor 绑定
+        ctx->reactor = -1;
+        // 持久模式：撤销注册并丢弃锁存的就绪状态
+        if (ctx->registered) {
+            if (epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr) == -1) {
+                // 忽略错误
+            }
+            ctx->registered = false;
+            ctx->ready.store(NONE, std::memory_order_relaxed);
+        }
         if (ctx->events == NONE) return false; // 无事件
 
         // 提取读/写事件的回调和协程
@@ -254,130 +418,1004 @@ bool IOManager::cancelAll(int fd) {
         if (ctx->write.fiber) f_w = std::move(ctx->write.fiber);
 
         // 从 epoll 删除所有事件
-        if (epoll_ctl(m_epfd, EPOLL_CTL_DEL, fd, nullptr) == -1) {
+        if (!m_persistent && epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr) == -1) {
             // 忽略错误
         }
+        // 更新待处理事件计数（按实际注册的事件数）
+        size_t removed = ((ctx->events & READ) ? 1 : 0) + ((ctx->events & WRITE) ? 1 : 0);
         ctx->events = NONE;
         ctx->read.reset();
         ctx->write.reset();
-        // 更新待处理事件计数（假设两个事件都被移除）
-        m_pendingEventCount.fetch_sub(2, std::memory_order_relaxed);
+        m_pendingEventCount.fetch_sub(removed, std::memory_order_relaxed);
     }
 
     // 触发所有事件回调
-    if (cb_r) scheduler(cb_r);
-    if (f_r) scheduler(f_r);
-    if (cb_w) scheduler(cb_w);
-    if (f_w) scheduler(f_w);
+    if (cb_r) scheduler(std::move(cb_r), thr);
+    if (f_r) scheduler(std::move(f_r), thr);
+    if (cb_w) scheduler(std::move(cb_w), thr);
+    if (f_w) scheduler(std::move(f_w), thr);
     return true;
 }
 
-// 重写 tickle()：使用 eventfd 唤醒 epoll_wait
-// 写入 eventfd 触发 epoll_wait 返回
-void IOManager::tickle() {
+// 同一个 fd 号同一时刻只会被一个 IOManager 等待，其余的 getFdContext / reactor 检查立即返回
+void IOManager::CancelAllEverywhere(int fd) {
+    IOManagerRegistry &reg = Registry();
+    std::shared_lock<std::shared_mutex> lock(reg.mutex);
+    for (IOManager *iom : reg.list) iom->cancelAll(fd);
+}
+
+// 重写 run()：工作线程（以及 use_caller 的调用线程）在调度期间开启 hook，
+// 协程里的阻塞式 socket I/O / sleep 会自动变成"注册事件 + 让出"
+// io_uring 后端：ring 在工作线程上创建（SINGLE_ISSUER 要求提交者就是创建者），线程退出时销毁
+void IOManager::run() {
+    set_hook_enable(true);
+    if (m_uring) uringThreadInit();
+    Scheduler::run();
+    if (m_uring) uringThreadFini();
+    set_hook_enable(false);
+}
+
+// 写 eventfd 唤醒第 idx 个 reactor 的 epoll_wait
+void IOManager::wakeReactor(size_t idx) {
+    countTickleSent();
     uint64_t one = 1;
-    ssize_t n = write(m_eventfd, &one, sizeof(one));
+    ssize_t n = write(m_reactors[idx]->eventfd, &one, sizeof(one));
     (void)n; // 忽略写入结果（通常成功）
-    // 同时通知父类条件变量（安全起见）
-    Scheduler::tickle();
 }
 
-// 触发事件回调（被 epoll 事件循环调用）
-// 1. 从上下文提取回调/协程
-// 2. 从 epoll 中移除事件
-// 3. 提交到调度器执行
-void IOManager::triggerEvent(int fd, Event ev) {
-    if (fd < 0) return;
-    if (fd >= (int)m_fdContexts.size()) return;
-    auto ctx = m_fdContexts[fd];
-    if (!ctx) return;
+// 多 reactor 模式：唤醒一个正阻塞在 epoll_wait 上的其他 reactor（从当前线程的下一个开始找）
+// 返回值：是否唤醒了某个 reactor
+bool IOManager::wakeOneSleeping() {
+    size_t n = m_reactors.size();
+    size_t self = getReactorIndex();
+    for (size_t k = 1; k <= n; ++k) {
+        size_t idx = (self + k) % n;
+        if (m_reactors[idx]->sleeping.load(std::memory_order_relaxed)) {
+            wakeReactor(idx);
+            return true;
+        }
+    }
+    return false;
+}
 
-    std::function<void()> cb;
-    Fiber::ptr f;
+// 单 reactor 模式：工作线程用自己的下标，其他线程（use_caller 的调用线程）用最后一个
+size_t IOManager::idleSlotIndex() const {
+    int self = currentWorkerIndex();
+    return self >= 0 ? static_cast<size_t>(self) : m_idleSlots.size() - 1;
+}
+
+// 先在锁内置 notified（follower 的条件变量谓词），再看它是不是 leader：
+// 与 sharedIdle 中 "CAS 成为 leader -> 检查 notified" 配对（都是 seq_cst），要么这里看到它是 leader
+// 并写 eventfd，要么它成为 leader 之后看到 notified，不再阻塞
+void IOManager::wakeIdleSlot(size_t idx) {
+    IdleSlot &slot = *m_idleSlots[idx];
     {
-        std::lock_guard<std::mutex> lock(ctx->mutex);
-        if ((ctx->events & ev) == 0) return; // 事件已被取消
+        std::lock_guard<std::mutex> lock(slot.mutex);
+        slot.notified.store(true);
+    }
+    slot.cond.notify_one();
+    if (m_poller.load() == static_cast<int>(idx)) {
+        wakeReactor(0);
+    } else {
+        countTickleSent();
+    }
+}
 
-        auto &ectx = ctx->getContext(ev);
-        if (ectx.cb) cb = std::move(ectx.cb);
-        if (ectx.fiber) f = std::move(ectx.fiber);
+// 从当前线程的下一个槽位开始找 follower，避免总是唤醒同一个
+void IOManager::wakeOneIdle() {
+    size_t n = m_idleSlots.size();
+    size_t self = idleSlotIndex();
+    int poller = m_poller.load();
+    for (size_t k = 1; k <= n; ++k) {
+        size_t idx = (self + k) % n;
+        if (static_cast<int>(idx) == poller) continue;
+        if (m_idleSlots[idx]->sleeping.load(std::memory_order_relaxed)) {
+            wakeIdleSlot(idx);
+            return;
+        }
+    }
+    wakeReactor(0);
+}
 
-        // 更新 epoll 事件
-        Event newEvents = static_cast<Event>(ctx->events & ~ev);
-        uint32_t events = 0;
-        if (newEvents & READ) events |= EPOLLIN;
-        if (newEvents & WRITE) events |= EPOLLOUT;
-        events |= EPOLLET | EPOLLERR | EPOLLHUP;
+// 重写 tickle()：使用 eventfd 唤醒 epoll_wait
+// 1. 单 reactor 模式：唤醒空闲线程（leader 写共享的 eventfd，follower 通知各自的条件变量），
+//    同时通知父类条件变量（安全起见，不重复计入 tickle 指标）
+//    - 停止时唤醒全部
+//    - pinned 队列里有任务的工作线程逐个直接唤醒；调用线程的 pinned 任务在全局队列里，它空闲时也唤醒
+//    - 还有可被任意线程执行的任务时，再唤醒一个空闲线程
+// 2. 多 reactor 模式：只唤醒需要醒来的线程
+//    - 停止时唤醒全部
+//    - pinned 队列里有任务的 reactor 必须由自己处理，逐个唤醒
+//    - 还有可被任意线程执行的任务时，再唤醒一个正在睡眠的 reactor
+//    fence 与 idle() 中 "置 sleeping -> fence -> 检查任务" 配对：要么这里看到 sleeping，要么对方看到任务
+// 3. 有线程正在自旋并且一定能接手新任务时不写 eventfd（见 Scheduler::spinnerWillSee）
+void IOManager::tickle() {
+    if (!m_multiReactor) {
+        if (spinnerWillSee()) return;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        size_t n = m_idleSlots.size();
+        if (m_stopping.load()) {
+            for (size_t i = 0; i < n; ++i) wakeIdleSlot(i);
+            wakeReactor(0);
+            notifyWaiters();
+            return;
+        }
+        bool woke = false;
+        if (m_pinnedCount.load(std::memory_order_relaxed) > 0) {
+            for (size_t i = 0; i + 1 < n; ++i) {
+                if (m_idleSlots[i]->sleeping.load(std::memory_order_relaxed) && !workerPinnedEmpty(i)) {
+                    wakeIdleSlot(i);
+                    woke = true;
+                }
+            }
+            if (m_globalCount.load(std::memory_order_relaxed) > 0 &&
+                m_idleSlots[n - 1]->sleeping.load(std::memory_order_relaxed)) {
+                wakeIdleSlot(n - 1);
+                woke = true;
+            }
+        }
+        if (!woke || m_taskCount.load() > m_pinnedCount.load()) wakeOneIdle();
+        notifyWaiters();
+        return;
+    }
 
-        epoll_event epevent{};
-        epevent.events = events;
-        epevent.data.ptr = ctx.get();
-        int op = (newEvents == NONE) ? EPOLL_CTL_DEL : EPOLL_CTL_MOD;
-        if (epoll_ctl(m_epfd, op, fd, (op == EPOLL_CTL_DEL) ? nullptr : &epevent) == -1) {
-            // 忽略错误
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    size_t n = m_reactors.size();
+    if (m_stopping.load()) {
+        for (size_t i = 0; i < n; ++i) wakeReactor(i);
+        return;
+    }
+    bool woke = false;
+    if (m_pinnedCount.load(std::memory_order_relaxed) > 0) {
+        for (size_t i = 0; i < n; ++i) {
+            if (m_reactors[i]->sleeping.load(std::memory_order_relaxed) && !workerPinnedEmpty(i)) {
+                wakeReactor(i);
+                woke = true;
+            }
         }
-        ctx->events = newEvents;
-        ctx->getContext(ev).reset(); // 重置上下文
-        m_pendingEventCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+    if (!woke && m_taskCount.load() > m_pinnedCount.load() && !spinnerWillSee()) wakeOneSleeping();
+}
+
+// 触发事件（被 epoll 事件循环调用）
+// 1. 从上下文提取回调/协程
+// 2. 从 epoll 中移除事件
+// 3. 追加到本轮就绪列表（由 idle() 整批提交到调度器）
+void IOManager::triggerEvent(FdContext *ctx, Event ev, std::vector<std::function<void()>> &cbs,
+                             std::vector<Fiber::ptr> &fibers) {
+    std::lock_guard<std::mutex> lock(ctx->mutex);
+    if ((ctx->events & ev) == 0) {
+        // 持久模式：没有等待者，锁存就绪状态，留给下一次 addEvent 消费
+        // 非持久模式：事件已被取消
+        if (m_persistent) ctx->ready.fetch_or(ev, std::memory_order_relaxed);
+        return;
     }
 
-    // 提交到调度器执行
-    if (cb)
-        scheduler(cb);
-    else if (f)
-        scheduler(f);
+    auto &ectx = ctx->getContext(ev);
+    if (ectx.cb) {
+        cbs.push_back(std::move(ectx.cb));
+    } else if (ectx.fiber) {
+        fibers.push_back(std::move(ectx.fiber));
+    }
+
+    // 更新 epoll 事件
+    Event newEvents = static_cast<Event>(ctx->events & ~ev);
+    disarmEvent(ctx, newEvents);
+    ctx->events = newEvents;
+    ctx->getContext(ev).reset(); // 重置上下文
+    m_pendingEventCount.fetch_sub(1, std::memory_order_relaxed);
 }
 
-// 重写 run()：实现 epoll 事件循环
-void IOManager::run() {
-    setThis(); // 设置当前线程的调度器
+// 新定时器插到了最前面：唤醒一个阻塞在 epoll_wait 上的线程重新计算超时
+// 单 reactor 模式只有 leader 阻塞在 epoll_wait 上（follower 不等定时器），写共享的 eventfd 即可
+void IOManager::onTimerInsertedAtFront() {
+    if (!m_multiReactor) {
+        wakeReactor(0);
+        return;
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    wakeOneSleeping();
+}
+
+// 每个线程复用的就绪列表（避免每轮 epoll_wait 都分配）
+static thread_local std::vector<std::function<void()>> t_ready_cbs;
+static thread_local std::vector<Fiber::ptr> t_ready_fibers;
+
+// 重写 idle()：epoll 事件循环的一次迭代
+// 1. 已有可执行任务时不阻塞（timeout = 0），否则等到最近的定时器到期
+// 2. eventfd 事件表示 tickle 唤醒；停止过程中不读取 eventfd，使其保持可读以唤醒所有线程
+// 3. 到期定时器和就绪事件的回调 / 协程先收集起来，再整批提交给调度器
+// 4. 整批最多 tickle 一次；当前工作线程返回 run() 后自己就会执行这批任务，
+//    只有一个任务、且它不是绑定在别的线程上的共享栈协程时不唤醒其他线程
+// 5. 多 reactor 模式：只等待本线程的 epoll，整批任务固定在本线程执行（不会被窃取），不需要 tickle；
+//    例外是绑定在别的线程上的共享栈协程，它只能回到绑定的线程
+//    单 reactor 模式见 sharedIdle
+// 6. io_uring 后端：线程有 ring 时改为阻塞在 io_uring_enter 上（见 uringIdle）
+// 7. 阻塞之前先短暂自旋（Scheduler::spinIdle），期间由 pollIdle() 轮询 epoll；io_uring 后端不自旋
+void IOManager::idle() {
+    Reactor &reactor = *m_reactors[getReactorIndex()];
+    if (m_uring && reactor.ring && isWorkerThread()) {
+        uringIdle(reactor);
+        return;
+    }
+    if (spinIdle()) return;
+    if (!m_multiReactor) {
+        sharedIdle(reactor);
+        return;
+    }
+
+    epoll_event events[MAX_EVENTS];
+    reactor.sleeping.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int timeout_ms = -1;
+    uint64_t next_timeout = getNextTimer();
+    if (hasPendingTask()) {
+        timeout_ms = 0;
+    } else if (next_timeout != ~0ull) {
+        timeout_ms = static_cast<int>(std::min<uint64_t>(next_timeout, MAX_TIMEOUT));
+    }
+    int n = epoll_wait(reactor.epfd, events, MAX_EVENTS, timeout_ms);
+    if (n < 0 && errno != EINTR) {
+        perror("epoll_wait");
+    }
+    reactor.sleeping.store(false, std::memory_order_relaxed);
+    countWakeup(n);
+
+    std::vector<std::function<void()>> &cbs = t_ready_cbs;
+    std::vector<Fiber::ptr> &fibers = t_ready_fibers;
+
+    // 到期定时器
+    listExpiredCb(cbs);
+    dispatchEpollEvents(reactor, events, n, cbs, fibers);
+    submitReady(cbs, fibers);
+}
 
-    // 预分配 epoll 事件缓冲区
-    const int MAX_EVENTS_LOCAL = MAX_EVENTS;
-    std::vector<epoll_event> events(MAX_EVENTS_LOCAL);
+// 单 reactor 模式的 idle()：leader / follower
+// 1. 已有可执行任务时不阻塞，直接轮询一次共享 epoll（不成为 leader）
+// 2. 没有 leader 时本线程成为 leader，阻塞在共享的 epoll_wait 上（超时为最近的定时器）；
+//    只有 leader 读取共享的 eventfd，其他线程轮询到它时不读，留给 leader
+// 3. 已经有 leader 时成为 follower，睡在自己的条件变量上，直到被直接唤醒（wakeIdleSlot）或停止
+// 4. leader 醒来后让出位置；要去执行任务时唤醒一个 follower 接替，保证有线程继续等待 I/O
+// sleeping / fence 与 tickle() 配对：要么 tickle 看到本线程空闲，要么本线程看到任务
+void IOManager::sharedIdle(Reactor &reactor) {
+    size_t self = idleSlotIndex();
+    IdleSlot &slot = *m_idleSlots[self];
+    slot.sleeping.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
 
-    while (!m_stopping.load()) {
-        int timeout_ms = -1; // 无限等待
-        int n = epoll_wait(m_epfd, events.data(), MAX_EVENTS_LOCAL, timeout_ms);
-        if (n < 0) {
-            if (errno == EINTR) continue; // 系统中断
+    epoll_event events[MAX_EVENTS];
+    int n = 0;
+    int expected = -1;
+    bool leader = false;
+    if (hasPendingTask()) {
+        n = epoll_wait(reactor.epfd, events, MAX_EVENTS, 0);
+    } else if (m_poller.compare_exchange_strong(expected, static_cast<int>(self))) {
+        leader = true;
+        int timeout_ms = -1;
+        uint64_t next_timeout = getNextTimer();
+        // 成为 leader 之前已经被直接唤醒（见 wakeIdleSlot）：不阻塞
+        if (slot.notified.exchange(false) || hasPendingTask()) {
+            timeout_ms = 0;
+        } else if (next_timeout != ~0ull) {
+            timeout_ms = static_cast<int>(std::min<uint64_t>(next_timeout, MAX_TIMEOUT));
+        }
+        n = epoll_wait(reactor.epfd, events, MAX_EVENTS, timeout_ms);
+        if (n < 0 && errno != EINTR) {
             perror("epoll_wait");
-            continue;
         }
+    } else {
+        std::unique_lock<std::mutex> lock(slot.mutex);
+        slot.cond.wait(lock, [this, &slot]() { return slot.notified.load() || m_stopping.load(); });
+        slot.notified.store(false);
+        lock.unlock();
+        slot.sleeping.store(false, std::memory_order_relaxed);
+        if (ThreadCounters *c = localCounters()) c->ticklesReceived.add();
+        return;
+    }
+    slot.sleeping.store(false, std::memory_order_relaxed);
+    countWakeup(n);
 
-        // 处理每个事件
-        for (int i = 0; i < n; ++i) {
-            epoll_event &e = events[i];
-            // 处理 eventfd 事件（tickle 唤醒）
-            if (e.data.ptr == nullptr) {
-                uint64_t val;
-                ssize_t r = read(m_eventfd, &val, sizeof(val));
-                (void)r; // 忽略读取结果
-                continue;
+    std::vector<std::function<void()>> &cbs = t_ready_cbs;
+    std::vector<Fiber::ptr> &fibers = t_ready_fibers;
+    listExpiredCb(cbs);
+    dispatchEpollEvents(reactor, events, n, cbs, fibers);
+    if (leader) {
+        m_poller.store(-1);
+        if (!m_stopping.load() && (!cbs.empty() || !fibers.empty() || hasPendingTask())) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            size_t slots = m_idleSlots.size();
+            for (size_t k = 1; k < slots; ++k) {
+                size_t idx = (self + k) % slots;
+                if (m_idleSlots[idx]->sleeping.load(std::memory_order_relaxed)) {
+                    wakeIdleSlot(idx);
+                    break;
+                }
             }
+        }
+    }
+    submitReady(cbs, fibers);
+}
 
-            // 获取 fd 上下文
-            FdContext *ctx = reinterpret_cast<FdContext *>(e.data.ptr);
-            int fd = ctx->fd;
-            uint32_t revents = e.events;
+// 自旋期间的一次轮询：timeout = 0 的 epoll_wait 加到期定时器，就绪的任务整批提交（同 idle()）
+// 只有取到事件时才计入 reactor 唤醒指标，空轮询不计
+bool IOManager::pollIdle() {
+    Reactor &reactor = *m_reactors[getReactorIndex()];
+    epoll_event events[MAX_EVENTS];
+    int n = epoll_wait(reactor.epfd, events, MAX_EVENTS, 0);
+    if (n > 0) countWakeup(n);
+
+    std::vector<std::function<void()>> &cbs = t_ready_cbs;
+    std::vector<Fiber::ptr> &fibers = t_ready_fibers;
+    listExpiredCb(cbs);
+    if (n > 0) dispatchEpollEvents(reactor, events, n, cbs, fibers);
+    bool ready = !cbs.empty() || !fibers.empty();
+    submitReady(cbs, fibers);
+    return ready;
+}
 
-            // 优先处理错误事件（EPOLLERR/EPOLLHUP）
-            if (revents & (EPOLLERR | EPOLLHUP)) {
-                // 触发读/写事件（按实际场景）
-                triggerEvent(fd, READ);
-                triggerEvent(fd, WRITE);
+// 分发一批 epoll 事件
+void IOManager::dispatchEpollEvents(Reactor &reactor, const epoll_event *events, int n,
+                                    std::vector<std::function<void()>> &cbs, std::vector<Fiber::ptr> &fibers) {
+    for (int i = 0; i < n; ++i) {
+        const epoll_event &e = events[i];
+        // 处理 eventfd 事件（tickle 唤醒）：停止过程中不读取；单 reactor 模式只有 leader 读取（见 sharedIdle）
+        if (e.data.ptr == nullptr) {
+            if (m_stopping.load()) continue;
+            if (!m_multiReactor && m_poller.load(std::memory_order_relaxed) != static_cast<int>(idleSlotIndex())) {
                 continue;
             }
-            // 处理可读事件
-            if (revents & EPOLLIN) {
-                triggerEvent(fd, READ);
+            uint64_t val;
+            ssize_t r = read(reactor.eventfd, &val, sizeof(val));
+            if (r > 0) {
+                if (ThreadCounters *c = localCounters()) c->ticklesReceived.add();
+            }
+            continue;
+        }
+
+        // 获取 fd 上下文
+        FdContext *ctx = reinterpret_cast<FdContext *>(e.data.ptr);
+        uint32_t revents = e.events;
+
+        // 错误事件（EPOLLERR/EPOLLHUP）同时唤醒读写两端
+        if (revents & (EPOLLERR | EPOLLHUP)) {
+            revents |= EPOLLIN | EPOLLOUT;
+        }
+        // 处理可读事件
+        if (revents & EPOLLIN) {
+            triggerEvent(ctx, READ, cbs, fibers);
+        }
+        // 处理可写事件
+        if (revents & EPOLLOUT) {
+            triggerEvent(ctx, WRITE, cbs, fibers);
+        }
+    }
+}
+
+// 把一轮收集到的回调 / 协程交给调度器（见 idle() 的 4、5）
+void IOManager::submitReady(std::vector<std::function<void()>> &cbs, std::vector<Fiber::ptr> &fibers) {
+    size_t ready = cbs.size() + fibers.size();
+    if (ready == 0) return;
+    // 绑定在别的线程上的共享栈协程只能由那个线程执行，当前线程接不了手
+    bool remote = false;
+    std::thread::id self = std::this_thread::get_id();
+    for (const Fiber::ptr &f : fibers) {
+        std::thread::id bound = f->getBoundThread();
+        if (bound != std::thread::id() && bound != self) {
+            remote = true;
+            break;
+        }
+    }
+    if (m_multiReactor) {
+        // 绑定的协程会进入它所在线程的 pinned 队列（见 schedulerNoLock），需要唤醒那个线程
+        bool has_idle =
+            schedulerNoTickle(std::make_move_iterator(cbs.begin()), std::make_move_iterator(cbs.end()), self);
+        has_idle =
+            schedulerNoTickle(std::make_move_iterator(fibers.begin()), std::make_move_iterator(fibers.end()), self) ||
+            has_idle;
+        cbs.clear();
+        fibers.clear();
+        if (remote && has_idle) tickle();
+        return;
+    }
+    bool has_idle = schedulerNoTickle(std::make_move_iterator(cbs.begin()), std::make_move_iterator(cbs.end()));
+    has_idle = schedulerNoTickle(std::make_move_iterator(fibers.begin()), std::make_move_iterator(fibers.end())) ||
+               has_idle;
+    cbs.clear();
+    fibers.clear();
+    if (has_idle && (ready > 1 || remote || !isWorkerThread())) tickle();
+}
+
+// ===== io_uring 后端 =====
+
+// 在本工作线程上创建 ring：SQ / CQ、provided buffer ring（multishot recv 用）和 epfd 上的 multishot poll
+// 创建失败时本线程退回 epoll（idle 阻塞在 epoll_wait 上，hook 走 do_io）
+void IOManager::uringThreadInit() {
+    int self = currentWorkerIndex();
+    if (self < 0 || static_cast<size_t>(self) >= m_reactors.size()) return;
+    Reactor &reactor = *m_reactors[self];
+    reactor.ring = IoUring::Create(URING_ENTRIES);
+    if (!reactor.ring) {
+        LOG_WARN(LogManager::GetInstance().getRoot())
+            << "io_uring setup failed errno=" << errno << ", reactor " << self << " falls back to epoll";
+        return;
+    }
+    if (m_multishotRecv && !reactor.ring->setupBufRing(0, URING_RECV_BUFS, URING_RECV_BUF_SIZE)) {
+        LOG_WARN(LogManager::GetInstance().getRoot())
+            << "io_uring provided buffer ring setup failed errno=" << errno << ", using single-shot recv";
+    }
+    uringArmEpoll(reactor);
+    reactor.uringReady.store(true, std::memory_order_release);
+}
+
+// 线程退出：关闭 ring（内核取消所有在途请求），清掉 fd 上指向本线程请求的状态
+void IOManager::uringThreadFini() {
+    int self = currentWorkerIndex();
+    if (self < 0 || static_cast<size_t>(self) >= m_reactors.size()) return;
+    Reactor &reactor = *m_reactors[self];
+    if (!reactor.ring) return;
+    reactor.uringReady.store(false, std::memory_order_release);
+
+    for (auto &slot : m_fdChunks) {
+        FdContext *chunk = slot.load(std::memory_order_acquire);
+        if (!chunk) continue;
+        for (size_t i = 0; i < FD_CHUNK_SIZE; ++i) {
+            FdContext &ctx = chunk[i];
+            std::lock_guard<std::mutex> lock(ctx.mutex);
+            if (!ctx.uring || ctx.reactor != self) continue;
+            UringState &st = *ctx.uring;
+            st.ops[0] = st.ops[1] = st.multi = nullptr;
+            for (int fd : st.accepted) close_f(fd);
+            st.accepted.clear();
+            st.chunks.clear();
+            st.waiter.reset();
+        }
+    }
+    reactor.ring.reset();
+    reactor.pollArmed = false;
+    reactor.freeRequests.clear();
+    reactor.requests.clear();
+}
+
+// io_uring 后端的一次事件循环迭代
+// 1. 一次 io_uring_enter：提交本轮积累的 SQE，没有可执行任务时等待至少一个完成事件（或最近的定时器到期）
+// 2. epfd 的 poll CQE 表示 epoll 上有就绪事件（addEvent 注册的 fd 或 eventfd tickle），用 timeout = 0 的 epoll_wait 取出
+// 3. 请求的 CQE 恢复等待的协程；整批固定在本线程执行
+// sleeping / fence 与多 reactor 模式的 tickle() 配对，同 epoll 路径
+void IOManager::uringIdle(Reactor &reactor) {
+    reactor.sleeping.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int timeout_ms = -1;
+    uint64_t next_timeout = getNextTimer();
+    if (hasPendingTask()) {
+        timeout_ms = 0;
+    } else if (next_timeout != ~0ull) {
+        timeout_ms = static_cast<int>(std::min<uint64_t>(next_timeout, MAX_TIMEOUT));
+    }
+    if (!reactor.pollArmed) uringArmEpoll(reactor);
+    int ret = reactor.ring->submitAndWait(timeout_ms == 0 ? 0 : 1, timeout_ms);
+    if (ret < 0 && ret != -ETIME && ret != -EINTR && ret != -EBUSY) {
+        LOG_ERROR(LogManager::GetInstance().getRoot()) << "io_uring_enter error errno=" << -ret;
+    }
+    reactor.sleeping.store(false, std::memory_order_relaxed);
+
+    std::vector<std::function<void()>> &cbs = t_ready_cbs;
+    std::vector<Fiber::ptr> &fibers = t_ready_fibers;
+    listExpiredCb(cbs);
+
+    // 指标：一次 io_uring_enter 返回算一次唤醒，事件数为请求 CQE 数加上取出的 epoll 事件数
+    int events_n = 0;
+    bool epoll_ready = false;
+    reactor.ring->reap([&](const io_uring_cqe &cqe) {
+        if (cqe.user_data == URING_EPOLL_TAG) {
+            epoll_ready = true;
+            if (!(cqe.flags & IORING_CQE_F_MORE)) reactor.pollArmed = false;
+        } else if (cqe.user_data != 0) {
+            ++events_n;
+            uringComplete(reactor, cqe, fibers);
+        }
+    });
+    if (epoll_ready) {
+        epoll_event events[MAX_EVENTS];
+        int n = epoll_wait(reactor.epfd, events, MAX_EVENTS, 0);
+        if (n > 0) events_n += n;
+        dispatchEpollEvents(reactor, events, n, cbs, fibers);
+    }
+    countWakeup(events_n);
+    submitReady(cbs, fibers);
+}
+
+void IOManager::uringArmEpoll(Reactor &reactor) {
+    io_uring_sqe *sqe = uringSqe(reactor);
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = reactor.epfd;
+    sqe->poll32_events = POLLIN;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = URING_EPOLL_TAG;
+    reactor.pollArmed = true;
+}
+
+// 处理一个请求的 CQE
+// 1. 单次请求：记录结果，恢复等待的协程（协程取走结果后自己释放请求）
+// 2. multishot：结果排队到 fd 的 UringState 并唤醒等待者；请求已被 close 取消（不再是 st.multi）时只回收资源
+// 3. 没有 IORING_CQE_F_MORE 表示 multishot 请求终止，释放请求，下一次调用会重新布置
+void IOManager::uringComplete(Reactor &reactor, const io_uring_cqe &cqe, std::vector<Fiber::ptr> &fibers) {
+    UringRequest *req = reinterpret_cast<UringRequest *>(cqe.user_data);
+    if (req->kind == UringRequest::ONESHOT) {
+        req->res = cqe.res;
+        if (req->fiber) fibers.push_back(std::move(req->fiber));
+        return;
+    }
+
+    bool more = cqe.flags & IORING_CQE_F_MORE;
+    Fiber::ptr waiter;
+    {
+        std::lock_guard<std::mutex> lock(req->ctx->mutex);
+        UringState &st = *req->ctx->uring;
+        bool current = st.multi == req;
+        if (req->kind == UringRequest::MULTI_ACCEPT) {
+            if (cqe.res >= 0) {
+                if (current) {
+                    st.accepted.push_back(cqe.res);
+                } else {
+                    close_f(cqe.res);
+                }
+            } else if (current && cqe.res != -ECANCELED) {
+                st.error = -cqe.res;
+            }
+        } else {
+            if (cqe.flags & IORING_CQE_F_BUFFER) {
+                uint16_t bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+                if (current && cqe.res > 0) {
+                    st.chunks.push_back({bid, static_cast<uint32_t>(cqe.res), 0});
+                } else {
+                    reactor.ring->recycleBuf(bid);
+                }
             }
-            // 处理可写事件
-            if (revents & EPOLLOUT) {
-                triggerEvent(fd, WRITE);
+            if (current) {
+                if (cqe.res == 0) {
+                    st.eof = true;
+                } else if (cqe.res < 0 && cqe.res != -ENOBUFS && cqe.res != -ECANCELED) {
+                    st.error = -cqe.res;
+                }
             }
         }
+        if (current) {
+            if (!more) st.multi = nullptr;
+            waiter = std::move(st.waiter);
+        }
+    }
+    if (!more) uringFree(reactor, req);
+    if (waiter) fibers.push_back(std::move(waiter));
+}
+
+// 进入 fd 所属 reactor 的线程
+// 1. fd 还没绑定时绑定到当前线程的 reactor（与 addEvent 共用 ctx->reactor）
+// 2. 绑定在别的 reactor 上：把当前协程调度到那个线程再继续，之后请求的提交、收割、buffer 回收都在同一个线程
+// 3. 共享栈协程不走 io_uring：请求在让出之后才提交 / 完成，引用的栈上缓冲区此时已被换出
+IOManager::Reactor *IOManager::uringEnter(FdContext *ctx) {
+    if (!m_uring || Fiber::GetThis()->isSharedStack()) return nullptr;
+    for (;;) {
+        int self = currentWorkerIndex();
+        if (self < 0 || static_cast<size_t>(self) >= m_reactors.size()) return nullptr;
+        int target;
+        {
+            std::lock_guard<std::mutex> lock(ctx->mutex);
+            if (ctx->reactor < 0) ctx->reactor = self;
+            target = ctx->reactor;
+            if (!ctx->uring) ctx->uring.reset(new UringState);
+        }
+        Reactor *reactor = m_reactors[target].get();
+        if (!reactor->uringReady.load(std::memory_order_acquire)) return nullptr;
+        if (target == self) return reactor;
+        scheduler(Fiber::GetThis()->shared_from_this(), workerThreadId(static_cast<size_t>(target)));
+        Fiber::YieldToHold();
+    }
+}
+
+IOManager::UringRequest *IOManager::uringAlloc(Reactor &reactor, UringRequest::Kind kind, FdContext *ctx) {
+    UringRequest *req;
+    if (reactor.freeRequests.empty()) {
+        reactor.requests.emplace_back(new UringRequest);
+        req = reactor.requests.back().get();
+    } else {
+        req = reactor.freeRequests.back();
+        reactor.freeRequests.pop_back();
+    }
+    req->kind = kind;
+    req->closed = false;
+    req->res = 0;
+    req->seq = ++reactor.nextSeq;
+    req->ctx = ctx;
+    return req;
+}
+
+// seq 清零：跨线程的取消任务据此跳过已完成的请求
+void IOManager::uringFree(Reactor &reactor, UringRequest *req) {
+    req->fiber.reset();
+    req->ctx = nullptr;
+    req->seq = 0;
+    reactor.freeRequests.push_back(req);
+}
+
+io_uring_sqe *IOManager::uringSqe(Reactor &reactor, unsigned n) {
+    if (reactor.ring->sqSpace() < n) reactor.ring->submit();
+    if (reactor.ring->sqSpace() < n) return nullptr;
+    return reactor.ring->getSqe();
+}
+
+// 单次请求
+// 1. 请求登记到 ops[slot]（close 时据此取消；同一方向已有在途请求时返回 -EEXIST，同 addEvent）
+// 2. 有超时则追加一个 IORING_OP_LINK_TIMEOUT，超时后请求以 -ECANCELED 结束，转换成 -ETIMEDOUT
+// 3. SQE 只进入 SQ，由 idle() 的 io_uring_enter 整批提交；积累到 URING_SUBMIT_BATCH 个时立即提交
+// 4. 让出协程，完成事件在本线程收割后恢复
+template <class Prep>
+int32_t IOManager::uringWait(Reactor &reactor, FdContext *ctx, Event slot, uint64_t timeout_ms, Prep &&prep) {
+    int i = slot == READ ? 0 : 1;
+    bool linked = timeout_ms != (uint64_t)-1;
+    UringRequest *req = uringAlloc(reactor, UringRequest::ONESHOT, ctx);
+    {
+        std::lock_guard<std::mutex> lock(ctx->mutex);
+        if (ctx->uring->ops[i]) {
+            uringFree(reactor, req);
+            return -EEXIST;
+        }
+        ctx->uring->ops[i] = req;
+    }
+    io_uring_sqe *sqe = uringSqe(reactor, linked ? 2 : 1);
+    if (!sqe) {
+        std::lock_guard<std::mutex> lock(ctx->mutex);
+        ctx->uring->ops[i] = nullptr;
+        uringFree(reactor, req);
+        return -EBUSY;
+    }
+    prep(sqe);
+    sqe->user_data = reinterpret_cast<uint64_t>(req);
+    if (linked) {
+        sqe->flags |= IOSQE_IO_LINK;
+        req->ts.tv_sec = static_cast<int64_t>(timeout_ms / 1000);
+        req->ts.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1000000;
+        io_uring_sqe *tsqe = reactor.ring->getSqe();
+        tsqe->opcode = IORING_OP_LINK_TIMEOUT;
+        tsqe->fd = -1;
+        tsqe->addr = reinterpret_cast<uint64_t>(&req->ts);
+        tsqe->len = 1;
+        tsqe->user_data = 0;
+    }
+    req->fiber = Fiber::GetThis()->shared_from_this();
+    if (reactor.ring->pending() >= URING_SUBMIT_BATCH) reactor.ring->submit();
+
+    Fiber::YieldToHold();
+
+    bool closed;
+    {
+        std::lock_guard<std::mutex> lock(ctx->mutex);
+        ctx->uring->ops[i] = nullptr;
+        closed = req->closed;
+    }
+    int32_t res = req->res;
+    uringFree(reactor, req);
+    if (res == -ECANCELED) res = closed ? -EBADF : -ETIMEDOUT;
+    return res;
+}
+
+template <class Prep>
+int32_t IOManager::uringCall(Reactor &reactor, FdContext *ctx, Event slot, uint64_t timeout_ms, Prep &&prep) {
+    for (;;) {
+        int32_t res = uringWait(reactor, ctx, slot, timeout_ms, prep);
+        if (res != -EAGAIN) return res;
+        // 老内核对非阻塞 fd 可能不在内部等待就绪：先在 ring 上 poll 到就绪再重试
+        res = uringWait(reactor, ctx, slot, timeout_ms, [ctx, slot](io_uring_sqe *sqe) {
+            sqe->opcode = IORING_OP_POLL_ADD;
+            sqe->fd = ctx->fd;
+            sqe->poll32_events = slot == READ ? POLLIN : POLLOUT;
+        });
+        if (res < 0) return res;
+    }
+}
+
+// multishot 等待：登记等待者后让出；第一次等待时挂超时定时器（整个调用只挂一个）
+// 定时器可能在任意线程上到期，只在等待者还是本协程时把它唤醒到 fd 的 reactor 线程
+void IOManager::uringWaitMulti(FdContext *ctx, std::unique_lock<std::mutex> &lock, uint64_t timeout_ms,
+                               Timer::ptr &timer, std::shared_ptr<int> &token) {
+    Fiber::ptr self = Fiber::GetThis()->shared_from_this();
+    Fiber *raw = self.get();
+    ctx->uring->waiter = std::move(self);
+    if (timeout_ms != (uint64_t)-1 && !timer) {
+        token = std::make_shared<int>(0);
+        std::weak_ptr<int> weak(token);
+        std::thread::id thr = reactorThread(ctx);
+        timer = addConditionTimer(timeout_ms, [this, ctx, raw, thr]() {
+            Fiber::ptr waiter;
+            {
+                std::lock_guard<std::mutex> guard(ctx->mutex);
+                if (!ctx->uring || ctx->uring->waiter.get() != raw) return;
+                ctx->uring->timedOut = true;
+                waiter = std::move(ctx->uring->waiter);
+            }
+            scheduler(std::move(waiter), thr);
+        }, weak);
+    }
+    lock.unlock();
+    Fiber::YieldToHold();
+    lock.lock();
+}
+
+bool IOManager::uringRecv(int fd, void *buf, size_t len, int flags, uint64_t timeout_ms, ssize_t &res) {
+    FdContext *ctx = getFdContext(fd, true);
+    if (!ctx) return false;
+    Reactor *reactor = uringEnter(ctx);
+    if (!reactor) return false;
+
+    if (flags != 0 || !m_multishotRecv || !reactor->ring->hasBufRing()) {
+        res = uringCall(*reactor, ctx, READ, timeout_ms, [=](io_uring_sqe *sqe) {
+            sqe->opcode = IORING_OP_RECV;
+            sqe->fd = fd;
+            sqe->addr = reinterpret_cast<uint64_t>(buf);
+            sqe->len = static_cast<uint32_t>(len);
+            sqe->msg_flags = static_cast<uint32_t>(flags);
+        });
+        return true;
+    }
+    if (len == 0) {
+        res = 0;
+        return true;
+    }
+
+    // multishot recv：先交付已缓冲的数据（可跨多个 buffer），读空的 buffer 立即还给内核
+    IoUring &ring = *reactor->ring;
+    Timer::ptr timer;
+    std::shared_ptr<int> token;
+    std::unique_lock<std::mutex> lock(ctx->mutex);
+    UringState &st = *ctx->uring;
+    for (;;) {
+        if (!st.chunks.empty()) {
+            size_t copied = 0;
+            while (copied < len && !st.chunks.empty()) {
+                UringState::Chunk &c = st.chunks.front();
+                size_t n = std::min<size_t>(len - copied, c.len - c.off);
+                memcpy(static_cast<char *>(buf) + copied, ring.bufAddr(c.bid) + c.off, n);
+                copied += n;
+                c.off += static_cast<uint32_t>(n);
+                if (c.off == c.len) {
+                    ring.recycleBuf(c.bid);
+                    st.chunks.pop_front();
+                }
+            }
+            res = static_cast<ssize_t>(copied);
+            break;
+        }
+        if (st.error) {
+            res = -st.error;
+            st.error = 0;
+            break;
+        }
+        if (st.eof) {
+            res = 0;
+            break;
+        }
+        if (st.timedOut) {
+            st.timedOut = false;
+            res = -ETIMEDOUT;
+            break;
+        }
+        if (st.waiter) {
+            res = -EEXIST;
+            break;
+        }
+        if (!st.multi) {
+            io_uring_sqe *sqe = uringSqe(*reactor);
+            if (!sqe) {
+                res = -EBUSY;
+                break;
+            }
+            UringRequest *req = uringAlloc(*reactor, UringRequest::MULTI_RECV, ctx);
+            sqe->opcode = IORING_OP_RECV;
+            sqe->fd = fd;
+            sqe->ioprio = IORING_RECV_MULTISHOT;
+            sqe->flags = IOSQE_BUFFER_SELECT;
+            sqe->buf_group = ring.bufGroup();
+            sqe->user_data = reinterpret_cast<uint64_t>(req);
+            st.multi = req;
+        }
+        uringWaitMulti(ctx, lock, timeout_ms, timer, token);
+    }
+    lock.unlock();
+    if (timer) timer->cancel();
+    return true;
+}
+
+bool IOManager::uringSend(int fd, const void *buf, size_t len, int flags, uint64_t timeout_ms, ssize_t &res) {
+    FdContext *ctx = getFdContext(fd, true);
+    if (!ctx) return false;
+    Reactor *reactor = uringEnter(ctx);
+    if (!reactor) return false;
+    res = uringCall(*reactor, ctx, WRITE, timeout_ms, [=](io_uring_sqe *sqe) {
+        sqe->opcode = IORING_OP_SEND;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64_t>(buf);
+        sqe->len = static_cast<uint32_t>(len);
+        sqe->msg_flags = static_cast<uint32_t>(flags);
+    });
+    return true;
+}
+
+// multishot accept：布置一次后内核持续 accept，连接排队在 st.accepted；调用方需要对端地址时用 getpeername 补上
+bool IOManager::uringAccept(int fd, sockaddr *addr, socklen_t *addrlen, int flags, uint64_t timeout_ms,
+                            ssize_t &res) {
+    FdContext *ctx = getFdContext(fd, true);
+    if (!ctx) return false;
+    Reactor *reactor = uringEnter(ctx);
+    if (!reactor) return false;
+
+    Timer::ptr timer;
+    std::shared_ptr<int> token;
+    std::unique_lock<std::mutex> lock(ctx->mutex);
+    UringState &st = *ctx->uring;
+    for (;;) {
+        if (!st.accepted.empty()) {
+            res = st.accepted.front();
+            st.accepted.pop_front();
+            break;
+        }
+        if (st.error) {
+            res = -st.error;
+            st.error = 0;
+            break;
+        }
+        if (st.timedOut) {
+            st.timedOut = false;
+            res = -ETIMEDOUT;
+            break;
+        }
+        if (st.waiter) {
+            res = -EEXIST;
+            break;
+        }
+        if (!st.multi) {
+            io_uring_sqe *sqe = uringSqe(*reactor);
+            if (!sqe) {
+                res = -EBUSY;
+                break;
+            }
+            UringRequest *req = uringAlloc(*reactor, UringRequest::MULTI_ACCEPT, ctx);
+            sqe->opcode = IORING_OP_ACCEPT;
+            sqe->fd = fd;
+            sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+            sqe->accept_flags = static_cast<uint32_t>(flags);
+            sqe->user_data = reinterpret_cast<uint64_t>(req);
+            st.multi = req;
+        }
+        uringWaitMulti(ctx, lock, timeout_ms, timer, token);
+    }
+    lock.unlock();
+    if (timer) timer->cancel();
+    if (res >= 0 && addr && addrlen && getpeername(static_cast<int>(res), addr, addrlen) == -1) *addrlen = 0;
+    return true;
+}
+
+// connect：请求可能以 -EINPROGRESS 结束（内核按 fd 的非阻塞标志执行），此时在 ring 上等可写后取 SO_ERROR
+bool IOManager::uringConnect(int fd, const sockaddr *addr, socklen_t addrlen, uint64_t timeout_ms, ssize_t &res) {
+    FdContext *ctx = getFdContext(fd, true);
+    if (!ctx) return false;
+    Reactor *reactor = uringEnter(ctx);
+    if (!reactor) return false;
+    res = uringCall(*reactor, ctx, WRITE, timeout_ms, [=](io_uring_sqe *sqe) {
+        sqe->opcode = IORING_OP_CONNECT;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64_t>(addr);
+        sqe->off = addrlen;
+    });
+    if (res == -EINPROGRESS || res == -EALREADY) {
+        res = uringWait(*reactor, ctx, WRITE, timeout_ms, [=](io_uring_sqe *sqe) {
+            sqe->opcode = IORING_OP_POLL_ADD;
+            sqe->fd = fd;
+            sqe->poll32_events = POLLOUT;
+        });
+        if (res >= 0) {
+            int error = 0;
+            socklen_t len = sizeof(error);
+            if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) == -1) error = errno;
+            res = -error;
+        }
+    }
+    return true;
+}
+
+int IOManager::uringRegisterBuffers(const iovec *iovs, unsigned n) {
+    int self = currentWorkerIndex();
+    if (!m_uring || self < 0 || static_cast<size_t>(self) >= m_reactors.size()) return -EINVAL;
+    Reactor &reactor = *m_reactors[self];
+    if (!reactor.ring) return -EOPNOTSUPP;
+    return reactor.ring->registerBuffers(iovs, n);
+}
+
+bool IOManager::uringReadFixed(int fd, void *buf, size_t len, uint16_t buf_index, uint64_t timeout_ms,
+                               ssize_t &res) {
+    FdContext *ctx = getFdContext(fd, true);
+    if (!ctx) return false;
+    Reactor *reactor = uringEnter(ctx);
+    if (!reactor) return false;
+    res = uringCall(*reactor, ctx, READ, timeout_ms, [=](io_uring_sqe *sqe) {
+        sqe->opcode = IORING_OP_READ_FIXED;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64_t>(buf);
+        sqe->len = static_cast<uint32_t>(len);
+        sqe->buf_index = buf_index;
+    });
+    return true;
+}
+
+bool IOManager::uringWriteFixed(int fd, const void *buf, size_t len, uint16_t buf_index, uint64_t timeout_ms,
+                                ssize_t &res) {
+    FdContext *ctx = getFdContext(fd, true);
+    if (!ctx) return false;
+    Reactor *reactor = uringEnter(ctx);
+    if (!reactor) return false;
+    res = uringCall(*reactor, ctx, WRITE, timeout_ms, [=](io_uring_sqe *sqe) {
+        sqe->opcode = IORING_OP_WRITE_FIXED;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64_t>(buf);
+        sqe->len = static_cast<uint32_t>(len);
+        sqe->buf_index = buf_index;
+    });
+    return true;
+}
+
+// cancelAll 的 io_uring 部分（调用方持有 ctx->mutex，reactor 为 fd 原先绑定的 reactor）
+// 1. 在途的单次请求标记 closed（等待者恢复后得到 -EBADF），multishot 请求与 fd 脱钩（之后的 CQE 只回收资源）
+// 2. 排队的连接直接关闭，缓冲的数据丢弃（buffer 还给内核）；multishot 等待者以 EBADF 唤醒
+// 3. IORING_OP_ASYNC_CANCEL 必须在 ring 所属线程提交：当前就在该线程时直接提交，否则投递一个固定在该线程的任务
+void IOManager::uringCancel(FdContext *ctx, int reactor) {
+    UringState &st = *ctx->uring;
+    std::vector<std::pair<UringRequest *, uint64_t>> reqs;
+    std::vector<uint16_t> bids;
+    for (UringRequest *op : st.ops) {
+        if (!op) continue;
+        op->closed = true;
+        reqs.emplace_back(op, op->seq);
+    }
+    if (st.multi) {
+        reqs.emplace_back(st.multi, st.multi->seq);
+        st.multi = nullptr;
+    }
+    for (const UringState::Chunk &c : st.chunks) bids.push_back(c.bid);
+    st.chunks.clear();
+    for (int fd : st.accepted) close_f(fd);
+    st.accepted.clear();
+    st.eof = false;
+    st.timedOut = false;
+    st.error = 0;
+    Fiber::ptr waiter = std::move(st.waiter);
+    if (waiter) st.error = EBADF;
+
+    std::thread::id thr = workerThreadId(static_cast<size_t>(reactor));
+    if (!reqs.empty() || !bids.empty()) {
+        if (currentWorkerIndex() == reactor) {
+            uringCancelOn(*m_reactors[reactor], reqs, bids);
+        } else {
+            scheduler([this, reactor, reqs, bids]() { uringCancelOn(*m_reactors[reactor], reqs, bids); }, thr);
+        }
+    }
+    if (waiter) scheduler(std::move(waiter), thr);
+}
+
+// 取消请求立即提交：在途的请求持有文件引用，不取消的话 close 之后连接也不会真正关闭
+void IOManager::uringCancelOn(Reactor &reactor, const std::vector<std::pair<UringRequest *, uint64_t>> &reqs,
+                              const std::vector<uint16_t> &bids) {
+    if (!reactor.ring) return;
+    for (uint16_t bid : bids) reactor.ring->recycleBuf(bid);
+    bool submitted = false;
+    for (const auto &r : reqs) {
+        if (r.first->seq != r.second) continue; // 已经完成
+        io_uring_sqe *sqe = uringSqe(reactor);
+        if (!sqe) break;
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->addr = reinterpret_cast<uint64_t>(r.first);
+        sqe->user_data = 0;
+        submitted = true;
     }
+    if (submitted) reactor.ring->submit();
 }
 
-} // namespace sunshine
\ No newline at end of file
+} // namespace sunshine
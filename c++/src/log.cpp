@@ -1,5 +1,12 @@
 #include "libs/log.h"
+#include <algorithm>
 #include <chrono>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <unistd.h>
 #include <ctime>
 #include <functional>
 #include <thread>
@@ -30,6 +37,87 @@ LogEvent::LogEvent(const std::string &logger_name,
     m_level(level) {
 }
 
+namespace {
+
+// 线程本地的可复用对象；t_local_dead 在线程退出析构之后置位（平凡类型，析构后仍可读），
+// 避免线程退出或静态析构阶段的日志访问已经析构的对象
+thread_local bool t_local_dead = false;
+struct LocalLogState {
+    LogEvent::ptr event;
+    LogStream stream;
+    uint32_t threadId = static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    ~LocalLogState() {
+        t_local_dead = true;
+    }
+};
+thread_local LocalLogState t_local_state;
+
+// 取格式化用的线程本地流（已清空）；线程退出阶段退回到 tmp 里临时构造的流
+LogStream &localStream(std::unique_ptr<LogStream> &tmp) {
+    if (t_local_dead) {
+        tmp.reset(new LogStream);
+        return *tmp;
+    }
+    t_local_state.stream.clear();
+    return t_local_state.stream;
+}
+
+} // namespace
+
+LogEvent::ptr LogEvent::Acquire(const std::string &logger_name, const char *file, int32_t line, int level) {
+    // CLOCK_REALTIME 走 vDSO（读 TSC），和 time(nullptr) 一样不进内核；
+    // 不用 CLOCK_REALTIME_COARSE：它按时钟节拍（1~4ms）更新，%us 没有意义
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t now = static_cast<uint64_t>(ts.tv_sec);
+    if (t_local_dead) {
+        auto ev = std::make_shared<LogEvent>(logger_name,
+                                             static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id())),
+                                             file, line, now, 0, "", 0, level);
+        ev->m_nsec = static_cast<uint32_t>(ts.tv_nsec);
+        return ev;
+    }
+    LocalLogState &st = t_local_state;
+    // 缓存的事件还被别人持有（例如 << 的参数里又写了一条日志）时，新建一个并替换缓存
+    if (!st.event || st.event.use_count() != 1) {
+        st.event = std::make_shared<LogEvent>(logger_name, st.threadId, file, line, now, 0, "", 0, level);
+        st.event->m_nsec = static_cast<uint32_t>(ts.tv_nsec);
+        return st.event;
+    }
+    LogEvent &ev = *st.event;
+    ev.m_file = file;
+    ev.m_elapse = 0;
+    ev.m_line = line;
+    ev.m_threadid = st.threadId;
+    ev.m_fiberid = 0;
+    ev.m_time = now;
+    ev.m_nsec = static_cast<uint32_t>(ts.tv_nsec);
+    ev.m_context.clear();
+    if (ev.m_loggerName != logger_name) ev.m_loggerName = logger_name;
+    ev.m_level = level;
+    ev.m_ss.clear();
+    return st.event;
+}
+
+const char *LogEvent::appendLiteral(const char *fmt) {
+    const char *start = fmt;
+    for (const char *p = fmt;; ++p) {
+        char c = *p;
+        if (c == '\0') {
+            m_ss.write(start, p - start);
+            return nullptr;
+        }
+        if ((c == '{' || c == '}') && p[1] == c) {
+            // "{{" / "}}"：写出到第一个花括号为止，跳过第二个
+            m_ss.write(start, p + 1 - start);
+            start = ++p + 1;
+        } else if (c == '{' && p[1] == '}') {
+            m_ss.write(start, p - start);
+            return p + 2;
+        }
+    }
+}
+
 // ---------------- LogFormatter ----------------
 LogFormatter::FormatItem::~FormatItem() = default;
 
@@ -42,10 +130,14 @@ LogFormatter::LogFormatter(const std::string &pattern) :
 // format: 根据已解析的 m_items 对 event 进行格式化
 std::string LogFormatter::format(std::shared_ptr<LogEvent> event) {
     std::ostringstream ss;
+    format(ss, event);
+    return ss.str();
+}
+
+void LogFormatter::format(std::ostream &os, const std::shared_ptr<LogEvent> &event) {
     for (auto &it : m_items) {
-        if (it) it->format(ss, event);
+        if (it) it->format(os, event);
     }
-    return ss.str();
 }
 
 // 一些 FormatItem 实现（仅在 cpp 内部可见）
@@ -54,7 +146,7 @@ public:
     StringFormatItem(const std::string &str) :
         m_string(str) {
     }
-    void format(std::ostream &os, std::shared_ptr<LogEvent>) override {
+    void format(std::ostream &os, const std::shared_ptr<LogEvent> &) override {
         os << m_string;
     }
 
@@ -64,19 +156,18 @@ private:
 
 class MessageFormatItem : public LogFormatter::FormatItem {
 public:
-    void format(std::ostream &os, std::shared_ptr<LogEvent> ev) override {
+    void format(std::ostream &os, const std::shared_ptr<LogEvent> &ev) override {
         if (ev) {
             // 优先使用流中内容，否则使用 m_context
-            std::string s = ev->getContent();
-            if (s.empty()) s = ev->m_context;
-            os << s;
+            const std::string &s = ev->getContent().empty() ? ev->m_context : ev->getContent();
+            os.write(s.data(), static_cast<std::streamsize>(s.size()));
         }
     }
 };
 
 class LevelFormatItem : public LogFormatter::FormatItem {
 public:
-    void format(std::ostream &os, std::shared_ptr<LogEvent> ev) override {
+    void format(std::ostream &os, const std::shared_ptr<LogEvent> &ev) override {
         if (!ev) return;
         os << LogLevel::toString(static_cast<LogLevel::Level>(ev->m_level));
     }
@@ -84,25 +175,45 @@ public:
 
 class ElapseFormatItem : public LogFormatter::FormatItem {
 public:
-    void format(std::ostream &os, std::shared_ptr<LogEvent> ev) override {
+    void format(std::ostream &os, const std::shared_ptr<LogEvent> &ev) override {
         if (ev) os << ev->m_elapse;
     }
 };
 
 class NameFormatItem : public LogFormatter::FormatItem {
 public:
-    void format(std::ostream &os, std::shared_ptr<LogEvent> ev) override {
+    void format(std::ostream &os, const std::shared_ptr<LogEvent> &ev) override {
         if (ev) os << ev->m_loggerName;
     }
 };
 
+// 每个线程缓存最近格式化过的日期：按 DateFormatItem 的 id 直接映射到几个槽位，
+// 同一秒内再次格式化时直接复用，不再调用 localtime_r / strftime
+// 用 id 而不是地址区分 formatter（地址在析构后可能被复用）；槽位是平凡类型，线程退出后读取也安全
+struct DateCacheSlot {
+    uint64_t id;
+    uint64_t sec;
+    uint32_t len;
+    char buf[116];
+};
+static const size_t DATE_CACHE_SLOTS = 4;
+static thread_local DateCacheSlot t_date_cache[DATE_CACHE_SLOTS];
+static std::atomic<uint64_t> s_date_item_id{1};
+
 class DateFormatItem : public LogFormatter::FormatItem {
 public:
     DateFormatItem(const std::string &fmt = "%Y-%m-%d %H:%M:%S") :
-        m_fmt(fmt.empty() ? "%Y-%m-%d %H:%M:%S" : fmt) {
+        m_fmt(fmt.empty() ? "%Y-%m-%d %H:%M:%S" : fmt),
+        m_id(s_date_item_id.fetch_add(1, std::memory_order_relaxed)) {
     }
-    void format(std::ostream &os, std::shared_ptr<LogEvent> ev) override {
+    void format(std::ostream &os, const std::shared_ptr<LogEvent> &ev) override {
         if (!ev) return;
+        DateCacheSlot &slot = t_date_cache[m_id % DATE_CACHE_SLOTS];
+        if (slot.id == m_id && slot.sec == ev->m_time) {
+            os.write(slot.buf, slot.len);
+            return;
+        }
+
         std::time_t t = static_cast<std::time_t>(ev->m_time);
         std::tm tm;
 #if defined(_WIN32) || defined(_WIN64)
@@ -111,8 +222,16 @@ public:
         localtime_r(&t, &tm);
 #endif
         char buf[256] = {0};
-        if (std::strftime(buf, sizeof(buf), m_fmt.c_str(), &tm)) {
-            os << buf;
+        size_t len = std::strftime(buf, sizeof(buf), m_fmt.c_str(), &tm);
+        if (len) {
+            os.write(buf, static_cast<std::streamsize>(len));
+            // 放不进槽位的超长结果不缓存
+            if (len <= sizeof(slot.buf)) {
+                memcpy(slot.buf, buf, len);
+                slot.len = static_cast<uint32_t>(len);
+                slot.sec = ev->m_time;
+                slot.id = m_id;
+            }
         } else {
             os << "InvalidDate";
         }
@@ -120,32 +239,55 @@ public:
 
 private:
     std::string m_fmt;
+    uint64_t m_id;
+};
+
+// %ms / %us：秒内的毫秒 / 微秒，定宽补零
+class SubSecondFormatItem : public LogFormatter::FormatItem {
+public:
+    SubSecondFormatItem(uint32_t divisor, int width) :
+        m_divisor(divisor), m_width(width) {
+    }
+    void format(std::ostream &os, const std::shared_ptr<LogEvent> &ev) override {
+        if (!ev) return;
+        uint32_t v = ev->m_nsec / m_divisor;
+        char buf[8];
+        for (int i = m_width - 1; i >= 0; --i) {
+            buf[i] = static_cast<char>('0' + v % 10);
+            v /= 10;
+        }
+        os.write(buf, m_width);
+    }
+
+private:
+    uint32_t m_divisor;
+    int m_width;
 };
 
 class ThreadIdFormatItem : public LogFormatter::FormatItem {
 public:
-    void format(std::ostream &os, std::shared_ptr<LogEvent> ev) override {
+    void format(std::ostream &os, const std::shared_ptr<LogEvent> &ev) override {
         if (ev) os << ev->m_threadid;
     }
 };
 
 class FileFormatItem : public LogFormatter::FormatItem {
 public:
-    void format(std::ostream &os, std::shared_ptr<LogEvent> ev) override {
+    void format(std::ostream &os, const std::shared_ptr<LogEvent> &ev) override {
         if (ev && ev->m_file) os << ev->m_file;
     }
 };
 
 class LineFormatItem : public LogFormatter::FormatItem {
 public:
-    void format(std::ostream &os, std::shared_ptr<LogEvent> ev) override {
+    void format(std::ostream &os, const std::shared_ptr<LogEvent> &ev) override {
         if (ev) os << ev->m_line;
     }
 };
 
 class NewLineFormatItem : public LogFormatter::FormatItem {
 public:
-    void format(std::ostream &os, std::shared_ptr<LogEvent>) override {
+    void format(std::ostream &os, const std::shared_ptr<LogEvent> &) override {
         os << std::endl;
     }
 };
@@ -186,6 +328,16 @@ void LogFormatter::init() {
             break;
         }
         char spec = p[++i];
+        // 两个字符的项：%ms / %us（优先于单字符的 %m；消息后跟字面量 s 写作 %m{}s）
+        if ((spec == 'm' || spec == 'u') && i + 1 < p.size() && p[i + 1] == 's') {
+            ++i;
+            if (spec == 'm') {
+                m_items.push_back(std::make_shared<SubSecondFormatItem>(1000000, 3));
+            } else {
+                m_items.push_back(std::make_shared<SubSecondFormatItem>(1000, 6));
+            }
+            continue;
+        }
         std::string fmt;
         if (i + 1 < p.size() && p[i + 1] == '{') {
             size_t j = i + 2;
@@ -225,14 +377,19 @@ void StdoutLogAppender::log(LogLevel::Level level, std::shared_ptr<LogEvent> eve
         f = s_def;
     }
 
+    // 在锁外格式化到线程本地缓冲区
+    std::unique_ptr<LogStream> tmp;
+    LogStream &out = localStream(tmp);
+    if (f) {
+        f->format(out, event);
+    } else {
+        out << event->getContent() << '\n';
+    }
+
     // 控制台输出需要保证行不混杂，故在 appender 层互斥写入
     {
         std::lock_guard<std::mutex> lk(m_mutex);
-        if (f) {
-            std::cout << f->format(event);
-        } else {
-            std::cout << event->getContent() << std::endl;
-        }
+        std::cout.write(out.str().data(), static_cast<std::streamsize>(out.str().size()));
     }
 }
 
@@ -259,23 +416,324 @@ void FileoutAppender::log(LogLevel::Level level, std::shared_ptr<LogEvent> event
         f = s_def;
     }
 
+    std::unique_ptr<LogStream> tmp;
+    LogStream &out = localStream(tmp);
+    if (f) {
+        f->format(out, event);
+    } else {
+        out << event->getContent() << '\n';
+    }
+
     // 在文件流操作上加锁，确保同一文件的写入串行化
     std::lock_guard<std::mutex> lk(m_file_mutex);
     if (!m_filestream.is_open()) {
         if (!reopen()) return;
     }
+    m_filestream.write(out.str().data(), static_cast<std::streamsize>(out.str().size()));
+    // 注意：可以考虑 flush 策略（按行 flush、定时 flush、或不 flush 由后台线程处理）
+}
+
+// ---------------- AsyncLogAppender ----------------
+// 每个生产者线程一个的字节环：head 只由后台线程推进，tail 只由所属线程推进
+// head / tail 是单调递增的字节计数，取模即为在 buf 里的位置
+struct AsyncLogAppender::Ring {
+    explicit Ring(size_t cap) :
+        buf(new char[cap]), mask(cap - 1) {
+    }
+    size_t capacity() const {
+        return mask + 1;
+    }
+
+    std::unique_ptr<char[]> buf;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+    std::atomic<bool> closed{false}; // 所属线程已退出，写空后由后台线程摘除
+};
+
+namespace {
+
+// 线程本地：本线程在各个 AsyncLogAppender 上注册过的环
+struct LocalRings {
+    std::vector<std::pair<uint64_t, std::shared_ptr<AsyncLogAppender::Ring>>> rings;
+    ~LocalRings() {
+        for (auto &it : rings) it.second->closed.store(true, std::memory_order_release);
+    }
+};
+thread_local LocalRings t_local_rings;
+
+std::atomic<uint64_t> s_async_appender_id{1};
+
+// 写满为止（处理 EINTR 和部分写）；失败直接放弃这一批，日志不值得无限重试
+void writevAll(int fd, struct iovec *iov, int cnt) {
+    while (cnt > 0) {
+        ssize_t n = ::writev(fd, iov, cnt);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        while (cnt > 0 && static_cast<size_t>(n) >= iov->iov_len) {
+            n -= static_cast<ssize_t>(iov->iov_len);
+            ++iov;
+            --cnt;
+        }
+        if (cnt > 0) {
+            iov->iov_base = static_cast<char *>(iov->iov_base) + n;
+            iov->iov_len -= static_cast<size_t>(n);
+        }
+    }
+}
+
+} // namespace
+
+AsyncLogAppender::AsyncLogAppender(const std::string &filename, size_t ring_size, uint32_t flush_interval_ms,
+                                   OverflowPolicy policy) :
+    m_id(s_async_appender_id.fetch_add(1, std::memory_order_relaxed)),
+    m_filename(filename),
+    m_flushInterval(flush_interval_ms ? flush_interval_ms : 1),
+    m_policy(policy) {
+    size_t cap = 4096;
+    while (cap < ring_size) cap <<= 1;
+    m_ringSize = cap;
+    reopen();
+    m_thread = std::thread([this]() { run(); });
+}
+
+AsyncLogAppender::~AsyncLogAppender() {
+    {
+        std::lock_guard<std::mutex> lk(m_waitMutex);
+        m_stop = true;
+    }
+    m_cond.notify_one();
+    if (m_thread.joinable()) m_thread.join();
+    if (m_fd >= 0 && m_fd != STDOUT_FILENO) ::close(m_fd);
+}
+
+bool AsyncLogAppender::reopen() {
+    if (m_filename.empty()) {
+        m_fd = STDOUT_FILENO;
+        return true;
+    }
+    int fd = ::open(m_filename.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    std::lock_guard<std::mutex> lk(m_fdMutex);
+    if (m_fd >= 0) ::close(m_fd);
+    m_fd = fd;
+    return true;
+}
+
+// 取本线程在当前 appender 上的环，第一次调用时创建并注册
+// 顺便清掉已经被析构的 appender 留下的环（只剩线程本地这一份引用）
+AsyncLogAppender::Ring *AsyncLogAppender::localRing() {
+    auto &rings = t_local_rings.rings;
+    for (auto &it : rings) {
+        if (it.first == m_id) return it.second.get();
+    }
+    for (auto it = rings.begin(); it != rings.end();) {
+        if (it->second.use_count() == 1) {
+            it = rings.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    auto ring = std::make_shared<Ring>(m_ringSize);
+    {
+        std::lock_guard<std::mutex> lk(m_ringsMutex);
+        m_rings.push_back(ring);
+    }
+    rings.emplace_back(m_id, ring);
+    return ring.get();
+}
+
+void AsyncLogAppender::wakeup() {
+    if (m_signaled.load(std::memory_order_relaxed) || m_signaled.exchange(true)) return;
+    std::lock_guard<std::mutex> lk(m_waitMutex);
+    m_cond.notify_one();
+}
+
+// 把一行放进环：空间不够时按策略丢弃或等待后台线程写出
+bool AsyncLogAppender::push(Ring &ring, const char *data, size_t len) {
+    const size_t cap = ring.capacity();
+    size_t tail = ring.tail.load(std::memory_order_relaxed);
+    size_t head = ring.head.load(std::memory_order_acquire);
+    while (cap - (tail - head) < len) {
+        wakeup();
+        if (m_policy == DROP) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        {
+            std::unique_lock<std::mutex> lk(m_waitMutex);
+            m_spaceCond.wait_for(lk, std::chrono::milliseconds(1));
+        }
+        head = ring.head.load(std::memory_order_acquire);
+    }
+
+    size_t pos = tail & ring.mask;
+    size_t first = std::min(len, cap - pos);
+    memcpy(ring.buf.get() + pos, data, first);
+    if (first < len) memcpy(ring.buf.get(), data + first, len - first);
+    ring.tail.store(tail + len, std::memory_order_release);
+
+    // 超过半满就提前唤醒后台线程，不等 flush 间隔
+    if (tail + len - head > cap / 2) wakeup();
+    return true;
+}
+
+void AsyncLogAppender::writeAll(const char *data, size_t len) {
+    struct iovec iov;
+    iov.iov_base = const_cast<char *>(data);
+    iov.iov_len = len;
+    std::lock_guard<std::mutex> lk(m_fdMutex);
+    if (m_fd >= 0) writevAll(m_fd, &iov, 1);
+}
+
+void AsyncLogAppender::log(LogLevel::Level level, std::shared_ptr<LogEvent> event) {
+    if (level < getLevel()) return;
+
+    LogFormatter::ptr f = getFormatter();
+    if (!f && event) {
+        static LogFormatter::ptr s_def = std::make_shared<LogFormatter>();
+        f = s_def;
+    }
+    std::unique_ptr<LogStream> tmp;
+    LogStream &out = localStream(tmp);
     if (f) {
-        m_filestream << f->format(event);
+        f->format(out, event);
     } else {
-        m_filestream << event->getContent() << std::endl;
+        out << event->getContent() << '\n';
+    }
+    const std::string &line = out.str();
+
+    Ring *ring = localRing();
+    if (line.size() <= ring->capacity()) {
+        push(*ring, line.data(), line.size());
+        return;
+    }
+    // 比整个环还大的行：DROP 直接丢弃；BLOCK 等本线程之前的日志写完后直接写出，保持线程内顺序
+    if (m_policy == DROP) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    while (ring->head.load(std::memory_order_acquire) != ring->tail.load(std::memory_order_relaxed)) {
+        wakeup();
+        std::unique_lock<std::mutex> lk(m_waitMutex);
+        m_spaceCond.wait_for(lk, std::chrono::milliseconds(1));
+    }
+    writeAll(line.data(), line.size());
+}
+
+// 一轮写出：把每个环 [head, tail) 的内容收集成 iovec（环绕时拆成两段），凑满 IOV_MAX 就 writev 一次
+// 返回是否写出了数据
+bool AsyncLogAppender::drain() {
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+        std::lock_guard<std::mutex> lk(m_ringsMutex);
+        rings = m_rings;
+    }
+
+    struct iovec iov[IOV_MAX];
+    int cnt = 0;
+    std::vector<std::pair<Ring *, size_t>> commits; // 本批写完后各环的新 head
+    bool wrote = false;
+    bool has_closed = false;
+
+    auto flushBatch = [&]() {
+        if (cnt > 0) {
+            std::lock_guard<std::mutex> lk(m_fdMutex);
+            if (m_fd >= 0) writevAll(m_fd, iov, cnt);
+        }
+        for (auto &c : commits) c.first->head.store(c.second, std::memory_order_release);
+        cnt = 0;
+        commits.clear();
+    };
+
+    for (auto &ring : rings) {
+        // 先读 closed 再读 tail：线程退出前写入的内容一定能在这一轮看到
+        bool closed = ring->closed.load(std::memory_order_acquire);
+        has_closed |= closed;
+        size_t tail = ring->tail.load(std::memory_order_acquire);
+        size_t head = ring->head.load(std::memory_order_relaxed);
+        if (tail == head) continue;
+        if (cnt + 2 > IOV_MAX) flushBatch();
+
+        size_t cap = ring->capacity();
+        size_t pos = head & ring->mask;
+        size_t len = tail - head;
+        size_t first = std::min(len, cap - pos);
+        iov[cnt].iov_base = ring->buf.get() + pos;
+        iov[cnt].iov_len = first;
+        ++cnt;
+        if (first < len) {
+            iov[cnt].iov_base = ring->buf.get();
+            iov[cnt].iov_len = len - first;
+            ++cnt;
+        }
+        commits.emplace_back(ring.get(), tail);
+        wrote = true;
+    }
+    flushBatch();
+
+    if (has_closed) {
+        std::lock_guard<std::mutex> lk(m_ringsMutex);
+        for (auto it = m_rings.begin(); it != m_rings.end();) {
+            Ring &r = **it;
+            if (r.closed.load(std::memory_order_acquire) &&
+                r.head.load(std::memory_order_relaxed) == r.tail.load(std::memory_order_acquire)) {
+                it = m_rings.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    return wrote;
+}
+
+// 后台线程：等 flush 间隔或被唤醒，写出一轮后通知等待空间的生产者
+void AsyncLogAppender::run() {
+    for (;;) {
+        bool stop;
+        {
+            std::unique_lock<std::mutex> lk(m_waitMutex);
+            m_cond.wait_for(lk, std::chrono::milliseconds(m_flushInterval),
+                            [this]() { return m_stop || m_signaled.load(std::memory_order_relaxed); });
+            m_signaled.store(false, std::memory_order_relaxed);
+            stop = m_stop;
+        }
+        drain();
+        {
+            std::lock_guard<std::mutex> lk(m_waitMutex);
+            m_spaceCond.notify_all();
+        }
+        if (stop) {
+            while (drain()) {
+            }
+            return;
+        }
+    }
+}
+
+// 记下调用时各环的 tail，等后台线程把它们都写出
+void AsyncLogAppender::flush() {
+    std::vector<std::pair<std::shared_ptr<Ring>, size_t>> targets;
+    {
+        std::lock_guard<std::mutex> lk(m_ringsMutex);
+        for (auto &ring : m_rings) targets.emplace_back(ring, ring->tail.load(std::memory_order_acquire));
+    }
+    for (auto &t : targets) {
+        while (t.first->head.load(std::memory_order_acquire) < t.second) {
+            wakeup();
+            std::unique_lock<std::mutex> lk(m_waitMutex);
+            m_spaceCond.wait_for(lk, std::chrono::milliseconds(1));
+        }
     }
-    // 注意：可以考虑 flush 策略（按行 flush、定时 flush、或不 flush 由后台线程处理）
 }
 
 // ---------------- Logger ----------------
 // 构造函数
 Logger::Logger(const std::string &name) :
-    m_name(name) {
+    m_name(name),
+    m_appenders(std::make_shared<AppenderList>()) {
     m_formatter = std::make_shared<LogFormatter>(); // 默认格式器
 }
 
@@ -283,14 +741,14 @@ Logger::Logger(const std::string &name) :
 void Logger::log(LogLevel::Level level, std::shared_ptr<LogEvent> event) {
     if (level < getLevel()) return;
 
-    // 1) 读锁保护读取 appenders（读多写少），并复制到本地，尽快释放锁
+    // 1) 读锁保护读取 appenders（读多写少），只复制列表的 shared_ptr，尽快释放锁
     std::shared_lock<std::shared_mutex> sl(m_mutex);
-    auto appenders = m_appenders;        // 复制共享指针容器（快）
+    std::shared_ptr<const AppenderList> appenders = m_appenders;
     auto logger_formatter = m_formatter; // 复制默认 formatter
     sl.unlock();
 
     // 2) 在没有持有 logger 的情况下对每个 appender 做输出（appender 内部自己负责同步）
-    for (auto &app : appenders) {
+    for (auto &app : *appenders) {
         if (!app) continue;
         if (!app->getFormatter()) {
             app->setFormatter(logger_formatter);
@@ -316,26 +774,33 @@ void Logger::fatal(std::shared_ptr<LogEvent> event) {
     log(LogLevel::FATAL, event);
 }
 
-// add/del appender: 写操作使用独占锁
+// add/del appender: 写操作使用独占锁，复制一份新列表替换（正在输出的线程继续用旧列表）
 void Logger::addAppender(LogAppender::ptr appender) {
     std::unique_lock<std::shared_mutex> ul(m_mutex);
-    m_appenders.push_back(appender);
+    auto list = std::make_shared<AppenderList>(*m_appenders);
+    list->push_back(appender);
+    m_appenders = list;
 }
 void Logger::delAppender(LogAppender::ptr appender) {
     std::unique_lock<std::shared_mutex> ul(m_mutex);
-    m_appenders.remove(appender);
+    auto list = std::make_shared<AppenderList>(*m_appenders);
+    list->erase(std::remove(list->begin(), list->end(), appender), list->end());
+    m_appenders = list;
 }
 
 // ---------------- LogEventWrap ----------------
 // RAII 帮助类，析构时把内容发给 Logger
 LogEventWrap::LogEventWrap(Logger::ptr logger, std::shared_ptr<LogEvent> event) :
-    m_logger(logger), m_event(event) {
+    m_logger(logger.get()), m_owner(std::move(logger)), m_event(std::move(event)) {
+}
+
+LogEventWrap::LogEventWrap(const Logger::ptr &logger, LogLevel::Level level, const char *file, int32_t line) :
+    m_logger(logger.get()), m_event(LogEvent::Acquire(logger->getName(), file, line, level)) {
 }
 
+// MessageFormatItem 直接读流中的内容，不再复制到 m_context
 LogEventWrap::~LogEventWrap() {
     if (m_logger && m_event) {
-        // 将流内容复制到 m_context（以兼容旧 formatter）
-        m_event->m_context = m_event->getContent();
         m_logger->log(static_cast<LogLevel::Level>(m_event->m_level), m_event);
     }
 }
@@ -0,0 +1,196 @@
+// file: libs/metrics.cpp
+#include "libs/metrics.h"
+
+#include <cstdio>
+#include <unordered_map>
+#include <utility>
+
+namespace sunshine {
+
+namespace {
+
+// 一个调度器的快照与它导出时使用的（已转义、去重的）名字
+typedef std::vector<std::pair<std::string, const Scheduler::Metrics *>> Entries;
+
+// 标签值转义：反斜杠、双引号、换行
+std::string EscapeLabel(const std::string &v) {
+    std::string out;
+    out.reserve(v.size());
+    for (char c : v) {
+        if (c == '\\') {
+            out += "\\\\";
+        } else if (c == '"') {
+            out += "\\\"";
+        } else if (c == '\n') {
+            out += "\\n";
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+void AppendDouble(std::string &out, double v) {
+    char buf[32];
+    int n = std::snprintf(buf, sizeof(buf), "%.9g", v);
+    out.append(buf, n);
+}
+
+void Family(std::string &out, const char *name, const char *type, const char *help) {
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+// name{scheduler="x"[,thread="i"][,le="b"]} value
+void Sample(std::string &out, const char *name, const char *suffix, const std::string &sched, const char *thread,
+            const char *le) {
+    out += name;
+    out += suffix;
+    out += "{scheduler=\"";
+    out += sched;
+    if (thread) {
+        out += "\",thread=\"";
+        out += thread;
+    }
+    if (le) {
+        out += "\",le=\"";
+        out += le;
+    }
+    out += "\"} ";
+}
+
+// 每线程计数器：thread="0".."N-1"，use_caller 时最后一个线程为 "caller"
+void ThreadCounter(std::string &out, const Entries &all, const char *name, const char *help,
+                   uint64_t Scheduler::ThreadStats::*field) {
+    Family(out, name, "counter", help);
+    for (const auto &e : all) {
+        const Scheduler::Metrics &m = *e.second;
+        for (size_t i = 0; i < m.workers.size(); ++i) {
+            std::string thread = m.useCaller && i + 1 == m.workers.size() ? "caller" : std::to_string(i);
+            Sample(out, name, "", e.first, thread.c_str(), nullptr);
+            out += std::to_string(m.workers[i].*field);
+            out += '\n';
+        }
+    }
+}
+
+template <class Get>
+void SchedulerValue(std::string &out, const Entries &all, const char *name, const char *type, const char *help,
+                    Get get) {
+    Family(out, name, type, help);
+    for (const auto &e : all) {
+        Sample(out, name, "", e.first, nullptr, nullptr);
+        out += std::to_string(get(*e.second));
+        out += '\n';
+    }
+}
+
+// 直方图：buckets 为各桶的计数（最后一桶是溢出），bound(k) 给出第 k 桶的上界
+template <size_t N, class Bound>
+void Histogram(std::string &out, const char *name, const std::string &sched, const uint64_t (&buckets)[N],
+               Bound bound, double sum) {
+    uint64_t cum = 0;
+    for (size_t k = 0; k < N; ++k) {
+        cum += buckets[k];
+        std::string le = "+Inf";
+        if (k + 1 < N) {
+            le.clear();
+            AppendDouble(le, bound(k));
+        }
+        Sample(out, name, "_bucket", sched, nullptr, le.c_str());
+        out += std::to_string(cum);
+        out += '\n';
+    }
+    Sample(out, name, "_sum", sched, nullptr, nullptr);
+    AppendDouble(out, sum);
+    out += '\n';
+    Sample(out, name, "_count", sched, nullptr, nullptr);
+    out += std::to_string(cum);
+    out += '\n';
+}
+
+} // namespace
+
+void RenderPrometheus(const std::vector<Scheduler::Metrics> &all, std::string &out) {
+    Entries entries;
+    std::unordered_map<std::string, size_t> seen;
+    for (const auto &m : all) {
+        std::string name = EscapeLabel(m.name);
+        size_t n = ++seen[name];
+        if (n > 1) name += "#" + std::to_string(n);
+        entries.emplace_back(std::move(name), &m);
+    }
+
+    SchedulerValue(out, entries, "sunshine_scheduler_threads", "gauge", "Threads running the scheduler loop.",
+                   [](const Scheduler::Metrics &m) { return m.threads; });
+    SchedulerValue(out, entries, "sunshine_scheduler_active_threads", "gauge", "Threads currently running a task.",
+                   [](const Scheduler::Metrics &m) { return m.active; });
+    SchedulerValue(out, entries, "sunshine_scheduler_idle_threads", "gauge",
+                   "Threads currently idle (waiting or polling for I/O).",
+                   [](const Scheduler::Metrics &m) { return m.idle; });
+    SchedulerValue(out, entries, "sunshine_scheduler_queued_tasks", "gauge", "Tasks waiting in any run queue.",
+                   [](const Scheduler::Metrics &m) { return m.queued; });
+
+    ThreadCounter(out, entries, "sunshine_scheduler_tasks_total", "Tasks run.", &Scheduler::ThreadStats::tasks);
+    ThreadCounter(out, entries, "sunshine_scheduler_fiber_resumes_total",
+                  "Tasks that resumed an existing fiber rather than running a callback.",
+                  &Scheduler::ThreadStats::fiberResumes);
+    ThreadCounter(out, entries, "sunshine_scheduler_steal_attempts_total",
+                  "Attempts to take a task from another thread's non-empty local queue.",
+                  &Scheduler::ThreadStats::stealAttempts);
+    ThreadCounter(out, entries, "sunshine_scheduler_steals_total", "Tasks taken from another thread's local queue.",
+                  &Scheduler::ThreadStats::steals);
+    ThreadCounter(out, entries, "sunshine_scheduler_tickles_sent_total", "Wakeups sent by this thread.",
+                  &Scheduler::ThreadStats::ticklesSent);
+    ThreadCounter(out, entries, "sunshine_scheduler_tickles_received_total", "Wakeups received by this thread.",
+                  &Scheduler::ThreadStats::ticklesReceived);
+    SchedulerValue(out, entries, "sunshine_scheduler_external_tickles_total", "counter",
+                   "Wakeups sent by threads that do not belong to the scheduler.",
+                   [](const Scheduler::Metrics &m) { return m.externalTickles; });
+    ThreadCounter(out, entries, "sunshine_scheduler_spin_hits_total",
+                  "Idle spins that found a task before sleeping.", &Scheduler::ThreadStats::spinHits);
+    ThreadCounter(out, entries, "sunshine_scheduler_spin_timeouts_total",
+                  "Idle spins that used up their budget and went to sleep.", &Scheduler::ThreadStats::spinTimeouts);
+    ThreadCounter(out, entries, "sunshine_iomanager_wakeups_total", "Returns from epoll_wait / io_uring_enter.",
+                  &Scheduler::ThreadStats::wakeups);
+    ThreadCounter(out, entries, "sunshine_iomanager_events_total", "Events returned by reactor wakeups.",
+                  &Scheduler::ThreadStats::wakeupEvents);
+
+    const char *wait = "sunshine_scheduler_queue_wait_seconds";
+    Family(out, wait, "histogram", "Time from enqueue until a thread starts running the task (sampled).");
+    for (const auto &e : entries) {
+        const Scheduler::ThreadStats &t = e.second->total;
+        Histogram(out, wait, e.first, t.queueWait, [](size_t k) { return static_cast<double>(1ull << k) * 1e-6; },
+                  static_cast<double>(t.queueWaitNs) * 1e-9);
+    }
+    const char *events = "sunshine_iomanager_events_per_wakeup";
+    Family(out, events, "histogram", "Events returned by one epoll_wait / io_uring_enter.");
+    for (const auto &e : entries) {
+        const Scheduler::ThreadStats &t = e.second->total;
+        Histogram(out, events, e.first, t.eventsPerWakeup,
+                  [](size_t k) { return static_cast<double>((1ull << k) - 1); },
+                  static_cast<double>(t.wakeupEvents));
+    }
+}
+
+std::string RenderPrometheus() {
+    std::vector<Scheduler::Metrics> all;
+    Scheduler::GetAllMetrics(all);
+    std::string out;
+    RenderPrometheus(all, out);
+    return out;
+}
+
+void MetricsServlet::handle(const HttpRequest &, HttpResponse &rsp, const Socket::ptr &) {
+    rsp.setHeader("Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+    rsp.setBody(RenderPrometheus());
+}
+
+} // namespace sunshine
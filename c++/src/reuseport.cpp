@@ -0,0 +1,51 @@
+// file: libs/reuseport.cpp
+#include "libs/reuseport.h"
+#include "libs/fd_manager.h"
+#include "libs/hook.h"
+#include <errno.h>
+#include <linux/filter.h>
+#include <unistd.h>
+
+namespace sunshine {
+
+int ReusePortListen(const sockaddr *addr, socklen_t addrlen, int backlog) {
+    int fd = socket_f(addr->sa_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) return -1;
+
+    int on = 1;
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) == -1 ||
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) == -1 || ::bind(fd, addr, addrlen) == -1 ||
+        ::listen(fd, backlog) == -1) {
+        int err = errno;
+        close_f(fd);
+        errno = err;
+        return -1;
+    }
+    // 新 fd 的编号可能属于一个没有经过 hook close 关闭的旧 socket，先丢弃旧的上下文
+    FdManager::GetInstance().del(fd);
+    FdManager::GetInstance().get(fd, true);
+    return fd;
+}
+
+bool AttachReusePortCpuSteering(int fd, uint32_t groups) {
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+    if (groups == 0) return false;
+    // A = 当前 CPU；A %= groups；返回 A 作为组内下标
+    sock_filter code[] = {
+        {BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)},
+        {BPF_ALU | BPF_MOD | BPF_K, 0, 0, groups},
+        {BPF_RET | BPF_A, 0, 0, 0},
+    };
+    sock_fprog prog{};
+    prog.len = sizeof(code) / sizeof(code[0]);
+    prog.filter = code;
+    return setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) == 0;
+#else
+    (void)fd;
+    (void)groups;
+    errno = ENOPROTOOPT;
+    return false;
+#endif
+}
+
+} // namespace sunshine
@@ -0,0 +1,469 @@
+// file: libs/rpc.cpp
+#include "libs/rpc.h"
+#include "libs/Config.h"
+#include "libs/fd_manager.h"
+#include "libs/log.h"
+#include "libs/timer.h"
+
+#include <iterator>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <utility>
+#include <vector>
+
+namespace sunshine {
+
+static Logger::ptr g_logger = std::make_shared<Logger>("system");
+
+static ConfigVar<uint32_t>::ptr g_max_frame_size =
+    Config::Lookup<uint32_t>("rpc.max_frame_size", 16 * 1024 * 1024, "max bytes of one RPC frame after the head");
+static ConfigVar<uint64_t>::ptr g_call_timeout =
+    Config::Lookup<uint64_t>("rpc.call_timeout", 3000, "default RpcClient::call timeout in ms");
+
+// 每次 recv 最多读多少：多路复用时一次能取到很多帧
+static const size_t RPC_RECV_CHUNK = 64 * 1024;
+
+static inline size_t VarintSize(uint64_t v) {
+    size_t n = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        ++n;
+    }
+    return n;
+}
+
+// ---------- RpcCodec ----------
+
+static void WriteHead(ByteArray &out, uint8_t type, size_t len) {
+    out.writeFuint8(RpcCodec::MAGIC);
+    out.writeFuint8(RpcCodec::VERSION);
+    out.writeFuint8(type);
+    out.writeFuint8(0); // flags，保留
+    out.writeFuint32(static_cast<uint32_t>(len));
+}
+
+size_t RpcCodec::RequestSize(uint64_t id, std::string_view method, std::string_view payload) {
+    return VarintSize(id) + VarintSize(method.size()) + method.size() + payload.size();
+}
+
+size_t RpcCodec::ResponseSize(uint64_t id, uint32_t status, std::string_view payload) {
+    return VarintSize(id) + VarintSize(status) + payload.size();
+}
+
+void RpcCodec::EncodeRequest(ByteArray &out, RpcMessage::Type type, uint64_t id, std::string_view method,
+                             std::string_view payload) {
+    WriteHead(out, type, RequestSize(id, method, payload));
+    out.writeUint64(id);
+    out.writeUint64(method.size());
+    out.write(method.data(), method.size());
+    if (!payload.empty()) out.write(payload.data(), payload.size());
+}
+
+void RpcCodec::EncodeResponse(ByteArray &out, uint64_t id, uint32_t status, std::string_view payload) {
+    WriteHead(out, RpcMessage::RESPONSE, ResponseSize(id, status, payload));
+    out.writeUint64(id);
+    out.writeUint32(status);
+    if (!payload.empty()) out.write(payload.data(), payload.size());
+}
+
+RpcCodec::Result RpcCodec::Decode(ByteArray &in, RpcMessage &msg, uint32_t max_frame) {
+    if (in.getReadSize() < HEAD_SIZE) return NEED_MORE;
+    size_t pos = in.getPosition();
+    uint8_t magic = in.readFuint8();
+    uint8_t version = in.readFuint8();
+    uint8_t type = in.readFuint8();
+    in.readFuint8();
+    uint32_t len = in.readFuint32();
+    if (magic != MAGIC || version != VERSION || type < RpcMessage::REQUEST || type > RpcMessage::ONEWAY ||
+        len > max_frame) {
+        return ERROR;
+    }
+    if (in.getReadSize() < len) {
+        in.setPosition(pos);
+        return NEED_MORE;
+    }
+
+    // 帧已经完整：varint 字段越过帧尾（或缓冲区尾）都是非法帧
+    size_t end = pos + HEAD_SIZE + len;
+    try {
+        msg.type = static_cast<RpcMessage::Type>(type);
+        msg.id = in.readUint64();
+        if (msg.type == RpcMessage::RESPONSE) {
+            msg.status = in.readUint32();
+            msg.method.clear();
+        } else {
+            uint64_t n = in.readUint64();
+            if (in.getPosition() > end || n > end - in.getPosition()) return ERROR;
+            msg.status = RPC_OK;
+            msg.method.resize(n);
+            in.read(&msg.method[0], n);
+        }
+    } catch (const std::out_of_range &) {
+        return ERROR;
+    }
+    if (in.getPosition() > end) return ERROR;
+    if (in.getPosition() == end) {
+        msg.payload.clear();
+    } else {
+        msg.payload = in.readSlice(end - in.getPosition());
+    }
+    return DONE;
+}
+
+// ---------- 接收缓冲区 ----------
+
+namespace {
+// recv 追加到末尾，从上次停下的位置继续解帧；缓冲区里没有未完成的帧时直接 clear（块还给 BufferPool），
+// 未完成的帧前面积了至少一个块的已处理数据时把它搬到开头（交出去的负载切片持有块的引用，不受影响）
+class FrameReader {
+public:
+    FrameReader() :
+        m_maxFrame(g_max_frame_size->getValue()) {
+        m_in.setIsLittleEndian(false);
+    }
+
+    // 读一次，对每个完整的帧调用 on_frame(RpcMessage&)（可以把字段 move 走）；
+    // 连接关闭、出错或读到非法帧时返回 false
+    template <class F>
+    bool readOnce(Socket &sock, F &&on_frame) {
+        m_in.setPosition(m_end);
+        int n = sock.recv(m_in, RPC_RECV_CHUNK);
+        if (n <= 0) return false;
+        m_end += n;
+        m_in.setPosition(m_parsed);
+
+        RpcCodec::Result r;
+        while ((r = RpcCodec::Decode(m_in, m_msg, m_maxFrame)) == RpcCodec::DONE) on_frame(m_msg);
+        if (r == RpcCodec::ERROR) {
+            LOG_DEBUG(g_logger) << "RpcCodec bad frame from " << sock.getRemoteAddress()->toString();
+            return false;
+        }
+
+        m_parsed = m_in.getPosition();
+        if (m_parsed == m_end) {
+            m_in.clear();
+            m_end = m_parsed = 0;
+        } else if (m_parsed >= m_in.getBaseSize()) {
+            std::string carry(m_end - m_parsed, '\0');
+            m_in.read(&carry[0], carry.size(), m_parsed);
+            m_in.clear();
+            m_in.write(carry.data(), carry.size());
+            m_end = carry.size();
+            m_parsed = 0;
+        }
+        return true;
+    }
+
+private:
+    ByteArray m_in;
+    RpcMessage m_msg;
+    size_t m_end = 0;
+    size_t m_parsed = 0;
+    uint32_t m_maxFrame;
+};
+} // namespace
+
+// ---------- RpcSession ----------
+
+RpcSession::RpcSession(Socket::ptr sock, IOManager *iom) :
+    m_sock(std::move(sock)), m_iom(iom), m_maxFrame(g_max_frame_size->getValue()), m_queue(std::make_unique<ByteArray>()),
+    m_writing(std::make_unique<ByteArray>()) {
+    m_queue->setIsLittleEndian(false);
+    m_writing->setIsLittleEndian(false);
+}
+
+void RpcSession::start() {
+    auto self = shared_from_this();
+    m_iom->scheduler([self]() { self->sendLoop(); });
+}
+
+// shutdown 在锁内完成：发送协程看到 m_closed 之后才会退出并释放 socket，不会 shutdown 到被复用的 fd 上
+void RpcSession::close() {
+    Fiber::ptr wake;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_closed) return;
+        m_closed = true;
+        ::shutdown(m_sock->getSocket(), SHUT_RDWR);
+        if (m_sendIdle) {
+            m_sendIdle = false;
+            wake = m_sendFiber;
+        }
+    }
+    if (wake) m_iom->scheduler(std::move(wake));
+}
+
+bool RpcSession::isClosed() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_closed;
+}
+
+template <class Encode>
+bool RpcSession::enqueue(Encode &&encode) {
+    Fiber::ptr wake;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_closed) return false;
+        encode(*m_queue);
+        ++m_queued;
+        if (m_sendIdle) {
+            m_sendIdle = false;
+            wake = m_sendFiber;
+        }
+    }
+    if (wake) m_iom->scheduler(std::move(wake));
+    return true;
+}
+
+bool RpcSession::sendRequest(RpcMessage::Type type, uint64_t id, std::string_view method, std::string_view payload) {
+    if (RpcCodec::RequestSize(id, method, payload) > m_maxFrame) return false;
+    return enqueue([&](ByteArray &out) { RpcCodec::EncodeRequest(out, type, id, method, payload); });
+}
+
+bool RpcSession::sendResponse(uint64_t id, uint32_t status, std::string_view payload) {
+    if (RpcCodec::ResponseSize(id, status, payload) > m_maxFrame) return false;
+    return enqueue([&](ByteArray &out) { RpcCodec::EncodeResponse(out, id, status, payload); });
+}
+
+// 队列为空时挂起，由 enqueue / close 重新调度（被调度时可能还没让出，Fiber::swapIn 会等上下文保存完）
+void RpcSession::sendLoop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_sendFiber = Fiber::GetThis()->shared_from_this();
+    }
+    for (;;) {
+        uint64_t frames = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (!m_queued && !m_closed) {
+                m_sendIdle = true;
+                lock.unlock();
+                Fiber::YieldToHold();
+                lock.lock();
+            }
+            if (m_closed) break;
+            std::swap(m_queue, m_writing);
+            frames = m_queued;
+            m_queued = 0;
+        }
+
+        bool ok = true;
+        m_writing->setPosition(0);
+        while (m_writing->getReadSize() > 0) {
+            m_writes.fetch_add(1, std::memory_order_relaxed);
+            if (m_sock->send(*m_writing) <= 0) {
+                ok = false;
+                break;
+            }
+        }
+        m_writing->clear();
+        m_frames.fetch_add(frames, std::memory_order_relaxed);
+        if (!ok) {
+            close();
+            break;
+        }
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_sendIdle = false;
+    m_sendFiber.reset();
+}
+
+// ---------- RpcClient ----------
+
+RpcClient::RpcClient(IOManager *iom) :
+    m_iom(iom) {
+}
+
+RpcClient::~RpcClient() {
+    close();
+}
+
+bool RpcClient::connect(Address::ptr addr, uint64_t timeout_ms) {
+    if (isConnected()) return false;
+    Socket::ptr sock = std::make_shared<Socket>(addr->getFamily(), SOCK_STREAM, 0);
+    if (!sock->connect(addr, timeout_ms)) return false;
+    // 在普通线程里 connect 时 socket 还不归 hook 管理：登记到 FdManager（系统层改为非阻塞），
+    // 接收 / 发送协程的读写才会挂起协程而不是阻塞 iom 的线程
+    FdManager::GetInstance().get(sock->getSocket(), true);
+
+    auto session = std::make_shared<RpcSession>(sock, m_iom);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_connected) return false;
+        m_session = session;
+        m_connected = true;
+    }
+    session->start();
+    auto self = shared_from_this();
+    m_iom->scheduler([self, session]() { self->recvLoop(session); });
+    return true;
+}
+
+void RpcClient::close() {
+    RpcSession::ptr session;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        session = m_session;
+    }
+    if (session) session->close();
+}
+
+bool RpcClient::isConnected() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_connected;
+}
+
+size_t RpcClient::getPendingCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_calls.size();
+}
+
+// 等待项先登记再发送：响应可能在 sendRequest 返回之前就到了
+RpcClient::Result RpcClient::call(std::string_view method, std::string_view payload, uint64_t timeout_ms) {
+    if (timeout_ms == 0) timeout_ms = g_call_timeout->getValue();
+    Scheduler *sched = Scheduler::GetThis();
+    bool in_fiber = sched && !Fiber::IsMainFiber();
+    uint64_t id = m_nextId.fetch_add(1, std::memory_order_relaxed);
+
+    RpcSession::ptr session;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_connected) return Result{RPC_CLOSED, {}};
+        session = m_session;
+        // 超长的请求不登记也不发送：对端会断开连接，连带失败其他在途调用
+        if (RpcCodec::RequestSize(id, method, payload) > session->getMaxFrame()) return Result{RPC_TOO_LARGE, {}};
+        Call &c = m_calls[id];
+        if (in_fiber) {
+            c.sched = sched;
+            c.fiber = Fiber::GetThis()->shared_from_this();
+        }
+    }
+
+    Timer::ptr timer;
+    if (timeout_ms != ~0ull) {
+        std::weak_ptr<RpcClient> weak = shared_from_this();
+        timer = m_iom->addTimer(timeout_ms, [weak, id]() {
+            if (auto self = weak.lock()) self->complete(id, RPC_TIMEOUT, ByteSlice());
+        });
+    }
+    if (!session->sendRequest(RpcMessage::REQUEST, id, method, payload)) complete(id, RPC_CLOSED, ByteSlice());
+
+    // 协程由 complete 恰好调度一次
+    if (in_fiber) Fiber::YieldToHold();
+    if (timer) timer->cancel();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto it = m_calls.find(id);
+    if (!in_fiber) m_cond.wait(lock, [&]() { return it->second.done; });
+    Result result = std::move(it->second.result);
+    m_calls.erase(it);
+    return result;
+}
+
+bool RpcClient::notify(std::string_view method, std::string_view payload) {
+    RpcSession::ptr session;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_connected) return false;
+        session = m_session;
+    }
+    return session->sendRequest(RpcMessage::ONEWAY, 0, method, payload);
+}
+
+// 调用由响应、超时或断开三者之一结束，先到的生效
+void RpcClient::complete(uint64_t id, uint32_t status, ByteSlice &&payload) {
+    Scheduler *sched = nullptr;
+    Fiber::ptr fiber;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_calls.find(id);
+        if (it == m_calls.end() || it->second.done) return;
+        Call &c = it->second;
+        c.done = true;
+        c.result.status = status;
+        c.result.payload = std::move(payload);
+        sched = c.sched;
+        fiber = std::move(c.fiber);
+    }
+    if (fiber) {
+        sched->scheduler(std::move(fiber));
+    } else {
+        m_cond.notify_all();
+    }
+}
+
+void RpcClient::failAll(uint32_t status) {
+    std::vector<uint64_t> ids;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto &i : m_calls) {
+            if (!i.second.done) ids.push_back(i.first);
+        }
+    }
+    for (uint64_t id : ids) complete(id, status, ByteSlice());
+}
+
+void RpcClient::recvLoop(RpcSession::ptr session) {
+    FrameReader reader;
+    while (reader.readOnce(*session->getSocket(), [this](RpcMessage &msg) {
+        if (msg.type == RpcMessage::RESPONSE) complete(msg.id, msg.status, std::move(msg.payload));
+    })) {
+    }
+    session->close();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_session == session) m_connected = false;
+    }
+    failAll(RPC_CLOSED);
+}
+
+// ---------- RpcServer ----------
+
+RpcServer::RpcServer(IOManager *worker, IOManager *acceptor) :
+    TcpServer(worker, acceptor) {
+}
+
+void RpcServer::registerMethod(const std::string &name, Handler handler) {
+    m_methods[name] = std::move(handler);
+}
+
+void RpcServer::handleClient(Socket::ptr client) {
+    IOManager *iom = IOManager::GetThis();
+    auto session = std::make_shared<RpcSession>(client, iom);
+    session->start();
+
+    FrameReader reader;
+    std::vector<std::function<void()>> tasks;
+    auto on_frame = [&](RpcMessage &msg) {
+        if (msg.type == RpcMessage::RESPONSE) return; // 服务端不发请求
+        auto it = m_methods.find(msg.method);
+        if (it == m_methods.end()) {
+            if (msg.type == RpcMessage::REQUEST) session->sendResponse(msg.id, RPC_NOT_FOUND, {});
+            return;
+        }
+        const Handler *handler = &it->second;
+        tasks.emplace_back([session, handler, msg = std::move(msg)]() {
+            std::string rsp;
+            uint32_t status;
+            try {
+                status = (*handler)(msg, rsp);
+            } catch (const std::exception &e) {
+                status = RPC_HANDLER_ERROR;
+                rsp = e.what();
+            }
+            // 响应超过 rpc.max_frame_size 时改回一个错误，调用方不至于等到超时
+            if (msg.type == RpcMessage::REQUEST && !session->sendResponse(msg.id, status, rsp) &&
+                !session->isClosed()) {
+                session->sendResponse(msg.id, RPC_HANDLER_ERROR, "response exceeds rpc.max_frame_size");
+            }
+        });
+    };
+    while (reader.readOnce(*client, on_frame)) {
+        if (tasks.empty()) continue;
+        iom->scheduler(std::make_move_iterator(tasks.begin()), std::make_move_iterator(tasks.end()));
+        tasks.clear();
+    }
+    session->close();
+}
+
+} // namespace sunshine
@@ -1,12 +1,94 @@
 // file: libs/scheduler.cpp
 #include "libs/scheduler.h"
+#include "libs/Config.h"
+#include <algorithm>
+#include <bit>
+#include <ctime>
 #include <iostream>
+#include <latch>
 
 namespace sunshine {
 
+// 队列等待直方图的采样间隔：每个线程每 N 次入队记一次时间戳（读单调时钟约几十 ns，逐个记录会拖慢短任务），
+// 1 表示每个任务都记录，0 表示关闭
+static ConfigVar<uint32_t>::ptr g_scheduler_queue_wait_sample = Config::Lookup<uint32_t>(
+    "scheduler.queue_wait_sample", 16, "sample queue wait time for one in N enqueued tasks (0 = off)");
+
+// 工作线程绑核：none 不绑定；core 每个线程绑一个 CPU（轮流分配）；numa 每个线程绑一个 NUMA 节点的全部 CPU
+// （按节点轮流分配）。绑定在线程执行任何任务之前完成，运行队列随后在线程内分配（first-touch 落在本节点）
+// use_caller 的调用线程不受影响
+static ConfigVar<std::string>::ptr g_scheduler_affinity =
+    Config::Lookup<std::string>("scheduler.affinity", "none", "pin worker threads: none / core / numa");
+// 参与分配的 CPU（空表示进程允许的全部 CPU）
+static ConfigVar<std::vector<int>>::ptr g_scheduler_affinity_cpus = Config::Lookup<std::vector<int>>(
+    "scheduler.affinity_cpus", std::vector<int>(), "cpus used by scheduler.affinity (empty = all allowed)");
+// 空闲线程睡眠前最多自旋多久（微秒）：新任务在这段时间内到达时不需要 futex / eventfd 唤醒
+// -1 表示自动（多核 50us，单核 0：只有一个 CPU 时自旋只会挡住要提交任务的线程）
+static ConfigVar<int32_t>::ptr g_scheduler_spin_max_us = Config::Lookup<int32_t>(
+    "scheduler.spin_max_us", -1, "max idle spin before sleeping in us (-1 = auto, 0 = off)");
+
 // 线程局部变量：存储当前线程绑定的调度器实例
 // 用于实现线程局部存储（TLS），避免全局变量
 static thread_local Scheduler *t_scheduler = nullptr;
+// 线程局部变量：当前线程作为哪个调度器的第几个工作线程（-1 表示不是工作线程）
+static thread_local Scheduler *t_worker_owner = nullptr;
+static thread_local int t_worker_index = -1;
+// 线程局部变量：当前线程的指标计数（run() 期间有效，属于 t_counters_owner）
+static thread_local Scheduler *t_counters_owner = nullptr;
+static thread_local void *t_counters = nullptr;
+
+// 存活的调度器（构造时登记、析构时注销），供 GetAllMetrics 汇总
+static std::mutex s_registry_mutex;
+static std::vector<Scheduler *> s_registry;
+
+// 本线程距下一次队列等待采样还剩几次入队
+static thread_local uint32_t t_wait_countdown = 1;
+
+// 队列等待计时用的单调时钟（vDSO，不进内核）
+static inline uint64_t NowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// 忙等时的 CPU 提示：降低功耗，并把流水线让给同一物理核上的另一个超线程
+static inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+// 按 scheduler.affinity 计算 n 个工作线程各自绑定的 CPU（空表示不绑定）
+static std::vector<std::vector<int>> WorkerCpus(const std::string &mode, const std::vector<int> &configured, size_t n) {
+    std::vector<std::vector<int>> out(n);
+    if (mode.empty() || mode == "none") return out;
+    const std::vector<int> &cpus = configured.empty() ? CpuTopology::AllowedCpus() : configured;
+    if (cpus.empty()) return out;
+    if (mode == "core") {
+        for (size_t i = 0; i < n; ++i) out[i] = {cpus[i % cpus.size()]};
+    } else if (mode == "numa") {
+        // 节点按其 CPU 在 cpus 中首次出现的顺序排列
+        std::vector<int> ids;
+        std::vector<std::vector<int>> nodes;
+        for (int cpu : cpus) {
+            int node = CpuTopology::NodeOf(cpu);
+            size_t k = std::find(ids.begin(), ids.end(), node) - ids.begin();
+            if (k == ids.size()) {
+                ids.push_back(node);
+                nodes.emplace_back();
+            }
+            nodes[k].push_back(cpu);
+        }
+        for (size_t i = 0; i < n; ++i) out[i] = nodes[i % nodes.size()];
+    } else {
+        LOG_WARN(LogManager::GetInstance().getRoot()) << "unknown scheduler.affinity \"" << mode << "\", ignored";
+    }
+    return out;
+}
 
 // 构造函数
 // 参数说明：
@@ -21,11 +103,29 @@ Scheduler::Scheduler(size_t threads, bool use_caller, const std::string &name) :
     if (m_threadCount == 0) m_threadCount = 1;
     // 初始状态：调度器处于停止状态
     m_stopping.store(true);
+    m_waitSample = g_scheduler_queue_wait_sample->getValue();
+    m_rootCounters = std::make_unique<ThreadCounters>();
+    m_affinity = g_scheduler_affinity->getValue();
+    m_affinityCpus = g_scheduler_affinity_cpus->getValue();
+
+    int32_t spin_us = g_scheduler_spin_max_us->getValue();
+    if (spin_us < 0) spin_us = std::thread::hardware_concurrency() > 1 ? 50 : 0;
+    m_spinMaxNs = static_cast<uint64_t>(spin_us) * 1000;
+    size_t workers = m_threadCount - (m_useCaller ? 1 : 0);
+    m_spinLimit = std::max<int>(1, static_cast<int>(workers / 2));
+
+    std::lock_guard<std::mutex> lock(s_registry_mutex);
+    s_registry.push_back(this);
 }
 
 // 析构函数
 // 确保调度器安全停止（如果未停止则调用stop）
+// 先注销：派生类此时已经析构，GetAllMetrics 只会读到 Scheduler 自己的成员
 Scheduler::~Scheduler() {
+    {
+        std::lock_guard<std::mutex> lock(s_registry_mutex);
+        s_registry.erase(std::remove(s_registry.begin(), s_registry.end(), this), s_registry.end());
+    }
     if (!m_stopping.load()) stop();
 }
 
@@ -50,14 +150,35 @@ void Scheduler::start() {
         m_rootThread = std::this_thread::get_id();
     }
 
-    // 创建工作线程
+    // 创建工作线程：Thread 在执行回调之前完成命名与绑核（scheduler.affinity）
+    // 每个线程在绑核之后自己分配运行队列，内存按 first-touch 落在该线程所在的 NUMA 节点上；
+    // 全部分配完（ready）之后 m_workers 不再变化
+    std::vector<std::vector<int>> cpus = WorkerCpus(m_affinity, m_affinityCpus, createCount);
+    std::string prefix = m_name.empty() ? "sched" : m_name;
+    m_workers.clear();
+    m_workers.resize(createCount);
+    std::latch ready(static_cast<std::ptrdiff_t>(createCount));
     for (size_t i = 0; i < createCount; ++i) {
-        auto thr = std::make_shared<std::thread>([this]() {
-            this->run(); // 虚函数调用，允许子类覆盖（如IOManager）
-        });
+        auto thr = std::make_shared<Thread>(
+            [this, i, &ready]() {
+                auto worker = std::make_unique<Worker>(LOCAL_QUEUE_CAPACITY);
+                worker->threadId = std::this_thread::get_id();
+                worker->spinBudgetNs = m_spinMaxNs / 4;
+                m_workers[i] = std::move(worker);
+                ready.count_down();
+                // 等待 start() 写完所有线程 id 后再开始调度（start 持有 m_mutex）
+                { std::lock_guard<std::mutex> gate(m_mutex); }
+                t_worker_owner = this;
+                t_worker_index = static_cast<int>(i);
+                this->run(); // 虚函数调用，允许子类覆盖（如IOManager）
+                t_worker_owner = nullptr;
+                t_worker_index = -1;
+            },
+            prefix + "_" + std::to_string(i), cpus[i]);
         m_threads.push_back(thr);
-        threadIds.push_back(thr->get_id());
     }
+    ready.wait();
+    for (size_t i = 0; i < createCount; ++i) threadIds.push_back(m_workers[i]->threadId);
 
     // 如果使用caller模式，调用线程将作为主协程（后续会调用run()）
     // 注意：此时不会立即执行run()，需等待后续调度
@@ -66,15 +187,22 @@ void Scheduler::start() {
 // 停止调度器并等待所有线程结束（阻塞）
 // 逻辑流程：
 // 1. 设置停止标志（m_stopping=true）
-// 2. 唤醒所有等待的线程（notify_all）
+// 2. 唤醒所有等待的线程（每个线程 tickle 一次 + notify_all）
 // 3. 等待所有工作线程结束（join）
 void Scheduler::stop() {
     m_stopping.store(true); // 标记停止
-    m_cond.notify_all();    // 唤醒所有等待线程
+    // 子类（如 IOManager）的线程阻塞在自己的等待点上，逐个 tickle 唤醒
+    for (size_t i = 0; i < m_threads.size(); ++i) {
+        tickle();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+    }
+    m_cond.notify_all(); // 唤醒所有等待线程
 
     // 等待工作线程结束
     for (auto &t : m_threads) {
-        if (t && t->joinable()) t->join();
+        if (t) t->join();
     }
     m_threads.clear(); // 清空线程列表
     threadIds.clear(); // 清空线程ID列表
@@ -98,9 +226,106 @@ Fiber *Scheduler::GetMainFiber() {
 }
 
 // 唤醒策略实现（默认唤醒一个等待线程）
-// 用于在任务队列非空时唤醒等待的工作线程
+// 用于在有空闲线程时唤醒它来取任务
+// 先获取一次 m_mutex：保证等待方要么已经进入 wait，要么尚未检查谓词，避免丢失唤醒
+// 有 pinned 任务待处理时改用 notify_all：被唤醒的必须是目标线程，notify_one 无法指定
+// 有线程正在自旋并且一定能接手新任务时不唤醒（见 spinnerWillSee）
 void Scheduler::tickle() {
-    m_cond.notify_one(); // 通知一个等待的线程
+    if (spinnerWillSee()) return;
+    countTickleSent();
+    notifyWaiters();
+}
+
+void Scheduler::notifyWaiters() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+    }
+    if (m_pinnedCount.load(std::memory_order_relaxed) > 0) {
+        m_cond.notify_all();
+    } else {
+        m_cond.notify_one(); // 通知一个等待的线程
+    }
+}
+
+// 当前线程的计数：run() 开始时绑定到本线程的 Worker（或调用线程的 m_rootCounters）
+Scheduler::ThreadCounters *Scheduler::localCounters() const {
+    return t_counters_owner == this ? static_cast<ThreadCounters *>(t_counters) : nullptr;
+}
+
+void Scheduler::countTickleSent() {
+    if (ThreadCounters *c = localCounters()) {
+        c->ticklesSent.add();
+    } else {
+        m_externalTickles.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// 分桶见 WAKEUP_EVENT_BUCKETS：bit_width(n) 正好是 n 所在的 2 的幂区间
+void Scheduler::countWakeup(int n) {
+    ThreadCounters *c = localCounters();
+    if (!c) return;
+    uint64_t events = n > 0 ? static_cast<uint64_t>(n) : 0;
+    c->wakeups.add();
+    c->wakeupEvents.add(events);
+    c->eventsPerWakeup[std::min<size_t>(std::bit_width(events), WAKEUP_EVENT_BUCKETS - 1)].add();
+}
+
+void Scheduler::ThreadCounters::snapshot(ThreadStats &out) const {
+    out.tasks = tasks.get();
+    out.fiberResumes = fiberResumes.get();
+    out.queueWaitNs = queueWaitNs.get();
+    for (size_t i = 0; i < QUEUE_WAIT_BUCKETS; ++i) out.queueWait[i] = queueWait[i].get();
+    out.stealAttempts = stealAttempts.get();
+    out.steals = steals.get();
+    out.ticklesSent = ticklesSent.get();
+    out.ticklesReceived = ticklesReceived.get();
+    out.wakeups = wakeups.get();
+    out.wakeupEvents = wakeupEvents.get();
+    for (size_t i = 0; i < WAKEUP_EVENT_BUCKETS; ++i) out.eventsPerWakeup[i] = eventsPerWakeup[i].get();
+    out.spinHits = spinHits.get();
+    out.spinTimeouts = spinTimeouts.get();
+}
+
+void Scheduler::ThreadStats::merge(const ThreadStats &o) {
+    tasks += o.tasks;
+    fiberResumes += o.fiberResumes;
+    queueWaitNs += o.queueWaitNs;
+    for (size_t i = 0; i < QUEUE_WAIT_BUCKETS; ++i) queueWait[i] += o.queueWait[i];
+    stealAttempts += o.stealAttempts;
+    steals += o.steals;
+    ticklesSent += o.ticklesSent;
+    ticklesReceived += o.ticklesReceived;
+    wakeups += o.wakeups;
+    wakeupEvents += o.wakeupEvents;
+    for (size_t i = 0; i < WAKEUP_EVENT_BUCKETS; ++i) eventsPerWakeup[i] += o.eventsPerWakeup[i];
+    spinHits += o.spinHits;
+    spinTimeouts += o.spinTimeouts;
+}
+
+// m_workers 只在 start() 里（持有 m_mutex）重建，这里加锁读取；计数本身无锁读取
+void Scheduler::getMetrics(Metrics &out) const {
+    out = Metrics();
+    out.name = m_name;
+    out.threads = m_threadCount;
+    out.useCaller = m_useCaller;
+    out.active = m_activeThreadCount.load(std::memory_order_relaxed);
+    out.idle = m_idleThreadCount.load(std::memory_order_relaxed);
+    out.queued = m_taskCount.load(std::memory_order_relaxed);
+    out.externalTickles = m_externalTickles.load(std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        out.workers.resize(m_workers.size() + (m_useCaller ? 1 : 0));
+        for (size_t i = 0; i < m_workers.size(); ++i) m_workers[i]->counters.snapshot(out.workers[i]);
+    }
+    if (m_useCaller) m_rootCounters->snapshot(out.workers.back());
+    for (const auto &w : out.workers) out.total.merge(w);
+    out.total.ticklesSent += out.externalTickles;
+}
+
+void Scheduler::GetAllMetrics(std::vector<Metrics> &out) {
+    std::lock_guard<std::mutex> lock(s_registry_mutex);
+    out.resize(s_registry.size());
+    for (size_t i = 0; i < s_registry.size(); ++i) s_registry[i]->getMetrics(out[i]);
 }
 
 // 设置当前线程绑定的调度器（用于线程局部存储）
@@ -108,35 +333,205 @@ void Scheduler::setThis() {
     t_scheduler = this; // 设置线程局部变量
 }
 
-// 从任务队列取一个任务（考虑线程绑定）
+// 当前线程在本调度器中的工作线程下标
+int Scheduler::currentWorkerIndex() const {
+    return t_worker_owner == this ? t_worker_index : -1;
+}
+
+// 第 idx 个工作线程的线程 id
+std::thread::id Scheduler::workerThreadId(size_t idx) const {
+    return idx < m_workers.size() ? m_workers[idx]->threadId : std::thread::id();
+}
+
+// 第 idx 个工作线程的 pinned 队列是否为空（不存在的工作线程视为空）
+bool Scheduler::workerPinnedEmpty(size_t idx) const {
+    return idx >= m_workers.size() || m_workers[idx]->pinned.emptyApprox();
+}
+
+// 根据线程 id 找工作线程下标（工作线程数量很少，线性查找即可）
+int Scheduler::workerIndexOf(std::thread::id thr) const {
+    for (size_t i = 0; i < m_workers.size(); ++i) {
+        if (m_workers[i]->threadId == thr) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+// 任务入队
+// 1. 指定了线程：压入目标线程的 pinned 队列（找不到目标或队列满则落到全局队列）
+// 2. 工作线程提交的普通任务：无锁压入本线程的 local 队列（满则落到全局队列）
+// 3. 外部线程提交：压入全局队列
+// 计数器先于入队递增：消费者可能先看到计数再看到任务（会重试），但不会出现计数下溢
+// 返回值：是否有空闲线程需要唤醒
+bool Scheduler::enqueue(FiberAndThread &&ft) {
+    bool pinned = ft.threadid != std::thread::id();
+    if (m_waitSample && --t_wait_countdown == 0) {
+        t_wait_countdown = m_waitSample;
+        ft.enqueued = NowNs();
+    }
+    m_taskCount.fetch_add(1);
+    bool queued = false;
+    if (pinned) {
+        m_pinnedCount.fetch_add(1);
+        int target = workerIndexOf(ft.threadid);
+        if (target >= 0) queued = m_workers[target]->pinned.push(std::move(ft));
+    } else {
+        int self = currentWorkerIndex();
+        if (self >= 0) queued = m_workers[self]->local.push(std::move(ft));
+    }
+
+    if (!queued) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (pinned) {
+            m_pinnedFibers.push_back(std::move(ft));
+        } else {
+            m_fibers.push_back(std::move(ft));
+        }
+        m_globalCount.fetch_add(1);
+    }
+    // pinned 任务不计入 hasPendingTask 的计数比较，目标线程只能看到队列本身：
+    // 入队（release store）与读空闲计数之间加 fence，与 run() 里 "空闲计数加一 -> idle() 检查任务" 配对，
+    // 否则双方可能都看不到对方（目标线程睡下而这里不唤醒）
+    if (pinned) std::atomic_thread_fence(std::memory_order_seq_cst);
+    return m_idleThreadCount.load() > 0;
+}
+
+// 当前线程是否有可执行的任务
+// - 非 pinned 任务（本地 / 全局 / 可窃取）任何工作线程都能执行
+// - pinned 任务只有目标线程能执行，只看自己的 pinned 队列
+bool Scheduler::hasPendingTask() const {
+    if (m_taskCount.load() > m_pinnedCount.load()) return true;
+    int self = currentWorkerIndex();
+    if (self >= 0 && !m_workers[self]->pinned.emptyApprox()) return true;
+    return false;
+}
+
+// 取一个任务
+// 顺序：自己的 pinned 队列 -> 自己的 local 队列 -> 全局队列 -> 从其他线程的 local 队列窃取
 // 参数说明：
-// out_fiber: 输出协程（若任务是协程）
-// out_cb: 输出函数对象（若任务是函数）
+// out: 输出任务
 // 返回值：是否成功取到任务
-bool Scheduler::takeOneTask(Fiber::ptr &out_fiber, std::function<void()> &out_cb) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    // 任务队列为空则返回false
-    if (m_fibers.empty()) return false;
-
-    // 获取当前线程ID
-    std::thread::id cur = std::this_thread::get_id();
+bool Scheduler::takeOneTask(FiberAndThread &out) {
+    int self = currentWorkerIndex();
+    if (self >= 0) {
+        Worker &w = *m_workers[self];
+        if (w.pinned.pop(out)) {
+            m_pinnedCount.fetch_sub(1);
+            m_taskCount.fetch_sub(1);
+            return true;
+        }
+        if (w.local.pop(out)) {
+            m_taskCount.fetch_sub(1);
+            return true;
+        }
+    }
 
-    // 遍历任务队列，寻找可执行任务：
-    // 1. 任务未指定线程（threadid为空）则任意线程可执行
-    // 2. 任务指定了线程ID，且与当前线程ID匹配
-    for (auto it = m_fibers.begin(); it != m_fibers.end(); ++it) {
-        if (it->threadid != std::thread::id() && it->threadid != cur)
-            continue; // 任务指定线程不匹配当前线程，跳过
+    // 全局队列：只有非空时才加锁
+    if (m_globalCount.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // 全局 pinned 任务很少（只有溢出或目标不是工作线程时才进来），逐个检查线程匹配，
+        // 不匹配的放回队尾
+        std::thread::id cur = std::this_thread::get_id();
+        for (size_t k = m_pinnedFibers.size(); k > 0; --k) {
+            FiberAndThread ft;
+            m_pinnedFibers.pop_front(ft);
+            if (ft.threadid == cur) {
+                out = std::move(ft);
+                m_pinnedCount.fetch_sub(1);
+                m_globalCount.fetch_sub(1);
+                m_taskCount.fetch_sub(1);
+                return true;
+            }
+            m_pinnedFibers.push_back(std::move(ft));
+        }
+        if (m_fibers.pop_front(out)) {
+            m_globalCount.fetch_sub(1);
+            m_taskCount.fetch_sub(1);
+            return true;
+        }
+    }
 
-        // 取出任务
-        out_fiber = std::move(it->fiber);
-        out_cb = std::move(it->cb);
-        m_fibers.erase(it); // 从队列移除
-        return true;
+    // 窃取：从下一个工作线程开始轮询，避免所有线程同时去抢同一个队列
+    size_t n = m_workers.size();
+    size_t start = self >= 0 ? static_cast<size_t>(self) + 1 : 0;
+    ThreadCounters *c = localCounters();
+    for (size_t k = 0; k < n; ++k) {
+        size_t idx = (start + k) % n;
+        if (static_cast<int>(idx) == self) continue;
+        if (m_workers[idx]->local.emptyApprox()) continue;
+        if (c) c->stealAttempts.add();
+        if (m_workers[idx]->local.pop(out)) {
+            if (c) c->steals.add();
+            m_taskCount.fetch_sub(1);
+            return true;
+        }
     }
     return false;
 }
 
+bool Scheduler::spinnerWillSee() const {
+    if (m_spinMaxNs == 0) return false;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return m_spinningCount.load(std::memory_order_relaxed) > 0 &&
+           m_pinnedCount.load(std::memory_order_relaxed) == 0 && !m_stopping.load(std::memory_order_relaxed);
+}
+
+// 空闲自旋（见头文件）
+// 进入自旋时 m_spinningCount 加一（超过上限则直接去睡眠），此后提交任务的线程可能因此跳过 tickle，
+// 所以退出时必须 "减一 -> fence -> 再检查一次任务"，看到任务就由本线程接手
+bool Scheduler::spinIdle() {
+    int self = currentWorkerIndex();
+    if (self < 0 || m_spinMaxNs == 0) return false;
+    if (m_stopping.load() || hasPendingTask()) return false;
+    int spinning = m_spinningCount.load(std::memory_order_relaxed);
+    do {
+        if (spinning >= m_spinLimit) return false;
+    } while (!m_spinningCount.compare_exchange_weak(spinning, spinning + 1));
+
+    Worker &w = *m_workers[self];
+    uint64_t deadline = NowNs() + w.spinBudgetNs;
+    bool found = false;
+    for (uint32_t k = 1;; ++k) {
+        if (m_stopping.load(std::memory_order_relaxed) || hasPendingTask()) {
+            found = true;
+            break;
+        }
+        if (k % SPIN_POLL_INTERVAL == 0) {
+            if (pollIdle()) {
+                found = true;
+                break;
+            }
+            if (NowNs() >= deadline) break;
+        }
+        CpuRelax();
+    }
+    m_spinningCount.fetch_sub(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!found) found = m_stopping.load() || hasPendingTask();
+
+    if (found) {
+        w.counters.spinHits.add();
+        w.spinBudgetNs = std::min(m_spinMaxNs, w.spinBudgetNs * 2);
+        // 跳过唤醒的提交方可能一次提交了多个任务：本线程只取走一个，其余的再唤醒下一个线程
+        if (m_taskCount.load() > m_pinnedCount.load() + 1) tickle();
+    } else {
+        w.counters.spinTimeouts.add();
+        w.spinBudgetNs = std::max(m_spinMaxNs / 16, w.spinBudgetNs / 2);
+    }
+    return found;
+}
+
+// 空闲处理（默认实现）：先短暂自旋，仍没有任务再在条件变量上等待新任务或停止
+void Scheduler::idle() {
+    if (spinIdle()) return;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto ready = [this]() {
+        return m_stopping.load() || hasPendingTask();
+    };
+    if (ready()) return;
+    m_cond.wait(lock, ready);
+    if (ThreadCounters *c = localCounters()) c->ticklesReceived.add();
+}
+
 // 调度器主循环（核心执行逻辑）
 // 逻辑流程：
 // 1. 设置当前线程的调度器（setThis）
@@ -146,12 +541,13 @@ bool Scheduler::takeOneTask(Fiber::ptr &out_fiber, std::function<void()> &out_cb
 //    a. 尝试取任务（takeOneTask）
 //    b. 若取到任务：
 //       - 增加活跃线程计数
-//       - 执行任务（协程swapIn或函数对象转协程执行）
+//       - 执行任务（协程swapIn或函数对象转协程执行，回调协程执行完后留给下一个回调复用）
+//       - 协程以 READY 状态让出时重新入队
 //       - 捕获异常（避免崩溃）
 //       - 减少活跃线程计数
 //    c. 若未取到任务：
 //       - 增加空闲线程计数
-//       - 等待条件变量（新任务或停止）
+//       - 调用 idle()（默认等待条件变量，IOManager 等待 epoll）
 //       - 减少空闲线程计数
 // 4. 停止时清理线程局部变量
 void Scheduler::run() {
@@ -167,46 +563,89 @@ void Scheduler::run() {
         m_rootFiber->swapIn();
     }
 
+    // 回调任务复用协程：
+    // cb_fiber 是当前线程空闲的回调协程，下一个回调任务直接 reset 复用；
+    // fiber_pool 回收执行完毕（TERM）且没有其他持有者的协程，cb_fiber 被占用时从这里取
+    Fiber::ptr cb_fiber;
+    std::vector<Fiber::ptr> fiber_pool;
+    fiber_pool.reserve(FIBER_POOL_CAPACITY);
+
+    // 指标计数：工作线程用自己 Worker 里的一份，调用线程用 m_rootCounters
+    int self = currentWorkerIndex();
+    ThreadCounters *counters = self >= 0 ? &m_workers[self]->counters : m_rootCounters.get();
+    t_counters_owner = this;
+    t_counters = counters;
+
     // 主循环：持续执行任务
     while (!m_stopping.load()) {
-        Fiber::ptr task_f;
-        std::function<void()> task_cb;
+        FiberAndThread task;
 
         // 尝试获取任务
-        if (takeOneTask(task_f, task_cb)) {
+        if (takeOneTask(task)) {
             ++m_activeThreadCount; // 标记活跃线程
+            counters->tasks.add();
+            if (task.fiber) counters->fiberResumes.add();
+            if (task.enqueued) {
+                // 队列等待（采样）：第 0 桶 < 1us，之后按 2 的幂微秒（bit_width 即所在区间）
+                uint64_t wait_ns = NowNs() - task.enqueued;
+                counters->queueWaitNs.add(wait_ns);
+                counters->queueWait[std::min<size_t>(std::bit_width(wait_ns / 1000), QUEUE_WAIT_BUCKETS - 1)].add();
+            }
             try {
-                if (task_f) {
+                if (task.fiber) {
                     // 执行协程任务
-                    task_f->swapIn();
-                } else if (task_cb) {
-                    // 将函数对象转为协程执行
-                    Fiber::ptr tmp = std::make_shared<Fiber>(std::move(task_cb));
-                    tmp->swapIn();
+                    task.fiber->swapIn();
+                    // 主动让出为 READY 的协程需要重新调度
+                    if (task.fiber->getState() == Fiber::READY) {
+                        scheduler(std::move(task.fiber), task.threadid);
+                    } else if (task.fiber->getState() == Fiber::TERM && task.fiber.use_count() == 1 &&
+                               fiber_pool.size() < FIBER_POOL_CAPACITY) {
+                        // 只有调度器持有的已结束协程（例如挂起后被唤醒的回调协程）回收复用
+                        fiber_pool.push_back(std::move(task.fiber));
+                    }
+                } else if (task.cb) {
+                    // 将函数对象放到协程里执行：优先复用空闲协程，没有时才新建
+                    if (!cb_fiber && !fiber_pool.empty()) {
+                        cb_fiber = std::move(fiber_pool.back());
+                        fiber_pool.pop_back();
+                    }
+                    if (cb_fiber) {
+                        cb_fiber->reset(std::move(task.cb));
+                    } else {
+                        cb_fiber = std::make_shared<Fiber>(std::move(task.cb));
+                    }
+                    cb_fiber->swapIn();
+                    if (cb_fiber->getState() == Fiber::READY) {
+                        scheduler(std::move(cb_fiber), task.threadid);
+                        cb_fiber.reset();
+                    } else if (cb_fiber->getState() != Fiber::TERM) {
+                        // 挂起（HOLD）：协程交给等待的事件 / 定时器持有，不能再复用
+                        cb_fiber.reset();
+                    }
                 }
             } catch (const std::exception &e) {
                 // 捕获异常并打印（避免崩溃）
                 std::cerr << "Scheduler task exception: " << e.what() << std::endl;
+                cb_fiber.reset(); // 状态未知，不再复用
             } catch (...) {
                 std::cerr << "Scheduler task unknown exception" << std::endl;
+                cb_fiber.reset();
             }
             --m_activeThreadCount; // 恢复活跃计数
             continue;              // 继续循环
         }
 
-        // 未取到任务：进入等待状态
-        std::unique_lock<std::mutex> lock(m_mutex);
+        // 未取到任务：进入空闲状态
         if (m_stopping.load()) break; // 停止标志已设置，退出循环
         m_idleThreadCount++;          // 标记空闲线程
-        // 等待条件变量（新任务或停止）
-        m_cond.wait(lock, [this]() {
-            return m_stopping.load() || !m_fibers.empty();
-        });
+        idle();
         m_idleThreadCount--; // 恢复空闲计数
     }
 
     // 停止时清理线程局部变量
     if (t_scheduler == this) t_scheduler = nullptr;
+    t_counters_owner = nullptr;
+    t_counters = nullptr;
 }
 
-} // namespace sunshine
\ No newline at end of file
+} // namespace sunshine
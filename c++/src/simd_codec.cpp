@@ -0,0 +1,593 @@
+// file: libs/simd_codec.cpp
+#include "libs/simd_codec.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SUNSHINE_SIMD_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define SUNSHINE_SIMD_NEON 1
+#endif
+
+namespace sunshine {
+
+namespace {
+
+/* ========================= 标量实现（也用来处理 SIMD 内核的尾部） ========================= */
+
+inline uint8_t *EncodeOne32(uint32_t v, uint8_t *out) {
+    while (v >= 0x80) {
+        *out++ = static_cast<uint8_t>(v | 0x80);
+        v >>= 7;
+    }
+    *out++ = static_cast<uint8_t>(v);
+    return out;
+}
+
+inline uint8_t *EncodeOne64(uint64_t v, uint8_t *out) {
+    while (v >= 0x80) {
+        *out++ = static_cast<uint8_t>(v | 0x80);
+        v >>= 7;
+    }
+    *out++ = static_cast<uint8_t>(v);
+    return out;
+}
+
+// 解一个值，语义与 ByteArray::readUint32 / readUint64 相同（最多 5 / 10 字节）
+// 在 end 之前没有结束时返回 false，p 不动
+inline bool DecodeOne32(const uint8_t *&p, const uint8_t *end, uint32_t &v) {
+    const uint8_t *q = p;
+    uint32_t result = 0;
+    for (int i = 0; i < 32; i += 7) {
+        if (q == end) return false;
+        uint8_t b = *q++;
+        if (b < 0x80) {
+            result |= static_cast<uint32_t>(b) << i;
+            break;
+        }
+        result |= static_cast<uint32_t>(b & 0x7f) << i;
+    }
+    v = result;
+    p = q;
+    return true;
+}
+
+inline bool DecodeOne64(const uint8_t *&p, const uint8_t *end, uint64_t &v) {
+    const uint8_t *q = p;
+    uint64_t result = 0;
+    for (int i = 0; i < 64; i += 7) {
+        if (q == end) return false;
+        uint8_t b = *q++;
+        if (b < 0x80) {
+            result |= static_cast<uint64_t>(b) << i;
+            break;
+        }
+        result |= static_cast<uint64_t>(b & 0x7f) << i;
+    }
+    v = result;
+    p = q;
+    return true;
+}
+
+// 把 8 个字节各自的低 7 位依次拼接成 56 位（没有 BMI2 pext 时的替代）
+inline uint64_t Compact7(uint64_t w) {
+    w &= 0x7f7f7f7f7f7f7f7fULL;
+    w = (w & 0x007f007f007f007fULL) | ((w & 0x7f007f007f007f00ULL) >> 1);
+    w = (w & 0x00003fff00003fffULL) | ((w & 0x3fff00003fff0000ULL) >> 2);
+    w = (w & 0x000000000fffffffULL) | ((w & 0x0fffffff00000000ULL) >> 4);
+    return w;
+}
+
+// 低 len 个字节的掩码（len <= 8）
+inline uint64_t ByteMask(size_t len) {
+    return len >= 8 ? ~0ULL : ((1ULL << (8 * len)) - 1);
+}
+
+inline uint64_t Load64(const uint8_t *p) {
+    uint64_t w;
+    memcpy(&w, p, sizeof(w));
+    return w;
+}
+
+size_t EncodeVarint32Scalar(const uint32_t *in, size_t n, uint8_t *out) {
+    uint8_t *p = out;
+    size_t i = 0;
+    // 4 个值都小于 128 时直接写 4 个字节
+    for (; i + 4 <= n; i += 4) {
+        if (((in[i] | in[i + 1] | in[i + 2] | in[i + 3]) >> 7) == 0) {
+            p[0] = static_cast<uint8_t>(in[i]);
+            p[1] = static_cast<uint8_t>(in[i + 1]);
+            p[2] = static_cast<uint8_t>(in[i + 2]);
+            p[3] = static_cast<uint8_t>(in[i + 3]);
+            p += 4;
+        } else {
+            for (size_t j = i; j < i + 4; ++j) p = EncodeOne32(in[j], p);
+        }
+    }
+    for (; i < n; ++i) p = EncodeOne32(in[i], p);
+    return p - out;
+}
+
+size_t EncodeVarint64Scalar(const uint64_t *in, size_t n, uint8_t *out) {
+    uint8_t *p = out;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        if (((in[i] | in[i + 1] | in[i + 2] | in[i + 3]) >> 7) == 0) {
+            p[0] = static_cast<uint8_t>(in[i]);
+            p[1] = static_cast<uint8_t>(in[i + 1]);
+            p[2] = static_cast<uint8_t>(in[i + 2]);
+            p[3] = static_cast<uint8_t>(in[i + 3]);
+            p += 4;
+        } else {
+            for (size_t j = i; j < i + 4; ++j) p = EncodeOne64(in[j], p);
+        }
+    }
+    for (; i < n; ++i) p = EncodeOne64(in[i], p);
+    return p - out;
+}
+
+size_t DecodeVarint32Scalar(const uint8_t *in, size_t len, uint32_t *out, size_t n, size_t *consumed) {
+    const uint8_t *p = in;
+    const uint8_t *end = in + len;
+    size_t i = 0;
+    while (i < n && DecodeOne32(p, end, out[i])) ++i;
+    *consumed = p - in;
+    return i;
+}
+
+size_t DecodeVarint64Scalar(const uint8_t *in, size_t len, uint64_t *out, size_t n, size_t *consumed) {
+    const uint8_t *p = in;
+    const uint8_t *end = in + len;
+    size_t i = 0;
+    while (i < n && DecodeOne64(p, end, out[i])) ++i;
+    *consumed = p - in;
+    return i;
+}
+
+void ByteSwapScalar(void *dst, const void *src, size_t n, size_t width) {
+    uint8_t *d = static_cast<uint8_t *>(dst);
+    const uint8_t *s = static_cast<const uint8_t *>(src);
+    switch (width) {
+    case 2:
+        for (size_t i = 0; i < n; ++i) {
+            uint16_t v;
+            memcpy(&v, s + i * 2, 2);
+            v = __builtin_bswap16(v);
+            memcpy(d + i * 2, &v, 2);
+        }
+        break;
+    case 4:
+        for (size_t i = 0; i < n; ++i) {
+            uint32_t v;
+            memcpy(&v, s + i * 4, 4);
+            v = __builtin_bswap32(v);
+            memcpy(d + i * 4, &v, 4);
+        }
+        break;
+    case 8:
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t v;
+            memcpy(&v, s + i * 8, 8);
+            v = __builtin_bswap64(v);
+            memcpy(d + i * 8, &v, 8);
+        }
+        break;
+    default:
+        if (d != s) memcpy(d, s, n * width);
+        break;
+    }
+}
+
+/* ========================= x86-64：SSE4.1 / AVX2 ========================= */
+#if defined(SUNSHINE_SIMD_X86)
+
+// 窗口内按结束字节逐个取值：term 的第 k 位为 1 表示窗口第 k 字节是某个值的最后一个字节
+// 每个值用一次 8 字节读取 + 拼接 7 位组得到；超过 8 字节（或超长）的值退回标量解码
+// 返回窗口内消耗的字节数，调用方保证 p 之后至少还有 窗口大小 + MAX_VARINT64 字节
+#define SUNSHINE_DECODE_WINDOW(T, MAXLEN, DECODE_ONE, EXTRACT)                  \
+    size_t k = 0;                                                               \
+    while (i < n) {                                                             \
+        uint64_t t = term >> k;                                                 \
+        if (t == 0) break;                                                      \
+        size_t l = static_cast<size_t>(__builtin_ctzll(t)) + 1;                 \
+        if (l > 8 || l > (MAXLEN)) {                                            \
+            const uint8_t *q = p + k;                                           \
+            DECODE_ONE(q, end, out[i]);                                         \
+            ++i;                                                                \
+            k = q - p;                                                          \
+            continue;                                                           \
+        }                                                                       \
+        out[i++] = static_cast<T>(EXTRACT(Load64(p + k), ByteMask(l)));         \
+        k += l;                                                                 \
+    }                                                                           \
+    p += k;
+
+#define SUNSHINE_COMPACT7(w, mask) Compact7((w) & (mask))
+#define SUNSHINE_PEXT7(w, mask) _pext_u64((w), 0x7f7f7f7f7f7f7f7fULL & (mask))
+
+__attribute__((target("sse4.1"))) size_t EncodeVarint32Sse(const uint32_t *in, size_t n, uint8_t *out) {
+    uint8_t *p = out;
+    size_t i = 0;
+    const __m128i high = _mm_set1_epi32(~0x7f);
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        if (_mm_testz_si128(v, high)) {
+            // 4 个值都是单字节：32 -> 16 -> 8 位收窄后一次写出
+            __m128i b = _mm_packus_epi16(_mm_packus_epi32(v, v), v);
+            int32_t w = _mm_cvtsi128_si32(b);
+            memcpy(p, &w, 4);
+            p += 4;
+        } else {
+            for (size_t j = i; j < i + 4; ++j) p = EncodeOne32(in[j], p);
+        }
+    }
+    for (; i < n; ++i) p = EncodeOne32(in[i], p);
+    return p - out;
+}
+
+__attribute__((target("sse4.1"))) size_t DecodeVarint32Sse(const uint8_t *in, size_t len, uint32_t *out,
+                                                           size_t n, size_t *consumed) {
+    const uint8_t *p = in;
+    const uint8_t *end = in + len;
+    size_t i = 0;
+    while (i < n && end - p >= 16 + static_cast<ptrdiff_t>(SimdCodec::MAX_VARINT64)) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        uint32_t cont = static_cast<uint32_t>(_mm_movemask_epi8(v));
+        if (cont == 0 && n - i >= 16) {
+            // 16 个单字节值：直接零扩展成 16 个 uint32
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_cvtepu8_epi32(v));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 4), _mm_cvtepu8_epi32(_mm_srli_si128(v, 4)));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 8), _mm_cvtepu8_epi32(_mm_srli_si128(v, 8)));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 12), _mm_cvtepu8_epi32(_mm_srli_si128(v, 12)));
+            p += 16;
+            i += 16;
+            continue;
+        }
+        uint64_t term = ~cont & 0xffffu;
+        if (term == 0) {
+            // 整个窗口都是续接字节（超长值），按标量规则截断
+            DecodeOne32(p, end, out[i]);
+            ++i;
+            continue;
+        }
+        SUNSHINE_DECODE_WINDOW(uint32_t, SimdCodec::MAX_VARINT32, DecodeOne32, SUNSHINE_COMPACT7)
+    }
+    while (i < n && DecodeOne32(p, end, out[i])) ++i;
+    *consumed = p - in;
+    return i;
+}
+
+__attribute__((target("sse4.1"))) size_t DecodeVarint64Sse(const uint8_t *in, size_t len, uint64_t *out,
+                                                           size_t n, size_t *consumed) {
+    const uint8_t *p = in;
+    const uint8_t *end = in + len;
+    size_t i = 0;
+    while (i < n && end - p >= 16 + static_cast<ptrdiff_t>(SimdCodec::MAX_VARINT64)) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        uint32_t cont = static_cast<uint32_t>(_mm_movemask_epi8(v));
+        if (cont == 0 && n - i >= 16) {
+            __m128i *o = reinterpret_cast<__m128i *>(out + i);
+            _mm_storeu_si128(o + 0, _mm_cvtepu8_epi64(v));
+            _mm_storeu_si128(o + 1, _mm_cvtepu8_epi64(_mm_srli_si128(v, 2)));
+            _mm_storeu_si128(o + 2, _mm_cvtepu8_epi64(_mm_srli_si128(v, 4)));
+            _mm_storeu_si128(o + 3, _mm_cvtepu8_epi64(_mm_srli_si128(v, 6)));
+            _mm_storeu_si128(o + 4, _mm_cvtepu8_epi64(_mm_srli_si128(v, 8)));
+            _mm_storeu_si128(o + 5, _mm_cvtepu8_epi64(_mm_srli_si128(v, 10)));
+            _mm_storeu_si128(o + 6, _mm_cvtepu8_epi64(_mm_srli_si128(v, 12)));
+            _mm_storeu_si128(o + 7, _mm_cvtepu8_epi64(_mm_srli_si128(v, 14)));
+            p += 16;
+            i += 16;
+            continue;
+        }
+        uint64_t term = ~cont & 0xffffu;
+        if (term == 0) {
+            DecodeOne64(p, end, out[i]);
+            ++i;
+            continue;
+        }
+        SUNSHINE_DECODE_WINDOW(uint64_t, SimdCodec::MAX_VARINT64, DecodeOne64, SUNSHINE_COMPACT7)
+    }
+    while (i < n && DecodeOne64(p, end, out[i])) ++i;
+    *consumed = p - in;
+    return i;
+}
+
+// pshufb 的字节翻转表（每个元素内部倒序）
+alignas(32) static const uint8_t s_bswap_table[3][32] = {
+    {1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14, 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14},
+    {3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12},
+    {7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8},
+};
+
+inline const uint8_t *BswapTable(size_t width) {
+    return width == 2 ? s_bswap_table[0] : (width == 4 ? s_bswap_table[1] : s_bswap_table[2]);
+}
+
+__attribute__((target("sse4.1"))) void ByteSwapSse(void *dst, const void *src, size_t n, size_t width) {
+    if (width != 2 && width != 4 && width != 8) return ByteSwapScalar(dst, src, n, width);
+    uint8_t *d = static_cast<uint8_t *>(dst);
+    const uint8_t *s = static_cast<const uint8_t *>(src);
+    const __m128i shuf = _mm_load_si128(reinterpret_cast<const __m128i *>(BswapTable(width)));
+    size_t bytes = n * width;
+    size_t off = 0;
+    for (; off + 16 <= bytes; off += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + off));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(d + off), _mm_shuffle_epi8(v, shuf));
+    }
+    ByteSwapScalar(d + off, s + off, (bytes - off) / width, width);
+}
+
+// BMI2：pdep 把值的 7 位组一次散布到 8 个字节，按长度补上续接位后整字写出（多写的字节会被下一个值覆盖）
+// 调用方保证 out 之后至少还有 8 字节可写（不足时改用 EncodeOne64）
+__attribute__((target("bmi2"))) inline uint8_t *EncodeOneBmi2(uint64_t v, uint8_t *out) {
+    size_t bits = 64 - static_cast<size_t>(__builtin_clzll(v | 1));
+    size_t len = (bits + 6) / 7;
+    uint64_t w = _pdep_u64(v, 0x7f7f7f7f7f7f7f7fULL);
+    if (len <= 8) {
+        w |= 0x8080808080808080ULL & ByteMask(len - 1);
+        memcpy(out, &w, 8);
+        return out + len;
+    }
+    w |= 0x8080808080808080ULL;
+    memcpy(out, &w, 8);
+    return EncodeOne64(v >> 56, out + 8);
+}
+
+__attribute__((target("avx2,bmi2"))) size_t EncodeVarint32Avx2(const uint32_t *in, size_t n, uint8_t *out) {
+    uint8_t *p = out;
+    size_t i = 0;
+    const __m256i high = _mm256_set1_epi32(~0x7f);
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+        if (_mm256_testz_si256(v, high)) {
+            __m128i w = _mm_packus_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(p), _mm_packus_epi16(w, w));
+            p += 8;
+        } else if (i + 8 < n) {
+            for (size_t j = i; j < i + 8; ++j) p = EncodeOneBmi2(in[j], p);
+        } else {
+            for (size_t j = i; j < i + 8; ++j) p = EncodeOne32(in[j], p);
+        }
+    }
+    for (; i < n; ++i) p = EncodeOne32(in[i], p);
+    return p - out;
+}
+
+// 最后一个值之前都至少还有 MAX_VARINT64 字节余量，整字写出不会越界
+__attribute__((target("avx2,bmi2"))) size_t EncodeVarint64Avx2(const uint64_t *in, size_t n, uint8_t *out) {
+    uint8_t *p = out;
+    size_t i = 0;
+    for (; i + 4 < n; i += 4) {
+        if (((in[i] | in[i + 1] | in[i + 2] | in[i + 3]) >> 7) == 0) {
+            p[0] = static_cast<uint8_t>(in[i]);
+            p[1] = static_cast<uint8_t>(in[i + 1]);
+            p[2] = static_cast<uint8_t>(in[i + 2]);
+            p[3] = static_cast<uint8_t>(in[i + 3]);
+            p += 4;
+        } else {
+            for (size_t j = i; j < i + 4; ++j) p = EncodeOneBmi2(in[j], p);
+        }
+    }
+    for (; i < n; ++i) p = EncodeOne64(in[i], p);
+    return p - out;
+}
+
+__attribute__((target("avx2,bmi2"))) size_t DecodeVarint32Avx2(const uint8_t *in, size_t len, uint32_t *out,
+                                                               size_t n, size_t *consumed) {
+    const uint8_t *p = in;
+    const uint8_t *end = in + len;
+    size_t i = 0;
+    while (i < n && end - p >= 32 + static_cast<ptrdiff_t>(SimdCodec::MAX_VARINT64)) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        uint32_t cont = static_cast<uint32_t>(_mm256_movemask_epi8(v));
+        if (cont == 0 && n - i >= 32) {
+            // 32 个单字节值：每 8 字节零扩展成 8 个 uint32
+            __m256i *o = reinterpret_cast<__m256i *>(out + i);
+            _mm256_storeu_si256(o + 0, _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p))));
+            _mm256_storeu_si256(o + 1, _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p + 8))));
+            _mm256_storeu_si256(o + 2, _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p + 16))));
+            _mm256_storeu_si256(o + 3, _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p + 24))));
+            p += 32;
+            i += 32;
+            continue;
+        }
+        uint64_t term = static_cast<uint32_t>(~cont);
+        if (term == 0) {
+            DecodeOne32(p, end, out[i]);
+            ++i;
+            continue;
+        }
+        SUNSHINE_DECODE_WINDOW(uint32_t, SimdCodec::MAX_VARINT32, DecodeOne32, SUNSHINE_PEXT7)
+    }
+    while (i < n && DecodeOne32(p, end, out[i])) ++i;
+    *consumed = p - in;
+    return i;
+}
+
+__attribute__((target("avx2,bmi2"))) size_t DecodeVarint64Avx2(const uint8_t *in, size_t len, uint64_t *out,
+                                                               size_t n, size_t *consumed) {
+    const uint8_t *p = in;
+    const uint8_t *end = in + len;
+    size_t i = 0;
+    while (i < n && end - p >= 32 + static_cast<ptrdiff_t>(SimdCodec::MAX_VARINT64)) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        uint32_t cont = static_cast<uint32_t>(_mm256_movemask_epi8(v));
+        if (cont == 0 && n - i >= 32) {
+            __m256i *o = reinterpret_cast<__m256i *>(out + i);
+            for (size_t j = 0; j < 8; ++j) {
+                int32_t w;
+                memcpy(&w, p + j * 4, 4);
+                _mm256_storeu_si256(o + j, _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(w)));
+            }
+            p += 32;
+            i += 32;
+            continue;
+        }
+        uint64_t term = static_cast<uint32_t>(~cont);
+        if (term == 0) {
+            DecodeOne64(p, end, out[i]);
+            ++i;
+            continue;
+        }
+        SUNSHINE_DECODE_WINDOW(uint64_t, SimdCodec::MAX_VARINT64, DecodeOne64, SUNSHINE_PEXT7)
+    }
+    while (i < n && DecodeOne64(p, end, out[i])) ++i;
+    *consumed = p - in;
+    return i;
+}
+
+__attribute__((target("avx2"))) void ByteSwapAvx2(void *dst, const void *src, size_t n, size_t width) {
+    if (width != 2 && width != 4 && width != 8) return ByteSwapScalar(dst, src, n, width);
+    uint8_t *d = static_cast<uint8_t *>(dst);
+    const uint8_t *s = static_cast<const uint8_t *>(src);
+    const __m256i shuf = _mm256_load_si256(reinterpret_cast<const __m256i *>(BswapTable(width)));
+    size_t bytes = n * width;
+    size_t off = 0;
+    for (; off + 32 <= bytes; off += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + off));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(d + off), _mm256_shuffle_epi8(v, shuf));
+    }
+    ByteSwapScalar(d + off, s + off, (bytes - off) / width, width);
+}
+
+#undef SUNSHINE_DECODE_WINDOW
+#undef SUNSHINE_COMPACT7
+#undef SUNSHINE_PEXT7
+
+#endif // SUNSHINE_SIMD_X86
+
+/* ========================= aarch64：NEON ========================= */
+#if defined(SUNSHINE_SIMD_NEON)
+
+// NEON 没有 movemask，只做"16 个单字节值"的整段快速路径，其余按标量解到窗口末尾
+size_t DecodeVarint32Neon(const uint8_t *in, size_t len, uint32_t *out, size_t n, size_t *consumed) {
+    const uint8_t *p = in;
+    const uint8_t *end = in + len;
+    size_t i = 0;
+    while (i < n && end - p >= 16) {
+        uint8x16_t v = vld1q_u8(p);
+        if (vmaxvq_u8(v) < 0x80 && n - i >= 16) {
+            uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+            uint16x8_t hi = vmovl_u8(vget_high_u8(v));
+            vst1q_u32(out + i, vmovl_u16(vget_low_u16(lo)));
+            vst1q_u32(out + i + 4, vmovl_u16(vget_high_u16(lo)));
+            vst1q_u32(out + i + 8, vmovl_u16(vget_low_u16(hi)));
+            vst1q_u32(out + i + 12, vmovl_u16(vget_high_u16(hi)));
+            p += 16;
+            i += 16;
+            continue;
+        }
+        const uint8_t *wend = p + 16;
+        while (i < n && p < wend && DecodeOne32(p, end, out[i])) ++i;
+        if (p < wend) break;
+    }
+    while (i < n && DecodeOne32(p, end, out[i])) ++i;
+    *consumed = p - in;
+    return i;
+}
+
+size_t DecodeVarint64Neon(const uint8_t *in, size_t len, uint64_t *out, size_t n, size_t *consumed) {
+    const uint8_t *p = in;
+    const uint8_t *end = in + len;
+    size_t i = 0;
+    while (i < n && end - p >= 16) {
+        uint8x16_t v = vld1q_u8(p);
+        if (vmaxvq_u8(v) < 0x80 && n - i >= 16) {
+            uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+            uint16x8_t hi = vmovl_u8(vget_high_u8(v));
+            uint32x4_t q[4] = {vmovl_u16(vget_low_u16(lo)), vmovl_u16(vget_high_u16(lo)),
+                               vmovl_u16(vget_low_u16(hi)), vmovl_u16(vget_high_u16(hi))};
+            for (size_t j = 0; j < 4; ++j) {
+                vst1q_u64(out + i + j * 4, vmovl_u32(vget_low_u32(q[j])));
+                vst1q_u64(out + i + j * 4 + 2, vmovl_u32(vget_high_u32(q[j])));
+            }
+            p += 16;
+            i += 16;
+            continue;
+        }
+        const uint8_t *wend = p + 16;
+        while (i < n && p < wend && DecodeOne64(p, end, out[i])) ++i;
+        if (p < wend) break;
+    }
+    while (i < n && DecodeOne64(p, end, out[i])) ++i;
+    *consumed = p - in;
+    return i;
+}
+
+void ByteSwapNeon(void *dst, const void *src, size_t n, size_t width) {
+    if (width != 2 && width != 4 && width != 8) return ByteSwapScalar(dst, src, n, width);
+    uint8_t *d = static_cast<uint8_t *>(dst);
+    const uint8_t *s = static_cast<const uint8_t *>(src);
+    size_t bytes = n * width;
+    size_t off = 0;
+    for (; off + 16 <= bytes; off += 16) {
+        uint8x16_t v = vld1q_u8(s + off);
+        v = width == 2 ? vrev16q_u8(v) : (width == 4 ? vrev32q_u8(v) : vrev64q_u8(v));
+        vst1q_u8(d + off, v);
+    }
+    ByteSwapScalar(d + off, s + off, (bytes - off) / width, width);
+}
+
+#endif // SUNSHINE_SIMD_NEON
+
+/* ========================= 运行时分派 ========================= */
+
+struct Kernels {
+    size_t (*encode32)(const uint32_t *, size_t, uint8_t *);
+    size_t (*encode64)(const uint64_t *, size_t, uint8_t *);
+    size_t (*decode32)(const uint8_t *, size_t, uint32_t *, size_t, size_t *);
+    size_t (*decode64)(const uint8_t *, size_t, uint64_t *, size_t, size_t *);
+    void (*bswap)(void *, const void *, size_t, size_t);
+    const char *name;
+};
+
+Kernels SelectKernels() {
+    Kernels k = {EncodeVarint32Scalar, EncodeVarint64Scalar, DecodeVarint32Scalar, DecodeVarint64Scalar,
+                 ByteSwapScalar, "scalar"};
+#if defined(SUNSHINE_SIMD_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2")) {
+        k = {EncodeVarint32Avx2, EncodeVarint64Avx2, DecodeVarint32Avx2, DecodeVarint64Avx2, ByteSwapAvx2, "avx2"};
+    } else if (__builtin_cpu_supports("sse4.1")) {
+        k = {EncodeVarint32Sse, EncodeVarint64Scalar, DecodeVarint32Sse, DecodeVarint64Sse, ByteSwapSse, "sse4.1"};
+    }
+#elif defined(SUNSHINE_SIMD_NEON)
+    k = {EncodeVarint32Scalar, EncodeVarint64Scalar, DecodeVarint32Neon, DecodeVarint64Neon, ByteSwapNeon, "neon"};
+#endif
+    return k;
+}
+
+const Kernels &GetKernels() {
+    static const Kernels s_kernels = SelectKernels();
+    return s_kernels;
+}
+
+} // namespace
+
+size_t SimdCodec::EncodeVarint32(const uint32_t *in, size_t n, uint8_t *out) {
+    return GetKernels().encode32(in, n, out);
+}
+
+size_t SimdCodec::EncodeVarint64(const uint64_t *in, size_t n, uint8_t *out) {
+    return GetKernels().encode64(in, n, out);
+}
+
+size_t SimdCodec::DecodeVarint32(const uint8_t *in, size_t len, uint32_t *out, size_t n, size_t *consumed) {
+    return GetKernels().decode32(in, len, out, n, consumed);
+}
+
+size_t SimdCodec::DecodeVarint64(const uint8_t *in, size_t len, uint64_t *out, size_t n, size_t *consumed) {
+    return GetKernels().decode64(in, len, out, n, consumed);
+}
+
+void SimdCodec::ByteSwap(void *dst, const void *src, size_t n, size_t width) {
+    GetKernels().bswap(dst, src, n, width);
+}
+
+const char *SimdCodec::Backend() {
+    return GetKernels().name;
+}
+
+} // namespace sunshine
@@ -1,7 +1,11 @@
 #include "libs/socket.h"
 #include "libs/address.h"
+#include "libs/Config.h"
+#include "libs/dns_resolver.h"
+#include "libs/hook.h"
 #include "libs/iomanager.h"
 #include "libs/log.h"
+#include "libs/timer.h"
 
 #include <cstring>
 #include <memory>
@@ -14,6 +18,9 @@
 #include <errno.h>
 #include <sys/time.h>
 #include <net/if.h> // IF_NAMESIZE, if_indextoname
+#include <limits.h>  // IOV_MAX
+#include <linux/errqueue.h>
+#include <vector>
 
 // 可移植的 likely/unlikely hints 宏
 #if defined(__has_builtin)
@@ -37,6 +44,10 @@ namespace sunshine {
 // logger（替换为你的日志实例构造方式）
 static Logger::ptr g_logger = std::make_shared<Logger>("system");
 
+// 零拷贝的固定开销（固定用户页 + 完成通知）只在大块发送时划算，小块仍走普通拷贝
+static ConfigVar<uint32_t>::ptr g_socket_zerocopy_threshold =
+    Config::Lookup<uint32_t>("socket.zerocopy_threshold", 16 * 1024, "min bytes per send to use MSG_ZEROCOPY");
+
 // ----------------------------
 // 辅助：把 sockaddr_storage -> Address::ptr
 // ----------------------------
@@ -198,6 +209,21 @@ bool Socket::init(int sock) {
     return true;
 }
 
+bool Socket::initAccepted(int sock, const sockaddr *peer, socklen_t peerlen) {
+    if (sock < 0) return false;
+    m_socket = sock;
+    m_isConnected = true;
+    m_localAddress.reset();
+    m_remoteAddress = peer ? createAddressFromSockaddr(peer, peerlen) : nullptr;
+#ifdef TCP_NODELAY
+    if (m_type == SOCK_STREAM) {
+        int val = 1;
+        ::setsockopt(m_socket, IPPROTO_TCP, TCP_NODELAY, &val, static_cast<socklen_t>(sizeof(val)));
+    }
+#endif
+    return true;
+}
+
 // ----------------------------
 // bind（检查 family 后 bind）
 // ----------------------------
@@ -225,18 +251,19 @@ bool Socket::bind(const Address::ptr addr) {
         return false;
     }
 
-    // 更新本地地址缓存
+    // 更新本地地址缓存（init 时缓存的可能是 bind 之前的地址）
+    m_localAddress.reset();
     getLocalAddress();
     return true;
 }
 
 // ----------------------------
-// connect_with_timeout：辅助函数（非成员）
+// poll_connect_with_timeout：辅助函数（非成员，未开启 hook 的线程使用）
 // - 临时把 socket 设为非阻塞（若原来是阻塞），发起 connect，poll 等待可写 / 超时
 // - 成功后恢复原有 socket flags
 // 返回 0 成功，-1 失败（errno 被设置）
 // ----------------------------
-static int connect_with_timeout(int sockfd, const struct sockaddr *addr, socklen_t addrlen, int timeout_ms) {
+static int poll_connect_with_timeout(int sockfd, const struct sockaddr *addr, socklen_t addrlen, int timeout_ms) {
     // 获取原 flags
     int flags = fcntl(sockfd, F_GETFL, 0);
     if (flags == -1) return -1;
@@ -326,8 +353,11 @@ bool Socket::connect(const Address::ptr addr, uint64_t timeout_ms) {
     int rt = 0;
     if (timeout_ms == (uint64_t)-1) {
         rt = ::connect(m_socket, addr->getAddr(), addr->getAddrLen());
+    } else if (sunshine::is_hook_enable()) {
+        // hook 线程上让出协程等待可写，不阻塞工作线程
+        rt = ::connect_with_timeout(m_socket, addr->getAddr(), addr->getAddrLen(), timeout_ms);
     } else {
-        rt = connect_with_timeout(m_socket, addr->getAddr(), addr->getAddrLen(), static_cast<int>(timeout_ms));
+        rt = poll_connect_with_timeout(m_socket, addr->getAddr(), addr->getAddrLen(), static_cast<int>(timeout_ms));
     }
 
     if (rt != 0) {
@@ -338,11 +368,27 @@ bool Socket::connect(const Address::ptr addr, uint64_t timeout_ms) {
 
     m_isConnected = true;
     // 更新远端/本地地址缓存
+    m_remoteAddress.reset();
+    m_localAddress.reset();
     getRemoteAddress();
     getLocalAddress();
     return true;
 }
 
+bool Socket::connect(const std::string &host, uint64_t timeout_ms) {
+    DnsResolver::Addrs addrs = DnsResolver::GetInstance().resolve(host, m_family, m_type, m_protocol);
+    if (!addrs) {
+        LOG_ERROR(g_logger) << "connect resolve(" << host << ") failed";
+        return false;
+    }
+    for (auto &addr : *addrs) {
+        if (connect(addr, timeout_ms)) return true;
+        // 连接失败后 fd 的状态不确定，换下一个地址前重建
+        close();
+    }
+    return false;
+}
+
 // ----------------------------
 // listen / close
 // ----------------------------
@@ -466,6 +512,108 @@ int Socket::recvFrom(iovec *buffers, size_t length, Address::ptr &peer, int flag
     return static_cast<int>(n);
 }
 
+// ----------------------------
+// ByteArray 直接收发（iovec 指向 ByteArray 的节点内存）
+// ----------------------------
+// 单次 sendmsg / recvmsg 超过 IOV_MAX 个 iovec 会直接失败（EMSGSIZE），按节点大小截断长度
+// 起始节点可能只用到一部分，所以按 IOV_MAX - 1 个整节点算
+static size_t clampIovLength(const ByteArray &ba, size_t length) {
+    size_t max_len = static_cast<size_t>(IOV_MAX - 1) * ba.getBaseSize();
+    return length > max_len ? max_len : length;
+}
+
+int Socket::send(ByteArray &ba, size_t length, int flags) {
+    if (!m_isConnected) return -1;
+    std::vector<iovec> iovs;
+    size_t len = ba.getReadBuffers(iovs, clampIovLength(ba, length));
+    if (len == 0) return 0;
+
+    bool zc = m_zeroCopy && len >= g_socket_zerocopy_threshold->getValue();
+    if (zc) flags |= MSG_ZEROCOPY;
+    int n = send(iovs.data(), iovs.size(), flags);
+    if (n > 0) {
+        if (zc) ++m_zcSent;
+        ba.setPosition(ba.getPosition() + n);
+    }
+    return n;
+}
+
+int Socket::send(const ByteSlice &slice, size_t offset, int flags) {
+    if (!m_isConnected) return -1;
+    std::vector<iovec> iovs;
+    if (slice.getIovecs(iovs, offset) == 0) return 0;
+    if (iovs.size() > IOV_MAX) iovs.resize(IOV_MAX);
+    return send(iovs.data(), iovs.size(), flags);
+}
+
+int Socket::recv(ByteArray &ba, size_t length, int flags) {
+    if (!m_isConnected) return -1;
+    std::vector<iovec> iovs;
+    if (ba.getWriteBuffers(iovs, clampIovLength(ba, length)) == 0) return 0;
+    int n = recv(iovs.data(), iovs.size(), flags);
+    if (n > 0) ba.setPosition(ba.getPosition() + n);
+    return n;
+}
+
+// ----------------------------
+// MSG_ZEROCOPY
+// ----------------------------
+bool Socket::setZeroCopy(bool v) {
+    if (v == m_zeroCopy) return true;
+    int val = v ? 1 : 0;
+    if (!setOption(SOL_SOCKET, SO_ZEROCOPY, val)) {
+        LOG_WARN(g_logger) << "setsockopt SO_ZEROCOPY sock=" << m_socket << " errno=" << errno
+                           << " errstr=" << strerror(errno);
+        return false;
+    }
+    m_zeroCopy = v;
+    return true;
+}
+
+// 完成通知是错误队列上的 sock_extended_err：ee_info..ee_data 是一段已完成的发送序号（闭区间）
+// 内核退化为拷贝（例如回环地址、网卡不支持 scatter-gather）时带 SO_EE_CODE_ZEROCOPY_COPIED，
+// 这时零拷贝只剩额外开销，之后的发送不再带 MSG_ZEROCOPY
+int Socket::reapZeroCopy() {
+    if (!isValid()) return -1;
+    int done = 0;
+    while (getZeroCopyPending() > 0) {
+        char control[CMSG_SPACE(sizeof(sock_extended_err)) + CMSG_SPACE(sizeof(sockaddr_in6))];
+        msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        // 错误队列读取从不阻塞，直接调用原始实现，避免 hook 把 EAGAIN 变成等待可读
+        if (recvmsg_f(m_socket, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return done > 0 ? done : -1;
+        }
+        for (cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+            bool recverr = (cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR)
+                           || (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR);
+            if (!recverr) continue;
+            const sock_extended_err *serr = reinterpret_cast<const sock_extended_err *>(CMSG_DATA(cm));
+            if (serr->ee_errno != 0 || serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY) continue;
+            uint32_t count = serr->ee_data - serr->ee_info + 1;
+            m_zcDone += count;
+            done += static_cast<int>(count);
+            if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) m_zeroCopy = false;
+        }
+    }
+    return done;
+}
+
+// 通知经错误队列到达，epoll 上只表现为 EPOLLERR，没有单独的事件可等，这里按 1ms 间隔轮询
+// （在 hook 线程上 usleep 是协程睡眠，不会阻塞工作线程）
+bool Socket::waitZeroCopy(int64_t timeout_ms) {
+    uint64_t deadline = timeout_ms < 0 ? ~0ull : TimerManager::GetCurrentMS() + timeout_ms;
+    while (true) {
+        if (reapZeroCopy() < 0) return false;
+        if (getZeroCopyPending() == 0) return true;
+        if (TimerManager::GetCurrentMS() >= deadline) return false;
+        ::usleep(1000);
+    }
+}
+
 // ----------------------------
 // 本地/远端地址查询
 // ----------------------------
@@ -0,0 +1,157 @@
+// file: libs/stack_pool.cpp
+#include "libs/stack_pool.h"
+#include "libs/Config.h"
+
+#include <atomic>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace sunshine {
+
+static ConfigVar<uint32_t>::ptr g_fiber_stack_size =
+    Config::Lookup<uint32_t>("fiber.stack_size", 128 * 1024, "fiber stack size");
+static ConfigVar<uint32_t>::ptr g_stack_pool_max =
+    Config::Lookup<uint32_t>("fiber.stack_pool_max", 128, "max cached fiber stacks per thread");
+
+// 配置缓存：Alloc / Free 在每个任务的创建 / 销毁路径上，避免每次都去拿 ConfigVar 的读锁
+static std::atomic<size_t> s_pool_stack_size{0};
+static std::atomic<uint32_t> s_pool_max{0};
+
+static std::atomic<uint64_t> s_total_mapped{0};
+static std::atomic<uint64_t> s_live_stacks{0};
+
+namespace {
+
+struct _StackPoolIniter {
+    _StackPoolIniter() {
+        s_pool_stack_size = StackPool::RoundToPage(g_fiber_stack_size->getValue());
+        s_pool_max = g_stack_pool_max->getValue();
+        g_fiber_stack_size->addListener(0x5354414B, [](const uint32_t &, const uint32_t &new_val) {
+            s_pool_stack_size = StackPool::RoundToPage(new_val);
+        });
+        g_stack_pool_max->addListener(0x5354414B, [](const uint32_t &, const uint32_t &new_val) {
+            s_pool_max = new_val;
+        });
+    }
+};
+
+static _StackPoolIniter s_stack_pool_initer;
+
+// 空闲栈链表节点：直接写在空闲栈可用区域的起始处
+struct FreeNode {
+    FreeNode *next;
+    size_t size;
+};
+
+// 线程局部的空闲栈缓存
+struct ThreadCache {
+    FreeNode *head = nullptr;
+    size_t count = 0;
+
+    ~ThreadCache();
+};
+
+// 线程退出析构缓存之后，仍可能有协程在该线程销毁（例如静态对象持有的协程），
+// 这时直接 munmap；该标记是平凡类型，析构后依然可读
+static thread_local bool t_cache_destroyed = false;
+static thread_local ThreadCache t_cache;
+
+ThreadCache::~ThreadCache() {
+    t_cache_destroyed = true;
+    while (head) {
+        FreeNode *n = head;
+        head = n->next;
+        StackPool::Unmap(n, n->size);
+    }
+    count = 0;
+}
+
+static size_t PageSize() {
+    static size_t s_page = (size_t)sysconf(_SC_PAGESIZE);
+    return s_page;
+}
+
+} // namespace
+
+size_t StackPool::RoundToPage(size_t size) {
+    size_t page = PageSize();
+    if (size == 0) size = page;
+    return (size + page - 1) & ~(page - 1);
+}
+
+size_t StackPool::DefaultSize() {
+    size_t size = s_pool_stack_size.load(std::memory_order_relaxed);
+    // 静态初始化阶段（配置尚未读入）使用默认值
+    return size ? size : RoundToPage(128 * 1024);
+}
+
+void *StackPool::Map(size_t size) {
+    size_t page = PageSize();
+    size = RoundToPage(size);
+    void *base = mmap(nullptr, size + page, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+    if (base == MAP_FAILED) throw std::bad_alloc();
+    // 栈向低地址增长：最低的一页设为保护页
+    if (mprotect(base, page, PROT_NONE) != 0) {
+        munmap(base, size + page);
+        throw std::bad_alloc();
+    }
+    s_total_mapped.fetch_add(1, std::memory_order_relaxed);
+    s_live_stacks.fetch_add(1, std::memory_order_relaxed);
+    return static_cast<char *>(base) + page;
+}
+
+void StackPool::Unmap(void *stack, size_t size) {
+    if (!stack) return;
+    size_t page = PageSize();
+    munmap(static_cast<char *>(stack) - page, RoundToPage(size) + page);
+    s_live_stacks.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void *StackPool::Alloc(size_t &size) {
+    size = RoundToPage(size);
+    if (size == s_pool_stack_size.load(std::memory_order_relaxed) && !t_cache_destroyed) {
+        ThreadCache &cache = t_cache;
+        while (cache.head) {
+            FreeNode *n = cache.head;
+            cache.head = n->next;
+            --cache.count;
+            if (n->size == size) return n;
+            // 配置修改前缓存的旧尺寸栈
+            Unmap(n, n->size);
+        }
+    }
+    return Map(size);
+}
+
+void StackPool::Free(void *stack, size_t size) {
+    if (!stack) return;
+    size = RoundToPage(size);
+    if (size == s_pool_stack_size.load(std::memory_order_relaxed) && !t_cache_destroyed) {
+        ThreadCache &cache = t_cache;
+        if (cache.count < s_pool_max.load(std::memory_order_relaxed)) {
+            FreeNode *n = static_cast<FreeNode *>(stack);
+            n->next = cache.head;
+            n->size = size;
+            cache.head = n;
+            ++cache.count;
+            return;
+        }
+    }
+    Unmap(stack, size);
+}
+
+size_t StackPool::CachedCount() {
+    return t_cache_destroyed ? 0 : t_cache.count;
+}
+
+uint64_t StackPool::TotalMapped() {
+    return s_total_mapped.load(std::memory_order_relaxed);
+}
+
+uint64_t StackPool::LiveStacks() {
+    return s_live_stacks.load(std::memory_order_relaxed);
+}
+
+} // namespace sunshine
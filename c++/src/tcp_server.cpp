@@ -0,0 +1,179 @@
+// file: libs/tcp_server.cpp
+#include "libs/tcp_server.h"
+#include "libs/Config.h"
+#include "libs/fd_manager.h"
+#include "libs/fiber.h"
+#include "libs/hook.h"
+#include "libs/log.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <functional>
+#include <string.h>
+
+namespace sunshine {
+
+static Logger::ptr g_logger = std::make_shared<Logger>("system");
+
+static ConfigVar<int>::ptr g_backlog =
+    Config::Lookup<int>("tcp_server.backlog", SOMAXCONN, "listen backlog of TcpServer sockets");
+static ConfigVar<uint32_t>::ptr g_accept_batch =
+    Config::Lookup<uint32_t>("tcp_server.accept_batch", 64, "max connections accepted per wakeup");
+static ConfigVar<uint64_t>::ptr g_read_timeout =
+    Config::Lookup<uint64_t>("tcp_server.read_timeout", 120000, "client recv timeout in ms, 0 for none");
+static ConfigVar<std::vector<int>>::ptr g_server_ports =
+    Config::Lookup<std::vector<int>>("server.ports", std::vector<int>(), "ports bound by TcpServer::bindConfigPorts");
+
+// fd 用完时暂停多久再 accept（监听 fd 一直可读，立即重试只会空转）
+static const uint64_t ACCEPT_RETRY_MS = 100;
+
+TcpServer::TcpServer(IOManager *worker, IOManager *acceptor) :
+    m_worker(worker), m_acceptor(acceptor) {
+}
+
+TcpServer::~TcpServer() {
+    // accept 协程持有服务器的引用，走到这里时它们都已退出并关闭了各自的监听 socket
+    for (auto &sock : m_socks) sock->close();
+}
+
+bool TcpServer::bind(Address::ptr addr) {
+    std::vector<Address::ptr> addrs{addr}, fails;
+    return bind(addrs, fails);
+}
+
+bool TcpServer::bind(const std::vector<Address::ptr> &addrs, std::vector<Address::ptr> &fails) {
+    std::vector<Socket::ptr> socks;
+    for (auto &addr : addrs) {
+        if (!addr) continue;
+        auto sock = std::make_shared<Socket>(addr->getFamily(), SOCK_STREAM, 0);
+        if (!sock->bind(addr) || !sock->listen(g_backlog->getValue())) {
+            LOG_ERROR(g_logger) << "TcpServer " << m_name << " bind/listen " << addr->toString()
+                                << " failed errno=" << errno << " " << strerror(errno);
+            fails.push_back(addr);
+            continue;
+        }
+        // 登记到 FdManager：系统层非阻塞，accept 协程自己处理 EAGAIN
+        FdManager::GetInstance().del(sock->getSocket());
+        FdManager::GetInstance().get(sock->getSocket(), true);
+        socks.push_back(sock);
+    }
+    if (!fails.empty()) {
+        for (auto &sock : socks) sock->close();
+        return false;
+    }
+    for (auto &sock : socks) {
+        LOG_INFO(g_logger) << "TcpServer " << m_name << " listening on " << sock->getLocalAddress()->toString();
+        m_socks.push_back(sock);
+    }
+    return true;
+}
+
+bool TcpServer::bindConfigPorts(const std::string &host) {
+    std::vector<Address::ptr> addrs, fails;
+    for (int port : g_server_ports->getValue()) {
+        auto addr = Address::LookupAny(host + ":" + std::to_string(port), AF_UNSPEC, SOCK_STREAM);
+        if (!addr) {
+            LOG_ERROR(g_logger) << "TcpServer " << m_name << " bad address " << host << ":" << port;
+            return false;
+        }
+        addrs.push_back(addr);
+    }
+    if (addrs.empty()) return false;
+    return bind(addrs, fails);
+}
+
+bool TcpServer::start() {
+    if (m_socks.empty() || m_started.exchange(true)) return false;
+    auto self = shared_from_this();
+    for (auto &sock : m_socks) {
+        m_acceptor->scheduler([self, sock]() { self->acceptLoop(sock); });
+    }
+    return true;
+}
+
+// 先置位再取消事件：accept 协程注册事件后会再检查一次标记，两者至少有一方能唤醒它
+void TcpServer::stop() {
+    if (m_stopping.exchange(true, std::memory_order_seq_cst)) return;
+    for (auto &sock : m_socks) m_acceptor->cancelAll(sock->getSocket());
+}
+
+std::vector<Address::ptr> TcpServer::getLocalAddresses() const {
+    std::vector<Address::ptr> addrs;
+    for (auto &sock : m_socks) addrs.push_back(sock->getLocalAddress());
+    return addrs;
+}
+
+void TcpServer::handleClient(Socket::ptr client) {
+    LOG_INFO(g_logger) << "TcpServer " << m_name << " handleClient " << client->getRemoteAddress()->toString();
+}
+
+void TcpServer::acceptLoop(Socket::ptr sock) {
+    const int fd = sock->getSocket();
+    const size_t batch = std::max<uint32_t>(1, g_accept_batch->getValue());
+    Fiber::ptr self_fiber = Fiber::GetThis()->shared_from_this();
+    std::vector<std::function<void()>> tasks;
+    tasks.reserve(batch);
+    auto self = shared_from_this();
+
+    while (!isStop()) {
+        bool exhausted = false; // 本轮已经取到 EAGAIN
+        bool pause = false;     // fd 用完等可恢复的资源错误
+        while (tasks.size() < batch) {
+            sockaddr_storage ss;
+            socklen_t len = sizeof(ss);
+            int c = accept4_f(fd, reinterpret_cast<sockaddr *>(&ss), &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (c < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    exhausted = true;
+                } else {
+                    LOG_ERROR(g_logger) << "TcpServer " << m_name << " accept4 failed errno=" << errno << " "
+                                        << strerror(errno);
+                    pause = true;
+                }
+                break;
+            }
+            // SOCK_NONBLOCK 已经是系统层非阻塞，FdCtx::init 不必再 fcntl；用户层仍是阻塞语义
+            // 新 fd 没有等待者，不走 del（CancelAllEverywhere 要取全局的 IOManager 登记表锁）
+            FdCtx::ptr ctx = FdManager::GetInstance().reset(c);
+            uint64_t timeout = g_read_timeout->getValue();
+            if (ctx && timeout) ctx->setTimeout(SO_RCVTIMEO, timeout);
+
+            auto client = std::make_shared<Socket>(sock->getFamily(), SOCK_STREAM, 0);
+            client->initAccepted(c, reinterpret_cast<sockaddr *>(&ss), len);
+            m_connections.fetch_add(1, std::memory_order_relaxed);
+            tasks.emplace_back([self, client]() {
+                struct Done {
+                    TcpServer *server;
+                    ~Done() {
+                        server->m_connections.fetch_sub(1, std::memory_order_relaxed);
+                    }
+                } done{self.get()};
+                self->handleClient(client);
+            });
+        }
+        if (!tasks.empty()) {
+            m_worker->scheduler(std::make_move_iterator(tasks.begin()), std::make_move_iterator(tasks.end()));
+            tasks.clear();
+        }
+
+        if (pause) {
+            m_acceptor->addTimer(ACCEPT_RETRY_MS, [this, self_fiber]() { m_acceptor->scheduler(self_fiber); });
+            Fiber::YieldToHold();
+        } else if (!exhausted) {
+            // 取满一批：让出一次给其他任务，之后直接继续取
+            Fiber::YieldToReady();
+        } else {
+            if (m_acceptor->addEvent(fd, IOManager::READ) != 0) {
+                LOG_ERROR(g_logger) << "TcpServer " << m_name << " addEvent failed errno=" << errno;
+                break;
+            }
+            if (isStop()) m_acceptor->cancelEvent(fd, IOManager::READ);
+            Fiber::YieldToHold();
+        }
+    }
+    sock->close();
+    LOG_INFO(g_logger) << "TcpServer " << m_name << " stopped accepting on fd=" << fd;
+}
+
+} // namespace sunshine
@@ -1,149 +1,209 @@
-// thread.cpp
+// file: libs/thread.cpp
 #include "libs/thread.h"
-#include <libs/log.h>
-#include <iostream>
+#include "libs/log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <sched.h>
 #include <stdexcept>
-#include <atomic>
-#include <cstring> // for strncpy
-#include <functional>
-#ifdef __linux__
-#include <sys/syscall.h> // syscall, SYS_gettid
+#include <sys/syscall.h>
 #include <unistd.h>
-#endif
 
 namespace sunshine {
 
 // 线程局部变量：当前线程对应的 Thread*（供 Thread::GetThis() 使用）
 static thread_local Thread *t_thread = nullptr;
-// 线程局部变量：当前线程名（供 Thread::SetName() / 调试使用）
+// 线程局部变量：当前线程名（供 Thread::GetName() / 调试使用）
 static thread_local std::string t_thread_name = "UNKNOWN";
 
-// 构造函数：接收回调和线程名，创建 pthread 并启动线程
-Thread::Thread(std::function<void()> cb, std::string &name) :
-    m_cb(std::move(cb)), m_name(name), m_thread(0), m_id(0) {
-    // 在创建 pthread 之前，确保回调有效
+// pthread_setname_np 的名字最长 15 字符（含终止符 16）
+static void SetPthreadName(const std::string &name) {
+    char buf[16];
+    std::strncpy(buf, name.c_str(), sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    pthread_setname_np(pthread_self(), buf); // 失败不影响功能
+}
+
+// 构造函数：创建 pthread，等新线程设置好 id / 名字 / 亲和性后返回
+Thread::Thread(std::function<void()> cb, const std::string &name, std::vector<int> cpus) :
+    m_name(name), m_cpus(std::move(cpus)), m_cb(std::move(cb)) {
     if (!m_cb) {
         throw std::invalid_argument("Thread callback is empty");
     }
-
-    // 创建 pthread，传入 this 指针作为参数
-    // pthread_create 会在成功返回后把 pthread id 写入 m_thread
     int rt = pthread_create(&m_thread, nullptr, &Thread::run, this);
     if (rt != 0) {
-        // 若创建失败，抛出异常并让调用方处理
+        m_thread = 0;
         throw std::runtime_error(std::string("pthread_create failed: ") + std::strerror(rt));
     }
-
-    // 注意：此时线程已经开始执行 run(), 但 m_id 由 run() 内设置（线程自己设置）
+    m_started.acquire();
 }
 
-// 析构函数：如果线程仍然可 join 且未 join，选择 detach（避免 std::terminate）
-// 也可以根据需要改为强制 join（可能阻塞析构），这里选择 detach 更安全
+// 析构函数：未 join 的线程 detach（避免 std::terminate 式的资源泄漏）
 Thread::~Thread() {
-    // 如果线程句柄有效且不是主线程的 t_thread（避免误 detach 主线程）：
     if (m_thread) {
-        // 尝试 detach：如果线程已被 join，则 pthread_detach 会返回 ESRCH 或 EINVAL
         int rt = pthread_detach(m_thread);
-        // 我们不抛异常，因为析构不能抛出；把错误打印出来以便调试
         if (rt != 0 && rt != ESRCH && rt != EINVAL) {
-            LOG_ERROR(Log::LogManager::GetInstance().getRoot())
-                << "Thread::~Thread: pthread_detach failed: "
-                << std::strerror(rt) << "\n";
+            LOG_ERROR(LogManager::GetInstance().getRoot()) << "Thread::~Thread: pthread_detach failed: "
+                                                           << std::strerror(rt);
         }
-        m_thread = 0; // 避免重复操作
+        m_thread = 0;
     }
 }
 
-// 获取线程 id（内核线程 id 或由实现决定）
-// 在 Linux 下用 syscall(SYS_gettid) 获取真实 tid；在其它平台用 hash(pthread_t)
-uint32_t Thread::getId() {
-    return m_id;
-}
-
-// 阻塞等待线程结束
 void Thread::join() {
-    if (!m_thread) {
-        return; // 线程尚未创建或已被处理
-    }
+    if (!m_thread) return; // 尚未创建或已经 join
     int rt = pthread_join(m_thread, nullptr);
     if (rt != 0) {
-        // join 失败，抛异常让调用方知晓
         throw std::runtime_error(std::string("pthread_join failed: ") + std::strerror(rt));
     }
-    // join 成功后清理
     m_thread = 0;
 }
 
-// 返回当前线程对应的 Thread*，若不是由本类创建的线程则返回 nullptr
 Thread *Thread::GetThis() {
     return t_thread;
 }
 
-// 设置当前线程名字（仅影响调用该函数的线程）
-// 此函数也尝试同步到 pthread 名称（Linux: pthread_setname_np）
-void Thread::SetName(const std::string name) {
+const std::string &Thread::GetName() {
+    return t_thread_name;
+}
+
+void Thread::SetName(const std::string &name) {
+    if (name.empty()) return;
+    if (t_thread) t_thread->m_name = name;
     t_thread_name = name;
-#ifdef __linux__
-    // pthread_setname_np 名字长度限制为 16（包含终止符）
-    // 因此我们截断为 15 个字符
-    char buf[16];
-    std::strncpy(buf, name.c_str(), sizeof(buf) - 1);
-    buf[sizeof(buf) - 1] = '\0';
-    // 作用于当前线程
-    pthread_setname_np(pthread_self(), buf);
-#endif
+    SetPthreadName(name);
 }
 
-// 静态入口：pthread_create 需要的函数签名
-// 这里把 arg 转回 Thread*，然后在托管线程中执行用户回调
+bool Thread::SetAffinity(const std::vector<int> &cpus) {
+    if (cpus.empty()) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+// 线程入口：先设置好 id / 名字 / 亲和性，再通知构造函数，最后执行回调
+// 回调里的异常不允许逃出线程边界（会 terminate），记录日志后结束线程
 void *Thread::run(void *arg) {
-    Thread *thread_obj = static_cast<Thread *>(arg);
-    // 在新线程中设置线程局部变量，使 GetThis() 可用
-    t_thread = thread_obj;
-    t_thread_name = thread_obj->m_name;
-
-    // 如果需要设置内核 tid 到对象中（让主线程可以通过 getId() 读取）
-#ifdef __linux__
-    // Linux: 获取真实线程 id（tid）
-    pid_t tid = static_cast<pid_t>(::syscall(SYS_gettid));
-    thread_obj->m_id = static_cast<uint32_t>(tid);
-#else
-    // 非 Linux 平台：用 pthread_t 的 hash 值作为 id
-    std::hash<pthread_t> hasher;
-    thread_obj->m_id = static_cast<uint32_t>(hasher(pthread_self()));
-#endif
-
-    // 尝试设置 pthread 名称（便于调试）
-#ifdef __linux__
-    {
-        char buf[16];
-        std::strncpy(buf, thread_obj->m_name.c_str(), sizeof(buf) - 1);
-        buf[sizeof(buf) - 1] = '\0';
-        // 忽略返回值：设置失败通常不影响功能
-        pthread_setname_np(pthread_self(), buf);
+    Thread *thread = static_cast<Thread *>(arg);
+    t_thread = thread;
+    t_thread_name = thread->m_name;
+    thread->m_id = static_cast<uint32_t>(::syscall(SYS_gettid));
+    SetPthreadName(thread->m_name);
+    if (!thread->m_cpus.empty() && !SetAffinity(thread->m_cpus)) {
+        LOG_WARN(LogManager::GetInstance().getRoot()) << "Thread " << thread->m_name << ": set affinity failed";
     }
-#endif
 
-    // 执行用户回调，捕获异常以避免异常逃出线程边界（会导致 terminate）
+    std::function<void()> cb;
+    cb.swap(thread->m_cb);
+    thread->m_started.release(); // 之后 thread 可能随时被析构（detach），不再访问它
+
     try {
-        thread_obj->m_cb();
+        cb();
     } catch (const std::exception &ex) {
-        LOG_ERROR(Log::LogManager::GetInstance().getRoot())
-            << "Thread caught std::exception: "
-            << ex.what() << "\n";
+        LOG_ERROR(LogManager::GetInstance().getRoot()) << "Thread caught std::exception: " << ex.what();
     } catch (...) {
-        LOG_ERROR(Log::LogManager::GetInstance().getRoot())
-            << "Thread caught unknown exception"
-            << "\n";
+        LOG_ERROR(LogManager::GetInstance().getRoot()) << "Thread caught unknown exception";
     }
-
-    // 线程函数返回前清理线程局部变量（可选）
     t_thread = nullptr;
     t_thread_name = "UNKNOWN";
-
     return nullptr;
 }
-const std::string &Thread::getName() const {
-    return m_name;
+
+// ---------- CpuTopology ----------
+
+// 解析 cpulist 格式（如 "0-3,8,10-11"）
+static std::vector<int> ParseCpuList(const std::string &s) {
+    std::vector<int> out;
+    size_t pos = 0;
+    while (pos < s.size()) {
+        size_t comma = s.find(',', pos);
+        if (comma == std::string::npos) comma = s.size();
+        std::string item = s.substr(pos, comma - pos);
+        size_t dash = item.find('-');
+        char *end = nullptr;
+        long lo = std::strtol(item.c_str(), &end, 10);
+        if (end != item.c_str()) {
+            long hi = dash == std::string::npos ? lo : std::strtol(item.c_str() + dash + 1, nullptr, 10);
+            for (long c = lo; c <= hi; ++c) out.push_back(static_cast<int>(c));
+        }
+        pos = comma + 1;
+    }
+    return out;
+}
+
+namespace {
+
+struct Topology {
+    std::vector<int> allowed;
+    std::vector<int> nodes;
+    std::vector<int> nodeOf; // 下标为 CPU 编号
+
+    Topology() {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (int c = 0; c < CPU_SETSIZE; ++c) {
+                if (CPU_ISSET(c, &set)) allowed.push_back(c);
+            }
+        }
+        if (allowed.empty()) {
+            long n = sysconf(_SC_NPROCESSORS_ONLN);
+            for (long c = 0; c < std::max(1L, n); ++c) allowed.push_back(static_cast<int>(c));
+        }
+        nodeOf.assign(allowed.back() + 1, 0);
+
+        if (DIR *dir = opendir("/sys/devices/system/node")) {
+            while (dirent *e = readdir(dir)) {
+                int node = 0;
+                if (std::sscanf(e->d_name, "node%d", &node) != 1) continue;
+                std::ifstream in(std::string("/sys/devices/system/node/") + e->d_name + "/cpulist");
+                std::string list;
+                std::getline(in, list);
+                for (int c : ParseCpuList(list)) {
+                    if (c >= 0 && c < static_cast<int>(nodeOf.size())) nodeOf[c] = node;
+                }
+            }
+            closedir(dir);
+        }
+        for (int c : allowed) nodes.push_back(nodeOf[c]);
+        std::sort(nodes.begin(), nodes.end());
+        nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+    }
+};
+
+const Topology &GetTopology() {
+    static Topology s_topology;
+    return s_topology;
+}
+
+} // namespace
+
+const std::vector<int> &CpuTopology::AllowedCpus() {
+    return GetTopology().allowed;
+}
+
+const std::vector<int> &CpuTopology::Nodes() {
+    return GetTopology().nodes;
 }
+
+std::vector<int> CpuTopology::NodeCpus(int node) {
+    const Topology &t = GetTopology();
+    std::vector<int> out;
+    for (int c : t.allowed) {
+        if (t.nodeOf[c] == node) out.push_back(c);
+    }
+    return out;
+}
+
+int CpuTopology::NodeOf(int cpu) {
+    const Topology &t = GetTopology();
+    return cpu >= 0 && cpu < static_cast<int>(t.nodeOf.size()) ? t.nodeOf[cpu] : 0;
+}
+
 } // namespace sunshine
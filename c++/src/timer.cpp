@@ -0,0 +1,276 @@
+// file: libs/timer.cpp
+#include "libs/timer.h"
+#include <algorithm>
+#include <chrono>
+
+namespace sunshine {
+
+// ---------- Timer ----------
+
+Timer::Timer(uint64_t ms, std::function<void()> cb, bool recurring, TimerManager *manager) :
+    m_recurring(recurring), m_ms(ms), m_cb(std::move(cb)), m_manager(manager) {
+    m_next = TimerManager::GetCurrentMS() + m_ms;
+}
+
+bool Timer::cancel() {
+    std::lock_guard<std::mutex> lock(m_manager->m_mutex);
+    if (!m_slot) return false; // 已到期或已取消
+    m_cb = nullptr;
+    // 取回时间轮持有的引用，离开作用域时（锁释放后）再析构
+    Timer::ptr self = m_manager->unlink(this);
+    return true;
+}
+
+bool Timer::refresh() {
+    bool at_front = false;
+    {
+        std::lock_guard<std::mutex> lock(m_manager->m_mutex);
+        if (!m_slot || !m_cb) return false;
+        Timer::ptr self = m_manager->unlink(this);
+        m_next = TimerManager::GetCurrentMS() + m_ms;
+        m_manager->link(self);
+        at_front = m_manager->checkInsertedAtFront(self);
+    }
+    if (at_front) m_manager->onTimerInsertedAtFront();
+    return true;
+}
+
+bool Timer::reset(uint64_t ms, bool from_now) {
+    bool at_front = false;
+    {
+        std::lock_guard<std::mutex> lock(m_manager->m_mutex);
+        if (!m_slot || !m_cb) return false;
+        if (ms == m_ms && !from_now) return true;
+        Timer::ptr self = m_manager->unlink(this);
+        uint64_t start = from_now ? TimerManager::GetCurrentMS() : m_next - m_ms;
+        m_ms = ms;
+        m_next = start + m_ms;
+        m_manager->link(self);
+        at_front = m_manager->checkInsertedAtFront(self);
+    }
+    if (at_front) m_manager->onTimerInsertedAtFront();
+    return true;
+}
+
+// ---------- TimerManager ----------
+
+TimerManager::TimerManager() {
+    m_current = GetCurrentMS();
+}
+
+TimerManager::~TimerManager() {
+    // 打断定时器自身引用形成的环，释放所有未到期定时器
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto &head : m_wheel0) {
+        while (head) unlink(head);
+    }
+    for (auto &level : m_wheelN) {
+        for (auto &head : level) {
+            while (head) unlink(head);
+        }
+    }
+}
+
+uint64_t TimerManager::GetCurrentMS() {
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+Timer::ptr TimerManager::addTimer(uint64_t ms, std::function<void()> cb, bool recurring) {
+    Timer::ptr timer(new Timer(ms, std::move(cb), recurring, this));
+    bool at_front = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        link(timer);
+        at_front = checkInsertedAtFront(timer);
+    }
+    if (at_front) onTimerInsertedAtFront();
+    return timer;
+}
+
+// 条件定时器的回调包装：条件对象已释放则不执行
+static void OnTimer(std::weak_ptr<void> weak_cond, std::function<void()> cb) {
+    std::shared_ptr<void> tmp = weak_cond.lock();
+    if (tmp) cb();
+}
+
+Timer::ptr TimerManager::addConditionTimer(uint64_t ms, std::function<void()> cb,
+                                           std::weak_ptr<void> weak_cond, bool recurring) {
+    return addTimer(ms, std::bind(&OnTimer, weak_cond, std::move(cb)), recurring);
+}
+
+bool TimerManager::hasTimer() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_count > 0;
+}
+
+// 新定时器早于当前唤醒点且尚未通知过时，需要打断等待
+bool TimerManager::checkInsertedAtFront(const Timer::ptr &timer) {
+    if (m_tickled || timer->m_next >= m_nextWake) return false;
+    m_tickled = true;
+    return true;
+}
+
+// 放置规则（与 Linux 内核经典时间轮一致）：
+// 以 m_current 为基准，距离到期 < 2^8 放第 0 层，< 2^14 放第 1 层，依此类推；
+// 超过 2^32 的按 2^32 放入最高层，cascade 时会用真实到期时间重新放置
+void TimerManager::link(Timer::ptr timer) {
+    uint64_t expires = std::max(timer->m_next, m_current);
+    uint64_t idx = expires - m_current;
+
+    Timer **head = nullptr;
+    int level = 0;
+    size_t index = 0;
+    if (idx < (1ull << WHEEL0_BITS)) {
+        index = expires & (WHEEL0_SIZE - 1);
+        head = &m_wheel0[index];
+        m_bits0[index / 64] |= (1ull << (index % 64));
+    } else {
+        if (idx > 0xffffffffull) expires = m_current + 0xffffffffull;
+        level = 1;
+        while (level < (int)LEVELS - 1 && idx >= (1ull << (WHEEL0_BITS + level * WHEELN_BITS))) {
+            ++level;
+        }
+        index = (expires >> (WHEEL0_BITS + (level - 1) * WHEELN_BITS)) & (WHEELN_SIZE - 1);
+        head = &m_wheelN[level - 1][index];
+        m_bitsN[level - 1] |= (1ull << index);
+    }
+
+    Timer *t = timer.get();
+    t->m_prev = nullptr;
+    t->m_nextNode = *head;
+    if (*head) (*head)->m_prev = t;
+    *head = t;
+    t->m_slot = head;
+    t->m_level = level;
+    t->m_index = (int)index;
+    t->m_self = std::move(timer);
+    ++m_count;
+}
+
+Timer::ptr TimerManager::unlink(Timer *t) {
+    if (t->m_prev) {
+        t->m_prev->m_nextNode = t->m_nextNode;
+    } else {
+        *t->m_slot = t->m_nextNode;
+    }
+    if (t->m_nextNode) t->m_nextNode->m_prev = t->m_prev;
+
+    // 槽位变空时清除位图
+    if (!*t->m_slot) {
+        if (t->m_level == 0) {
+            m_bits0[t->m_index / 64] &= ~(1ull << (t->m_index % 64));
+        } else {
+            m_bitsN[t->m_level - 1] &= ~(1ull << t->m_index);
+        }
+    }
+
+    t->m_prev = t->m_nextNode = nullptr;
+    t->m_slot = nullptr;
+    t->m_level = t->m_index = -1;
+    --m_count;
+    return std::move(t->m_self);
+}
+
+void TimerManager::cascade(size_t level, size_t index) {
+    Timer **head = &m_wheelN[level - 1][index];
+    while (*head) {
+        Timer::ptr t = unlink(*head);
+        link(std::move(t));
+    }
+}
+
+int TimerManager::findWheel0(size_t from) const {
+    for (size_t w = from / 64; w < WHEEL0_SIZE / 64; ++w) {
+        uint64_t bits = m_bits0[w];
+        if (w == from / 64) bits &= ~0ull << (from % 64);
+        if (bits) return (int)(w * 64 + __builtin_ctzll(bits));
+    }
+    return -1;
+}
+
+void TimerManager::advance(uint64_t now, std::vector<Timer::ptr> &expired) {
+    while (m_current <= now) {
+        size_t idx0 = m_current & (WHEEL0_SIZE - 1);
+        if (idx0 == 0) {
+            // 第 0 层转完一圈：依次把高层当前槽位下放
+            for (size_t level = 1; level < LEVELS; ++level) {
+                size_t idx = (m_current >> (WHEEL0_BITS + (level - 1) * WHEELN_BITS)) & (WHEELN_SIZE - 1);
+                cascade(level, idx);
+                if (idx != 0) break;
+            }
+        }
+
+        while (m_wheel0[idx0]) {
+            expired.push_back(unlink(m_wheel0[idx0]));
+        }
+        ++m_current;
+
+        // 快进：时间轮为空直接跳到 now；否则跳到第 0 层下一个非空槽位或下一次 cascade
+        if (m_count == 0) {
+            m_current = std::max(m_current, now + 1);
+            break;
+        }
+        if ((m_current & (WHEEL0_SIZE - 1)) == 0) continue;
+        int s = findWheel0(m_current & (WHEEL0_SIZE - 1));
+        uint64_t target = s >= 0 ? (m_current & ~(uint64_t)(WHEEL0_SIZE - 1)) + s
+                                 : (m_current | (WHEEL0_SIZE - 1)) + 1;
+        m_current = std::min(target, now + 1);
+    }
+}
+
+uint64_t TimerManager::getNextTimer() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_tickled = false;
+    if (m_count == 0) {
+        m_nextWake = ~0ull;
+        return ~0ull;
+    }
+
+    // 第 0 层环形查找：当前位置之后的槽位属于本圈，之前的槽位属于下一圈
+    uint64_t base = m_current & ~(uint64_t)(WHEEL0_SIZE - 1);
+    size_t idx0 = m_current & (WHEEL0_SIZE - 1);
+    uint64_t next;
+    int s = findWheel0(idx0);
+    if (s >= 0) {
+        next = base + s;
+    } else if ((s = findWheel0(0)) >= 0 && (size_t)s < idx0) {
+        next = base + WHEEL0_SIZE + s;
+    } else {
+        next = base + WHEEL0_SIZE; // 第 0 层为空，下一次 cascade 时再看
+    }
+
+    m_nextWake = next;
+    uint64_t now = GetCurrentMS();
+    return next > now ? next - now : 0;
+}
+
+void TimerManager::listExpiredCb(std::vector<std::function<void()>> &cbs) {
+    uint64_t now = GetCurrentMS();
+    std::vector<Timer::ptr> expired;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_count == 0) {
+            m_current = std::max(m_current, now + 1);
+            return;
+        }
+        if (m_current > now) return;
+
+        advance(now, expired);
+        cbs.reserve(cbs.size() + expired.size());
+        for (auto &timer : expired) {
+            if (!timer->m_cb) continue;
+            if (timer->m_recurring) {
+                cbs.push_back(timer->m_cb);
+                timer->m_next = now + timer->m_ms;
+                link(timer);
+            } else {
+                cbs.push_back(std::move(timer->m_cb));
+                timer->m_cb = nullptr;
+            }
+        }
+    }
+    // expired 在锁外析构，避免定时器析构（捕获对象的析构）在持锁期间发生
+}
+
+} // namespace sunshine
@@ -0,0 +1,144 @@
+// file: tests/fd_close_test.cpp
+// fd 关闭路径：协程阻塞在 read 上时由普通线程（未开启 hook）close 这个 fd，
+// 检查等待的协程被唤醒，以及复用同一个 fd 号的新 socket 还能正常等待就绪
+// 以及绕过 hook 用 close_f 直接关闭后，编号被新 fd 复用时旧的等待者被唤醒、新 fd 能正常等待
+// 分别在默认、持久注册（iomanager.persistent_et）和多 reactor 模式下运行
+#include "test_util.h"
+#include "libs/Config.h"
+#include "libs/fd_manager.h"
+#include "libs/hook.h"
+#include "libs/iomanager.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace sunshine;
+using sunshine_test::WaitUntil;
+
+// 创建一对 socket 并登记到 FdManager（hook 的读写只处理登记过的 socket）
+// 同 tcp_server：先 del 丢弃这个编号上可能残留的旧状态
+static bool makePair(int sv[2]) {
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) return false;
+    for (int i = 0; i < 2; ++i) {
+        FdManager::GetInstance().del(sv[i]);
+        FdManager::GetInstance().get(sv[i], true);
+    }
+    return true;
+}
+
+// 在协程里从 fd 读一个字节，结果写到 result（1 为读到，-1 为出错），done 置 true
+static void fiberRead(IOManager &iom, int fd, std::atomic<int> &result, std::atomic<bool> &done) {
+    iom.scheduler([fd, &result, &done]() {
+        char c;
+        result = static_cast<int>(read(fd, &c, 1));
+        done = true;
+    });
+}
+
+// 协程挂起在 read 上，普通线程 close 读端：协程必须被唤醒并得到错误
+static void testCloseWakesReader(IOManager &iom) {
+    int sv[2];
+    TEST_CHECK(makePair(sv));
+    std::atomic<int> result{0};
+    std::atomic<bool> done{false};
+    fiberRead(iom, sv[0], result, done);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50)); // 等协程挂起
+    TEST_CHECK(!done.load());
+    close(sv[0]);
+    TEST_CHECK(WaitUntil([&]() { return done.load(); }, 5000));
+    TEST_CHECK_EQ(result.load(), -1);
+    close(sv[1]);
+}
+
+// 等待过一次就绪的 fd 被普通线程 close 后，新 socket 复用这个编号：在新 socket 上等待就绪不能挂死
+static void testReuseAfterClose(IOManager &iom) {
+    int sv[2];
+    TEST_CHECK(makePair(sv));
+    std::atomic<int> result{0};
+    std::atomic<bool> done{false};
+    fiberRead(iom, sv[0], result, done);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    TEST_CHECK_EQ(write(sv[1], "a", 1), static_cast<ssize_t>(1));
+    TEST_CHECK(WaitUntil([&]() { return done.load(); }, 5000));
+    TEST_CHECK_EQ(result.load(), 1);
+
+    int old_fd = sv[0];
+    close(sv[0]);
+    close(sv[1]);
+    TEST_CHECK(makePair(sv));
+    if (sv[1] == old_fd) std::swap(sv[0], sv[1]); // 在复用了旧编号的那一端上等待
+    if (sv[0] != old_fd) std::printf("  note: fd %d was not reused\n", old_fd);
+
+    result = 0;
+    done = false;
+    fiberRead(iom, sv[0], result, done);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    TEST_CHECK_EQ(write(sv[1], "b", 1), static_cast<ssize_t>(1));
+    TEST_CHECK(WaitUntil([&]() { return done.load(); }, 5000));
+    TEST_CHECK_EQ(result.load(), 1);
+    close(sv[0]);
+    close(sv[1]);
+}
+
+// close_f 直接关闭（不经过 hook，IOManager 不知道）：一个协程仍挂起在旧 fd 上
+// 新 socket 复用这个编号并登记时，旧的等待者以错误返回，新 socket 上的等待不受旧的注册 / 就绪状态影响
+static void testReuseAfterRawClose(IOManager &iom) {
+    int sv[2];
+    TEST_CHECK(makePair(sv));
+    std::atomic<int> result{0};
+    std::atomic<bool> done{false};
+    fiberRead(iom, sv[0], result, done);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    TEST_CHECK_EQ(write(sv[1], "a", 1), static_cast<ssize_t>(1));
+    TEST_CHECK(WaitUntil([&]() { return done.load(); }, 5000));
+    TEST_CHECK_EQ(result.load(), 1);
+
+    std::atomic<int> stale_result{0};
+    std::atomic<bool> stale_done{false};
+    fiberRead(iom, sv[0], stale_result, stale_done);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    int old_fd = sv[0];
+    close_f(sv[0]);
+    close_f(sv[1]);
+    TEST_CHECK(makePair(sv));
+    if (sv[1] == old_fd) std::swap(sv[0], sv[1]);
+    if (sv[0] != old_fd) std::printf("  note: fd %d was not reused\n", old_fd);
+    TEST_CHECK(WaitUntil([&]() { return stale_done.load(); }, 5000));
+    TEST_CHECK_EQ(stale_result.load(), -1);
+
+    result = 0;
+    done = false;
+    fiberRead(iom, sv[0], result, done);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    TEST_CHECK_EQ(write(sv[1], "b", 1), static_cast<ssize_t>(1));
+    TEST_CHECK(WaitUntil([&]() { return done.load(); }, 5000));
+    TEST_CHECK_EQ(result.load(), 1);
+    close(sv[0]);
+    close(sv[1]);
+}
+
+static void runSuite(const char *name, bool persistent, bool multi_reactor) {
+    std::printf("%s\n", name);
+    Config::Lookup<bool>("iomanager.persistent_et")->setValue(persistent);
+    Config::Lookup<bool>("iomanager.multi_reactor")->setValue(multi_reactor);
+    IOManager iom(2, false, name);
+    iom.start();
+    testCloseWakesReader(iom);
+    testReuseAfterClose(iom);
+    testReuseAfterRawClose(iom);
+    iom.stop();
+}
+
+int main() {
+    setvbuf(stdout, nullptr, _IONBF, 0);
+    runSuite("default", false, false);
+    runSuite("persistent", true, false);
+    runSuite("multi_reactor", false, true);
+    runSuite("persistent_multi_reactor", true, true);
+    return sunshine_test::TestExitCode();
+}
@@ -0,0 +1,294 @@
+// file: tests/fiber_sync_test.cpp
+// FiberMutex / FiberCondVar / FiberSemaphore / Channel 的压力测试
+// 每个原语同时由大量协程和一个普通线程（走线程阻塞的退化路径）使用，
+// 分别在 IOManager(4)（单 reactor / 多 reactor / io_uring）、Scheduler(3)、Scheduler(1) 上运行，检查结果不丢不重、等待者都能被唤醒
+// IOManager 上另外检查同一个 fd 先后被不同线程上的协程等待（fd 唤醒指定了 reactor 线程）
+//
+// 用法：fiber_sync_test [shared]   shared 表示使用共享栈协程（唤醒全部变成 pinned 任务）
+#include "test_util.h"
+#include "libs/Config.h"
+#include "libs/fd_manager.h"
+#include "libs/fiber_sync.h"
+#include "libs/iomanager.h"
+
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace sunshine;
+using sunshine_test::WaitUntil;
+
+// 协程加锁后让出再写回：没有互斥时计数会丢失
+static void testMutex(Scheduler &s) {
+    const int fibers = 200, rounds = 500;
+    FiberMutex m;
+    long count = 0;
+    std::atomic<int> done{0};
+    for (int f = 0; f < fibers; ++f) {
+        s.scheduler([&]() {
+            for (int k = 0; k < rounds; ++k) {
+                std::lock_guard<FiberMutex> guard(m);
+                long c = count;
+                if (k % 50 == 0) Fiber::YieldToReady();
+                count = c + 1;
+            }
+            ++done;
+        });
+    }
+    std::thread th([&]() {
+        for (int k = 0; k < rounds; ++k) {
+            std::lock_guard<FiberMutex> guard(m);
+            ++count;
+        }
+        ++done;
+    });
+    TEST_CHECK(WaitUntil([&]() { return done.load() == fibers + 1; }));
+    th.join();
+    TEST_CHECK_EQ(count, static_cast<long>(fibers + 1) * rounds);
+    TEST_CHECK(m.try_lock());
+    m.unlock();
+}
+
+// 生产者 notify_one，关闭时 notify_all：每个元素只被取走一次，所有消费者都能退出
+static void testCondVar(Scheduler &s) {
+    const int producers = 20, items = 2000, consumers = 10;
+    FiberMutex m;
+    FiberCondVar cv;
+    std::vector<int> queue;
+    bool closed = false;
+    long sum = 0;
+    std::atomic<int> produced{0}, consumed{0};
+    for (int c = 0; c < consumers; ++c) {
+        s.scheduler([&]() {
+            long local = 0;
+            for (;;) {
+                std::unique_lock<FiberMutex> lock(m);
+                cv.wait(lock, [&]() { return !queue.empty() || closed; });
+                if (queue.empty()) break;
+                local += queue.back();
+                queue.pop_back();
+            }
+            {
+                std::lock_guard<FiberMutex> guard(m);
+                sum += local;
+            }
+            ++consumed;
+        });
+    }
+    for (int p = 0; p < producers; ++p) {
+        s.scheduler([&]() {
+            for (int i = 1; i <= items; ++i) {
+                {
+                    std::lock_guard<FiberMutex> guard(m);
+                    queue.push_back(i);
+                }
+                cv.notify_one();
+                if (i % 100 == 0) Fiber::YieldToReady();
+            }
+            ++produced;
+        });
+    }
+    TEST_CHECK(WaitUntil([&]() { return produced.load() == producers; }));
+    {
+        std::lock_guard<FiberMutex> guard(m);
+        closed = true;
+    }
+    cv.notify_all();
+    TEST_CHECK(WaitUntil([&]() { return consumed.load() == consumers; }));
+    TEST_CHECK_EQ(sum, static_cast<long>(producers) * items * (items + 1) / 2);
+}
+
+// 同时持有许可的不超过初始计数，结束后计数复原
+static void testSemaphore(Scheduler &s) {
+    const int permits = 3, fibers = 300, thread_rounds = 100;
+    FiberSemaphore sem(permits);
+    std::atomic<int> inside{0}, max_inside{0}, done{0};
+    auto enter = [&]() {
+        int v = ++inside;
+        int mx = max_inside.load();
+        while (v > mx && !max_inside.compare_exchange_weak(mx, v)) {
+        }
+    };
+    for (int f = 0; f < fibers; ++f) {
+        s.scheduler([&]() {
+            sem.wait();
+            enter();
+            Fiber::YieldToReady();
+            --inside;
+            sem.post();
+            ++done;
+        });
+    }
+    std::thread th([&]() {
+        for (int i = 0; i < thread_rounds; ++i) {
+            sem.wait();
+            enter();
+            --inside;
+            sem.post();
+        }
+        ++done;
+    });
+    TEST_CHECK(WaitUntil([&]() { return done.load() == fibers + 1; }));
+    th.join();
+    TEST_CHECK(max_inside.load() <= permits);
+    TEST_CHECK_EQ(sem.getCount(), static_cast<size_t>(permits));
+    TEST_CHECK(!FiberSemaphore(0).tryWait());
+}
+
+// 多个协程生产者 + 一个线程生产者，多个协程消费者 + 一个线程消费者，小容量下频繁满 / 空
+static void testChannel(Scheduler &s) {
+    const int producers = 8, consumers = 6;
+    const long items = 5000;
+    Channel<long> ch(4);
+    std::atomic<long> sum{0};
+    std::atomic<int> produced{0}, consumed{0};
+    std::atomic<bool> send_failed{false};
+    auto consume = [&]() {
+        long v, local = 0;
+        while (ch.recv(v)) local += v;
+        sum += local;
+        ++consumed;
+    };
+    auto produce = [&]() {
+        for (long i = 1; i <= items; ++i) {
+            if (!ch.send(i)) send_failed = true;
+        }
+        ++produced;
+    };
+    for (int c = 0; c < consumers; ++c) s.scheduler(consume);
+    for (int p = 0; p < producers; ++p) s.scheduler(produce);
+    std::thread thread_producer(produce);
+    std::thread thread_consumer(consume);
+
+    TEST_CHECK(WaitUntil([&]() { return produced.load() == producers + 1; }));
+    ch.close();
+    TEST_CHECK(WaitUntil([&]() { return consumed.load() == consumers + 1; }));
+    thread_producer.join();
+    thread_consumer.join();
+    TEST_CHECK(!send_failed.load());
+    TEST_CHECK_EQ(sum.load(), (producers + 1) * items * (items + 1) / 2);
+    TEST_CHECK(ch.isClosed());
+    TEST_CHECK(!ch.send(1));
+
+    // 容量向上取整为 2 的幂；满时 trySend 失败且不动参数，关闭后仍能取完剩余元素
+    Channel<long> small(3);
+    TEST_CHECK_EQ(small.capacity(), static_cast<size_t>(4));
+    for (long i = 0; i < 4; ++i) {
+        long v = i;
+        TEST_CHECK(small.trySend(v));
+    }
+    long extra = 42;
+    TEST_CHECK(!small.trySend(extra));
+    TEST_CHECK_EQ(extra, 42L);
+    small.close();
+    long v = -1, total = 0;
+    while (small.recv(v)) total += v;
+    TEST_CHECK_EQ(total, 0L + 1 + 2 + 3);
+    TEST_CHECK(!small.tryRecv(v));
+}
+
+// 测试用：取得工作线程的线程 id，把任务指定到某个工作线程上
+class TestIOManager : public IOManager {
+public:
+    using IOManager::IOManager;
+    using Scheduler::workerThreadId;
+};
+
+// 同一个 fd 先后由不同工作线程上的协程等待：fd 的 reactor 在第一次等待时固定
+// 每轮在第 (轮次 + 编号) % 4 个工作线程上新建一个协程，写一个字节到 sv[0] 再等 echo 协程从 sv[1] 回写；
+// 共享栈模式下协程绑定在第一次运行的线程，多 reactor 模式下唤醒必须回到它绑定的线程而不是 fd 所在 reactor 的线程，
+// 否则协程被丢弃、等待永远不返回
+static void testFdHandoff(TestIOManager &iom) {
+    const int pairs = 8, rounds = 50;
+    std::vector<std::array<int, 2>> socks(pairs);
+    for (auto &sv : socks) {
+        TEST_CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, sv.data()) == 0);
+        for (int fd : sv) {
+            FdManager::GetInstance().del(fd);
+            FdManager::GetInstance().get(fd, true);
+        }
+        int echo_fd = sv[1];
+        iom.scheduler([echo_fd]() {
+            char c;
+            while (read(echo_fd, &c, 1) == 1) {
+                if (write(echo_fd, &c, 1) != 1) break;
+            }
+        });
+    }
+    std::atomic<int> done{0}, ok{0};
+    for (int r = 0; r < rounds; ++r) {
+        for (int p = 0; p < pairs; ++p) {
+            int fd = socks[p][0];
+            iom.scheduler([fd, r, &done, &ok]() {
+                char c = static_cast<char>('a' + r % 26), back = 0;
+                if (write(fd, &c, 1) == 1 && read(fd, &back, 1) == 1 && back == c) ++ok;
+                ++done;
+            }, iom.workerThreadId(static_cast<size_t>(r + p) % 4));
+        }
+        if (!WaitUntil([&]() { return done.load() == (r + 1) * pairs; }, 10000)) {
+            std::printf("  round %d: %d of %d done\n", r, done.load() - r * pairs, pairs);
+            TEST_CHECK(!"fd handoff round timed out");
+            break;
+        }
+    }
+    TEST_CHECK_EQ(ok.load(), rounds * pairs);
+    for (auto &sv : socks) {
+        close(sv[0]); // echo 协程读到 EOF 退出
+        close(sv[1]);
+    }
+}
+
+static void runSuite(Scheduler &s, const char *name) {
+    std::printf("%s: mutex\n", name);
+    testMutex(s);
+    std::printf("%s: condvar\n", name);
+    testCondVar(s);
+    std::printf("%s: semaphore\n", name);
+    testSemaphore(s);
+    std::printf("%s: channel\n", name);
+    testChannel(s);
+}
+
+static void runIOManagerSuite(const char *name, bool multi_reactor, bool uring) {
+    Config::Lookup<bool>("iomanager.multi_reactor")->setValue(multi_reactor);
+    Config::Lookup<bool>("iomanager.io_uring")->setValue(uring);
+    {
+        TestIOManager iom(4, false, name);
+        iom.start();
+        runSuite(iom, name);
+        std::printf("%s: fd handoff\n", name);
+        testFdHandoff(iom);
+        iom.stop();
+    }
+    Config::Lookup<bool>("iomanager.multi_reactor")->setValue(false);
+    Config::Lookup<bool>("iomanager.io_uring")->setValue(false);
+}
+
+int main(int argc, char **argv) {
+    setvbuf(stdout, nullptr, _IONBF, 0);
+    if (argc > 1 && std::strcmp(argv[1], "shared") == 0) {
+        Config::Lookup<bool>("fiber.shared_stack")->setValue(true);
+    }
+    runIOManagerSuite("iomanager", false, false);
+    // 多 reactor / io_uring 后端（隐含多 reactor）：fd 的唤醒都指定了线程（fd 所在的 reactor）
+    runIOManagerSuite("multi_reactor", true, false);
+    runIOManagerSuite("io_uring", false, true);
+    {
+        Scheduler sc(3, false, "sched");
+        sc.start();
+        runSuite(sc, "scheduler");
+        sc.stop();
+    }
+    {
+        Scheduler one(1, false, "one");
+        one.start();
+        runSuite(one, "single");
+        one.stop();
+    }
+    return sunshine_test::TestExitCode();
+}
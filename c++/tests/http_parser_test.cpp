@@ -0,0 +1,256 @@
+// file: tests/http_parser_test.cpp
+// HttpParser::execute：
+// - 同一条报文在每个字节偏移处切成两段（以及逐字节）喂入，结果都与一次喂完相同；小块 ByteArray 让 token 跨块
+// - 一个缓冲区里的多条报文（pipelining）依次解析，每次停在报文末尾
+// - 拒绝的报文：Content-Length 与 Transfer-Encoding 同时出现（400）、头部超长（431）、包体超长（413）、非法 chunk 大小（400）
+// - HTTP/1.0 默认不保持连接，Connection: keep-alive 时保持；HTTP/1.1 相反
+#include "test_util.h"
+#include "libs/Config.h"
+#include "libs/http_parser.h"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+
+using namespace sunshine;
+
+static const uint32_t MAX_HEADER = 1024;
+static const uint64_t MAX_BODY = 4096;
+
+// 接收缓冲区：数据追加到末尾，解析从 position 继续（同 http_server 的读法）
+class Input {
+public:
+    explicit Input(size_t block = 16) :
+        m_ba(std::make_unique<ByteArray>(block)) {}
+
+    void append(std::string_view s) {
+        size_t pos = m_ba->getPosition();
+        m_ba->setPosition(m_end);
+        m_ba->write(s.data(), s.size());
+        m_end += s.size();
+        m_ba->setPosition(pos);
+    }
+    ByteArray &ba() {
+        return *m_ba;
+    }
+
+private:
+    std::unique_ptr<ByteArray> m_ba;
+    size_t m_end = 0;
+};
+
+static const std::string CHUNKED_POST = "POST /upload/file?name=a%20b&x=1#frag HTTP/1.1\r\n"
+                                        "Host: example.com\r\n"
+                                        "X-Long-Header-Name:   some value with spaces  \r\n"
+                                        "Transfer-Encoding: chunked\r\n"
+                                        "\r\n"
+                                        "5;ext=1\r\nhello\r\n"
+                                        "1a\r\nabcdefghijklmnopqrstuvwxyz\r\n"
+                                        "0\r\n"
+                                        "Trailer: ignored\r\n"
+                                        "\r\n";
+
+static const std::string LENGTH_PUT = "PUT /data HTTP/1.1\r\n"
+                                      "Content-Length: 11\r\n"
+                                      "connection: close\r\n"
+                                      "\r\n"
+                                      "hello world";
+
+static bool checkChunkedPost(const HttpRequest &req) {
+    bool ok = req.getMethod() == HttpMethod::POST && req.getPath() == "/upload/file" &&
+              req.getQuery() == "name=a%20b&x=1" && req.getFragment() == "frag" && req.getVersion() == 0x11 &&
+              req.getHeader("host") == "example.com" &&
+              req.getHeader("X-Long-Header-Name") == "some value with spaces" && req.isChunked() &&
+              req.isKeepAlive() && req.getBodyString() == "helloabcdefghijklmnopqrstuvwxyz";
+    if (!ok) {
+        std::printf("  got %.*s %.*s? %.*s body \"%s\"\n", (int)req.getMethodString().size(),
+                    req.getMethodString().data(), (int)req.getPath().size(), req.getPath().data(),
+                    (int)req.getQuery().size(), req.getQuery().data(), req.getBodyString().c_str());
+    }
+    return ok;
+}
+
+static bool checkLengthPut(const HttpRequest &req) {
+    return req.getMethod() == HttpMethod::PUT && req.getPath() == "/data" && req.getContentLength() == 11 &&
+           !req.isKeepAlive() && req.getBodyString() == "hello world";
+}
+
+// 在 split 处切成两段：第一段不完整时必须返回 NEED_MORE；返回最终结果
+static HttpParser::Result parseSplit(HttpParser &parser, Input &in, std::string_view msg, size_t split) {
+    in.append(msg.substr(0, split));
+    HttpParser::Result r = parser.execute(in.ba());
+    if (split < msg.size() && r != HttpParser::NEED_MORE) return r;
+    in.append(msg.substr(split));
+    return parser.execute(in.ba());
+}
+
+static void testSplitAtEveryOffset() {
+    for (const std::string *msg : {&CHUNKED_POST, &LENGTH_PUT}) {
+        for (size_t split = 0; split <= msg->size(); ++split) {
+            Input in;
+            HttpParser parser;
+            bool ok = parseSplit(parser, in, *msg, split) == HttpParser::DONE &&
+                      (msg == &CHUNKED_POST ? checkChunkedPost(parser.getRequest())
+                                            : checkLengthPut(parser.getRequest()));
+            if (!ok) std::printf("  split at %zu failed\n", split);
+            TEST_CHECK(ok);
+            TEST_CHECK_EQ(in.ba().getReadSize(), static_cast<size_t>(0));
+        }
+    }
+    // 逐字节喂入
+    Input in;
+    HttpParser parser;
+    HttpParser::Result r = HttpParser::NEED_MORE;
+    for (size_t i = 0; i < CHUNKED_POST.size(); ++i) {
+        TEST_CHECK(r == HttpParser::NEED_MORE);
+        in.append(std::string_view(CHUNKED_POST).substr(i, 1));
+        r = parser.execute(in.ba());
+    }
+    TEST_CHECK(r == HttpParser::DONE);
+    TEST_CHECK(checkChunkedPost(parser.getRequest()));
+}
+
+// 三条报文在一个缓冲区里（前面多一个空行），每条 DONE 后 reset；最后一条的一半留在缓冲区里等待后续数据
+static void testPipelined() {
+    const std::string get = "GET /a HTTP/1.1\r\nHost: x\r\n\r\n";
+    Input in(64);
+    in.append("\r\n" + LENGTH_PUT + get + CHUNKED_POST + get.substr(0, 10));
+    HttpParser parser;
+
+    TEST_CHECK(parser.execute(in.ba()) == HttpParser::DONE);
+    TEST_CHECK(checkLengthPut(parser.getRequest()));
+    parser.reset();
+    TEST_CHECK(parser.execute(in.ba()) == HttpParser::DONE);
+    TEST_CHECK(parser.getRequest().getMethod() == HttpMethod::GET);
+    TEST_CHECK(parser.getRequest().getPath() == "/a");
+    TEST_CHECK(parser.getRequest().getBody().empty());
+    parser.reset();
+    TEST_CHECK(parser.execute(in.ba()) == HttpParser::DONE);
+    TEST_CHECK(checkChunkedPost(parser.getRequest()));
+    parser.reset();
+    TEST_CHECK(parser.execute(in.ba()) == HttpParser::NEED_MORE);
+    in.append(get.substr(10));
+    TEST_CHECK(parser.execute(in.ba()) == HttpParser::DONE);
+    TEST_CHECK(parser.getRequest().getPath() == "/a");
+    TEST_CHECK_EQ(in.ba().getReadSize(), static_cast<size_t>(0));
+}
+
+// 一次喂完，期望以 status 拒绝
+static bool rejects(const std::string &msg, uint16_t status) {
+    Input in;
+    HttpParser parser;
+    in.append(msg);
+    HttpParser::Result r = parser.execute(in.ba());
+    if (r == HttpParser::ERROR && parser.getError() == status) return true;
+    std::printf("  want %u, got result %d error %u for \"%.40s\"\n", status, static_cast<int>(r), parser.getError(),
+                msg.c_str());
+    return false;
+}
+
+static void testRejected() {
+    // Content-Length 与 Transfer-Encoding 同时出现：两种顺序
+    TEST_CHECK(rejects("POST / HTTP/1.1\r\nContent-Length: 5\r\nTransfer-Encoding: chunked\r\n\r\n", 400));
+    TEST_CHECK(rejects("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\nContent-Length: 5\r\n\r\n", 400));
+    TEST_CHECK(rejects("POST / HTTP/1.1\r\nContent-Length: 5\r\nContent-Length: 6\r\n\r\n", 400));
+
+    // 头部超长：一个超长的值、很多短字段、超过拼接区的跨块 token
+    TEST_CHECK(rejects("GET / HTTP/1.1\r\nX: " + std::string(MAX_HEADER, 'v') + "\r\n\r\n", 431));
+    std::string many = "GET / HTTP/1.1\r\n";
+    for (int i = 0; i < 100; ++i) many += "X-" + std::to_string(i) + ": 0123456789\r\n";
+    TEST_CHECK(rejects(many + "\r\n", 431));
+    {
+        Input in;
+        HttpParser parser;
+        for (size_t i = 0; i < MAX_HEADER * 2; ++i) in.append("a");
+        TEST_CHECK(parser.execute(in.ba()) == HttpParser::ERROR);
+        TEST_CHECK_EQ(parser.getError(), static_cast<uint16_t>(431));
+    }
+    // 逐字节喂入也在头部超长时停下，不等到空行
+    {
+        Input in;
+        HttpParser parser;
+        std::string head = "GET / HTTP/1.1\r\nX: " + std::string(MAX_HEADER, 'v');
+        HttpParser::Result r = HttpParser::NEED_MORE;
+        for (size_t i = 0; i < head.size() && r == HttpParser::NEED_MORE; ++i) {
+            in.append(std::string_view(head).substr(i, 1));
+            r = parser.execute(in.ba());
+        }
+        TEST_CHECK(r == HttpParser::ERROR);
+        TEST_CHECK_EQ(parser.getError(), static_cast<uint16_t>(431));
+    }
+
+    // 包体超长：Content-Length、单个 chunk、多个 chunk 累计
+    TEST_CHECK(rejects("POST / HTTP/1.1\r\nContent-Length: " + std::to_string(MAX_BODY + 1) + "\r\n\r\n", 413));
+    TEST_CHECK(rejects("POST / HTTP/1.1\r\nContent-Length: 1234567890123456789\r\n\r\n", 413));
+    char size_line[32];
+    std::snprintf(size_line, sizeof(size_line), "%llx\r\n", static_cast<unsigned long long>(MAX_BODY + 1));
+    TEST_CHECK(rejects(std::string("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n") + size_line, 413));
+    std::string chunks = "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n";
+    std::string piece(1000, 'p');
+    for (int i = 0; i < 5; ++i) chunks += "3e8\r\n" + piece + "\r\n";
+    TEST_CHECK(rejects(chunks, 413));
+    TEST_CHECK(rejects("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nffffffffffffffff\r\n", 413));
+    // 恰好等于上限的包体可以接受
+    {
+        Input in;
+        HttpParser parser;
+        in.append("POST / HTTP/1.1\r\nContent-Length: " + std::to_string(MAX_BODY) + "\r\n\r\n" +
+                  std::string(MAX_BODY, 'b'));
+        TEST_CHECK(parser.execute(in.ba()) == HttpParser::DONE);
+        TEST_CHECK_EQ(parser.getRequest().getBody().size(), static_cast<size_t>(MAX_BODY));
+    }
+
+    // 非法 chunk 大小：非十六进制、空、数字后跟非法字符、数据后缺少 CRLF
+    const char *chunked = "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n";
+    TEST_CHECK(rejects(std::string(chunked) + "zz\r\n", 400));
+    TEST_CHECK(rejects(std::string(chunked) + "\r\n", 400));
+    TEST_CHECK(rejects(std::string(chunked) + "-1\r\n", 400));
+    TEST_CHECK(rejects(std::string(chunked) + "5x\r\nhello\r\n", 400));
+    TEST_CHECK(rejects(std::string(chunked) + "5\r\nhelloXX\r\n", 400));
+}
+
+static bool keepAlive(const std::string &msg, uint8_t version) {
+    Input in;
+    HttpParser parser;
+    in.append(msg);
+    if (parser.execute(in.ba()) != HttpParser::DONE) return false;
+    TEST_CHECK_EQ(parser.getRequest().getVersion(), version);
+    return parser.getRequest().isKeepAlive();
+}
+
+static void testKeepAlive() {
+    TEST_CHECK(!keepAlive("GET / HTTP/1.0\r\n\r\n", 0x10));
+    TEST_CHECK(keepAlive("GET / HTTP/1.0\r\nConnection: keep-alive\r\n\r\n", 0x10));
+    TEST_CHECK(keepAlive("GET / HTTP/1.0\r\nConnection: Upgrade, Keep-Alive\r\n\r\n", 0x10));
+    TEST_CHECK(!keepAlive("GET / HTTP/1.0\r\nConnection: close\r\n\r\n", 0x10));
+    TEST_CHECK(keepAlive("GET / HTTP/1.1\r\n\r\n", 0x11));
+    TEST_CHECK(!keepAlive("GET / HTTP/1.1\r\nConnection: close\r\n\r\n", 0x11));
+
+    // 同一个解析器上先 1.0 keep-alive，reset 后 1.0 默认
+    Input in;
+    HttpParser parser;
+    in.append("GET /1 HTTP/1.0\r\nConnection: keep-alive\r\n\r\nGET /2 HTTP/1.0\r\n\r\n");
+    TEST_CHECK(parser.execute(in.ba()) == HttpParser::DONE);
+    TEST_CHECK(parser.getRequest().isKeepAlive());
+    parser.reset();
+    TEST_CHECK(parser.execute(in.ba()) == HttpParser::DONE);
+    TEST_CHECK(parser.getRequest().getPath() == "/2");
+    TEST_CHECK(!parser.getRequest().isKeepAlive());
+}
+
+int main() {
+    setvbuf(stdout, nullptr, _IONBF, 0);
+    // 解析器在构造时读取上限
+    Config::Lookup<uint32_t>("http.max_header_size")->setValue(MAX_HEADER);
+    Config::Lookup<uint64_t>("http.max_body_size")->setValue(MAX_BODY);
+    std::printf("split at every offset\n");
+    testSplitAtEveryOffset();
+    std::printf("pipelined\n");
+    testPipelined();
+    std::printf("rejected\n");
+    testRejected();
+    std::printf("keep-alive\n");
+    testKeepAlive();
+    return sunshine_test::TestExitCode();
+}
@@ -0,0 +1,126 @@
+// file: tests/log_format_test.cpp
+// LogFormatter 的 %d 线程本地缓存与 %ms / %us：
+// - 缓存路径的输出必须与直接 localtime_r + strftime 的结果完全一致（连续的秒、重复的秒、来回切换的秒）
+// - 共用同一个缓存槽位的多个 formatter 互不干扰；放不进槽位的超长结果不缓存，也必须正确
+// - %ms / %us 定宽补零；%m{}s 仍然是消息后跟字面量 s
+#include "test_util.h"
+#include "libs/log.h"
+
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <vector>
+
+using namespace sunshine;
+
+static LogEvent::ptr makeEvent(uint64_t sec, uint32_t nsec = 0, const std::string &msg = "") {
+    auto ev = std::make_shared<LogEvent>("test", 0, __FILE__, __LINE__, sec, 0, "", 0, LogLevel::INFO);
+    ev->m_nsec = nsec;
+    ev->getSS() << msg;
+    return ev;
+}
+
+// 不经过缓存的参考结果
+static std::string reference(const std::string &fmt, uint64_t sec) {
+    std::time_t t = static_cast<std::time_t>(sec);
+    std::tm tm;
+    localtime_r(&t, &tm);
+    char buf[512];
+    size_t len = std::strftime(buf, sizeof(buf), fmt.c_str(), &tm);
+    return std::string(buf, len);
+}
+
+static bool checkDate(LogFormatter &f, const std::string &fmt, uint64_t sec) {
+    std::string got = f.format(makeEvent(sec));
+    std::string want = reference(fmt, sec);
+    if (got == want) return true;
+    std::printf("  %%d{%s} at %llu: got \"%s\", want \"%s\"\n", fmt.c_str(), static_cast<unsigned long long>(sec),
+                got.c_str(), want.c_str());
+    return false;
+}
+
+static const uint64_t BASE_SEC = 1700000000; // 2023-11-14，附近跨越分钟 / 小时边界
+
+// 每个 pattern：连续 2000 秒各格式化两次，再在几个秒之间来回切换
+static void testConsecutiveAndRepeated() {
+    const std::vector<std::string> patterns = {
+        "%Y-%m-%d %H:%M:%S", "%H:%M:%S", "%a %b %e %j %Z %z", "%s", "[%F %T]",
+    };
+    for (const auto &fmt : patterns) {
+        LogFormatter f("%d{" + fmt + "}");
+        for (uint64_t s = BASE_SEC; s < BASE_SEC + 2000; ++s) {
+            TEST_CHECK(checkDate(f, fmt, s));
+            TEST_CHECK(checkDate(f, fmt, s));
+        }
+        const uint64_t order[] = {BASE_SEC, BASE_SEC + 1, BASE_SEC, BASE_SEC + 86400, BASE_SEC + 86400, BASE_SEC + 1};
+        for (uint64_t s : order) TEST_CHECK(checkDate(f, fmt, s));
+    }
+    // 不带 {} 的 %d 使用默认格式
+    LogFormatter def("%d");
+    for (uint64_t s = BASE_SEC; s < BASE_SEC + 10; ++s) TEST_CHECK(checkDate(def, "%Y-%m-%d %H:%M:%S", s));
+}
+
+// 槽位按 id % DATE_CACHE_SLOTS 映射：连续创建 8 个（多于槽位数）formatter 必然有共用槽位的，
+// 同一秒内轮流格式化，每个都必须得到自己 pattern 的结果，而不是同槽位上一个 formatter 的缓存
+static void testSharedSlot() {
+    std::vector<std::string> patterns;
+    std::vector<std::unique_ptr<LogFormatter>> formatters;
+    for (int i = 0; i < 8; ++i) {
+        patterns.push_back("#" + std::to_string(i) + " %H:%M:%S");
+        formatters.emplace_back(new LogFormatter("%d{" + patterns.back() + "}"));
+    }
+    for (uint64_t s = BASE_SEC; s < BASE_SEC + 3; ++s) {
+        for (int round = 0; round < 3; ++round) {
+            for (size_t i = 0; i < formatters.size(); ++i) TEST_CHECK(checkDate(*formatters[i], patterns[i], s));
+        }
+    }
+}
+
+// 超过缓存槽位（116 字节）的结果：每次都重新格式化，与同槽位的短结果交替时也不串
+static void testUncachedLong() {
+    std::string fmt;
+    for (int i = 0; i < 7; ++i) fmt += "%Y-%m-%d %H:%M:%S ";
+    LogFormatter longf("%d{" + fmt + "}");
+    TEST_CHECK(reference(fmt, BASE_SEC).size() > 116);
+    std::vector<std::unique_ptr<LogFormatter>> shorts;
+    for (int i = 0; i < 8; ++i) shorts.emplace_back(new LogFormatter("%d{%T}"));
+    for (uint64_t s = BASE_SEC; s < BASE_SEC + 3; ++s) {
+        for (int round = 0; round < 3; ++round) {
+            TEST_CHECK(checkDate(longf, fmt, s));
+            for (auto &f : shorts) TEST_CHECK(checkDate(*f, "%T", s));
+        }
+    }
+}
+
+static void testSubSecond() {
+    struct Case {
+        uint32_t nsec;
+        const char *ms;
+        const char *us;
+    };
+    const Case cases[] = {
+        {0, "000", "000000"},          {7000, "000", "000007"},       {5000000, "005", "005000"},
+        {42123456, "042", "042123"},   {999999999, "999", "999999"},  {100000000, "100", "100000"},
+    };
+    LogFormatter ms("%ms");
+    LogFormatter us("%us");
+    LogFormatter both("%d{%H:%M:%S}.%ms|%us");
+    for (const Case &c : cases) {
+        TEST_CHECK_EQ(ms.format(makeEvent(BASE_SEC, c.nsec)), std::string(c.ms));
+        TEST_CHECK_EQ(us.format(makeEvent(BASE_SEC, c.nsec)), std::string(c.us));
+        TEST_CHECK_EQ(both.format(makeEvent(BASE_SEC, c.nsec)),
+                      reference("%H:%M:%S", BASE_SEC) + "." + c.ms + "|" + c.us);
+    }
+    // %ms 优先解析为毫秒；消息后跟字面量 s 写作 %m{}s
+    LogFormatter msg("%m{}s %m");
+    TEST_CHECK_EQ(msg.format(makeEvent(BASE_SEC, 0, "hello")), std::string("hellos hello"));
+}
+
+int main() {
+    setvbuf(stdout, nullptr, _IONBF, 0);
+    testConsecutiveAndRepeated();
+    testSharedSlot();
+    testUncachedLong();
+    testSubSecond();
+    return sunshine_test::TestExitCode();
+}
@@ -0,0 +1,97 @@
+// file: tests/rpc_test.cpp
+// 超过 rpc.max_frame_size 的帧在发送端被拒绝：
+// - 超长请求只让这一次 call 以 RPC_TOO_LARGE 返回，同一连接上的在途调用和之后的调用不受影响
+// - 恰好等于上限的请求正常发送；超长的 notify 返回 false
+// - handler 的响应超长时调用方收到 RPC_HANDLER_ERROR，而不是连接被对端断开
+#include "test_util.h"
+#include "libs/Config.h"
+#include "libs/address.h"
+#include "libs/iomanager.h"
+#include "libs/rpc.h"
+
+#include <atomic>
+#include <cstdio>
+#include <signal.h>
+#include <string>
+#include <unistd.h>
+
+using namespace sunshine;
+using sunshine_test::WaitUntil;
+
+static const uint32_t MAX_FRAME = 4096;
+
+static void testOversizedRequest(RpcClient &client, IOManager &iom) {
+    // 在途的慢调用：超长请求被拒绝后它仍然正常完成
+    std::atomic<bool> slow_done{false};
+    std::atomic<uint32_t> slow_status{~0u};
+    iom.scheduler([&]() {
+        slow_status = client.call("slow", "").status;
+        slow_done = true;
+    });
+    usleep(20 * 1000);
+
+    RpcClient::Result r = client.call("echo", std::string(MAX_FRAME, 'x'));
+    TEST_CHECK_EQ(r.status, static_cast<uint32_t>(RPC_TOO_LARGE));
+    TEST_CHECK(!client.notify("echo", std::string(MAX_FRAME, 'x')));
+    TEST_CHECK(!client.getSession()->isClosed());
+
+    TEST_CHECK(WaitUntil([&]() { return slow_done.load(); }, 5000));
+    TEST_CHECK_EQ(slow_status.load(), static_cast<uint32_t>(RPC_OK));
+    TEST_CHECK_EQ(client.getPendingCount(), static_cast<size_t>(0));
+
+    // id 小于 128，varint 各占一个字节：id + 方法名长度 + "echo" + 负载恰好等于上限
+    std::string exact(MAX_FRAME - 1 - 1 - 4, 'y');
+    TEST_CHECK(RpcCodec::RequestSize(1, "echo", exact) == MAX_FRAME);
+    r = client.call("echo", exact);
+    TEST_CHECK_EQ(r.status, static_cast<uint32_t>(RPC_OK));
+    TEST_CHECK_EQ(r.payload.size(), exact.size());
+}
+
+static void testOversizedResponse(RpcClient &client) {
+    RpcClient::Result r = client.call("big", "");
+    TEST_CHECK_EQ(r.status, static_cast<uint32_t>(RPC_HANDLER_ERROR));
+    TEST_CHECK(!client.getSession()->isClosed());
+    r = client.call("echo", "after");
+    TEST_CHECK(r.ok());
+    TEST_CHECK_EQ(r.payload.toString(), std::string("after"));
+}
+
+int main() {
+    setvbuf(stdout, nullptr, _IONBF, 0);
+    signal(SIGPIPE, SIG_IGN);
+    // 会话与接收缓冲区在创建时读取上限，必须先设置
+    Config::Lookup<uint32_t>("rpc.max_frame_size")->setValue(MAX_FRAME);
+
+    IOManager server_iom(1, false, "rpc");
+    IOManager client_iom(1, false, "client");
+    server_iom.start();
+    client_iom.start();
+    {
+        auto server = std::make_shared<RpcServer>(&server_iom, &server_iom);
+        server->registerMethod("echo", [](const RpcMessage &req, std::string &rsp) {
+            rsp = req.payload.toString();
+            return RPC_OK;
+        });
+        server->registerMethod("slow", [](const RpcMessage &, std::string &) {
+            usleep(200 * 1000);
+            return RPC_OK;
+        });
+        server->registerMethod("big", [](const RpcMessage &, std::string &rsp) {
+            rsp.assign(MAX_FRAME, 'z');
+            return RPC_OK;
+        });
+        TEST_CHECK(server->bind(IPv4Address::Create("127.0.0.1", 0)) && server->start());
+
+        auto client = std::make_shared<RpcClient>(&client_iom);
+        TEST_CHECK(client->connect(server->getLocalAddresses()[0]));
+        std::printf("oversized request\n");
+        testOversizedRequest(*client, client_iom);
+        std::printf("oversized response\n");
+        testOversizedResponse(*client);
+        client->close();
+        server->stop();
+    }
+    client_iom.stop();
+    server_iom.stop();
+    return sunshine_test::TestExitCode();
+}
@@ -0,0 +1,55 @@
+// file: tests/test_util.h
+// 测试程序共用的检查宏：失败时打印位置和表达式并计数，main 最后用 TestExitCode() 作为返回值
+// 不中断执行，一次运行可以看到所有失败的检查
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <thread>
+
+namespace sunshine_test {
+
+inline int &FailureCount() {
+    static int s_failures = 0;
+    return s_failures;
+}
+
+inline int TestExitCode() {
+    if (FailureCount() == 0) {
+        std::printf("all checks passed\n");
+        return 0;
+    }
+    std::printf("%d check(s) failed\n", FailureCount());
+    return 1;
+}
+
+// 轮询等待 done() 为真，超时返回 false（等待其他线程 / 协程完成时用，避免测试挂死）
+inline bool WaitUntil(const std::function<bool()> &done, int timeout_ms = 30000) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (!done()) {
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    return true;
+}
+
+} // namespace sunshine_test
+
+#define TEST_CHECK(cond)                                                                  \
+    do {                                                                                  \
+        if (!(cond)) {                                                                    \
+            ++sunshine_test::FailureCount();                                              \
+            std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);          \
+        }                                                                                 \
+    } while (0)
+
+#define TEST_CHECK_EQ(a, b)                                                               \
+    do {                                                                                  \
+        auto &&test_a_ = (a);                                                             \
+        auto &&test_b_ = (b);                                                             \
+        if (!(test_a_ == test_b_)) {                                                      \
+            ++sunshine_test::FailureCount();                                              \
+            std::printf("%s:%d: check failed: %s == %s\n", __FILE__, __LINE__, #a, #b);   \
+        }                                                                                 \
+    } while (0)